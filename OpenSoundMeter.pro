@@ -12,7 +12,9 @@ SOURCES += src/main.cpp \
     src/audio/deviceinfo.cpp \
     src/audio/devicemodel.cpp \
     src/audio/format.cpp \
+    src/audio/loopback.cpp \
     src/audio/plugin.cpp \
+    src/audio/plugins/virtualplugin.cpp \
     src/audio/stream.cpp \
     src/chart/crestfactorplot.cpp \
     src/chart/cursorhelper.cpp \
@@ -30,12 +32,19 @@ SOURCES += src/main.cpp \
     src/chart/stepplot.cpp \
     src/chart/coherenceplot.cpp \
     src/common/autosaver.cpp \
+    src/common/binaryfile.cpp \
+    src/common/memorybudget.cpp \
     src/common/recentfilesmodel.cpp \
+    src/common/scheduler.cpp \
     src/common/wavfile.cpp \
+    src/common/wavwriter.cpp \
     src/common/workingfolder.cpp \
     src/filesystem/dialog.cpp \
     src/filesystem/dialogPlugin.cpp \
     src/filesystem/plugins/widgetdialogplugin.cpp \
+    src/autoeq.cpp \
+    src/exporter.cpp \
+    src/filterchain.cpp \
     src/filtersource.cpp \
     src/generator/brownnoise.cpp \
     src/generator/burstnoise.cpp \
@@ -62,7 +71,11 @@ SOURCES += src/main.cpp \
     src/meta/metameasurement.cpp \
     src/meta/metastored.cpp \
     src/meta/metawindowing.cpp \
+    src/multimeasurement.cpp \
     src/metertablemodel.cpp \
+    src/importer.cpp \
+    src/offlineanalysis.cpp \
+    src/recorder.cpp \
     src/remote/generatorremote.cpp \
     src/remote/item.cpp \
     src/remote/items/groupitem.cpp \
@@ -72,6 +85,9 @@ SOURCES += src/main.cpp \
     src/remote/remoteclient.cpp \
     src/remote/server.cpp \
     src/remote/tcpreciever.cpp \
+    src/source/axis.cpp \
+    src/source/compactframe.cpp \
+    src/source/curvetable.cpp \
     src/source/group.cpp \
     src/source/source_abstract.cpp \
     src/source/source_shared.cpp \
@@ -93,6 +109,7 @@ SOURCES += src/main.cpp \
     src/chart/painteditem.cpp \
     src/measurement.cpp \
     src/common/settings.cpp \
+    src/common/textwriter.cpp \
     src/chart/variablechart.cpp \
     src/chart/plot.cpp \
     src/chart/rtaplot.cpp \
@@ -103,10 +120,13 @@ SOURCES += src/main.cpp \
     src/math/meter.cpp \
     src/math/coherence.cpp \
     src/math/averaging.cpp \
+    src/math/eqfit.cpp \
+    src/math/analogfilter.cpp \
     src/math/complex.cpp \
     src/math/fouriertransform.cpp \
     src/math/windowfunction.cpp \
     src/math/deconvolution.cpp \
+    src/math/resampler.cpp \
 
 RESOURCES += qml.qrc \
     audio/noises.qrc \
@@ -150,7 +170,9 @@ HEADERS += \
     src/audio/deviceinfo.h \
     src/audio/devicemodel.h \
     src/audio/format.h \
+    src/audio/loopback.h \
     src/audio/plugin.h \
+    src/audio/plugins/virtualplugin.h \
     src/audio/stream.h \
     src/chart/crestfactorplot.h \
     src/chart/cursorhelper.h \
@@ -171,12 +193,19 @@ HEADERS += \
     src/chart/coherenceplot.h \
     src/common/atomic.h \
     src/common/autosaver.h \
+    src/common/binaryfile.h \
+    src/common/memorybudget.h \
     src/common/recentfilesmodel.h \
+    src/common/scheduler.h \
     src/common/wavfile.h \
+    src/common/wavwriter.h \
     src/common/workingfolder.h \
     src/filesystem/dialog.h \
     src/filesystem/dialogPlugin.h \
     src/filesystem/plugins/widgetdialogplugin.h \
+    src/autoeq.h \
+    src/exporter.h \
+    src/filterchain.h \
     src/filtersource.h \
     src/generator/brownnoise.h \
     src/generator/burstnoise.h \
@@ -206,7 +235,11 @@ HEADERS += \
     src/meta/metameasurement.h \
     src/meta/metastored.h \
     src/meta/metawindowing.h \
+    src/multimeasurement.h \
     src/metertablemodel.h \
+    src/importer.h \
+    src/offlineanalysis.h \
+    src/recorder.h \
     src/remote/generatorremote.h \
     src/remote/item.h \
     src/remote/items/groupitem.h \
@@ -216,6 +249,9 @@ HEADERS += \
     src/remote/remoteclient.h \
     src/remote/server.h \
     src/remote/tcpreciever.h \
+    src/source/axis.h \
+    src/source/compactframe.h \
+    src/source/curvetable.h \
     src/source/group.h \
     src/source/source_abstract.h \
     src/source/source_shared.h \
@@ -239,6 +275,7 @@ HEADERS += \
     src/chart/type.h \
     src/measurement.h \
     src/common/settings.h \
+    src/common/textwriter.h \
     src/chart/variablechart.h \
     src/chart/plot.h \
     src/chart/rtaplot.h \
@@ -249,14 +286,19 @@ HEADERS += \
     src/math/meter.h \
     src/math/coherence.h \
     src/math/averaging.h \
+    src/math/eqfit.h \
+    src/math/analogfilter.h \
     src/math/complex.h \
     src/math/fouriertransform.h \
     src/math/deconvolution.h \
     src/math/windowfunction.h \
+    src/math/resampler.h \
     src/math/deconvolution.h \
     src/container/fifo.h \
     src/container/circular.h \
-    src/container/array.h
+    src/container/array.h \
+    src/container/ringbuffer.h \
+    src/container/span.h
 
 #math
 equals(QT_ARCH, "arm64") {
@@ -0,0 +1,125 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.13
+import QtQuick.Controls 2.13
+import QtQuick.Controls.Material 2.13
+import QtQuick.Layouts 1.12
+import QtQuick.Dialogs 1.2
+
+import OpenSoundMeter 1.0
+import "elements"
+
+Popup {
+    id: popup
+    modal: true
+    focus: true
+    padding: 25
+    closePolicy: Popup.CloseOnEscape | Popup.CloseOnPressOutside
+
+    //checked sources, filled by Select
+    property var selected: []
+    property int selectedCount: 0
+    onSelectedChanged: selectedCount = sourceSelect.model.checkedCount()
+    property var formats: ["osm"]
+    readonly property var availableFormats: ["osm", "json", "cal", "frd", "txt", "csv", "wav"]
+
+    ColumnLayout {
+        anchors.fill: parent
+
+        Label {
+            text: qsTr("Export")
+            font.bold: true
+        }
+
+        Select {
+            id: sourceSelect
+            Layout.preferredWidth: 300
+            tooltip: qsTr("sources to export")
+            sources: sourceList
+            dataObject: popup
+        }
+
+        Flow {
+            Layout.preferredWidth: 300
+            spacing: 5
+
+            Repeater {
+                model: popup.availableFormats
+
+                CheckBox {
+                    text: modelData
+                    checked: popup.formats.indexOf(modelData) !== -1
+                    onToggled: {
+                        var list = popup.formats.filter(function(format) { return format !== modelData; });
+                        if (checked) {
+                            list.push(modelData);
+                        }
+                        popup.formats = list;
+                    }
+                }
+            }
+        }
+
+        RowLayout {
+            Layout.preferredWidth: 300
+
+            ProgressBar {
+                id: exportProgress
+                property string fileName
+                Layout.fillWidth: true
+                from: 0
+                to: 1
+                value: 0
+            }
+
+            Button {
+                text: qsTr("Export")
+                enabled: popup.selectedCount > 0 && popup.formats.length > 0
+                onClicked: folderDialog.open()
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("choose a folder and write every selected source in every checked format")
+            }
+        }
+
+        Label {
+            Layout.preferredWidth: 300
+            text: exportProgress.fileName
+            elide: Text.ElideMiddle
+        }
+    }
+
+    Connections {
+        target: sourceList
+        function onExportProgress(fileName, done, total) {
+            exportProgress.fileName = fileName;
+            exportProgress.value = total ? done / total : 1;
+        }
+    }
+
+    FileDialog {
+        id: folderDialog
+        selectFolder: true
+        title: qsTr("Please choose a folder")
+        folder: (typeof shortcuts !== 'undefined' ? shortcuts.home : Filesystem.StandardFolder.Home)
+        onAccepted: {
+            exportProgress.fileName = "";
+            exportProgress.value = 0;
+            sourceList.exportFiles(popup.selected, popup.formats, folderDialog.fileUrl);
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.13
+import QtQuick.Controls 2.13
+import QtQuick.Controls.Material 2.13
+import QtQuick.Layouts 1.12
+import QtQuick.Dialogs 1.2
+
+import SourceModel 1.0
+import OpenSoundMeter 1.0
+import "elements"
+
+Item {
+    id: recorderProperties
+    readonly property int elementWidth: width / 9
+
+    ColumnLayout {
+        anchors.fill: parent
+
+        RowLayout {
+
+            Button {
+                checkable: true
+                text: qsTr("Input")
+                checked: recorder.active
+                Material.background: parent.Material.background
+                onCheckedChanged: {
+                    recorder.active = checked;
+                    checked = Qt.binding(function() { return recorder.active; });
+                }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("keep the pre-trigger buffer filled")
+            }
+
+            Button {
+                checkable: true
+                text: recorder.recording ? qsTr("Stop") : qsTr("Record")
+                checked: recorder.recording
+                Material.background: checked ? Material.Red : parent.Material.background
+                onCheckedChanged: {
+                    recorder.recording = checked;
+                    checked = Qt.binding(function() { return recorder.recording; });
+                }
+            }
+
+            DropDown {
+                enabled: !recorder.active
+                model: SourceModel {
+                    id: sourceModel
+                    addNone: true
+                    noneTitle: qsTr("first measurement")
+                    unrollGroups: true
+                    list: sourceList
+                }
+                currentIndex: { model.indexOf(recorder.source) }
+                textRole: "title"
+                valueRole: "source"
+                Layout.preferredWidth: elementWidth * 2
+                onCurrentIndexChanged: {
+                    recorder.source = model.get(currentIndex);
+                }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("measurement which input is recorded")
+            }
+
+            TextField {
+                id: channelsField
+                enabled: !recorder.active
+                Layout.preferredWidth: elementWidth
+                text: recorder.channels.map(function(channel) { return channel + 1; }).join(", ")
+                validator: RegExpValidator { regExp: /^\s*\d+(\s*,\s*\d+)*\s*$/ }
+                onEditingFinished: {
+                    recorder.channels = text.split(",").map(function(channel) { return parseInt(channel) - 1; })
+                                                      .filter(function(channel) { return channel >= 0; });
+                }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("input chanels, comma separated")
+            }
+
+            FloatSpinBox {
+                Layout.preferredWidth: elementWidth
+                value: recorder.preTrigger
+                from: 0
+                to: 60
+                decimals: 1
+                step: 1
+                units: "s"
+                onValueChanged: recorder.preTrigger = value
+                tooltiptext: qsTr("pre-trigger")
+            }
+
+            SelectableSpinBox {
+                Layout.preferredWidth: elementWidth
+                value: recorder.rotation
+                from: 0
+                to: 1440
+                editable: true
+                onValueChanged: recorder.rotation = value
+                textFromValue: function(value, locale) {
+                    return value ? qsTr("%1 min").arg(value) : qsTr("one file");
+                }
+                valueFromText: function(text, locale) {
+                    return parseInt(text) || 0;
+                }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("start a new file every")
+            }
+
+            Button {
+                text: qsTr("Folder")
+                Material.background: parent.Material.background
+                onClicked: folderDialog.open()
+                ToolTip.visible: hovered
+                ToolTip.text: recorder.folder
+            }
+
+            Label {
+                Layout.fillWidth: true
+                text: (recorder.currentFile ? recorder.currentFile : "") +
+                      (recorder.overruns ? qsTr(" overruns: <b>%1</b>").arg(recorder.overruns) : "")
+                elide: Text.ElideMiddle
+                horizontalAlignment: Text.AlignHCenter
+                verticalAlignment: Text.AlignVCenter
+                textFormat: Text.RichText
+            }
+        }
+    }
+
+    FileDialog {
+        id: folderDialog
+        selectFolder: true
+        title: qsTr("Please choose a folder")
+        folder: recorder.folder
+        onAccepted: recorder.folder = folderDialog.fileUrl
+    }
+}
@@ -261,6 +261,21 @@ Item {
                 }
             }
 
+            Button {
+                text: "\u25cf"
+                flat: true
+                Material.foreground: recorder.recording ? Material.Red : Material.Grey
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("recorder")
+
+                PropertiesOpener {
+                   propertiesQml: "qrc:/RecorderProperties.qml"
+                   onClicked: {
+                       open();
+                   }
+                }
+            }
+
             Button {
                 font.family: "Osm"
                 text: "\ue807"
@@ -72,6 +72,14 @@ ListView {
             highlight: modelHighlight
         }
     }
+    Component {
+        id: filterChainDelegate
+        FilterChain {
+            width: sideList.width
+            dataModel: modelData
+            highlight: modelHighlight
+        }
+    }
     Component {
         id: windowingDelegate
         Windowing {
@@ -170,7 +178,7 @@ ListView {
                 swipeStart = mouseX;
             }
             onDoubleClicked: {
-                if ((model.name === "Group" || model.name === "RemoteGroup") && source.data) {
+                if ((model.name === "Group" || model.name === "MultiMeasurement" || model.name === "RemoteGroup") && source.data) {
                     applicationWindow.dataSourceList.list.openGroup(source);
                 }
             }
@@ -203,8 +211,11 @@ ListView {
                                 case "Union": return unionDelegate;
                                 case "StandardLine": return standardLineDelegate;
                                 case "Filter": return filterDelegate;
+                                case "FilterChain": return filterChainDelegate;
                                 case "Windowing": return windowingDelegate;
-                                case "Group": return groupDelegate;
+                                case "Group":
+                                case "MultiMeasurement":
+                                    return groupDelegate;
 
                                 case "RemoteItem":
                                 case "RemoteGroup":
@@ -61,6 +61,46 @@ Item {
                 tooltiptext: qsTr("SPL offset")
             }
 
+            Label {
+                id: deviationLabel
+                property var deviation: ({})
+                Layout.leftMargin: 10
+                text: deviation.valid ?
+                          qsTr("rms %1 dB max %2 dB %3")
+                            .arg(deviation.rms.toFixed(1))
+                            .arg(deviation.max.toFixed(1))
+                            .arg(deviation.pass ? qsTr("pass") : qsTr("fail")) :
+                          ""
+                color: deviation.valid && !deviation.pass ? Material.color(Material.Red) : Material.foreground
+
+                function failed() {
+                    let list = [];
+                    for (let band of (deviation.bands || [])) {
+                        if (!band.pass) {
+                            list.push(band.frequency.toFixed(0) + " Hz: " + band.max.toFixed(1) + " dB");
+                        }
+                    }
+                    return list.join("\n");
+                }
+
+                MouseArea {
+                    id: deviationArea
+                    anchors.fill: parent
+                    hoverEnabled: true
+                }
+                ToolTip.visible: deviationArea.containsMouse && deviation.valid
+                ToolTip.text: qsTr("deviation of the selected source from the target in 1/3 octave bands") +
+                              (deviation.pass ? "" : "\n" + failed())
+
+                Timer {
+                    interval: 500
+                    running: deviationLabel.visible && targetTraceModel.active
+                    repeat: true
+                    triggeredOnStart: true
+                    onTriggered: deviationLabel.deviation = targetTraceModel.deviationMap(sourceList.selected, 3)
+                }
+            }
+
             Rectangle {
                 Layout.fillWidth: true
             }
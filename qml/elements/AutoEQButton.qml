@@ -0,0 +1,99 @@
+/**
+ *  OSM
+ *  Copyright (C) 2022  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.13
+import QtQuick.Controls 2.13
+import QtQuick.Layouts 1.3
+import QtQuick.Controls.Material 2.12
+
+Button {
+    id: control
+    property var source
+    text: qsTr("auto EQ")
+
+    ToolTip.visible: hovered
+    ToolTip.text: qsTr("fit filters to the target curve")
+
+    onClicked: popup.open()
+
+    Popup {
+        id: popup
+        modal: true
+        focus: true
+        closePolicy: Popup.CloseOnEscape | Popup.CloseOnPressOutside
+        y: -height
+
+        RowLayout {
+            FloatSpinBox {
+                id: fromSpinBox
+                implicitWidth: 150
+                value: 40
+                from: 10
+                to: 20000
+                step: 1
+                decimals: 0
+                units: "Hz"
+                tooltiptext: qsTr("lowest frequency")
+            }
+
+            FloatSpinBox {
+                id: toSpinBox
+                implicitWidth: 150
+                value: 16000
+                from: 20
+                to: 24000
+                step: 1
+                decimals: 0
+                units: "Hz"
+                tooltiptext: qsTr("highest frequency")
+            }
+
+            FloatSpinBox {
+                id: coherenceSpinBox
+                implicitWidth: 120
+                value: 0.7
+                from: 0
+                to: 1
+                step: 0.05
+                decimals: 2
+                units: ""
+                tooltiptext: qsTr("coherence threshold")
+            }
+
+            FloatSpinBox {
+                id: bandsSpinBox
+                implicitWidth: 120
+                value: 16
+                from: 1
+                to: 32
+                step: 1
+                decimals: 0
+                units: ""
+                tooltiptext: qsTr("maximum number of bands")
+            }
+
+            Button {
+                text: qsTr("fit")
+                onClicked: {
+                    sourceList.autoEQ(control.source, fromSpinBox.value, toSpinBox.value,
+                                      coherenceSpinBox.value, Math.round(bandsSpinBox.value));
+                    popup.close();
+                }
+            }
+        }
+    }
+}
@@ -172,13 +172,18 @@ ApplicationWindow {
         anchors.centerIn: parent
     }
 
+    Export {
+        id: exportPopup
+        anchors.centerIn: parent
+    }
+
     FileDialog {
         id: saveDialog
         selectExisting: false
         title: qsTr("Please choose a file's name")
         folder: (typeof shortcuts !== 'undefined' ? shortcuts.home : Filesystem.StandardFolder.Home)
         defaultSuffix: "osm"
-        nameFilters: ["Open Sound Meter (*.osm)"]
+        nameFilters: ["Open Sound Meter (*.osm)", "Open Sound Meter JSON (*.json)"]
         onAccepted: sourceList.save(saveDialog.fileUrl);
     }
 
@@ -188,7 +193,7 @@ ApplicationWindow {
         title: qsTr("Please choose a file's name")
         folder: (typeof shortcuts !== 'undefined' ? shortcuts.home : Filesystem.StandardFolder.Home)
         defaultSuffix: "osm"
-        nameFilters: ["Open Sound Meter (*.osm)"]
+        nameFilters: ["Open Sound Meter (*.osm *.json)"]
         onAccepted: function() {
             applicationWindow.properiesbar.clear();
             if (!sourceList.load(openDialog.fileUrl)) {
@@ -200,6 +205,7 @@ ApplicationWindow {
     FileDialog {
         id: importDialog
         selectExisting: true
+        selectMultiple: true
         title: qsTr("Please choose a file's name")
         folder: (typeof shortcuts !== 'undefined' ? shortcuts.home : Filesystem.StandardFolder.Home)
         defaultSuffix: "txt"
@@ -212,7 +218,10 @@ ApplicationWindow {
         ]
         onAccepted: function() {
             applicationWindow.properiesbar.clear();
-            if (!sourceList.import(importDialog.fileUrl, nameFilters.indexOf(selectedNameFilter))) {
+            var type = nameFilters.indexOf(selectedNameFilter);
+            if (importDialog.fileUrls.length > 1) {
+                sourceList.importFiles(importDialog.fileUrls, type);
+            } else if (!sourceList.import(importDialog.fileUrl, type)) {
                 message.showError(qsTr("could not open the file"));
             }
         }
@@ -62,6 +62,10 @@ Drawer {
         ListElement {
             name: qsTr("Import")
             onclick: function() {importDialog.open();}
+        }
+        ListElement {
+            name: qsTr("Export")
+            onclick: function() {exportPopup.open();}
             separator: true
         }
 
@@ -81,6 +85,10 @@ Drawer {
             name: qsTr("Add filter")
             onclick: function() {sourceList.addFilter();}
         }
+        ListElement {
+            name: qsTr("Add filter chain")
+            onclick: function() {sourceList.addFilterChain();}
+        }
         ListElement {
             name: qsTr("Add windowing")
             onclick: function() {sourceList.addWindowing();}
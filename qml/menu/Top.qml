@@ -167,11 +167,19 @@ MenuBar {
             shortcut: "Ctrl+I"
             onTriggered: importDialog.open()
         }
+        MenuItem {
+            text: qsTr("&Export")
+            onTriggered: exportPopup.open()
+        }
         MenuItem {
             text: qsTr("&Add measurement")
             shortcut: "Ctrl+A"
             onTriggered: sourceList.addMeasurement();
         }
+        MenuItem {
+            text: qsTr("Add &multichannel measurement")
+            onTriggered: sourceList.addMultiMeasurement();
+        }
         MenuItem {
             text: qsTr("&Add math source")
             shortcut: "Ctrl+M"
@@ -187,6 +195,10 @@ MenuBar {
             shortcut: "Ctrl+F"
             onTriggered: sourceList.addFilter();
         }
+        MenuItem {
+            text: qsTr("&Add filter chain")
+            onTriggered: sourceList.addFilterChain();
+        }
         MenuItem {
             text: qsTr("&Add windowing")
             shortcut: "Ctrl+W"
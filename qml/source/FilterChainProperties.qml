@@ -0,0 +1,267 @@
+/**
+ *  OSM
+ *  Copyright (C) 2022  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.13
+import QtQuick.Controls 2.13
+import QtQuick.Layouts 1.3
+import OpenSoundMeter 1.0
+import Measurement 1.0
+import "qrc:/elements"
+
+Item {
+    property var dataObject
+    property var dataObjectData : dataObject.data
+    readonly property int elementWidth: 200//width / 9
+    property int stageIndex: 0
+    property var current: ({})
+    readonly property bool hasStage: dataObjectData.count > 0
+
+    function refresh() {
+        stageIndex = Math.max(0, Math.min(stageIndex, dataObjectData.count - 1));
+        current = dataObjectData.stage(stageIndex);
+        stageSelect.currentIndex = stageIndex;
+        selectOrder.model = hasStage ? dataObjectData.orders(current.type) : [];
+    }
+
+    function setStage(key, value) {
+        if (hasStage && current[key] !== value) {
+            dataObjectData.setStage(stageIndex, key, value);
+        }
+    }
+
+    Connections {
+        target: dataObjectData
+        function onStagesChanged() {
+            refresh();
+        }
+    }
+    Component.onCompleted: refresh();
+
+    ColumnLayout {
+        spacing: 0
+        anchors.fill: parent
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            DropDown {
+                id: modeSelect
+                model: dataObjectData.modes
+                currentIndex: dataObjectData.mode
+                displayText: (dataObjectData.mode === Measurement.LFT ? "LTW" : (modeSelect.width > 120 ? "Power:" : "") + currentText)
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("Transfrom mode")
+                onCurrentIndexChanged: dataObjectData.mode = currentIndex;
+                Layout.preferredWidth: elementWidth
+            }
+
+            DropDown {
+                model: [44100, 48000, 96000, 192000]
+                currentIndex: model.indexOf(dataObjectData.sampleRate)
+                onCurrentValueChanged: dataObjectData.sampleRate = currentValue;
+
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("Sample rate")
+                Layout.preferredWidth: elementWidth
+            }
+
+            ColorPicker {
+                id: colorPicker
+                Layout.preferredWidth: 25
+                Layout.preferredHeight: 25
+                Layout.margins: 0
+
+                onColorChanged: {
+                    dataObjectData.color = color
+                }
+
+                Component.onCompleted: {
+                    color = dataObjectData.color
+                }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("series color")
+            }
+
+            NameField {
+                id:titleField
+                target: dataObject
+                onTextEdited: dataObjectData.autoName = false;
+                Layout.preferredWidth: elementWidth - 30
+                Layout.minimumWidth: 100
+                Layout.alignment: Qt.AlignVCenter
+            }
+
+            RowLayout {
+                Layout.fillWidth: true
+            }
+        }
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            DropDown {
+                id: stageSelect
+                model: dataObjectData.stageNames
+                enabled: hasStage
+                displayText: hasStage ? currentText : qsTr("no stages")
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("stage")
+                onActivated: function(index) {
+                    stageIndex = index;
+                    refresh();
+                }
+                Layout.preferredWidth: elementWidth
+            }
+
+            Button {
+                text: "+"
+                implicitWidth: 30
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("add stage of the same type")
+                onClicked: {
+                    var index = dataObjectData.addStage(hasStage ? current.type : 0);
+                    if (index >= 0) {
+                        stageIndex = index;
+                        refresh();
+                    }
+                }
+            }
+
+            Button {
+                text: "−"
+                implicitWidth: 30
+                enabled: hasStage
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("remove stage")
+                onClicked: dataObjectData.removeStage(stageIndex);
+            }
+
+            CheckBox {
+                text: qsTr("on")
+                enabled: hasStage
+                checked: hasStage && current.enabled
+                onToggled: setStage("enabled", checked);
+
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("stage is used")
+            }
+
+            DropDown {
+                model: dataObjectData.types
+                enabled: hasStage
+                currentIndex: hasStage ? current.type : -1
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("Filter type")
+                onActivated: function(index) {
+                    setStage("type", index);
+                }
+                Layout.preferredWidth: elementWidth
+            }
+
+            DropDown {
+                id: selectOrder
+                enabled: hasStage
+                currentIndex: hasStage ? model.indexOf(current.order) : -1
+                onActivated: setStage("order", currentValue);
+
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("order")
+                Layout.preferredWidth: elementWidth
+            }
+
+            FloatSpinBox {
+                value: hasStage ? current.frequency : 1000
+                from: 1
+                to: 96000
+                decimals: 1
+                step: 1
+                units: "Hz"
+                onValueChanged: setStage("frequency", value);
+
+                visible: current.type != 10
+                enabled: hasStage
+
+                tooltiptext: qsTr("frequency")
+                Layout.preferredWidth: elementWidth
+            }
+
+            FloatSpinBox {
+                value: hasStage ? current.gain : 0
+                from: -90
+                to: 90
+                decimals: 1
+                step: 0.1
+                units: "dB"
+                onValueChanged: setStage("gain", value);
+
+                visible: current.type >= 7 && current.type <= 9
+
+                tooltiptext: qsTr("gain")
+                Layout.preferredWidth: elementWidth
+            }
+
+            FloatSpinBox {
+                value: hasStage ? current.q : 0.7
+                from: 0.1
+                to: 10
+                decimals: 1
+                step: 0.1
+                units: ""
+                onValueChanged: setStage("q", value);
+
+                visible: current.type >= 7 && current.type <= 9
+
+                tooltiptext: qsTr("Q")
+                Layout.preferredWidth: elementWidth
+            }
+
+            FloatSpinBox {
+                value: hasStage ? current.delay : 0
+                from: -1000
+                to: 1000
+                decimals: 2
+                step: 0.01
+                units: "ms"
+                onValueChanged: setStage("delay", value);
+
+                visible: current.type == 10
+
+                tooltiptext: qsTr("delay")
+                Layout.preferredWidth: elementWidth
+            }
+
+            Item {
+                Layout.fillWidth: true
+            }
+
+            Button {
+                text: qsTr("Store");
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("store current measurement")
+                implicitWidth: 75
+
+                onClicked: {
+                    var stored = dataObjectData.store();
+                    if (stored) {
+                        stored.data.active = true;
+                        sourceList.appendItem(stored, true);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -129,6 +129,8 @@ Item {
                 units: "Hz"
                 onValueChanged: dataObjectData.cornerFrequency = value
 
+                visible: dataObjectData.type != 10
+
                 tooltiptext: qsTr("frequency")
                 Layout.preferredWidth: elementWidth
             }
@@ -142,7 +144,7 @@ Item {
                 units: "dB"
                 onValueChanged: dataObjectData.gain = value
 
-                visible: dataObjectData.type == 7
+                visible: dataObjectData.type >= 7 && dataObjectData.type <= 9
 
                 tooltiptext: qsTr("gain")
                 Layout.preferredWidth: elementWidth
@@ -157,12 +159,27 @@ Item {
                 units: ""
                 onValueChanged: dataObjectData.q = value
 
-                visible: dataObjectData.type == 7
+                visible: dataObjectData.type >= 7 && dataObjectData.type <= 9
 
                 tooltiptext: qsTr("Q")
                 Layout.preferredWidth: elementWidth
             }
 
+            FloatSpinBox {
+                value: dataObjectData.delay
+                from: -1000
+                to: 1000
+                decimals: 2
+                step: 0.01
+                units: "ms"
+                onValueChanged: dataObjectData.delay = value
+
+                visible: dataObjectData.type == 10
+
+                tooltiptext: qsTr("delay")
+                Layout.preferredWidth: elementWidth
+            }
+
             Item {
                 Layout.fillWidth: true
             }
@@ -27,7 +27,9 @@ Item {
     property var sharedGroup : dataModel.data
     property bool chartable : false;
     property bool highlight : false;
-    property string propertiesQml: "qrc:/source/GroupProperties.qml"
+    property string propertiesQml: (sharedGroup && sharedGroup.objectName === "MultiMeasurement" ?
+                                        "qrc:/source/MultiMeasurementProperties.qml" :
+                                        "qrc:/source/GroupProperties.qml")
 
     width: parent.width
     height: 50
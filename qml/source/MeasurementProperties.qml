@@ -341,6 +341,19 @@ Item {
                 Layout.preferredWidth: elementWidth
             }
 
+            Button {
+                enabled: isLocal
+                checkable: true
+                checked: dataObjectData.driftCompensation
+                onCheckedChanged: dataObjectData.driftCompensation = checked
+                text: checked ? qsTr("%L1 ppm").arg(Number(dataObjectData.clockDrift).toLocaleString(locale, 'f', 1)) : qsTr("drift")
+                Layout.preferredWidth: elementWidth
+                Material.background: parent.Material.background
+
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("follow the generator clock on the Loop chanel when it runs on another device")
+            }
+
             DropDown {
                 id: deviceSelect
                 enabled: isLocal
@@ -393,6 +406,49 @@ Item {
                 implicitWidth: 75
             }
 
+            Button {
+                id: analyseButton
+                enabled: isLocal
+                text: qsTr("Files");
+                onClicked: analyseDialog.open()
+                ToolTip.visible: hovered
+                ToolTip.text: analysisProgress.visible ?
+                                  qsTr("analysing %1").arg(analysisProgress.fileName) :
+                                  qsTr("analyse recorded wav files with the settings of this measurement")
+                implicitWidth: 75
+
+                ProgressBar {
+                    id: analysisProgress
+                    property string fileName
+                    anchors.left: parent.left
+                    anchors.right: parent.right
+                    anchors.bottom: parent.bottom
+                    anchors.margins: 6
+                    visible: false
+                    from: 0
+                    to: 1
+                }
+
+                Connections {
+                    target: sourceList
+                    function onAnalysisProgress(fileName, value) {
+                        analysisProgress.fileName = fileName;
+                        analysisProgress.value = value;
+                        analysisProgress.visible = value < 1;
+                    }
+                }
+
+                FileDialog {
+                    id: analyseDialog
+                    selectExisting: true
+                    selectMultiple: true
+                    title: qsTr("Please choose files to analyse")
+                    folder: (typeof shortcuts !== 'undefined' ? shortcuts.home : Filesystem.StandardFolder.Home)
+                    nameFilters: ["wav files (*.wav)"]
+                    onAccepted: sourceList.analyseFiles(analyseDialog.fileUrls, dataObject)
+                }
+            }
+
             Shortcut {
                 sequence: "Ctrl+C"
                 onActivated: measurementProperties.store()
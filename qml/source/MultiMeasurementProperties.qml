@@ -0,0 +1,176 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.13
+import QtQuick.Controls 2.13
+import QtQuick.Layouts 1.3
+import OpenSoundMeter 1.0
+import Measurement 1.0
+import Audio 1.0
+import "qrc:/elements"
+
+Item {
+    property var dataObject
+    property var dataObjectData : dataObject.data
+    readonly property int elementWidth: width / 9
+
+    //"1-4, 6" <-> [0, 1, 2, 3, 5]
+    function chanelsToText(chanels) {
+        return chanels.map(function(c) { return c + 1; }).join(", ");
+    }
+    function textToChanels(text) {
+        var chanels = [];
+        text.split(",").forEach(function(part) {
+            var range = part.split("-").map(function(v) { return parseInt(v) - 1; });
+            if (isNaN(range[0])) {
+                return;
+            }
+            var last = range.length > 1 && !isNaN(range[1]) ? range[1] : range[0];
+            for (var c = range[0]; c <= last; ++c) {
+                if (c >= 0) chanels.push(c);
+            }
+        });
+        return chanels;
+    }
+
+    ColumnLayout {
+        spacing: 0
+        anchors.fill: parent
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            ColorPicker {
+                id: colorPicker
+                Layout.preferredWidth: 25
+                Layout.preferredHeight: 25
+                Layout.margins: 0
+
+                onColorChanged: {
+                    dataObjectData.color = color
+                }
+
+                Component.onCompleted: {
+                    color = dataObjectData.color
+                }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("series color")
+            }
+
+            NameField {
+                id:titleField
+                target: dataObject
+                Layout.preferredWidth: elementWidth
+                Layout.alignment: Qt.AlignVCenter
+            }
+
+            TextField {
+                id: dataChanels
+                Layout.fillWidth: true
+                text: chanelsToText(dataObjectData.dataChanels)
+                placeholderText: qsTr("1-8, 10")
+                onEditingFinished: dataObjectData.dataChanels = textToChanels(text)
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("measurement chanel numbers")
+            }
+
+            Label {
+                text: qsTr("R: %1 dB").arg(dataObjectData.referenceLevel.toFixed(1))
+                Layout.preferredWidth: elementWidth
+            }
+        }
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            DropDown {
+                id: modeSelect
+                model: dataObjectData.modes
+                currentIndex: dataObjectData.mode
+                displayText: (dataObjectData.mode === Measurement.LFT ? "LTW" : (modeSelect.width > 120 ? "Power:" : "") + currentText)
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("Transfrom mode")
+                onCurrentIndexChanged: dataObjectData.mode = currentIndex;
+                Layout.preferredWidth: elementWidth
+            }
+
+            DropDown {
+                id: windowSelect
+                model: dataObjectData.windows
+                currentIndex: dataObjectData.window
+                onCurrentIndexChanged: dataObjectData.window = currentIndex
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("window function")
+                Layout.preferredWidth: elementWidth
+            }
+
+            DropDown {
+                id: inputFilterSelect
+                model: dataObjectData.inputFilters
+                currentIndex: dataObjectData.inputFilter
+                onCurrentIndexChanged: dataObjectData.inputFilter = currentIndex
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("apply filter on inputs")
+                Layout.preferredWidth: elementWidth
+            }
+
+            DropDown {
+                id: referenceChannel
+                currentIndex: dataObjectData.referenceChanel
+                onCurrentIndexChanged: dataObjectData.referenceChanel = currentIndex
+                displayText: "R: " + currentText
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("reference chanel number")
+                Layout.preferredWidth: elementWidth
+            }
+
+            DropDown {
+                id: deviceSelect
+                Layout.fillWidth: true
+                model: DeviceModel {
+                    id: deviceModel
+                    scope: DeviceModel.InputOnly
+                }
+                textRole: "name"
+                valueRole: "id"
+                currentIndex: { model.indexOf(dataObjectData.deviceId) }
+                ToolTip.visible: hovered
+                ToolTip.text: qsTr("audio input device")
+                onCurrentIndexChanged: {
+                    var referenceIndex = referenceChannel.currentIndex;
+                    var channelNames = deviceModel.channelNames(deviceSelect.currentIndex);
+                    channelNames.push("Loop");
+                    dataObjectData.deviceId = model.deviceId(currentIndex);
+                    referenceChannel.model = channelNames;
+                    referenceChannel.currentIndex = referenceIndex < channelNames.length + 1 ? referenceIndex : -1;
+                }
+
+                Connections {
+                    target: deviceModel
+                    function onModelReset() {
+                        deviceSelect.currentIndex = deviceModel.indexOf(dataObjectData.deviceId);
+                        var referenceIndex = referenceChannel.currentIndex;
+                        var channelNames = deviceModel.channelNames(deviceSelect.currentIndex);
+                        channelNames.push("Loop");
+                        referenceChannel.model = channelNames;
+                        referenceChannel.currentIndex = referenceIndex < channelNames.length + 1 ? referenceIndex : -1;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -121,11 +121,28 @@ Item {
                     ToolTip.text: qsTr("ignore coherence")
                 }
 
+                Button {
+                    text: qsTr("compact")
+                    checkable: true
+                    checked: dataObjectData.compact
+                    onCheckedChanged: dataObjectData.compact = checked
+
+                    Material.background: parent.Material.background
+
+                    ToolTip.visible: hovered
+                    ToolTip.text: qsTr("keep data quantised in memory")
+                }
+
+                AutoEQButton {
+                    source: dataObjectData.uuid()
+                    Material.background: parent.Material.background
+                }
+
                 DropDown {
                     displayText: qsTr("Save data as");
 
                     implicitWidth: 170
-                    model: ["osm", "cal", "txt", "csv", "frd", "wav"]
+                    model: ["osm", "json", "cal", "txt", "csv", "frd", "wav"]
 
                     onActivated: function() {
                         saveas = currentText;
@@ -180,6 +197,7 @@ Item {
         onAccepted: {
             switch (saveas) {
                 case "osm":
+                case "json":
                     dataObjectData.save(fileDialog.fileUrl);
                     break;
                 case "cal":
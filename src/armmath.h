@@ -85,6 +85,16 @@ __attribute__((aligned(16))) inline v4sf _mm_load_ps( float *source )
     return _mm_set_ps(source[3], source[2], source[1], source[0]);
 }
 
+__attribute__((aligned(16))) inline v4sf _mm_loadu_ps(const float *source)
+{
+    return vld1q_f32(source);
+}
+
+__attribute__((aligned(16))) inline void _mm_storeu_ps(float *dest, const v4sf &source)
+{
+    vst1q_f32(dest, source);
+}
+
 
 #define _mm_shuffle_ps(a, b, imm8) \
 __extension__({ \
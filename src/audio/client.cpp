@@ -39,6 +39,8 @@
 #include "plugins/asioplugin.h"
 #endif
 
+#include "plugins/virtualplugin.h"
+
 namespace audio {
 
 QSharedPointer<Client> Client::m_instance = nullptr;
@@ -69,6 +71,11 @@ Client::Client() : QObject(), m_plugins(), m_deviceList()
 
 void Client::initPlugins()
 {
+    //virtual devices go first to become the default ones
+    if (VirtualPlugin::enabled()) {
+        m_plugins.push_back(QSharedPointer<Plugin>(new VirtualPlugin()));
+    }
+
 #ifdef Q_OS_MACOS
     m_plugins.push_back(QSharedPointer<Plugin>(new CoreaudioPlugin()));
 #endif
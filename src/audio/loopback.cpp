@@ -0,0 +1,203 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "loopback.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <QtMath>
+
+namespace audio {
+
+Loopback::Loopback() : m_data(SIZE),
+    m_epoch(0), m_sampleRate(48000),
+    m_stampSequence(0), m_stampPosition(0), m_stampTime(0), m_origin(0)
+{
+}
+
+Loopback *Loopback::getInstance()
+{
+    static Loopback instance;
+    return &instance;
+}
+
+void Loopback::reset(unsigned int sampleRate) noexcept
+{
+    if (sampleRate) {
+        m_sampleRate.store(sampleRate);
+    }
+    m_stampTime.store(0, std::memory_order_relaxed);
+    m_epoch.fetch_add(1, std::memory_order_release);
+}
+
+void Loopback::write(const float *data, std::size_t count) noexcept
+{
+    std::chrono::duration<double> now = clock::now().time_since_epoch();
+    auto begin = m_data.written();
+    m_data.write(data, count);
+
+    //the block starts where the sample count says, the callback time moves the origin slowly
+    const double rate = sampleRate();
+    auto error = now.count() - (m_origin + begin / rate);
+    if (!m_stampTime.load(std::memory_order_relaxed) || std::abs(error) > STAMP_TIMEOUT) {
+        //the first block after a reset or after the output was stalled
+        m_origin = now.count() - begin / rate;
+    } else {
+        m_origin += std::min(1.0, count / rate / STAMP_FILTER_TIME) * error;
+    }
+    auto time = std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>(m_origin + begin / rate)).count();
+
+    //the stamp always points to the first sample of the block
+    m_stampSequence.fetch_add(1, std::memory_order_relaxed);
+    //the odd sequence is visible before the data
+    std::atomic_thread_fence(std::memory_order_release);
+    m_stampPosition.store(begin, std::memory_order_relaxed);
+    m_stampTime.store(time, std::memory_order_relaxed);
+    m_stampSequence.fetch_add(1, std::memory_order_release);
+}
+
+bool Loopback::read(Reader &reader, float *data, std::size_t count, clock::time_point captured) const noexcept
+{
+    auto epoch = m_epoch.load(std::memory_order_acquire);
+    if (reader.epoch != epoch) {
+        //the generator was reopened, maybe on another device
+        reader.drift = 0;
+    }
+    if (!reader.synced || reader.epoch != epoch) {
+        reader.epoch = epoch;
+        align(reader, count, captured);
+    }
+
+    auto written = m_data.written();
+    auto lag = static_cast<int64_t>(written - reader.position);
+    if (lag > static_cast<int64_t>(SIZE - count) || lag < -static_cast<int64_t>(SIZE / 4)) {
+        align(reader, count, captured);
+        lag = static_cast<int64_t>(written - reader.position);
+    }
+
+    if (!reader.compensate) {
+        return fetch(reader, data, count, lag);
+    }
+
+    auto required = follow(reader, count, captured);
+    if (reader.buffer.size() < required) {
+        reader.buffer.resize(required);
+    }
+    auto result = fetch(reader, reader.buffer.data(), required, lag);
+    reader.resampler.process(reader.buffer.data(), required, data, count);
+    return result;
+}
+
+unsigned int Loopback::sampleRate() const noexcept
+{
+    return m_sampleRate.load(std::memory_order_relaxed);
+}
+
+Loopback::Stamp Loopback::stamp() const noexcept
+{
+    Stamp stamp {};
+    unsigned int begin, end;
+    do {
+        begin = m_stampSequence.load(std::memory_order_acquire);
+        stamp.position = m_stampPosition.load(std::memory_order_relaxed);
+        stamp.time = m_stampTime.load(std::memory_order_relaxed);
+        //the data is loaded before the sequence is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        end = m_stampSequence.load(std::memory_order_relaxed);
+    } while (begin != end || (begin & 1));
+    return stamp;
+}
+
+void Loopback::align(Reader &reader, std::size_t count, clock::time_point captured) const noexcept
+{
+    auto written = m_data.written();
+    auto last = stamp();
+    reader.synced = true;
+    reader.tracking = false;
+
+    if (!last.time) {
+        reader.position = written;
+        return;
+    }
+
+    //captured is the time of the end of the input block
+    std::chrono::duration<double> elapsed = captured - clock::time_point(clock::duration(last.time));
+    auto shift = static_cast<int64_t>(std::llround(elapsed.count() * sampleRate())) - static_cast<int64_t>(count);
+    auto target = static_cast<int64_t>(last.position) + shift;
+
+    auto oldest = static_cast<int64_t>(written) - static_cast<int64_t>(SIZE - count);
+    target = std::clamp(target, std::max<int64_t>(oldest, 0), static_cast<int64_t>(written));
+    reader.position = static_cast<uint64_t>(target);
+}
+
+bool Loopback::fetch(Reader &reader, float *data, std::size_t count, int64_t lag) const noexcept
+{
+    std::size_t available = lag > 0 ? std::min(count, static_cast<std::size_t>(lag)) : 0;
+    //the writer could overtake the reader while copying
+    if (available && !m_data.read(reader.position, data, available)) {
+        std::fill(data, data + count, 0.f);
+        reader.synced = false;
+        return false;
+    }
+    std::fill(data + available, data + count, 0.f);
+
+    reader.position += count;
+    return available > 0;
+}
+
+std::size_t Loopback::follow(Reader &reader, std::size_t count, clock::time_point captured) const noexcept
+{
+    const double rate = sampleRate();
+    const double dt = count / rate;
+
+    //the writer works with blocks, so the written counter is a staircase. When both devices use
+    //the same block size its steps stay in phase with reads, so the position of the writer
+    //is interpolated by the block stamp to the time the input block was captured.
+    auto last = stamp();
+    std::chrono::duration<double> elapsed = captured - clock::time_point(clock::duration(last.time));
+    if (!last.time || elapsed.count() > STAMP_TIMEOUT || elapsed.count() < -STAMP_TIMEOUT) {
+        //the generator is stopped: hold the estimated drift
+        reader.tracking = false;
+        reader.resampler.setRatio(1 + reader.drift);
+        return reader.resampler.required(count);
+    }
+    auto writer = static_cast<double>(last.position) + elapsed.count() * rate;
+    auto lag = writer - static_cast<double>(reader.position);
+
+    if (!reader.tracking) {
+        //the first block after a reset takes the resampler history, keep the lag that remains after it
+        reader.tracking = true;
+        reader.resampler.reset();
+        reader.error = 0;
+        reader.target = std::llround(lag) - static_cast<int64_t>(math::Resampler::HALF);
+    }
+
+    auto error = lag - static_cast<double>(reader.target);
+    reader.error += std::min(1.0, dt / DRIFT_FILTER_TIME) * (error - reader.error);
+
+    //critically damped PI loop: s^2 + 2ws + w^2
+    const double omega = 2 * M_PI * DRIFT_BANDWIDTH;
+    reader.drift += omega * omega / rate * reader.error * dt;
+    reader.drift = std::clamp(reader.drift, -MAX_DRIFT, MAX_DRIFT);
+
+    auto ratio = 1 + reader.drift + 2 * omega / rate * reader.error;
+    reader.resampler.setRatio(std::clamp(ratio, 1 - 2 * MAX_DRIFT, 1 + 2 * MAX_DRIFT));
+    return reader.resampler.required(count);
+}
+
+} // namespace audio
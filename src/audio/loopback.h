@@ -0,0 +1,118 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIO_LOOPBACK_H
+#define AUDIO_LOOPBACK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "container/ringbuffer.h"
+#include "math/resampler.h"
+
+namespace audio {
+
+/**
+ * @brief The Loopback class
+ * single writer (generator output thread), many readers (measurement input threads).
+ * The generator writes a whole block at once and stamps it with the time it was handed to the output.
+ * Stamps are counted from the written samples at the device rate. The callback time only corrects them
+ * slowly, so the scheduling jitter of the output callback doesn't get into them.
+ * Each reader keeps its own position: it is aligned once by timestamps and then advanced by
+ * exactly the number of captured frames, so the loop latency stays constant between blocks.
+ *
+ * When the generator and the input are different devices their clocks drift apart and the lag
+ * between the writer and a reader walks away. A reader with compensate set keeps its lag constant:
+ * a PI loop estimates the clock ratio from the lag at the capture time and the resampler follows it.
+ */
+class Loopback
+{
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr std::size_t SIZE = 1 << 18;
+
+    static constexpr double DRIFT_BANDWIDTH   = 0.02;   //Hz, natural frequency of the drift loop
+    static constexpr double DRIFT_FILTER_TIME = 1.0;    //s, smoothing of the block-wise lag
+    static constexpr double MAX_DRIFT         = 1e-3;   //1000 ppm
+    static constexpr double STAMP_TIMEOUT     = 0.5;    //s, older stamps mean the generator is stopped
+    static constexpr double STAMP_FILTER_TIME = 1.0;    //s, smoothing of the stamps against the callback time
+
+    struct Reader {
+        uint64_t position = 0;
+        unsigned int epoch = 0;
+        bool synced = false;
+
+        //drift compensation
+        bool compensate = false;
+        bool tracking = false;
+        int64_t target = 0;     //lag kept by the loop
+        double error = 0;       //smoothed lag error, samples
+        double drift = 0;       //estimated relative clock difference of the generator
+        math::Resampler resampler;
+        std::vector<float> buffer;
+
+        void reset() noexcept
+        {
+            synced = false;
+        }
+
+        //! positive when the generator clock runs faster than the input one
+        double ppm() const noexcept
+        {
+            return compensate ? drift * 1e6 : 0;
+        }
+    };
+
+    static Loopback *getInstance();
+
+    //! called by the generator every time output stream was (re)opened
+    void reset(unsigned int sampleRate) noexcept;
+
+    //! writer side, must be called from one thread only
+    void write(const float *data, std::size_t count) noexcept;
+
+    //! reads count samples for an input block captured at time. Missing samples are zeroes.
+    bool read(Reader &reader, float *data, std::size_t count, clock::time_point captured) const noexcept;
+
+    unsigned int sampleRate() const noexcept;
+
+private:
+    Loopback();
+
+    struct Stamp {
+        uint64_t position;
+        clock::rep time;
+    };
+    Stamp stamp() const noexcept;
+    void align(Reader &reader, std::size_t count, clock::time_point captured) const noexcept;
+    bool fetch(Reader &reader, float *data, std::size_t count, int64_t lag) const noexcept;
+    std::size_t follow(Reader &reader, std::size_t count, clock::time_point captured) const noexcept;
+
+    container::ringbuffer<float> m_data;
+    std::atomic<unsigned int> m_epoch, m_sampleRate;
+
+    //seqlock for the stamp of the last written block
+    std::atomic<unsigned int> m_stampSequence;
+    std::atomic<uint64_t> m_stampPosition;
+    std::atomic<clock::rep> m_stampTime;
+    double m_origin;    //s, time of the sample zero, used by the writer only
+};
+
+} // namespace audio
+
+#endif // AUDIO_LOOPBACK_H
@@ -0,0 +1,338 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "virtualplugin.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <QFileInfo>
+#include <QThread>
+#include <QtMath>
+
+#include "common/wavfile.h"
+#include "common/wavwriter.h"
+
+namespace audio {
+
+namespace {
+
+constexpr unsigned int MAX_CHANNELS = 256;
+
+/**
+ * produces or consumes blocks of one opened virtual device on the own thread
+ */
+class VirtualWorker
+{
+public:
+    VirtualWorker(const VirtualPlugin::Device &device, QIODevice *endpoint, bool paced) :
+        m_device(device), m_endpoint(endpoint), m_thread(nullptr), m_file(), m_writer(),
+        m_random(1), m_phase(0), m_running(false), m_paced(paced)
+    {
+    }
+
+    ~VirtualWorker()
+    {
+        m_running = false;
+        if (m_thread) {
+            m_thread->wait();
+            delete m_thread;
+        }
+        m_writer.close();
+    }
+
+    bool start()
+    {
+        switch (m_device.type) {
+        case VirtualPlugin::Device::File:
+            if (!m_file.load(m_device.fileName)) {
+                qWarning() << "virtual device: can't load" << m_device.fileName;
+                return false;
+            }
+            break;
+        case VirtualPlugin::Device::Record:
+            if (!m_writer.open(m_device.fileName, m_device.format.sampleRate, m_device.format.channelCount)) {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+
+        m_running = true;
+        m_thread = QThread::create([this]() {
+            run();
+        });
+        m_thread->setObjectName("VirtualAudio");
+        m_thread->start(QThread::TimeCriticalPriority);
+        return true;
+    }
+
+private:
+    void run()
+    {
+        using clock = std::chrono::steady_clock;
+        const auto frames = VirtualPlugin::BLOCK_FRAMES;
+        std::vector<float> buffer(frames * m_device.format.channelCount);
+        const auto bytes = static_cast<qint64>(buffer.size() * sizeof(float));
+        const auto period = std::chrono::duration_cast<clock::duration>(
+                                std::chrono::duration<double>(static_cast<double>(frames) / m_device.format.sampleRate));
+        const bool input = (m_device.direction() == Plugin::Input);
+
+        auto next = clock::now();
+        while (m_running) {
+            if (input) {
+                fill(buffer.data(), frames);
+                if (m_endpoint->isWritable()) {
+                    m_endpoint->write(reinterpret_cast<const char *>(buffer.data()), bytes);
+                }
+            } else {
+                std::fill(buffer.begin(), buffer.end(), 0.f);
+                if (m_endpoint->isReadable()) {
+                    m_endpoint->read(reinterpret_cast<char *>(buffer.data()), bytes);
+                }
+                if (m_writer.isOpen()) {
+                    m_writer.write(buffer.data(), frames);
+                }
+            }
+
+            if (m_paced) {
+                next += period;
+                auto now = clock::now();
+                if (next < now) {
+                    //the consumer stalled: drop the lost time like a real device does
+                    next = now;
+                }
+                std::this_thread::sleep_until(next);
+            }
+        }
+    }
+
+    void fill(float *data, unsigned int frames)
+    {
+        const auto channels = m_device.format.channelCount;
+        switch (m_device.type) {
+        case VirtualPlugin::Device::File: {
+            auto read = std::max(m_file.readFrames(data, frames, true), qint64(0));
+            std::fill(data + read * channels, data + frames * channels, 0.f);
+            break;
+        }
+        case VirtualPlugin::Device::Sine: {
+            const double step = 2 * M_PI * m_device.frequency / m_device.format.sampleRate;
+            for (unsigned int i = 0; i < frames; ++i, data += channels) {
+                std::fill_n(data, channels, static_cast<float>(0.5 * std::sin(m_phase)));
+                m_phase += step;
+                if (m_phase > 2 * M_PI) {
+                    m_phase -= 2 * M_PI;
+                }
+            }
+            break;
+        }
+        case VirtualPlugin::Device::Noise: {
+            std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+            for (unsigned int i = 0; i < frames; ++i, data += channels) {
+                std::fill_n(data, channels, distribution(m_random));
+            }
+            break;
+        }
+        default:
+            std::fill_n(data, frames * channels, 0.f);
+        }
+    }
+
+    const VirtualPlugin::Device m_device;
+    QIODevice *m_endpoint;
+    QThread *m_thread;
+    WavFile m_file;
+    WavWriter m_writer;
+    std::minstd_rand m_random;
+    double m_phase;
+    std::atomic<bool> m_running;
+    const bool m_paced;
+};
+
+QStringList channelNames(unsigned int count)
+{
+    QStringList names;
+    names.reserve(count);
+    for (unsigned int channel = 1; channel <= count; ++channel) {
+        names.push_back(QString::number(channel));
+    }
+    return names;
+}
+
+} // namespace
+
+VirtualPlugin::VirtualPlugin() : Plugin(), m_devices(), m_list(), m_default(),
+    m_paced(qgetenv(PACE_ENV).toLower() != "fast")
+{
+    auto specs = QString::fromLocal8Bit(qgetenv(DEVICES_ENV)).split(';', Qt::SkipEmptyParts);
+    for (auto &spec : specs) {
+        Device device;
+        if (!parse(spec.trimmed(), device)) {
+            qWarning() << "virtual device is skipped:" << spec;
+            continue;
+        }
+
+        DeviceInfo info(device.id, name());
+        QString deviceName;
+        switch (device.type) {
+        case Device::File:
+        case Device::Record:
+            deviceName = QFileInfo(device.fileName).fileName();
+            break;
+        case Device::Sine:
+            deviceName = QString("sine %1 Hz").arg(device.frequency);
+            break;
+        case Device::Noise:
+            deviceName = "noise";
+            break;
+        case Device::Null:
+            deviceName = "null";
+            break;
+        }
+        info.setName(QString("Virtual %1 (%2ch %3)").arg(deviceName)
+                     .arg(device.format.channelCount).arg(device.format.sampleRate));
+        info.setDefaultSampleRate(device.format.sampleRate);
+        if (device.direction() == Input) {
+            info.setInputChannels(channelNames(device.format.channelCount));
+        } else {
+            info.setOutputChannels(channelNames(device.format.channelCount));
+        }
+
+        if (m_default[device.direction()].isNull()) {
+            m_default[device.direction()] = device.id;
+        }
+        m_devices.push_back(device);
+        m_list << info;
+    }
+}
+
+bool VirtualPlugin::enabled()
+{
+    return !qEnvironmentVariableIsEmpty(DEVICES_ENV);
+}
+
+QString VirtualPlugin::name() const
+{
+    return "Virtual";
+}
+
+DeviceInfo::List VirtualPlugin::getDeviceInfoList() const
+{
+    return m_list;
+}
+
+DeviceInfo::Id VirtualPlugin::defaultDeviceId(const Plugin::Direction &mode) const
+{
+    return m_default.value(mode);
+}
+
+Format VirtualPlugin::deviceFormat(const DeviceInfo::Id &id, const Plugin::Direction &mode) const
+{
+    auto target = device(id, mode);
+    return target ? target->format : Format{};
+}
+
+Stream *VirtualPlugin::open(const DeviceInfo::Id &id, const Plugin::Direction &mode, const Format &format,
+                            QIODevice *endpoint)
+{
+    //virtual devices always run with the own format, like hardware that doesn't support another one
+    Q_UNUSED(format)
+    auto target = device(id, mode);
+    if (!target || !endpoint) {
+        return nullptr;
+    }
+
+    endpoint->open(mode == Input ? QIODevice::WriteOnly : QIODevice::ReadOnly);
+    //only inputs run fast, the consumer holds them back
+    const bool paced = m_paced || mode != Input;
+    auto worker = new VirtualWorker(*target, endpoint, paced);
+    if (!worker->start()) {
+        delete worker;
+        endpoint->close();
+        return nullptr;
+    }
+
+    auto stream = new Stream(target->format);
+    stream->setRealtime(paced);
+    connect(stream, &Stream::closeMe, this, [endpoint, stream, worker]() {
+        delete worker;
+        if (endpoint->isOpen()) {
+            endpoint->close();
+        }
+        stream->deleteLater();
+    }, Qt::DirectConnection);
+    return stream;
+}
+
+bool VirtualPlugin::parse(const QString &spec, Device &device)
+{
+    auto fields = spec.split(':');
+    auto type = fields.takeFirst().trimmed().toLower();
+    auto number = [&fields](int index) {
+        return index < fields.size() ? fields[index].toUInt() : 0u;
+    };
+
+    device.id = "virtual:" + spec;
+    if (type == "wav") {
+        device.type = Device::File;
+        device.fileName = fields.join(':');
+        WavFile file;
+        if (!file.load(device.fileName)) {
+            return false;
+        }
+        device.format.sampleRate = static_cast<unsigned int>(file.sampleRate());
+        device.format.channelCount = file.channels();
+    } else if (type == "sine" || type == "noise" || type == "null") {
+        device.type = (type == "sine" ? Device::Sine : (type == "noise" ? Device::Noise : Device::Null));
+        device.format.channelCount = number(0);
+        device.format.sampleRate = number(1);
+        if (device.type == Device::Sine && fields.size() > 2) {
+            device.frequency = fields[2].toFloat();
+        }
+    } else if (type == "record") {
+        if (fields.size() < 3) {
+            return false;
+        }
+        //the file name may contain ':', the format is taken from the end
+        device.type = Device::Record;
+        device.format.sampleRate = fields.takeLast().toUInt();
+        device.format.channelCount = fields.takeLast().toUInt();
+        device.fileName = fields.join(':');
+    } else {
+        return false;
+    }
+    return device.format.isValid() && device.format.channelCount <= MAX_CHANNELS;
+}
+
+const VirtualPlugin::Device *VirtualPlugin::device(const DeviceInfo::Id &id, const Plugin::Direction &mode) const
+{
+    auto it = std::find_if(m_devices.cbegin(), m_devices.cend(), [&id, &mode](const auto & d) {
+        return d.id == id && d.direction() == mode;
+    });
+    return it != m_devices.cend() ? &(*it) : nullptr;
+}
+
+Plugin::Direction VirtualPlugin::Device::direction() const
+{
+    return (type == Null || type == Record) ? Output : Input;
+}
+
+} // namespace audio
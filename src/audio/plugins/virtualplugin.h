@@ -0,0 +1,88 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIO_VIRTUALPLUGIN_H
+#define AUDIO_VIRTUALPLUGIN_H
+
+#include <vector>
+#include <QMap>
+#include "../plugin.h"
+
+namespace audio {
+
+/**
+ * @brief The VirtualPlugin class
+ * provides devices without any hardware: WAV files and signal generators as inputs,
+ * null and recording sinks as outputs. It makes runs reproducible on machines without sound cards.
+ *
+ * Devices are listed in OSM_VIRTUAL_DEVICES separated by ';':
+ *   wav:<file>                              input, loops the file with its own rate and channels
+ *   sine:<channels>:<rate>[:<frequency>]    input, the same sine on every channel
+ *   noise:<channels>:<rate>                 input, the same seeded white noise on every channel
+ *   null:<channels>:<rate>                  output, data is pulled and discarded
+ *   record:<file>:<channels>:<rate>         output, data is pulled and written to the file
+ *
+ * Streams are paced to real time, with OSM_VIRTUAL_PACE=fast inputs run as fast as the consumer takes them:
+ * such streams are not realtime (Stream::realtime), their measurements are transformed in the producer thread.
+ * Outputs are always paced: nothing would hold back a generator that is pulled without a clock.
+ */
+class VirtualPlugin : public Plugin
+{
+    Q_OBJECT
+
+public:
+    static constexpr const char *DEVICES_ENV    = "OSM_VIRTUAL_DEVICES";
+    static constexpr const char *PACE_ENV       = "OSM_VIRTUAL_PACE";
+    static constexpr unsigned int BLOCK_FRAMES  = 1024;
+
+    VirtualPlugin();
+
+    //! true if any virtual device is configured
+    static bool enabled();
+
+    QString name() const override;
+    DeviceInfo::List getDeviceInfoList() const override;
+    DeviceInfo::Id defaultDeviceId(const Direction &mode) const override;
+
+    Format deviceFormat(const DeviceInfo::Id &id, const Direction &mode) const override;
+    Stream *open(const DeviceInfo::Id &id, const Direction &mode, const Format &format, QIODevice *endpoint) override;
+
+    struct Device {
+        enum Type {File, Sine, Noise, Null, Record};
+
+        DeviceInfo::Id id;
+        Type type = Null;
+        QString fileName;
+        Format format;
+        float frequency = 1000.f;
+
+        Direction direction() const;
+    };
+
+private:
+    static bool parse(const QString &spec, Device &device);
+    const Device *device(const DeviceInfo::Id &id, const Direction &mode) const;
+
+    std::vector<Device> m_devices;
+    DeviceInfo::List m_list;
+    QMap<Direction, DeviceInfo::Id> m_default;
+    bool m_paced;
+};
+
+} // namespace audio
+
+#endif // AUDIO_VIRTUALPLUGIN_H
@@ -19,7 +19,7 @@
 
 namespace audio {
 
-Stream::Stream(const Format &format) : QObject(), m_active(true), m_depth(2)
+Stream::Stream(const Format &format) : QObject(), m_active(true), m_depth(2), m_realtime(true)
 {
     m_format = format;
 }
@@ -56,4 +56,14 @@ void Stream::setDepth(const size_t &depth)
     m_depth = depth;
 }
 
+bool Stream::realtime() const
+{
+    return m_realtime;
+}
+
+void Stream::setRealtime(bool realtime)
+{
+    m_realtime = realtime;
+}
+
 } // namespace audio
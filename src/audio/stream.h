@@ -39,6 +39,10 @@ public:
     size_t depth() const;
     void setDepth(const size_t &depth);
 
+    //! false if the stream isn't paced by a clock and its consumer has to keep up with every block
+    bool realtime() const;
+    void setRealtime(bool realtime);
+
 signals:
     void closeMe();
     void sampleRateChanged();
@@ -47,6 +51,7 @@ private:
     Format m_format;
     std::atomic<bool> m_active;
     size_t m_depth;
+    std::atomic<bool> m_realtime;
 };
 
 } // namespace audio
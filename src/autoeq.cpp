@@ -0,0 +1,130 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "autoeq.h"
+#include <algorithm>
+#include <cmath>
+#include <QCoreApplication>
+
+#include "filterchain.h"
+#include "targettrace.h"
+#include "common/scheduler.h"
+#include "source/source_abstract.h"
+
+AutoEQ::Result AutoEQ::fit(const Source::Shared &source, const Settings &settings)
+{
+    Result result;
+    if (!source) {
+        result.error = "no source";
+        return result;
+    }
+    if (!(settings.from > 0) || settings.to <= settings.from * 2 || !settings.bands) {
+        result.error = "wrong frequency range";
+        return result;
+    }
+
+    auto list = points(source.get(), settings);
+    if (list.size() < 3 * settings.bands) {
+        result.error = QString("not enough coherent data: %1 bands of %2 needed").arg(static_cast<int>(list.size())).arg(3 * settings.bands);
+        return result;
+    }
+
+    math::EqFit::Settings fitSettings;
+    fitSettings.bands = settings.bands;
+    fitSettings.minFrequency = settings.from;
+    fitSettings.maxFrequency = settings.to;
+    math::EqFit solver(std::move(list), fitSettings);
+
+    //the greedy start and random variations of it, the best fit wins
+    auto scheduler = Scheduler::getInstance();
+    std::vector<math::EqFit::Result> fits(std::clamp(scheduler->workers() + 1, 4u, 16u));
+    std::vector<Scheduler::Task> tasks;
+    tasks.reserve(fits.size());
+    for (unsigned int i = 0; i < fits.size(); ++i) {
+        tasks.push_back([&solver, &fits, i]() {
+            fits[i] = solver.fit(i);
+        });
+    }
+    scheduler->parallel(tasks);
+    auto &best = *std::min_element(fits.cbegin(), fits.cend(), [](const auto & a, const auto & b) {
+        return a.error < b.error;
+    });
+
+    std::vector<FilterChain::Stage> stages;
+    for (auto &filter : best.filters) {
+        FilterChain::Stage stage;
+        stage.filter = filter;
+        stages.push_back(stage);
+    }
+
+    auto chain = std::make_shared<FilterChain>();
+    chain->setName("Auto EQ " + source->name());
+    chain->setStages(std::move(stages));
+    if (auto application = QCoreApplication::instance()) {
+        chain->moveToThread(application->thread());
+    }
+
+    result.chain = chain;
+    result.rms = best.error;
+    result.success = true;
+    return result;
+}
+
+std::vector<math::EqFit::Point> AutoEQ::points(Source::Abstract *source, const Settings &settings)
+{
+    //power average of the magnitude and mean coherence in every band
+    const auto count = static_cast<std::size_t>(std::floor(PPO * std::log2(settings.to / settings.from))) + 1;
+    std::vector<double> power(count, 0), coherence(count, 0);
+    std::vector<unsigned int> bins(count, 0);
+
+    source->pageIn();
+    source->lock();
+    for (unsigned int i = 0; i < source->size(); ++i) {
+        auto frequency = source->frequency(i);
+        if (!(frequency > 0)) {
+            continue;
+        }
+        auto band = std::lround(PPO * std::log2(frequency / settings.from));
+        if (band < 0 || band >= static_cast<long>(count)) {
+            continue;
+        }
+        auto magnitude = source->magnitude(i);
+        if (!std::isfinite(magnitude)) {
+            continue;
+        }
+        power[band] += std::pow(10.0, magnitude / 10);
+        coherence[band] += source->coherence(i);
+        ++bins[band];
+    }
+    source->unlock();
+
+    auto target = TargetTrace::getInstance();
+    std::vector<math::EqFit::Point> list;
+    list.reserve(count);
+    for (std::size_t band = 0; band < count; ++band) {
+        if (!bins[band] || coherence[band] / bins[band] < settings.coherence) {
+            continue;
+        }
+        math::EqFit::Point point;
+        point.frequency = settings.from * std::pow(2.f, static_cast<float>(band) / PPO);
+        point.level = static_cast<float>(10 * std::log10(power[band] / bins[band]));
+        point.target = target->level(point.frequency);
+        point.weight = static_cast<float>(coherence[band] / bins[band]);
+        list.push_back(point);
+    }
+    return list;
+}
@@ -0,0 +1,58 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUTOEQ_H
+#define AUTOEQ_H
+
+#include <memory>
+#include <QString>
+#include "math/eqfit.h"
+#include "source/source_shared.h"
+
+class FilterChain;
+
+/**
+ * @brief The AutoEQ class
+ * fits a parametric EQ that brings a source to the target curve. The source is banded once
+ * (PPO points per octave, bands below the coherence threshold are skipped),
+ * then fits from several starts run on the Scheduler pool and the best one is returned as a filter chain.
+ */
+class AutoEQ
+{
+public:
+    static constexpr unsigned int PPO = 24;
+
+    struct Settings {
+        float from = 40, to = 16000;    //Hz
+        float coherence = 0.7f;
+        unsigned int bands = 16;
+    };
+
+    struct Result {
+        bool success = false;
+        QString error;
+        float rms = 0;                  //dB
+        std::shared_ptr<FilterChain> chain;
+    };
+
+    static Result fit(const Source::Shared &source, const Settings &settings);
+
+private:
+    static std::vector<math::EqFit::Point> points(Source::Abstract *source, const Settings &settings);
+};
+
+#endif // AUTOEQ_H
@@ -22,13 +22,13 @@ namespace Chart {
 
 SeriesItem::SeriesItem(const Source::Shared &source, QQuickItem *parent,
                        NodeConstructor nodeConstructor) : QQuickItem(parent),
-    m_source(source), m_highlighted(false), m_nodeConstructor(nodeConstructor)
+    m_source(source), m_highlighted(false), m_nodeConstructor(nodeConstructor), m_version(0)
 {
     setFlag(QQuickItem::ItemHasContents, true);
     setSize(parent->size());
 
     connect(source.get(), SIGNAL(colorChanged(QColor)),  SLOT(update()));
-    connect(source.get(), SIGNAL(readyRead()),     SLOT(update()));
+    connect(source.get(), SIGNAL(readyRead()),     SLOT(sourceReadyRead()));
     connect(source.get(), SIGNAL(activeChanged()), SLOT(update()));
 }
 
@@ -37,6 +37,16 @@ const Source::Shared &SeriesItem::source() const
     return m_source;
 }
 
+void SeriesItem::sourceReadyRead()
+{
+    //readyRead is also sent for a republished frame, nothing to redraw then
+    auto version = m_source->version();
+    if (version != m_version) {
+        m_version = version;
+        update();
+    }
+}
+
 void SeriesItem::setZIndex(int index)
 {
     setZ(index);
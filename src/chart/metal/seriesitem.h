@@ -43,6 +43,9 @@ signals:
     void preSourceDeleted();
     void updated();
 
+private slots:
+    void sourceReadyRead();
+
 protected:
     QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override;
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
@@ -50,6 +53,7 @@ protected:
     Source::Shared m_source;
     bool m_highlighted;
     NodeConstructor m_nodeConstructor;
+    quint64 m_version;  //last source frame sent to the node
 };
 
 } // namespace chart
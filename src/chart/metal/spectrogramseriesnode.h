@@ -57,6 +57,7 @@ private:
     unsigned int m_pointsPerOctave;
     unsigned int m_sourceSize;
     QElapsedTimer m_timer;
+    quint64 m_historyVersion;   //source frame of the last history row
 
     //! MTLRenderPipelineState
     void *m_pipeline;
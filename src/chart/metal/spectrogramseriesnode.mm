@@ -26,7 +26,7 @@ namespace Chart {
 SpectrogramSeriesNode::SpectrogramSeriesNode(QQuickItem *item) : XYSeriesNode(item),
     m_history(), m_refreshBuffers(true),
     m_min(0), m_mid(0), m_max(0), m_pointsPerOctave(0), m_sourceSize(0),
-    m_timer(),
+    m_timer(), m_historyVersion(0),
     m_pipeline(nullptr), m_indiciesBuffer(nullptr)
 {
     connect(source().get(), &Source::Abstract::readyRead, this, &SpectrogramSeriesNode::updateHistory);
@@ -115,7 +115,6 @@ void SpectrogramSeriesNode::updateHistory()
     std::lock_guard guard(m_active);
     historyRowData rowData;
     historyRow row;
-    row.time = static_cast<int>(m_timer.restart());
     row.data.reserve(m_pointsPerOctave * 11);
     float value = 0.f;
     static const QColor qred("#F44336"), qgreen("#8BC34A"), qblue("#2196F3");
@@ -171,7 +170,16 @@ void SpectrogramSeriesNode::updateHistory()
     };
 
     if (m_plotActive) {
+        source()->lock();
+        //readyRead is also sent for a republished frame, it is already in the history
+        if (source()->pinnedVersion() == m_historyVersion) {
+            source()->unlock();
+            return;
+        }
+        m_historyVersion = source()->pinnedVersion();
+        row.time = static_cast<int>(m_timer.restart());
         iterate(m_pointsPerOctave, accumalte, collected);
+        source()->unlock();
 
         m_history.push_back(std::move(row));
         if (m_history.size() > MAX_HISTORY) {
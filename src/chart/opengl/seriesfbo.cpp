@@ -23,11 +23,11 @@ using namespace Chart;
 SeriesFBO::SeriesFBO(Source::Shared source, RendererCreator rc, QQuickItem *parent):
     QQuickFramebufferObject(parent),
     m_rendererCreator(std::move(rc)),
-    m_source(source), m_highlighted(false)
+    m_source(source), m_highlighted(false), m_version(0)
 {
     setFlag(QQuickItem::ItemHasContents);
     connect(source.get(), SIGNAL(colorChanged(QColor)), SLOT(update()));
-    connect(source.get(), SIGNAL(readyRead()),          SLOT(update()));
+    connect(source.get(), SIGNAL(readyRead()),          SLOT(sourceReadyRead()));
     connect(source.get(), SIGNAL(activeChanged()),      SLOT(update()));
 }
 
@@ -49,6 +49,15 @@ QQuickFramebufferObject::Renderer *SeriesFBO::createRenderer() const
 
     return renderer;
 }
+void SeriesFBO::sourceReadyRead()
+{
+    //readyRead is also sent for a republished frame, nothing to redraw then
+    auto version = m_source->version();
+    if (version != m_version) {
+        m_version = version;
+        update();
+    }
+}
 void SeriesFBO::setZIndex(qreal index)
 {
     setZ(index);
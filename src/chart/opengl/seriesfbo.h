@@ -41,10 +41,14 @@ public:
 signals:
     void preSourceDeleted();
 
+private slots:
+    void sourceReadyRead();
+
 protected:
     RendererCreator m_rendererCreator;
     Source::Shared m_source;
     bool m_highlighted;
+    quint64 m_version;  //last source frame sent to the renderer
 };
 }
 #endif // SERIESFBO_H
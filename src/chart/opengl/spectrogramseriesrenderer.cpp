@@ -27,7 +27,7 @@ using namespace Chart;
 
 SpectrogramSeriesRenderer::SpectrogramSeriesRenderer() : FrequencyBasedSeriesRenderer(),
     m_min(0), m_mid(0), m_max(0),
-    m_pointsPerOctave(0), m_timer(),
+    m_pointsPerOctave(0), m_timer(), m_historyVersion(0),
     m_indexBufferId(0), m_sourceSize(0)
 {
 }
@@ -87,7 +87,6 @@ void SpectrogramSeriesRenderer::renderSeries()
 
     historyRowData rowData;
     historyRow row;
-    row.time = static_cast<int>(m_timer.restart());
     row.data.reserve(m_pointsPerOctave * 11);
     float value = 0.f;
     static const QColor qred("#F44336"), qgreen("#8BC34A"), qblue("#2196F3");
@@ -142,7 +141,10 @@ void SpectrogramSeriesRenderer::renderSeries()
         value = 0;
     };
 
-    if (m_active) {
+    //a redraw without a new frame (zoom, resize) must not add a row
+    if (m_active && (history.empty() || m_source->pinnedVersion() != m_historyVersion)) {
+        m_historyVersion = m_source->pinnedVersion();
+        row.time = static_cast<int>(m_timer.restart());
         iterate(m_pointsPerOctave, accumalte, collected);
 
         //TODO: change to fifo instead of deque
@@ -49,6 +49,7 @@ private:
     int m_min, m_mid, m_max;
     unsigned int m_pointsPerOctave;
     QElapsedTimer m_timer;
+    quint64 m_historyVersion;   //source frame of the last history row
 
     unsigned int m_indexBufferId, m_sourceSize;
     std::vector<unsigned int> m_indices;
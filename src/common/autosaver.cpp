@@ -21,7 +21,8 @@
 #include "workingfolder.h"
 
 AutoSaver::AutoSaver(Settings *settings, SourceList *parent) : QObject(parent),
-    m_settings(settings), m_timer()
+    m_settings(settings), m_timer(), m_timerThread(), m_saveMutex(), m_chunks(workingfolder::autosaveChunksPath()),
+    m_saved()
 {
     m_timer.setInterval(30'000); //30 sec
     m_timer.moveToThread(&m_timerThread);
@@ -31,16 +32,14 @@ AutoSaver::AutoSaver(Settings *settings, SourceList *parent) : QObject(parent),
     connect(&m_timerThread, SIGNAL(started()),  &m_timer, SLOT(start()), Qt::DirectConnection);
     connect(&m_timerThread, &QThread::finished, &m_timer, &QTimer::stop,  Qt::DirectConnection);
 
+    m_timerThread.setObjectName("AutoSaver");
     m_timerThread.start();
     load();
 }
 
 AutoSaver::~AutoSaver()
 {
-    if (m_timerThread.isRunning()) {
-        m_timerThread.quit();
-        m_timerThread.wait();
-    }
+    stop();
 }
 
 SourceList *AutoSaver::list() const
@@ -72,14 +71,34 @@ void AutoSaver::load()
 
 void AutoSaver::save()
 {
+    std::lock_guard<std::mutex> guard(m_saveMutex);
     auto url = fileName();
-    if (list()->save(url)) {
+    BinaryFile file;
+    file.setChunks(&m_chunks);
+    if (!file.create(url.toLocalFile())) {
+        return;
+    }
+
+    QJsonObject object;
+    {
+        BinaryFile::Scope scope(&file);
+        object = list()->toDocument();
+    }
+    //chunk names change with data, so equal metadata means nothing to write
+    if (object == m_saved) {
+        file.cancel();
+        return;
+    }
+    if (file.finish(object)) {
+        m_saved = object;
         m_settings->setValue(FILE_KEY, url);
     }
 }
 
 void AutoSaver::stop()
 {
-    m_timerThread.quit();
-    m_timerThread.wait();
+    if (m_timerThread.isRunning()) {
+        m_timerThread.quit();
+        m_timerThread.wait();
+    }
 }
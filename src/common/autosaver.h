@@ -18,13 +18,21 @@
 #ifndef AUTOSAVER_H
 #define AUTOSAVER_H
 
+#include <mutex>
 #include <QTimer>
 #include <QThread>
 #include <QtQml>
+#include "binaryfile.h"
 
 class SourceList;
 class Settings;
 
+/**
+ * @brief The AutoSaver class
+ * saves the project every 30 s on its own thread, so file writes never hold a Scheduler worker.
+ * Columns of stored traces are kept in chunk files next to the autosave, so a tick writes only
+ * sources changed since the last one and the metadata. Nothing is written if nothing changed.
+ */
 class AutoSaver : public QObject
 {
     Q_OBJECT
@@ -49,6 +57,9 @@ private:
     Settings *m_settings;
     QTimer m_timer;
     QThread m_timerThread;
+    std::mutex m_saveMutex;     //protects chunks between the worker and the GUI thread
+    BinaryFile::Chunks m_chunks;
+    QJsonObject m_saved;        //metadata of the last autosave
 };
 
 #endif // AUTOSAVER_H
@@ -0,0 +1,427 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "binaryfile.h"
+#include <array>
+#include <cstring>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QtEndian>
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+#error "float columns are written in the host byte order"
+#endif
+
+namespace {
+constexpr char MAGIC[4] = {'O', 'S', 'M', 'B'};
+
+thread_local BinaryFile *t_current = nullptr;
+
+//header fields
+constexpr int VERSION_AT     = 4;
+constexpr int DATA_OFFSET_AT = 8;
+constexpr int DATA_SIZE_AT   = 16;
+constexpr int META_OFFSET_AT = 24;
+constexpr int META_SIZE_AT   = 32;
+constexpr int CHECKSUM_AT    = 40;
+
+const QString CHUNK_SUFFIX = ".osmc";
+
+//CRC-32 (IEEE 802.3), the same as zip and png use
+quint32 crc32(quint32 crc, const uchar *data, qint64 size)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> t {};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+}
+
+BinaryFile::Chunks::Chunks(const QString &folder) : folder(folder),
+    session(QString::number(QDateTime::currentMSecsSinceEpoch(), 36)), written(), used()
+{
+}
+
+BinaryFile::BinaryFile() : m_output(), m_file(), m_data(nullptr), m_size(0), m_buffer(), m_metadata(),
+    m_fileName(), m_folder(), m_saved(), m_chunks(nullptr), m_opened(), m_checksum(0), m_writing(false), m_failed(false)
+{
+}
+
+BinaryFile::~BinaryFile()
+{
+    close();
+}
+
+bool BinaryFile::detect(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return file.read(sizeof(MAGIC)) == QByteArray(MAGIC, sizeof(MAGIC));
+}
+
+bool BinaryFile::create(const QString &fileName)
+{
+    close();
+    m_fileName = fileName;
+    m_output.setFileName(fileName);
+    if (!m_output.open(QIODevice::WriteOnly)) {
+        qWarning() << "binary file: couldn't open" << fileName;
+        return false;
+    }
+    m_writing = true;
+    m_failed = false;
+
+    //the header is written by finish(), when all sizes are known
+    QByteArray header(HEADER_SIZE, 0);
+    return write(header.constData(), header.size());
+}
+
+QJsonObject BinaryFile::writeColumn(const float *data, std::size_t count)
+{
+    if (!m_writing || m_failed) {
+        return {};
+    }
+
+    auto position = m_output.pos();
+    auto padding = (COLUMN_ALIGN - position % COLUMN_ALIGN) % COLUMN_ALIGN;
+    if (padding) {
+        static const char zeros[COLUMN_ALIGN] = {};
+        if (!write(zeros, padding)) {
+            return {};
+        }
+        position += padding;
+    }
+
+    auto bytes = static_cast<qint64>(count * sizeof(float));
+    if (!write(reinterpret_cast<const char *>(data), bytes)) {
+        return {};
+    }
+
+    QJsonObject reference;
+    reference["offset"] = static_cast<double>(position);
+    reference["count"]  = static_cast<double>(count);
+    reference["crc"]    = static_cast<double>(crc32(0, reinterpret_cast<const uchar *>(data), bytes));
+    return reference;
+}
+
+bool BinaryFile::finish(const QJsonObject &metadata)
+{
+    if (!m_writing) {
+        return false;
+    }
+    if (m_failed) {
+        cancel();
+        return false;
+    }
+    m_writing = false;
+
+    auto dataSize = m_output.pos() - HEADER_SIZE;
+    auto meta = QJsonDocument(metadata).toJson(QJsonDocument::Compact);
+    auto metaOffset = m_output.pos();
+    m_checksum = crc32(0, reinterpret_cast<const uchar *>(meta.constData()), meta.size());
+
+    QByteArray header(HEADER_SIZE, 0);
+    auto h = reinterpret_cast<uchar *>(header.data());
+    std::memcpy(h, MAGIC, sizeof(MAGIC));
+    qToLittleEndian<quint32>(VERSION, h + VERSION_AT);
+    qToLittleEndian<quint64>(HEADER_SIZE, h + DATA_OFFSET_AT);
+    qToLittleEndian<quint64>(dataSize, h + DATA_SIZE_AT);
+    qToLittleEndian<quint64>(metaOffset, h + META_OFFSET_AT);
+    qToLittleEndian<quint64>(meta.size(), h + META_SIZE_AT);
+    qToLittleEndian<quint32>(m_checksum, h + CHECKSUM_AT);
+
+    if (!write(meta.constData(), meta.size()) || !m_output.seek(0) || !write(header.constData(), header.size())) {
+        m_output.cancelWriting();
+    }
+    //the old file is replaced only by the complete new one
+    if (!m_output.commit()) {
+        qWarning() << "binary file: couldn't save" << m_output.fileName() << m_output.errorString();
+        if (m_chunks) {
+            m_chunks->used.clear();
+        }
+        return false;
+    }
+    collectChunks();
+    for (auto &callback : m_saved) {
+        callback(*this);
+    }
+    m_saved.clear();
+    return true;
+}
+
+void BinaryFile::cancel()
+{
+    if (m_chunks) {
+        m_chunks->used.clear();
+    }
+    if (m_output.isOpen()) {
+        m_output.cancelWriting();
+        m_output.commit();
+    }
+    m_writing = false;
+}
+
+void BinaryFile::whenSaved(Saved callback)
+{
+    m_saved.push_back(std::move(callback));
+}
+
+void BinaryFile::setChunks(Chunks *chunks) noexcept
+{
+    m_chunks = chunks;
+}
+
+QJsonObject BinaryFile::columns(const QString &key, const ColumnsWriter &write)
+{
+    if (!m_chunks) {
+        return write(*this);
+    }
+    m_chunks->used.insert(key);
+    auto found = m_chunks->written.find(key);
+    if (found != m_chunks->written.end()) {
+        return found->second;
+    }
+
+    QDir folder(m_chunks->folder);
+    if (m_chunks->folder.isEmpty() || !folder.mkpath(".")) {
+        qWarning() << "binary file: couldn't create" << m_chunks->folder;
+        m_failed = true;
+        return {};
+    }
+    auto path = folder.filePath(m_chunks->session + "-" + key + CHUNK_SUFFIX);
+    BinaryFile chunk;
+    QJsonObject metadata;
+    metadata["type"] = "chunk";
+    metadata["key"] = key;
+    if (!chunk.create(path)) {
+        m_failed = true;
+        return {};
+    }
+    auto references = write(chunk);
+    if (!chunk.finish(metadata)) {
+        m_failed = true;
+        return {};
+    }
+
+    //the chunk is found relative to the project file, the folder may be moved along with it
+    auto name = QFileInfo(m_output.fileName()).dir().relativeFilePath(path);
+    QJsonObject columns;
+    for (auto it = references.constBegin(); it != references.constEnd(); ++it) {
+        auto reference = it.value().toObject();
+        reference["chunk"] = name;
+        columns[it.key()] = reference;
+    }
+    m_chunks->written[key] = columns;
+    return columns;
+}
+
+bool BinaryFile::open(const QString &fileName)
+{
+    close();
+    m_fileName = fileName;
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "binary file: couldn't open" << fileName;
+        return false;
+    }
+    m_folder = QFileInfo(fileName).absolutePath();
+    m_size = m_file.size();
+    if (m_size < HEADER_SIZE) {
+        qWarning() << "binary file: too short" << fileName;
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        m_buffer = m_file.readAll();
+        m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+    }
+
+    auto version = qFromLittleEndian<quint32>(m_data + VERSION_AT);
+    auto dataOffset = qFromLittleEndian<quint64>(m_data + DATA_OFFSET_AT);
+    auto dataSize = qFromLittleEndian<quint64>(m_data + DATA_SIZE_AT);
+    auto metaOffset = qFromLittleEndian<quint64>(m_data + META_OFFSET_AT);
+    auto metaSize = qFromLittleEndian<quint64>(m_data + META_SIZE_AT);
+    auto checksum = qFromLittleEndian<quint32>(m_data + CHECKSUM_AT);
+
+    auto size = static_cast<quint64>(m_size);
+    if (std::memcmp(m_data, MAGIC, sizeof(MAGIC)) != 0 || version > VERSION ||
+            dataOffset != HEADER_SIZE || dataOffset + dataSize != metaOffset || metaSize > size ||
+            metaOffset > size - metaSize) {
+        qWarning() << "binary file: unsupported or broken header" << fileName;
+        close();
+        return false;
+    }
+    if (crc32(0, m_data + metaOffset, static_cast<qint64>(metaSize)) != checksum) {
+        qWarning() << "binary file: checksum mismatch" << fileName;
+        close();
+        return false;
+    }
+
+    auto meta = QByteArray::fromRawData(reinterpret_cast<const char *>(m_data + metaOffset),
+                                        static_cast<int>(metaSize));
+    QJsonParseError error;
+    auto document = QJsonDocument::fromJson(meta, &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        qWarning() << "binary file: broken metadata" << fileName << error.errorString();
+        close();
+        return false;
+    }
+    m_metadata = document.object();
+    m_checksum = checksum;
+    return true;
+}
+
+QJsonObject BinaryFile::metadata() const
+{
+    return m_metadata;
+}
+
+QString BinaryFile::fileName() const
+{
+    return m_fileName;
+}
+
+QString BinaryFile::location(const QJsonValue &reference) const
+{
+    auto chunk = reference.toObject()["chunk"].toString();
+    return QFileInfo(chunk.isEmpty() ? m_fileName : QDir(m_folder).filePath(chunk)).absoluteFilePath();
+}
+
+container::span<const float> BinaryFile::column(const QJsonValue &reference) const
+{
+    auto object = reference.toObject();
+    if (object.contains("chunk")) {
+        auto file = chunk(object.take("chunk").toString());
+        return file ? file->column(object) : container::span<const float> {};
+    }
+
+    auto offset = static_cast<qint64>(object["offset"].toDouble(-1));
+    auto count = static_cast<qint64>(object["count"].toDouble(-1));
+    auto bytes = count * static_cast<qint64>(sizeof(float));
+    if (!m_data || offset < HEADER_SIZE || count < 0 || offset % COLUMN_ALIGN || offset + bytes > m_size) {
+        return {};
+    }
+    if (!object.contains("crc") || crc32(0, m_data + offset, bytes) != static_cast<quint32>(object["crc"].toDouble())) {
+        qWarning() << "binary file: column checksum mismatch" << m_fileName << offset;
+        return {};
+    }
+    return {reinterpret_cast<const float *>(m_data + offset), static_cast<std::size_t>(count)};
+}
+
+BinaryFile *BinaryFile::current() noexcept
+{
+    return t_current;
+}
+
+bool BinaryFile::write(const char *data, qint64 size)
+{
+    if (m_output.write(data, size) != size) {
+        qWarning() << "binary file: couldn't write" << m_output.fileName();
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+void BinaryFile::close()
+{
+    if (m_data && m_buffer.isEmpty()) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_buffer.clear();
+    m_metadata = {};
+    m_saved.clear();
+    m_opened.clear();
+    if (m_writing) {
+        cancel();
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void BinaryFile::collectChunks()
+{
+    if (!m_chunks || m_chunks->folder.isEmpty()) {
+        return;
+    }
+
+    std::set<QString> kept;
+    for (auto it = m_chunks->written.begin(); it != m_chunks->written.end(); ) {
+        if (m_chunks->used.count(it->first)) {
+            kept.insert(m_chunks->session + "-" + it->first + CHUNK_SUFFIX);
+            ++it;
+        } else {
+            it = m_chunks->written.erase(it);
+        }
+    }
+    m_chunks->used.clear();
+
+    //the saved project doesn't refer to other chunks, including ones of previous runs
+    QDir folder(m_chunks->folder);
+    for (auto &name : folder.entryList({"*" + CHUNK_SUFFIX}, QDir::Files)) {
+        if (!kept.count(name)) {
+            folder.remove(name);
+        }
+    }
+}
+
+const BinaryFile *BinaryFile::chunk(const QString &name) const
+{
+    auto found = m_opened.find(name);
+    if (found != m_opened.end()) {
+        return found->second.get();
+    }
+
+    auto file = std::make_unique<BinaryFile>();
+    if (!file->open(QDir(m_folder).filePath(name))) {
+        file.reset();
+    }
+    return (m_opened[name] = std::move(file)).get();
+}
+
+BinaryFile::Scope::Scope(BinaryFile *file) noexcept : m_previous(t_current)
+{
+    t_current = file;
+}
+
+BinaryFile::Scope::~Scope()
+{
+    t_current = m_previous;
+}
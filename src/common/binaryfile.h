@@ -0,0 +1,144 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BINARYFILE_H
+#define BINARYFILE_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+#include <QByteArray>
+#include <QFile>
+#include <QJsonObject>
+#include <QSaveFile>
+#include "container/span.h"
+
+/**
+ * @brief The BinaryFile class
+ * container for projects and stored traces: a fixed header, raw float32 columns and JSON metadata.
+ *
+ *   header    magic "OSMB", format version, offset and size of the data and of the metadata,
+ *             CRC-32 of the metadata
+ *   data      little-endian float32 columns, each one starts on a COLUMN_ALIGN boundary
+ *   metadata  compact JSON of the same shape as the text format, large arrays are replaced
+ *             by column references {"offset", "count", "crc"}
+ *
+ * Columns are streamed to the file while the metadata is built, so saving never holds a second
+ * copy of the data. On load the file is mapped and columns are read straight from the mapping.
+ * Every column has its own checksum: opening a file doesn't touch the data, a column is checked
+ * when it is read.
+ *
+ * Sources reach the file through current(): it is set by Scope for the thread that builds or
+ * parses the metadata. Without a current file sources keep writing plain JSON arrays.
+ *
+ * With Chunks set, columns of every source go to a separate chunk file, named by the source and
+ * its data version. Consecutive saves of one project reuse chunks of unchanged sources, so only
+ * changed data is written. Column references then also name their chunk.
+ * Files are written to a temporary file and renamed on finish(), a broken save keeps the old file.
+ */
+class BinaryFile
+{
+public:
+    static constexpr quint32 VERSION      = 1;
+    static constexpr qint64 HEADER_SIZE   = 64;
+    static constexpr qint64 COLUMN_ALIGN  = 64;
+
+    using ColumnsWriter = std::function<QJsonObject(BinaryFile &)>;
+    using Saved = std::function<void(const BinaryFile &)>;
+
+    //! chunks of one project, kept between saves
+    struct Chunks {
+        explicit Chunks(const QString &folder);
+
+        QString folder;                         //absolute path
+        QString session;                        //chunks of another run are never reused
+        std::map<QString, QJsonObject> written; //key -> references of chunks on disk
+        std::set<QString> used;                 //keys used by the current save
+    };
+
+    BinaryFile();
+    ~BinaryFile();
+    BinaryFile(const BinaryFile &) = delete;
+    BinaryFile &operator=(const BinaryFile &) = delete;
+
+    //! true if the file starts with the binary magic, otherwise it is expected to be JSON
+    static bool detect(const QString &fileName);
+
+    //! opens the file for writing and reserves the header
+    bool create(const QString &fileName);
+    //! appends the column and returns the reference to keep in the metadata, empty on error
+    QJsonObject writeColumn(const float *data, std::size_t count);
+    //! writes the metadata and the header, the file is complete after it
+    bool finish(const QJsonObject &metadata);
+    //! drops the file being written, the previous one is kept
+    void cancel();
+    //! callback is called when the file is complete on disk
+    void whenSaved(Saved callback);
+
+    //! chunks used for columns written after, nullptr writes columns to this file
+    void setChunks(Chunks *chunks) noexcept;
+    //! writes columns of the source with write(), or reuses its chunk if the key was already written
+    QJsonObject columns(const QString &key, const ColumnsWriter &write);
+
+    //! maps the file, checks the header and the checksum
+    bool open(const QString &fileName);
+    QJsonObject metadata() const;
+    QString fileName() const;
+    //! absolute path of the file that holds the column: this one or a chunk
+    QString location(const QJsonValue &reference) const;
+    //! column by the reference from the metadata, valid while the file is open. Empty if it's broken.
+    container::span<const float> column(const QJsonValue &reference) const;
+
+    //! the file that is written or read by this thread, or nullptr
+    static BinaryFile *current() noexcept;
+
+    class Scope
+    {
+    public:
+        explicit Scope(BinaryFile *file) noexcept;
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        BinaryFile *m_previous;
+    };
+
+private:
+    bool write(const char *data, qint64 size);
+    void close();
+    void collectChunks();
+    const BinaryFile *chunk(const QString &name) const;
+
+    QSaveFile m_output;
+    QFile m_file;
+    const uchar *m_data;        //mapped or buffered content of an opened file
+    qint64 m_size;
+    QByteArray m_buffer;        //used when the file can't be mapped
+    QJsonObject m_metadata;
+    QString m_fileName, m_folder;
+    std::vector<Saved> m_saved;
+    Chunks *m_chunks;
+    mutable std::map<QString, std::unique_ptr<BinaryFile>> m_opened;    //chunks read by column()
+    quint32 m_checksum;
+    bool m_writing, m_failed;
+};
+
+#endif // BINARYFILE_H
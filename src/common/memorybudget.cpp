@@ -0,0 +1,94 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "memorybudget.h"
+#include <algorithm>
+#include <QtGlobal>
+
+MemoryBudget *MemoryBudget::getInstance()
+{
+    static MemoryBudget instance;
+    return &instance;
+}
+
+MemoryBudget::MemoryBudget() : m_mutex(), m_idle(), m_limit(DEFAULT_LIMIT), m_used(0)
+{
+    bool ok = false;
+    auto limit = qEnvironmentVariableIntValue(LIMIT_ENV, &ok);
+    if (ok && limit >= 0) {
+        m_limit = static_cast<std::size_t>(limit) << 20;
+    }
+}
+
+std::size_t MemoryBudget::limit() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_limit;
+}
+
+void MemoryBudget::setLimit(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_limit = bytes;
+    trim();
+}
+
+std::size_t MemoryBudget::used() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_used;
+}
+
+void MemoryBudget::park(const void *owner, std::size_t bytes, Release release)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = std::find_if(m_idle.begin(), m_idle.end(), [owner](const auto & entry) {
+        return entry.owner == owner;
+    });
+    if (it != m_idle.end()) {
+        m_used -= it->bytes;
+        m_idle.erase(it);
+    }
+    m_idle.push_back({owner, bytes, std::move(release)});
+    m_used += bytes;
+    trim();
+}
+
+void MemoryBudget::unpark(const void *owner)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = std::find_if(m_idle.begin(), m_idle.end(), [owner](const auto & entry) {
+        return entry.owner == owner;
+    });
+    if (it != m_idle.end()) {
+        m_used -= it->bytes;
+        m_idle.erase(it);
+    }
+}
+
+//should be called while mutex locked
+void MemoryBudget::trim()
+{
+    while (m_used > m_limit && !m_idle.empty()) {
+        auto entry = std::move(m_idle.front());
+        m_idle.pop_front();
+        m_used -= entry.bytes;
+        if (entry.release) {
+            entry.release();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief The MemoryBudget class
+ * limits memory kept by idle sources. A source that is deactivated parks its working buffers here
+ * and they stay allocated for a quick restart while all parked buffers fit the limit. Beyond it
+ * the buffers of the longest idle sources are released.
+ * The limit is OSM_IDLE_MEMORY in MB, zero releases buffers on every deactivation.
+ */
+class MemoryBudget
+{
+public:
+    using Release = std::function<void()>;
+
+    static constexpr const char *LIMIT_ENV = "OSM_IDLE_MEMORY";
+    static constexpr std::size_t DEFAULT_LIMIT = 64 << 20;
+
+    static MemoryBudget *getInstance();
+
+    std::size_t limit() const;
+    void setLimit(std::size_t bytes);
+    std::size_t used() const;
+
+    //! owner became idle with bytes allocated, release is called when they don't fit the limit
+    //! release is called with the budget locked: park() and unpark() must not be called under owner locks
+    void park(const void *owner, std::size_t bytes, Release release);
+
+    //! owner is active again or destroyed, its release won't be called after return
+    void unpark(const void *owner);
+
+private:
+    MemoryBudget();
+    void trim();
+
+    struct Entry {
+        const void *owner;
+        std::size_t bytes;
+        Release release;
+    };
+
+    mutable std::mutex m_mutex;
+    std::deque<Entry> m_idle;   //the longest idle first
+    std::size_t m_limit, m_used;
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,367 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scheduler.h"
+#include <algorithm>
+#include <QJsonObject>
+
+namespace {
+constexpr std::size_t NO_WORKER = static_cast<std::size_t>(-1);
+
+thread_local std::size_t t_worker = NO_WORKER;
+thread_local const void *t_owner = nullptr;
+}
+
+Scheduler *Scheduler::getInstance()
+{
+    static Scheduler instance;
+    return &instance;
+}
+
+Scheduler::Scheduler() : m_queues(), m_threads(), m_ticker(), m_running(true), m_pending(0), m_next(0),
+    m_sleepMutex(), m_wake(), m_stateMutex(), m_idle(), m_queued(), m_active(),
+    m_timedMutex(), m_timedCondition(), m_timed(), m_timingMutex(), m_timings()
+{
+    //one core is left for the audio and GUI threads
+    auto cores = std::thread::hardware_concurrency();
+    auto count = std::max(1u, cores > 1 ? cores - 1 : 1u);
+
+    m_queues.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 0; i < count; ++i) {
+        m_threads.emplace_back([this, i]() {
+            workerLoop(i);
+        });
+    }
+    m_ticker = std::thread([this]() {
+        tickerLoop();
+    });
+}
+
+Scheduler::~Scheduler()
+{
+    m_running = false;
+    {
+        std::lock_guard<std::mutex> guard(m_sleepMutex);
+        m_wake.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_timedMutex);
+        m_timedCondition.notify_all();
+    }
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+    m_ticker.join();
+}
+
+unsigned int Scheduler::workers() const noexcept
+{
+    return static_cast<unsigned int>(m_queues.size());
+}
+
+void Scheduler::submit(const void *owner, const char *name, Task task, std::chrono::milliseconds delay)
+{
+    Key key {owner, name};
+    if (delay > std::chrono::milliseconds::zero()) {
+        std::lock_guard<std::mutex> guard(m_timedMutex);
+        auto scheduled = std::any_of(m_timed.cbegin(), m_timed.cend(), [&key](const auto & timed) {
+            return timed.owner == key.first && timed.name == key.second && timed.interval == clock::duration::zero();
+        });
+        if (!scheduled && !pending(key) && !cancelling(owner)) {
+            m_timed.push_back({owner, name, std::move(task), clock::duration::zero(), clock::now() + delay});
+            m_timedCondition.notify_one();
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_stateMutex);
+        if (m_cancelling.count(owner) || !m_queued.insert(key).second) {
+            return;
+        }
+    }
+    push({owner, name, std::move(task)});
+}
+
+void Scheduler::addPeriodic(const void *owner, const char *name, std::chrono::milliseconds interval, Task task)
+{
+    std::lock_guard<std::mutex> guard(m_timedMutex);
+    if (cancelling(owner)) {
+        return;
+    }
+    m_timed.push_back({owner, name, std::move(task), interval, clock::now() + interval});
+    m_timedCondition.notify_one();
+}
+
+void Scheduler::cancel(const void *owner)
+{
+    if (!owner) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_stateMutex);
+        m_cancelling.insert(owner);
+    }
+    drop(owner);
+
+    {
+        std::unique_lock<std::mutex> lock(m_stateMutex);
+        //the owner can cancel itself from its own task
+        m_idle.wait(lock, [this, owner]() {
+            unsigned int running = 0;
+            for (auto &[key, count] : m_active) {
+                if (key.first == owner) {
+                    running += count;
+                }
+            }
+            return running <= (t_owner == owner ? 1u : 0u);
+        });
+    }
+
+    //a task that was running could submit before the owner was marked
+    drop(owner);
+    std::lock_guard<std::mutex> guard(m_stateMutex);
+    m_cancelling.erase(m_cancelling.find(owner));
+}
+
+void Scheduler::parallel(const std::vector<Task> &tasks)
+{
+    if (tasks.empty()) {
+        return;
+    }
+
+    //runners claim tasks of this batch only: the caller may hold locks other tasks need
+    struct Batch {
+        const std::vector<Task> *tasks;
+        const std::size_t size;
+        std::atomic<std::size_t> next, done;
+    };
+    auto batch = std::shared_ptr<Batch>(new Batch {&tasks, tasks.size(), {0}, {0}});
+    auto run = [this, batch]() {
+        for (auto i = batch->next++; i < batch->size; i = batch->next++) {
+            (*batch->tasks)[i]();
+            if (++batch->done == batch->size) {
+                std::lock_guard<std::mutex> guard(m_stateMutex);
+                m_idle.notify_all();
+            }
+        }
+    };
+    auto helpers = std::min<std::size_t>(tasks.size() - 1, m_queues.size());
+    for (std::size_t i = 0; i < helpers; ++i) {
+        push({nullptr, nullptr, run});
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(m_stateMutex);
+    m_idle.wait(lock, [&batch]() {
+        return batch->done == batch->size;
+    });
+}
+
+std::vector<Scheduler::Timing> Scheduler::timings() const
+{
+    std::lock_guard<std::mutex> guard(m_timingMutex);
+    std::vector<Timing> list;
+    list.reserve(m_timings.size());
+    for (auto &[name, timing] : m_timings) {
+        list.push_back(timing);
+    }
+    return list;
+}
+
+QJsonArray Scheduler::statistics() const
+{
+    QJsonArray list;
+    for (auto &timing : timings()) {
+        QJsonObject object;
+        object["name"]  = QString::fromStdString(timing.name);
+        object["count"] = static_cast<double>(timing.count);
+        object["last"]  = timing.last;
+        object["mean"]  = timing.count ? timing.total / timing.count : 0.;
+        object["max"]   = timing.max;
+        list.append(object);
+    }
+    return list;
+}
+
+void Scheduler::push(Item &&item)
+{
+    auto index = (t_worker != NO_WORKER ? t_worker : m_next++ % m_queues.size());
+    {
+        std::lock_guard<std::mutex> guard(m_queues[index]->mutex);
+        m_queues[index]->items.push_back(std::move(item));
+    }
+    ++m_pending;
+    {
+        std::lock_guard<std::mutex> guard(m_sleepMutex);
+    }
+    m_wake.notify_one();
+}
+
+bool Scheduler::take(std::size_t index, Item &item)
+{
+    auto count = m_queues.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        auto &queue = *m_queues[(index + i) % count];
+        std::lock_guard<std::mutex> guard(queue.mutex);
+        if (queue.items.empty()) {
+            continue;
+        }
+        //own queue is served in order, others are stolen from the back
+        if (i == 0) {
+            item = std::move(queue.items.front());
+            queue.items.pop_front();
+        } else {
+            item = std::move(queue.items.back());
+            queue.items.pop_back();
+        }
+        --m_pending;
+
+        //mark it running while the queue is still locked, so cancel() can't miss it
+        if (item.owner) {
+            std::lock_guard<std::mutex> stateGuard(m_stateMutex);
+            Key key {item.owner, item.name};
+            m_queued.erase(key);
+            ++m_active[key];
+        }
+        return true;
+    }
+    return false;
+}
+
+void Scheduler::execute(Item &item)
+{
+    auto owner = t_owner;
+    t_owner = item.owner;
+    auto start = clock::now();
+    item.task();
+    std::chrono::duration<double, std::milli> elapsed = clock::now() - start;
+    t_owner = owner;
+
+    if (item.name) {
+        std::lock_guard<std::mutex> guard(m_timingMutex);
+        auto &timing = m_timings[item.name];
+        timing.name = item.name;
+        ++timing.count;
+        timing.last = elapsed.count();
+        timing.total += elapsed.count();
+        timing.max = std::max(timing.max, elapsed.count());
+    }
+
+    if (item.owner) {
+        std::lock_guard<std::mutex> guard(m_stateMutex);
+        auto it = m_active.find({item.owner, item.name});
+        if (it != m_active.end() && --it->second == 0) {
+            m_active.erase(it);
+        }
+        m_idle.notify_all();
+    }
+}
+
+void Scheduler::workerLoop(std::size_t index)
+{
+    t_worker = index;
+    Item item;
+    while (m_running) {
+        if (take(index, item)) {
+            execute(item);
+            item = {};
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() {
+            return !m_running || m_pending > 0;
+        });
+    }
+}
+
+void Scheduler::tickerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_timedMutex);
+    while (m_running) {
+        auto now = clock::now();
+        auto wake = now + std::chrono::seconds(1);
+        for (auto it = m_timed.begin(); it != m_timed.end(); ) {
+            if (it->next <= now) {
+                Key key {it->owner, it->name};
+                bool periodic = it->interval != clock::duration::zero();
+                bool skip;
+                {
+                    std::lock_guard<std::mutex> guard(m_stateMutex);
+                    skip = m_queued.count(key) || (periodic && m_active.count(key));
+                    if (!skip) {
+                        m_queued.insert(key);
+                    }
+                }
+                if (!skip) {
+                    push({it->owner, it->name, periodic ? it->task : std::move(it->task)});
+                }
+                if (!periodic) {
+                    it = m_timed.erase(it);
+                    continue;
+                }
+                it->next += it->interval;
+                if (it->next <= now) {
+                    it->next = now + it->interval;
+                }
+            }
+            wake = std::min(wake, it->next);
+            ++it;
+        }
+        m_timedCondition.wait_until(lock, wake);
+    }
+}
+
+bool Scheduler::pending(const Key &key) const
+{
+    std::lock_guard<std::mutex> guard(m_stateMutex);
+    return m_queued.count(key) > 0;
+}
+
+bool Scheduler::cancelling(const void *owner) const
+{
+    std::lock_guard<std::mutex> guard(m_stateMutex);
+    return m_cancelling.count(owner) > 0;
+}
+
+void Scheduler::drop(const void *owner)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_timedMutex);
+        m_timed.erase(std::remove_if(m_timed.begin(), m_timed.end(), [owner](const auto & timed) {
+            return timed.owner == owner;
+        }), m_timed.end());
+    }
+
+    for (auto &queue : m_queues) {
+        std::lock_guard<std::mutex> guard(queue->mutex);
+        auto &items = queue->items;
+        auto removed = std::remove_if(items.begin(), items.end(), [owner](const auto & item) {
+            return item.owner == owner;
+        });
+        m_pending -= static_cast<std::size_t>(std::distance(removed, items.end()));
+        items.erase(removed, items.end());
+    }
+
+    std::lock_guard<std::mutex> guard(m_stateMutex);
+    for (auto it = m_queued.begin(); it != m_queued.end(); ) {
+        it = (it->first == owner ? m_queued.erase(it) : std::next(it));
+    }
+}
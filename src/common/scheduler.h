@@ -0,0 +1,131 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QJsonArray>
+
+/**
+ * @brief The Scheduler class
+ * one pool of DSP workers for all sources instead of a thread with a timer per source.
+ * Each worker owns a queue and steals from the others when it is empty. Periodic and delayed tasks
+ * are fired by one ticker thread. Tasks are identified by owner and name: a task that is still queued
+ * is not queued twice, and a periodic tick is skipped while the previous one is not finished.
+ * Workers run with normal priority, below the audio threads.
+ */
+class Scheduler
+{
+public:
+    using Task = std::function<void()>;
+    using clock = std::chrono::steady_clock;
+
+    struct Timing {
+        std::string name;
+        quint64 count = 0;
+        double last = 0, total = 0, max = 0;  //ms
+    };
+
+    static Scheduler *getInstance();
+    ~Scheduler();
+
+    unsigned int workers() const noexcept;
+
+    //! queues task, or fires it after delay. Does nothing if the same task of the owner is pending.
+    void submit(const void *owner, const char *name, Task task,
+                std::chrono::milliseconds delay = std::chrono::milliseconds::zero());
+
+    //! fires task every interval while the previous run is finished
+    void addPeriodic(const void *owner, const char *name, std::chrono::milliseconds interval, Task task);
+
+    //! removes pending tasks of the owner and waits till its running ones are finished,
+    //! tasks submitted for the owner meanwhile are dropped
+    void cancel(const void *owner);
+
+    //! runs tasks on the pool and returns when all are done, the calling thread takes part in the work
+    void parallel(const std::vector<Task> &tasks);
+
+    std::vector<Timing> timings() const;
+    QJsonArray statistics() const;
+
+private:
+    Scheduler();
+
+    struct Item {
+        const void *owner = nullptr;
+        const char *name = nullptr;
+        Task task;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+    struct Timed {
+        const void *owner;
+        const char *name;
+        Task task;
+        clock::duration interval;   //zero for a single shot
+        clock::time_point next;
+    };
+    using Key = std::pair<const void *, const char *>;
+
+    void push(Item &&item);
+    bool take(std::size_t index, Item &item);
+    void execute(Item &item);
+    void workerLoop(std::size_t index);
+    void tickerLoop();
+    bool pending(const Key &key) const;
+    bool cancelling(const void *owner) const;
+    void drop(const void *owner);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::thread m_ticker;
+    std::atomic<bool> m_running;
+    std::atomic<std::size_t> m_pending, m_next;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+
+    //queued and running tasks, protected by m_stateMutex
+    mutable std::mutex m_stateMutex;
+    std::condition_variable m_idle;
+    std::set<Key> m_queued;
+    std::map<Key, unsigned int> m_active;
+    std::multiset<const void *> m_cancelling;
+
+    std::mutex m_timedMutex;
+    std::condition_variable m_timedCondition;
+    std::vector<Timed> m_timed;
+
+    mutable std::mutex m_timingMutex;
+    std::map<std::string, Timing> m_timings;
+};
+
+#endif // SCHEDULER_H
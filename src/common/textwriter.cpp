@@ -0,0 +1,176 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "textwriter.h"
+#include <cmath>
+#include <cstring>
+#include <QDebug>
+
+namespace {
+constexpr int PRECISION = 6;
+constexpr int NUMBER_SIZE = 16;
+}
+
+TextWriter::TextWriter() : m_file(), m_buffer(BUFFER_SIZE, Qt::Uninitialized), m_size(0), m_failed(false)
+{
+}
+
+TextWriter::~TextWriter()
+{
+    close();
+}
+
+bool TextWriter::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    m_size = 0;
+    m_failed = !m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (m_failed) {
+        qWarning() << "couldn't open" << fileName << m_file.errorString();
+    }
+    return !m_failed;
+}
+
+bool TextWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return !m_failed;
+    }
+    flush();
+    m_file.close();
+    return !m_failed;
+}
+
+TextWriter &TextWriter::operator<<(float value)
+{
+    reserve(NUMBER_SIZE);
+    m_size += format(value, m_buffer.data() + m_size);
+    return *this;
+}
+
+TextWriter &TextWriter::operator<<(const char *text)
+{
+    auto length = static_cast<int>(std::strlen(text));
+    if (length > BUFFER_SIZE) {
+        flush();
+        m_failed |= (m_file.write(text, length) != length);
+        return *this;
+    }
+    reserve(length);
+    std::memcpy(m_buffer.data() + m_size, text, length);
+    m_size += length;
+    return *this;
+}
+
+int TextWriter::format(float value, char *dst) noexcept
+{
+    auto start = dst;
+    if (std::isnan(value)) {
+        std::memcpy(dst, "nan", 3);
+        return 3;
+    }
+    if (std::signbit(value)) {
+        *dst++ = '-';
+        value = -value;
+    }
+    if (std::isinf(value)) {
+        std::memcpy(dst, "inf", 3);
+        return static_cast<int>(dst - start) + 3;
+    }
+    if (value == 0) {
+        *dst++ = '0';
+        return static_cast<int>(dst - start);
+    }
+
+    //digits holds PRECISION significant digits of the value, exponent is of the first one
+    double v = value;
+    int exponent = static_cast<int>(std::floor(std::log10(v)));
+    int scale = PRECISION - 1 - exponent;
+    auto scaled = (scale >= 0 ? v * std::pow(10.0, scale) : v / std::pow(10.0, -scale));
+    //ties go to even as in printf
+    auto digits = static_cast<long long>(std::nearbyint(scaled));
+    constexpr long long limit = 1'000'000;
+    static_assert(PRECISION == 6, "limit is 10^PRECISION");
+    if (digits >= limit) {
+        digits = (digits + 5) / 10;
+        ++exponent;
+    } else if (digits < limit / 10) {
+        digits *= 10;
+        --exponent;
+    }
+
+    char text[PRECISION];
+    for (int i = PRECISION - 1; i >= 0; --i) {
+        text[i] = static_cast<char>('0' + digits % 10);
+        digits /= 10;
+    }
+    int length = PRECISION;
+    while (length > 1 && text[length - 1] == '0') {
+        --length;
+    }
+
+    if (exponent < -4 || exponent >= PRECISION) {
+        *dst++ = text[0];
+        if (length > 1) {
+            *dst++ = '.';
+            std::memcpy(dst, text + 1, length - 1);
+            dst += length - 1;
+        }
+        *dst++ = 'e';
+        *dst++ = (exponent < 0 ? '-' : '+');
+        auto power = std::abs(exponent);
+        if (power >= 100) {
+            *dst++ = static_cast<char>('0' + power / 100);
+        }
+        *dst++ = static_cast<char>('0' + (power / 10) % 10);
+        *dst++ = static_cast<char>('0' + power % 10);
+    } else if (exponent < 0) {
+        *dst++ = '0';
+        *dst++ = '.';
+        for (int i = exponent + 1; i < 0; ++i) {
+            *dst++ = '0';
+        }
+        std::memcpy(dst, text, length);
+        dst += length;
+    } else {
+        for (int i = 0; i <= exponent; ++i) {
+            *dst++ = (i < length ? text[i] : '0');
+        }
+        if (length > exponent + 1) {
+            *dst++ = '.';
+            std::memcpy(dst, text + exponent + 1, length - exponent - 1);
+            dst += length - exponent - 1;
+        }
+    }
+    return static_cast<int>(dst - start);
+}
+
+void TextWriter::reserve(int size)
+{
+    if (m_size + size > BUFFER_SIZE) {
+        flush();
+    }
+}
+
+bool TextWriter::flush()
+{
+    if (m_size && m_file.isOpen()) {
+        m_failed |= (m_file.write(m_buffer.constData(), m_size) != m_size);
+    }
+    m_size = 0;
+    return !m_failed;
+}
@@ -0,0 +1,56 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+#include <QFile>
+
+/**
+ * @brief The TextWriter class
+ * buffered writer of text exports. Numbers are written like QTextStream does by default
+ * (6 significant digits, %g notation), but with '.' as the point whatever the locale is
+ * and without QString conversions.
+ */
+class TextWriter
+{
+public:
+    static constexpr int BUFFER_SIZE = 64 * 1024;
+
+    TextWriter();
+    ~TextWriter();
+
+    bool open(const QString &fileName);
+    bool close();
+
+    TextWriter &operator<<(float value);
+    TextWriter &operator<<(const char *text);
+
+    //! %g with 6 significant digits, returns the length. dst must have 16 bytes
+    static int format(float value, char *dst) noexcept;
+
+private:
+    void reserve(int size);
+    bool flush();
+
+    QFile m_file;
+    QByteArray m_buffer;
+    int m_size;
+    bool m_failed;
+};
+
+#endif // TEXTWRITER_H
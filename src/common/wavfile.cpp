@@ -19,19 +19,111 @@
 #include <QtEndian>
 #include <QtMath>
 #include <QDebug>
+#include <algorithm>
 #include <cstring>
+#include <limits>
 
-WavFile::WavFile() : m_header(), m_dataPosition(0)
+#if defined(Q_PROCESSOR_X86_64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+void convertPCM8(const char *src, float *dst, qint64 samples) noexcept
+{
+    //unsigned samples around 128: 0 is -1.0
+    constexpr float scale = 1.f / 128;
+    auto data = reinterpret_cast<const quint8 *>(src);
+    for (qint64 i = 0; i < samples; ++i) {
+        dst[i] = (static_cast<int>(data[i]) - 128) * scale;
+    }
+}
+
+void convertPCM16(const char *src, float *dst, qint64 samples) noexcept
+{
+    constexpr float scale = 1.f / std::numeric_limits<qint16>::max();
+    qint64 i = 0;
+#if defined(Q_PROCESSOR_X86_64)
+    const __m128 k = _mm_set1_ps(scale);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), k));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), k));
+    }
+#endif
+    for (; i < samples; ++i) {
+        dst[i] = qFromLittleEndian<qint16>(src + i * 2) * scale;
+    }
+}
+
+void convertPCM24(const char *src, float *dst, qint64 samples) noexcept
+{
+    constexpr double scale = 1.0 / std::numeric_limits<qint32>::max();
+    auto data = reinterpret_cast<const quint8 *>(src);
+    for (qint64 i = 0; i < samples; ++i, data += 3) {
+        auto value = static_cast<qint32>(
+                         (static_cast<quint32>(data[0]) << 8)  |
+                         (static_cast<quint32>(data[1]) << 16) |
+                         (static_cast<quint32>(data[2]) << 24));
+        dst[i] = static_cast<float>(value * scale);
+    }
+}
+
+void convertPCM32(const char *src, float *dst, qint64 samples) noexcept
+{
+    constexpr float scale = 1.f / std::numeric_limits<qint32>::max();
+    qint64 i = 0;
+#if defined(Q_PROCESSOR_X86_64)
+    const __m128 k = _mm_set1_ps(scale);
+    for (; i + 4 <= samples; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), k));
+    }
+#endif
+    for (; i < samples; ++i) {
+        dst[i] = qFromLittleEndian<qint32>(src + i * 4) * scale;
+    }
+}
+
+void convertFloat32(const char *src, float *dst, qint64 samples) noexcept
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    std::memcpy(dst, src, samples * sizeof(float));
+#else
+    for (qint64 i = 0; i < samples; ++i) {
+        dst[i] = qFromLittleEndian<float>(src + i * 4);
+    }
+#endif
+}
+
+void convertFloat64(const char *src, float *dst, qint64 samples) noexcept
+{
+    for (qint64 i = 0; i < samples; ++i) {
+        dst[i] = static_cast<float>(qFromLittleEndian<double>(src + i * 8));
+    }
+}
+
+}
+
+WavFile::WavFile() : m_header(), m_dataPosition(0), m_dataSize(0),
+    m_sampleType(WaveHeader::AudioFormat::PCM), m_sampleBytes(0), m_frames(0), m_position(0),
+    m_mapped(nullptr), m_decoded(), m_streamThread(), m_streamMutex(), m_streamCondition(), m_ring(),
+    m_streamBase(0), m_seekFrame(-1), m_ringRead(0), m_ringWrite(0),
+    m_streaming(false), m_streamFailed(false), m_realtime(false),
+    m_cache(), m_scratch(), m_cachePosition(0), m_cacheSize(0)
 {
 }
 
 WavFile::~WavFile()
 {
-    m_file.close();
+    close();
 }
 
 bool WavFile::load(const QString &fileName)
 {
+    close();
     m_file.setFileName(fileName);
 
     if (!m_file.open(QFile::ReadOnly)) {
@@ -43,35 +135,146 @@ bool WavFile::load(const QString &fileName)
     if (read != sizeof (m_header.wave)) {
         return false;
     }
+    bool rf64 = memcmp(m_header.wave.chunk.id, "RF64", 4) == 0;
+    quint64 dataSize64 = 0;
 
     //read next chunk until data
     char chunkId[4];
-    unsigned int chunkSize = 0;
+    quint32 chunkSize = 0;
     while (m_file.read(chunkId, 4) == 4) {
 
-        m_file.read(reinterpret_cast<char *>(&chunkSize), 4);
+        if (m_file.read(reinterpret_cast<char *>(&chunkSize), 4) != 4) {
+            break;
+        }
         chunkSize = qFromLittleEndian(chunkSize);
-        auto qChunkId = QString::fromLocal8Bit(chunkId, 4);
+        //chunks are word aligned
+        auto next = m_file.pos() + chunkSize + (chunkSize & 1);
 
-        if (qChunkId == "fmt ") {
-            m_file.seek(m_file.pos() - 8);
-            m_file.read(reinterpret_cast<char *>(&m_header.format), sizeof (m_header.format));
-        } else if (qChunkId == "data") {
+        if (memcmp(chunkId, "fmt ", 4) == 0) {
+            if (!readFormat(chunkSize)) {
+                return false;
+            }
+        } else if (memcmp(chunkId, "ds64", 4) == 0) {
+            WaveHeader::DataSize64 ds64;
+            if (chunkSize >= 28 && m_file.read(reinterpret_cast<char *>(&ds64), 28) == 28) {
+                dataSize64 = qFromLittleEndian(ds64.dataSize);
+            }
+        } else if (memcmp(chunkId, "data", 4) == 0) {
             memcpy(m_header.data.id, chunkId, 4);
             m_header.data.size = qToLittleEndian(chunkSize);
+            m_dataSize = (rf64 && chunkSize == 0xFFFFFFFF) ? dataSize64 : chunkSize;
             break;
-        } else {
-            //skip meta data
-            m_file.seek(m_file.pos() + chunkSize);
         }
+        //skip meta data
+        m_file.seek(next);
     }
     m_dataPosition = m_file.pos();
 
-    return m_header.valid();
+    if (!m_header.valid()) {
+        return false;
+    }
+    return prepareData();
+}
+
+bool WavFile::readFormat(qint64 chunkSize)
+{
+    if (chunkSize < 16) {
+        return false;
+    }
+
+    //WAVE_FORMAT_EXTENSIBLE is 40 bytes long, the sub format tag is the first field of its GUID
+    char format[40] = {};
+    auto size = std::min<qint64>(chunkSize, sizeof(format));
+    if (m_file.read(format, size) != size) {
+        return false;
+    }
+    std::memcpy(m_header.format.chunk.id, "fmt ", 4);
+    m_header.format.chunk.size = qToLittleEndian(static_cast<qint32>(chunkSize));
+    std::memcpy(&m_header.format.audioFormat, format, 16);
+
+    m_sampleType = qFromLittleEndian(m_header.format.audioFormat);
+    if (static_cast<quint16>(m_sampleType) == WaveHeader::AudioFormat::EXTENSIBLE) {
+        m_sampleType = (size >= 26 ? qFromLittleEndian<qint16>(format + 24) : 0);
+    }
+    return true;
+}
+
+bool WavFile::prepareData()
+{
+    if (!channels() || !blockAlign()) {
+        return false;
+    }
+
+    //samples with padding (e.g. 24 bit in 32 bit container) are left aligned
+    m_sampleBytes = blockAlign() / channels();
+    bool supported = false;
+    switch (m_sampleType) {
+    case WaveHeader::AudioFormat::PCM:
+        supported = m_sampleBytes >= 1 && m_sampleBytes <= 4;
+        break;
+    case WaveHeader::AudioFormat::FLOAT:
+        supported = m_sampleBytes == 4 || m_sampleBytes == 8;
+        break;
+    }
+    if (!supported) {
+        qCritical() << "unsupported wav format" << m_header;
+        return false;
+    }
+
+    auto available = static_cast<quint64>(std::max<qint64>(m_file.size() - m_dataPosition, 0));
+    if (m_dataSize == 0 || m_dataSize > available) {
+        m_dataSize = available;
+    }
+    m_frames = m_dataSize / blockAlign();
+    m_position = 0;
+    m_cache.resize(CACHE_FRAMES);
+    m_scratch.resize(CACHE_FRAMES * channels());
+
+    bool resource = m_file.fileName().startsWith(":") || m_file.fileName().startsWith("qrc:");
+    if (!resource) {
+        m_mapped = m_file.map(m_dataPosition, m_dataSize);
+        if (m_mapped) {
+            return true;
+        }
+    }
+
+    if (resource || m_dataSize <= static_cast<quint64>(PRELOAD_LIMIT)) {
+        m_file.seek(m_dataPosition);
+        auto raw = m_file.read(m_dataSize);
+        m_frames = raw.size() / blockAlign();
+        m_decoded.resize(m_frames * channels());
+        convert(raw.constData(), m_decoded.data(), m_frames * channels());
+        m_file.close();
+        return true;
+    }
+
+    startStream();
+    return true;
+}
+
+void WavFile::close()
+{
+    stopStream();
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+        m_mapped = nullptr;
+    }
+    m_file.close();
+
+    m_decoded.clear();
+    m_decoded.shrink_to_fit();
+    m_ring.clear();
+    m_ring.shrink_to_fit();
+    m_dataSize = 0;
+    m_frames = 0;
+    m_position = 0;
+    m_cachePosition = 0;
+    m_cacheSize = 0;
 }
 
 bool WavFile::save(const QString &fileName, int sampleRate, const QByteArray &data)
 {
+    close();
     m_file.setFileName(fileName);
     if (!m_file.open(QFile::WriteOnly)) {
         return false;
@@ -104,92 +307,258 @@ int WavFile::sampleRate() const noexcept
     return qFromLittleEndian(m_header.format.sampleRate);
 }
 
-constexpr unsigned int WavFile::blockAlign() const noexcept
+unsigned int WavFile::channels() const noexcept
+{
+    return qFromLittleEndian(m_header.format.channels);
+}
+
+qint64 WavFile::frames() const noexcept
+{
+    return m_frames;
+}
+
+unsigned int WavFile::blockAlign() const noexcept
 {
     return qFromLittleEndian(m_header.format.blockAlign);
 }
 
-constexpr unsigned int WavFile::bitsPerSample() const noexcept
+unsigned int WavFile::bitsPerSample() const noexcept
 {
     return qFromLittleEndian(m_header.format.bitsPerSample);
 }
 
-constexpr unsigned int WavFile::sampleType() const noexcept
+unsigned int WavFile::sampleType() const noexcept
 {
-    return qFromLittleEndian(m_header.format.audioFormat);
+    return m_sampleType;
 }
 
-constexpr unsigned int WavFile::dataSize() const noexcept
+quint64 WavFile::dataSize() const noexcept
 {
-    return qFromLittleEndian(m_header.data.size);
+    return m_dataSize;
 }
 
-float WavFile::nextSample(bool loop, bool *finished) noexcept
+void WavFile::rewind() noexcept
 {
-    float s = NAN;
+    m_position = 0;
+    m_cachePosition = 0;
+    m_cacheSize = 0;
+}
 
-    if (!m_file.isReadable()) {
-        return s;
-    }
+void WavFile::convert(const char *src, float *dst, qint64 samples) const noexcept
+{
+    switch (m_sampleType) {
+    case WaveHeader::AudioFormat::PCM:
+        switch (m_sampleBytes) {
+        case 1:
+            convertPCM8(src, dst, samples);
+            break;
+        case 2:
+            convertPCM16(src, dst, samples);
+            break;
+        case 3:
+            convertPCM24(src, dst, samples);
+            break;
+        case 4:
+            convertPCM32(src, dst, samples);
+            break;
+        }
+        break;
 
-    std::vector<char> buffer;
-    buffer.resize(blockAlign());
-    if (m_file.pos() >= m_dataPosition + dataSize()) {
-        if (loop) {
-            m_file.seek(m_dataPosition);
-            m_file.read(buffer.data(), blockAlign());
+    case WaveHeader::AudioFormat::FLOAT:
+        if (m_sampleBytes == 8) {
+            convertFloat64(src, dst, samples);
         } else {
-            if (finished) {
-                *finished = true;
-            }
-            return NAN;
+            convertFloat32(src, dst, samples);
         }
+        break;
     }
+}
 
-    if (m_file.read(buffer.data(), blockAlign()) == 0) {
-        return NAN;
+void WavFile::setRealtime(bool realtime) noexcept
+{
+    m_realtime = realtime;
+}
+
+void WavFile::startStream()
+{
+    if (!m_frames) {
+        return;
     }
+    m_ring.resize(RING_FRAMES * blockAlign());
+    m_streamBase = 0;
+    m_seekFrame = -1;
+    m_ringRead = m_ringWrite = 0;
+    m_streamFailed = false;
+    m_streaming = true;
+    m_streamThread = std::thread(&WavFile::streamLoop, this);
+}
 
-    switch (sampleType()) {
-    case WaveHeader::AudioFormat::PCM:
-        switch (bitsPerSample()) {
-        case 16: {
-            qint16_le value;
-            memcpy(&value, buffer.data(), 2);
-            s = qFromLittleEndian<float>(value) / std::numeric_limits<qint16>::max();
-            break;
+void WavFile::stopStream()
+{
+    if (!m_streamThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_streamMutex);
+        m_streaming = false;
+    }
+    m_streamCondition.notify_all();
+    m_streamThread.join();
+}
+
+void WavFile::streamLoop()
+{
+    const qint64 align = blockAlign();
+    std::unique_lock<std::mutex> lock(m_streamMutex);
+    while (m_streaming) {
+        if (m_seekFrame >= 0) {
+            m_streamBase = m_seekFrame;
+            m_seekFrame = -1;
+            m_ringRead = m_ringWrite = 0;
+            m_streamFailed = false;
         }
 
-        case 24: {
-            qint32_le value(0);
-            memcpy(reinterpret_cast<char *>(&value) + 1, buffer.data(), 3);
-            s = qFromLittleEndian<double>(value) / std::numeric_limits<qint32>::max();
-            break;
+        auto free = RING_FRAMES - static_cast<qint64>(m_ringWrite - m_ringRead);
+        if (free < std::min(STREAM_FRAMES, m_frames) || m_streamFailed) {
+            m_streamCondition.wait(lock);
+            continue;
         }
 
-        case 32: {
-            qint32_le value;
-            memcpy(&value, buffer.data(), 4);
-            s = qFromLittleEndian<double>(value) / std::numeric_limits<qint32>::max();
-            break;
+        //the file is read out of the lock, the player reads only filled frames meanwhile
+        auto frame = static_cast<qint64>((m_streamBase + m_ringWrite) % m_frames);
+        auto offset = static_cast<qint64>(m_ringWrite % RING_FRAMES);
+        auto count = std::min({STREAM_FRAMES, free, m_frames - frame, RING_FRAMES - offset});
+        lock.unlock();
+        qint64 read = -1;
+        if (m_file.seek(m_dataPosition + frame * align)) {
+            read = m_file.read(m_ring.data() + offset * align, count * align);
         }
+        lock.lock();
 
-        default:
-            Q_UNREACHABLE();
-            qCritical() << "unknown bitsPerSample";
-            return NAN;
+        if (read < align) {
+            qWarning() << "can't read" << m_file.fileName() << m_file.errorString();
+            m_streamFailed = true;
+        } else if (m_seekFrame < 0) {
+            m_ringWrite += read / align;
         }
-        break;
+        m_streamCondition.notify_all();
+    }
+}
 
-    case WaveHeader::AudioFormat::FLOAT: {
-        float value;
-        memcpy(&value, buffer.data(), 4);
-        s = qFromLittleEndian<float>(value);
-        break;
+qint64 WavFile::streamFrames(qint64 frame, float *dst, qint64 count) noexcept
+{
+    std::unique_lock<std::mutex> lock(m_streamMutex, std::defer_lock);
+    //the reader holds the lock only between reads, the audio path doesn't wait even for that
+    const bool realtime = m_realtime;
+    if (!realtime) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return -1;
+    }
+
+    auto expected = (m_seekFrame >= 0 ? m_seekFrame : static_cast<qint64>((m_streamBase + m_ringRead) % m_frames));
+    if (expected != frame) {
+        m_seekFrame = frame;
+        m_streamCondition.notify_all();
+    }
+    if (!realtime) {
+        m_streamCondition.wait(lock, [this]() {
+            return !m_streaming || (m_seekFrame < 0 && (m_streamFailed || m_ringWrite > m_ringRead));
+        });
+    }
+    if (m_seekFrame >= 0 || m_ringWrite == m_ringRead) {
+        return (m_streamFailed && !realtime) || !m_streaming ? 0 : -1;
+    }
+
+    auto offset = static_cast<qint64>(m_ringRead % RING_FRAMES);
+    auto size = std::min({count, static_cast<qint64>(m_ringWrite - m_ringRead), RING_FRAMES - offset, m_frames - frame});
+    convert(m_ring.data() + offset * blockAlign(), dst, size * channels());
+    m_ringRead += size;
+    lock.unlock();
+    m_streamCondition.notify_all();
+    return size;
+}
+
+qint64 WavFile::readFrames(float *data, qint64 count, bool loop, bool *finished) noexcept
+{
+    qint64 done = 0;
+    while (done < count) {
+        if (m_position >= m_frames) {
+            if (loop && m_frames > 0) {
+                m_position = 0;
+            } else {
+                if (finished) {
+                    *finished = true;
+                }
+                break;
+            }
+        }
+
+        auto size = std::min(count - done, m_frames - m_position);
+        auto dst = data + done * channels();
+        if (!m_decoded.empty()) {
+            std::memcpy(dst, m_decoded.data() + m_position * channels(), size * channels() * sizeof(float));
+        } else if (m_mapped) {
+            convert(reinterpret_cast<const char *>(m_mapped) + m_position * blockAlign(), dst, size * channels());
+        } else {
+            auto read = streamFrames(m_position, dst, size);
+            if (read < 0) {
+                //underrun: silence, the position waits for the reader
+                std::fill(dst, data + count * channels(), 0.f);
+                return count;
+            }
+            if (read == 0) {
+                if (finished) {
+                    *finished = true;
+                }
+                break;
+            }
+            size = read;
+        }
+
+        m_position += size;
+        done += size;
     }
+    return done;
+}
+
+qint64 WavFile::readChannel(float *data, qint64 count, unsigned int channel, bool loop, bool *finished) noexcept
+{
+    if (channel >= channels()) {
+        return 0;
+    }
+    if (channels() == 1) {
+        return readFrames(data, count, loop, finished);
+    }
+
+    qint64 done = 0;
+    while (done < count) {
+        auto size = readFrames(m_scratch.data(), std::min(count - done, CACHE_FRAMES), loop, finished);
+        if (size == 0) {
+            break;
+        }
+        for (qint64 i = 0; i < size; ++i) {
+            data[done + i] = m_scratch[i * channels() + channel];
+        }
+        done += size;
+    }
+    return done;
+}
+
+float WavFile::nextSample(bool loop, bool *finished) noexcept
+{
+    if (m_cachePosition >= m_cacheSize) {
+        m_cachePosition = 0;
+        m_cacheSize = readChannel(m_cache.data(), m_cache.size(), 0, loop, finished);
+        if (m_cacheSize == 0) {
+            if (finished) {
+                *finished = true;
+            }
+            return NAN;
+        }
     }
 
-    return s;
+    return m_cache[m_cachePosition++];
 }
 
 QDebug operator << (QDebug dbg, const WavFile::WaveHeader &header)
@@ -210,12 +579,14 @@ QDebug operator << (QDebug dbg, const WavFile::WaveHeader &header)
 bool WavFile::WaveHeader::valid() const noexcept
 {
     return
-        memcmp(wave.chunk.id,   "RIFF", 4) == 0 &&
+        (memcmp(wave.chunk.id,  "RIFF", 4) == 0 ||
+         memcmp(wave.chunk.id,  "RF64", 4) == 0) &&
         memcmp(wave.format,     "WAVE", 4) == 0 &&
 
         memcmp(format.chunk.id, "fmt ", 4) == 0 &&
         (format.audioFormat == AudioFormat::PCM ||
-         format.audioFormat == AudioFormat::FLOAT) &&
+         format.audioFormat == AudioFormat::FLOAT ||
+         static_cast<quint16>(format.audioFormat) == AudioFormat::EXTENSIBLE) &&
         format.channels >= 1 &&
 
         memcmp(data.id, "data", 4) == 0;
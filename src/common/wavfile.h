@@ -19,19 +19,45 @@
 #define WAVFILE_H
 
 #include <QFile>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class WavFile
 {
 public:
+    //! files smaller than this are decoded into memory if they can't be mapped
+    static constexpr qint64 PRELOAD_LIMIT   = 64 * 1024 * 1024;
+    //! size of one streaming read in frames
+    static constexpr qint64 STREAM_FRAMES   = 64 * 1024;
+    //! frames kept ahead of the player when streaming
+    static constexpr qint64 RING_FRAMES     = 4 * STREAM_FRAMES;
+    //! frames decoded at once for nextSample()
+    static constexpr qint64 CACHE_FRAMES    = 1024;
+
     WavFile();
     ~WavFile();
 
     bool load(const QString &fileName);
+    void close();
     int sampleRate() const noexcept;
-    constexpr unsigned int blockAlign() const noexcept;
-    constexpr unsigned int bitsPerSample() const noexcept;
-    constexpr unsigned int sampleType() const noexcept;
-    constexpr unsigned int dataSize() const noexcept;
+    unsigned int channels() const noexcept;
+    qint64 frames() const noexcept;
+    unsigned int blockAlign() const noexcept;
+    unsigned int bitsPerSample() const noexcept;
+    unsigned int sampleType() const noexcept;
+    quint64 dataSize() const noexcept;
+
+    void rewind() noexcept;
+    //! for the audio path: reads never wait for the disk, a streaming underrun gives silence
+    void setRealtime(bool realtime) noexcept;
+
+    //! reads up to count interleaved frames, returns number of frames read
+    qint64 readFrames(float *data, qint64 count, bool loop, bool *finished = nullptr) noexcept;
+    //! reads up to count samples of the one channel
+    qint64 readChannel(float *data, qint64 count, unsigned int channel, bool loop, bool *finished = nullptr) noexcept;
 
     float nextSample(bool loop, bool *finished = nullptr) noexcept;
 
@@ -54,8 +80,9 @@ private:
         };
 
         struct AudioFormat {
-            const static qint16 PCM     = 1;
-            const static qint16 FLOAT   = 3;
+            const static qint16 PCM         = 1;
+            const static qint16 FLOAT       = 3;
+            const static quint16 EXTENSIBLE = 0xFFFE;
 
             Chunk chunk             = {{'f', 'm', 't', ' '}, 16};
             qint16 audioFormat  = PCM;    //! PCM = 1
@@ -66,6 +93,14 @@ private:
             qint16 bitsPerSample = 8;   //! 8 bits = 8, 16 bits = 16, etc.
         };
 
+        //! RF64 sizes, stored in the ds64 chunk
+        struct DataSize64 {
+            quint64 riffSize;
+            quint64 dataSize;
+            quint64 sampleCount;
+            quint32 tableLength;
+        };
+
         Wave wave;
         AudioFormat format;
         Chunk data = {{'d', 'a', 't', 'a'}, 0};
@@ -73,7 +108,38 @@ private:
         bool valid() const noexcept;
     } m_header;
 
+    bool readFormat(qint64 chunkSize);
+    bool prepareData();
+    void convert(const char *src, float *dst, qint64 samples) const noexcept;
+    void startStream();
+    void stopStream();
+    void streamLoop();
+    //! converts up to count frames from the ring, returns 0 at the end of data and -1 on underrun
+    qint64 streamFrames(qint64 frame, float *dst, qint64 count) noexcept;
+
     qint64 m_dataPosition;
+    quint64 m_dataSize;
+    qint16 m_sampleType;
+    unsigned int m_sampleBytes;
+    qint64 m_frames, m_position;
+
+    //one of three storages is used: mapped file, decoded samples or the streaming ring
+    uchar *m_mapped;
+    std::vector<float> m_decoded;
+
+    //the reader thread fills the ring ahead of the player, only it uses m_file while streaming.
+    //Frame n of the ring since the last seek is the file frame (m_streamBase + n) % m_frames
+    std::thread m_streamThread;
+    std::mutex m_streamMutex;
+    std::condition_variable m_streamCondition;
+    std::vector<char> m_ring;
+    qint64 m_streamBase, m_seekFrame;           //m_seekFrame is -1 without a pending seek
+    quint64 m_ringRead, m_ringWrite;
+    bool m_streaming, m_streamFailed;
+    std::atomic<bool> m_realtime;
+
+    std::vector<float> m_cache, m_scratch;
+    qint64 m_cachePosition, m_cacheSize;
 
     friend QDebug operator << (QDebug dbg, const WavFile::WaveHeader &header);
 };
@@ -0,0 +1,164 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "wavwriter.h"
+#include <QtEndian>
+#include <QDebug>
+#include <limits>
+
+namespace {
+
+template<typename T> void append(QByteArray &data, T value)
+{
+    char buffer[sizeof(T)];
+    qToLittleEndian(value, buffer);
+    data.append(buffer, sizeof(T));
+}
+
+void appendId(QByteArray &data, const char *id)
+{
+    data.append(id, 4);
+}
+
+}
+
+WavWriter::WavWriter() : m_file(), m_sampleRate(0), m_channels(0), m_dataSize(0)
+{
+}
+
+WavWriter::~WavWriter()
+{
+    close();
+}
+
+bool WavWriter::open(const QString &fileName, unsigned int sampleRate, unsigned int channels)
+{
+    close();
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_dataSize = 0;
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "can't open" << fileName << m_file.errorString();
+        return false;
+    }
+    return m_file.write(header()) == DATA_OFFSET;
+}
+
+bool WavWriter::write(const float *data, qint64 frames)
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    auto size = frames * m_channels * static_cast<qint64>(sizeof(float));
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    auto written = m_file.write(reinterpret_cast<const char *>(data), size);
+#else
+    QByteArray buffer;
+    buffer.reserve(size);
+    for (qint64 i = 0; i < frames * m_channels; ++i) {
+        append(buffer, data[i]);
+    }
+    auto written = m_file.write(buffer);
+#endif
+    if (written > 0) {
+        m_dataSize += written;
+    }
+    return written == size;
+}
+
+bool WavWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    bool result = m_file.seek(0) && m_file.write(header()) == DATA_OFFSET;
+    m_file.close();
+    return result;
+}
+
+bool WavWriter::isOpen() const noexcept
+{
+    return m_file.isOpen();
+}
+
+qint64 WavWriter::frames() const noexcept
+{
+    return m_channels ? m_dataSize / (m_channels * sizeof(float)) : 0;
+}
+
+QString WavWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+QByteArray WavWriter::header() const
+{
+    constexpr quint32 FMT_SIZE = 40;
+    constexpr quint32 DS64_SIZE = 28;
+    //RIFF + ds64/JUNK + fmt + JUNK header + data header
+    constexpr quint32 FILLER_SIZE = DATA_OFFSET - (12 + 8 + DS64_SIZE + 8 + FMT_SIZE + 8 + 8);
+    static const char floatGuid[16] = {
+        0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+        static_cast<char>(0x80), 0x00, 0x00, static_cast<char>(0xAA),
+        0x00, 0x38, static_cast<char>(0x9B), 0x71
+    };
+
+    quint64 riffSize = DATA_OFFSET - 8 + m_dataSize;
+    bool rf64 = riffSize > std::numeric_limits<quint32>::max();
+    quint16 blockAlign = m_channels * sizeof(float);
+
+    QByteArray data;
+    data.reserve(DATA_OFFSET);
+
+    appendId(data, rf64 ? "RF64" : "RIFF");
+    append<quint32>(data, rf64 ? 0xFFFFFFFF : static_cast<quint32>(riffSize));
+    appendId(data, "WAVE");
+
+    //reserved place for ds64, it is used only when the file is over 4 GiB
+    appendId(data, rf64 ? "ds64" : "JUNK");
+    append<quint32>(data, DS64_SIZE);
+    append<quint64>(data, rf64 ? riffSize : 0);
+    append<quint64>(data, rf64 ? m_dataSize : 0);
+    append<quint64>(data, rf64 ? frames() : 0);
+    append<quint32>(data, 0);
+
+    appendId(data, "fmt ");
+    append<quint32>(data, FMT_SIZE);
+    append<quint16>(data, 0xFFFE);
+    append<quint16>(data, m_channels);
+    append<quint32>(data, m_sampleRate);
+    append<quint32>(data, m_sampleRate * blockAlign);
+    append<quint16>(data, blockAlign);
+    append<quint16>(data, 32);
+    append<quint16>(data, 22);
+    append<quint16>(data, 32);
+    append<quint32>(data, 0);
+    data.append(floatGuid, sizeof(floatGuid));
+
+    appendId(data, "JUNK");
+    append<quint32>(data, FILLER_SIZE);
+    data.append(FILLER_SIZE, '\0');
+
+    appendId(data, "data");
+    append<quint32>(data, rf64 ? 0xFFFFFFFF : static_cast<quint32>(m_dataSize));
+
+    Q_ASSERT(data.size() == DATA_OFFSET);
+    return data;
+}
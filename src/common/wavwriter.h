@@ -0,0 +1,53 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <QFile>
+
+/**
+ * @brief The WavWriter class
+ * writes interleaved float32 frames to a WAVE_FORMAT_EXTENSIBLE file of unknown length.
+ * The header is padded with a JUNK chunk, so samples start at DATA_OFFSET and block writes stay aligned.
+ * If the data grows over 4 GiB the file is turned into RF64 on close().
+ */
+class WavWriter
+{
+public:
+    static constexpr qint64 DATA_OFFSET = 4096;
+
+    WavWriter();
+    ~WavWriter();
+
+    bool open(const QString &fileName, unsigned int sampleRate, unsigned int channels);
+    bool write(const float *data, qint64 frames);
+    bool close();
+
+    bool isOpen() const noexcept;
+    qint64 frames() const noexcept;
+    QString fileName() const;
+
+private:
+    QByteArray header() const;
+
+    QFile m_file;
+    unsigned int m_sampleRate, m_channels;
+    quint64 m_dataSize;
+};
+
+#endif // WAVWRITER_H
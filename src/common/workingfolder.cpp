@@ -32,6 +32,19 @@ QString workingfolder::autosaveFilePath()
     return common.isEmpty() ? "" : common + "/autosave.osm";
 }
 
+QString workingfolder::autosaveChunksPath()
+{
+    auto common = commonPath() ;
+    return common.isEmpty() ? "" : common + "/autosave";
+}
+
+QString workingfolder::pagesPath()
+{
+    //private copies of paged out data, the system may clean it up between runs
+    auto static path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return path.isEmpty() ? "" : path + "/pages";
+}
+
 QString workingfolder::settingsFilePath()
 {
     auto common = commonPath() ;
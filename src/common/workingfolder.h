@@ -26,6 +26,8 @@ class workingfolder
 public:
     static QString logFilePath();
     static QString autosaveFilePath();
+    static QString autosaveChunksPath();
+    static QString pagesPath();
     static QString settingsFilePath();
 
 private:
@@ -100,8 +100,16 @@ public:
     void resize(size_t size)
     {
         m_size = size;
-        m_data.resize(m_size, 0);
-        clear();
+        m_data.assign(m_size, 0);
+        reset();
+    }
+
+    //! frees memory, resize() allocates it again
+    void release()
+    {
+        std::vector<T>().swap(m_data);
+        m_size = 0;
+        reset();
     }
 private:
     std::atomic<size_t> m_size;
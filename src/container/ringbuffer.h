@@ -0,0 +1,102 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CONTAINER_RINGBUFFER_H
+#define CONTAINER_RINGBUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace container {
+
+/**
+ * single producer ring with a monotonic write position.
+ * The writer never blocks and overwrites the oldest data, readers keep their own positions
+ * and check that data wasn't overwritten while it was copied.
+ */
+template<typename T> class ringbuffer
+{
+public:
+    explicit ringbuffer(size_t size = 0) : m_data(), m_mask(0), m_written(0)
+    {
+        resize(size);
+    }
+
+    //! size is rounded up to the power of two, not thread safe
+    void resize(size_t size)
+    {
+        size_t capacity = 1;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+        m_data.assign(size ? capacity : 0, T{});
+        m_mask = size ? capacity - 1 : 0;
+        m_written.store(0);
+    }
+
+    size_t size() const noexcept
+    {
+        return m_data.size();
+    }
+
+    uint64_t written() const noexcept
+    {
+        return m_written.load(std::memory_order_acquire);
+    }
+
+    void write(const T *data, size_t count) noexcept
+    {
+        if (m_data.empty()) {
+            return;
+        }
+        auto position = m_written.load(std::memory_order_relaxed);
+        for (size_t done = 0; done < count; ) {
+            auto index = static_cast<size_t>((position + done) & m_mask);
+            auto part = std::min(count - done, m_data.size() - index);
+            std::memcpy(m_data.data() + index, data + done, part * sizeof(T));
+            done += part;
+        }
+        m_written.store(position + count, std::memory_order_release);
+    }
+
+    //! copies count items from position, returns false if any of them were overwritten
+    bool read(uint64_t position, T *data, size_t count) const noexcept
+    {
+        if (m_data.empty() || position + count > written()) {
+            return false;
+        }
+        for (size_t done = 0; done < count; ) {
+            auto index = static_cast<size_t>((position + done) & m_mask);
+            auto part = std::min(count - done, m_data.size() - index);
+            std::memcpy(data + done, m_data.data() + index, part * sizeof(T));
+            done += part;
+        }
+        return written() - position <= m_data.size();
+    }
+
+private:
+    std::vector<T> m_data;
+    uint64_t m_mask;
+    std::atomic<uint64_t> m_written;
+};
+
+} // namespace container
+
+#endif // CONTAINER_RINGBUFFER_H
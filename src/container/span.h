@@ -0,0 +1,63 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CONTAINER_SPAN_H
+#define CONTAINER_SPAN_H
+
+#include <cstddef>
+
+namespace container {
+//! non-owning view of a contiguous array, like C++20 std::span
+template<typename T> class span
+{
+public:
+    constexpr span() noexcept : m_data(nullptr), m_size(0) {}
+    constexpr span(T *data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+    constexpr T *data() const noexcept
+    {
+        return m_data;
+    }
+    constexpr std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+    constexpr bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    constexpr T &operator [](std::size_t i) const noexcept
+    {
+        return m_data[i];
+    }
+    constexpr T *begin() const noexcept
+    {
+        return m_data;
+    }
+    constexpr T *end() const noexcept
+    {
+        return m_data + m_size;
+    }
+
+private:
+    T *m_data;
+    std::size_t m_size;
+};
+}
+
+#endif // CONTAINER_SPAN_H
@@ -0,0 +1,141 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "exporter.h"
+#include <atomic>
+#include <memory>
+#include <set>
+#include <QDir>
+#include <QFileInfo>
+#include <QUrl>
+
+#include "stored.h"
+#include "common/scheduler.h"
+
+Exporter::Exporter(QObject *parent) : QObject(parent)
+{
+}
+
+const QStringList &Exporter::formats()
+{
+    static const QStringList list {"osm", "json", "cal", "frd", "txt", "csv", "wav"};
+    return list;
+}
+
+std::vector<Exporter::Job> Exporter::jobs(const QList<Source::Shared> &sources, const QStringList &formats,
+                                          const QString &folder)
+{
+    std::vector<Job> list;
+    std::set<QString> used;
+    QDir dir(folder);
+    for (auto &source : sources) {
+        if (!source) {
+            continue;
+        }
+        auto base = source->name();
+        for (auto c : {'/', '\\', ':', '*', '?', '"', '<', '>', '|'}) {
+            base.replace(c, '_');
+        }
+        if (base.trimmed().isEmpty()) {
+            base = "trace";
+        }
+
+        //the same name is used for all formats of a source
+        auto name = base;
+        auto taken = [&]() {
+            for (auto &format : formats) {
+                auto fileName = dir.filePath(name + "." + format.toLower());
+                if (used.count(fileName.toLower()) || QFileInfo::exists(fileName)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        for (int i = 2; taken(); ++i) {
+            name = QString("%1 %2").arg(base).arg(i);
+        }
+
+        for (auto &format : formats) {
+            auto suffix = format.toLower();
+            if (!Exporter::formats().contains(suffix)) {
+                continue;
+            }
+            auto fileName = dir.filePath(name + "." + suffix);
+            used.insert(fileName.toLower());
+            list.push_back({source, suffix, fileName});
+        }
+    }
+    return list;
+}
+
+void Exporter::run(const std::vector<Job> &jobs, const Callback &done)
+{
+    const auto total = static_cast<int>(jobs.size());
+    std::atomic<int> count{0};
+
+    std::vector<Scheduler::Task> tasks;
+    tasks.reserve(jobs.size());
+    for (auto &job : jobs) {
+        tasks.push_back([this, &job, &done, &count, total]() {
+            auto result = exportFile(job);
+            done(result);
+            emit progress(QFileInfo(job.fileName).fileName(), ++count, total);
+        });
+    }
+    Scheduler::getInstance()->parallel(tasks);
+}
+
+Exporter::Result Exporter::exportFile(const Job &job)
+{
+    Result result;
+    result.fileName = job.fileName;
+
+    //other sources keep working, their current data is copied for the file
+    auto stored = dynamic_cast<const Stored *>(job.source.get());
+    std::unique_ptr<Stored> snapshot;
+    if (!stored) {
+        snapshot = std::make_unique<Stored>();
+        snapshot->build(job.source.get());
+        snapshot->setName(job.source->name());
+        stored = snapshot.get();
+    }
+
+    auto url = QUrl::fromLocalFile(job.fileName);
+    bool saved = false;
+    if (job.format == "osm" || job.format == "json") {
+        saved = stored->save(url);
+    } else if (job.format == "cal") {
+        saved = stored->saveCal(url);
+    } else if (job.format == "frd") {
+        saved = stored->saveFRD(url);
+    } else if (job.format == "txt") {
+        saved = stored->saveTXT(url);
+    } else if (job.format == "csv") {
+        saved = stored->saveCSV(url);
+    } else if (job.format == "wav") {
+        saved = stored->saveWAV(url);
+    } else {
+        result.error = "unknown format " + job.format;
+        return result;
+    }
+
+    result.success = saved;
+    if (!saved) {
+        result.error = "couldn't write file";
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <QObject>
+#include <QStringList>
+#include <functional>
+#include <vector>
+
+#include "source/source_shared.h"
+
+/**
+ * @brief The Exporter class
+ * writes many traces in many formats at once. Every file is a task on the Scheduler pool,
+ * sources that aren't stored are exported from a snapshot of their current data.
+ */
+class Exporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Job {
+        Source::Shared source;
+        QString format;
+        QString fileName;
+    };
+
+    struct Result {
+        QString fileName;
+        bool success = false;
+        QString error;
+    };
+    using Callback = std::function<void(const Result &)>;
+
+    explicit Exporter(QObject *parent = nullptr);
+
+    //! osm, json, cal, frd, txt, csv, wav
+    static const QStringList &formats();
+
+    //! a job per source and format, files are named after the sources and don't overwrite each other
+    static std::vector<Job> jobs(const QList<Source::Shared> &sources, const QStringList &formats,
+                                 const QString &folder);
+
+    //! writes files in parallel, done is called for every file as soon as it is written
+    void run(const std::vector<Job> &jobs, const Callback &done);
+    static Result exportFile(const Job &job);
+
+signals:
+    void progress(QString fileName, int done, int total);
+};
+
+#endif // EXPORTER_H
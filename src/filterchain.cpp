@@ -0,0 +1,484 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "filterchain.h"
+#include <algorithm>
+#include <QJsonArray>
+#include "stored.h"
+#include "common/scheduler.h"
+
+FilterChain::FilterChain(QObject *parent) : Source::Abstract(parent),
+    m_stagesMutex(), m_stages(), m_nextId(1), m_mode(Meta::Measurement::FFT14), m_sampleRate(48000),
+    m_responses(), m_grid(), m_real(), m_imag(), m_usedMode(Meta::Measurement::FFT14), m_usedSampleRate(0),
+    m_changes(1), m_usedChanges(0)
+{
+    setObjectName("FilterChain");
+    setName("Filter chain");
+    setActive(true);
+
+    connect(this, &FilterChain::modeChanged, this, &FilterChain::update);
+    connect(this, &FilterChain::sampleRateChanged, this, &FilterChain::update);
+    connect(this, &FilterChain::stagesChanged, this, &FilterChain::update);
+    connect(this, &FilterChain::stageChanged, this, &FilterChain::update);
+    connect(this, &FilterChain::activeChanged, this, &FilterChain::update);
+    update();
+}
+
+FilterChain::~FilterChain()
+{
+    Scheduler::getInstance()->cancel(this);
+}
+
+Source::Shared FilterChain::clone() const
+{
+    auto cloned = std::make_shared<FilterChain>();
+    cloned->setActive(active());
+    cloned->setName(name());
+    cloned->setMode(mode());
+    cloned->setSampleRate(sampleRate());
+    cloned->setStages(stages());
+
+    return std::static_pointer_cast<Source::Abstract>(cloned);
+}
+
+QJsonObject FilterChain::toJSON(const SourceList *list) const noexcept
+{
+    auto object = Source::Abstract::toJSON(list);
+
+    object["mode"]          = mode();
+    object["sampleRate"]    = static_cast<int>(sampleRate());
+
+    QJsonArray stagesData;
+    for (auto &stage : stages()) {
+        QJsonObject stageData;
+        stageData["type"]       = static_cast<int>(stage.filter.type);
+        stageData["order"]      = static_cast<int>(stage.filter.order);
+        stageData["frequency"]  = stage.filter.frequency;
+        stageData["gain"]       = stage.filter.gain;
+        stageData["q"]          = stage.filter.q;
+        stageData["delay"]      = stage.filter.delay;
+        stageData["enabled"]    = stage.enabled;
+        stagesData.append(stageData);
+    }
+    object["stages"] = stagesData;
+
+    return object;
+}
+
+void FilterChain::fromJSON(QJsonObject data, const SourceList *list) noexcept
+{
+    Source::Abstract::fromJSON(data, list);
+
+    auto variantMode = data["mode"].toVariant();
+    if (variantMode.isValid()) {
+        setMode(variantMode.value<Meta::Measurement::Mode>());
+    }
+    setSampleRate(data["sampleRate"].toInt(sampleRate()));
+
+    std::vector<Stage> stages;
+    for (const auto &item : data["stages"].toArray()) {
+        auto stageData = item.toObject();
+        Stage stage;
+        stage.filter.type       = static_cast<Meta::Filter::Type>(stageData["type"].toInt(stage.filter.type));
+        stage.filter.order      = stageData["order"].toInt(stage.filter.order);
+        stage.filter.frequency  = stageData["frequency"].toDouble(stage.filter.frequency);
+        stage.filter.gain       = stageData["gain"].toDouble(stage.filter.gain);
+        stage.filter.q          = stageData["q"].toDouble(stage.filter.q);
+        stage.filter.delay      = stageData["delay"].toDouble(stage.filter.delay);
+        stage.enabled           = stageData["enabled"].toBool(true);
+        stages.push_back(stage);
+    }
+    setStages(std::move(stages));
+}
+
+Source::Shared FilterChain::store()
+{
+    auto store = std::make_shared<Stored>();
+    store->build(this);
+    store->autoName(name());
+    store->setNotes(stageNames().join("\n"));
+    return { store };
+}
+
+Meta::Measurement::Mode FilterChain::mode() const
+{
+    std::lock_guard<std::mutex> guard(m_stagesMutex);
+    return m_mode;
+}
+
+void FilterChain::setMode(Meta::Measurement::Mode newMode)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        if (m_mode == newMode) {
+            return;
+        }
+        m_mode = newMode;
+    }
+    emit modeChanged();
+}
+
+unsigned int FilterChain::sampleRate() const
+{
+    std::lock_guard<std::mutex> guard(m_stagesMutex);
+    return m_sampleRate;
+}
+
+void FilterChain::setSampleRate(unsigned int newSampleRate)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        if (m_sampleRate == newSampleRate || !newSampleRate) {
+            return;
+        }
+        m_sampleRate = newSampleRate;
+    }
+    emit sampleRateChanged();
+}
+
+QVariant FilterChain::getAvailableModes()
+{
+    return Meta::Measurement::getAvailableModes();
+}
+
+QVariant FilterChain::getAvailableTypes()
+{
+    QStringList typeList;
+    for (const auto &type : Meta::Filter::m_typeMap) {
+        typeList << type.second;
+    }
+    return typeList;
+}
+
+int FilterChain::count() const
+{
+    std::lock_guard<std::mutex> guard(m_stagesMutex);
+    return static_cast<int>(m_stages.size());
+}
+
+QStringList FilterChain::stageNames() const
+{
+    QStringList names;
+    for (auto &stage : stages()) {
+        names << stageName(stage);
+    }
+    return names;
+}
+
+std::vector<FilterChain::Stage> FilterChain::stages() const
+{
+    std::lock_guard<std::mutex> guard(m_stagesMutex);
+    return m_stages;
+}
+
+void FilterChain::setStages(std::vector<Stage> stages)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        for (auto &stage : stages) {
+            stage.id = m_nextId++;
+        }
+        m_stages = std::move(stages);
+    }
+    emit stagesChanged();
+}
+
+int FilterChain::addStage(int type)
+{
+    Stage stage;
+    stage.filter.type = static_cast<Meta::Filter::Type>(type);
+    auto available = Meta::Filter::availableOrders(stage.filter.type);
+    if (available.isEmpty()) {
+        return -1;
+    }
+    stage.filter.order = available.first().toUInt();
+
+    int index;
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        stage.id = m_nextId++;
+        m_stages.push_back(stage);
+        index = static_cast<int>(m_stages.size()) - 1;
+    }
+    emit stagesChanged();
+    return index;
+}
+
+void FilterChain::removeStage(int index)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        if (index < 0 || index >= static_cast<int>(m_stages.size())) {
+            return;
+        }
+        m_stages.erase(m_stages.begin() + index);
+    }
+    emit stagesChanged();
+}
+
+QVariantMap FilterChain::stage(int index) const
+{
+    std::lock_guard<std::mutex> guard(m_stagesMutex);
+    if (index < 0 || index >= static_cast<int>(m_stages.size())) {
+        return {};
+    }
+    auto &stage = m_stages[index];
+    return {
+        {"type",        static_cast<int>(stage.filter.type)},
+        {"order",       stage.filter.order},
+        {"frequency",   stage.filter.frequency},
+        {"gain",        stage.filter.gain},
+        {"q",           stage.filter.q},
+        {"delay",       stage.filter.delay},
+        {"enabled",     stage.enabled}
+    };
+}
+
+void FilterChain::setStage(int index, const QString &key, const QVariant &value)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        if (index < 0 || index >= static_cast<int>(m_stages.size())) {
+            return;
+        }
+        auto stage = m_stages[index];
+        auto &filter = stage.filter;
+        if (key == "type") {
+            filter.type = static_cast<Meta::Filter::Type>(value.toInt());
+            auto available = Meta::Filter::availableOrders(filter.type);
+            if (!available.isEmpty() && !available.contains(static_cast<int>(filter.order))) {
+                filter.order = available.first().toUInt();
+            }
+        } else if (key == "order") {
+            filter.order = value.toUInt();
+        } else if (key == "frequency") {
+            filter.frequency = std::max(value.toFloat(), 1.f);
+        } else if (key == "gain") {
+            filter.gain = value.toFloat();
+        } else if (key == "q") {
+            filter.q = std::max(value.toFloat(), 0.01f);
+        } else if (key == "delay") {
+            filter.delay = value.toFloat();
+        } else if (key == "enabled") {
+            stage.enabled = value.toBool();
+        } else {
+            qWarning() << "filter chain: unknown stage property" << key;
+            return;
+        }
+        if (filter == m_stages[index].filter && stage.enabled == m_stages[index].enabled) {
+            return;
+        }
+        m_stages[index] = stage;
+    }
+    emit stageChanged(index);
+    emit stagesChanged();
+}
+
+QVariant FilterChain::orders(int type) const
+{
+    return Meta::Filter::availableOrders(static_cast<Meta::Filter::Type>(type));
+}
+
+void FilterChain::update()
+{
+    //edits in a row are one calc with the latest stages
+    ++m_changes;
+    Scheduler::getInstance()->submit(this, "FilterChain::calc", [this]() {
+        calc();
+    });
+}
+
+void FilterChain::pageIn()
+{
+    if (!active()) {
+        calc(true);
+    }
+}
+
+void FilterChain::calc(bool force)
+{
+    //hidden: sources that read the chain are told, they calc it with pageIn()
+    if (!active() && !force) {
+        emit readyRead();
+        return;
+    }
+
+    //taken before the stages: an edit made meanwhile is applied by the next calc
+    auto changes = m_changes.load();
+    std::vector<Stage> stages;
+    Meta::Measurement::Mode mode;
+    unsigned int sampleRate;
+    {
+        std::lock_guard<std::mutex> guard(m_stagesMutex);
+        stages = m_stages;
+        mode = m_mode;
+        sampleRate = m_sampleRate;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        if (changes == m_usedChanges) {
+            return;
+        }
+        m_usedChanges = changes;
+        if (mode != m_usedMode || sampleRate != m_usedSampleRate || m_grid.empty()) {
+            m_responses.clear();
+            if (!resize(mode, sampleRate)) {
+                m_grid.clear();
+                m_deconvolutionSize = 0;
+                m_dataLength = 0;
+                publish();
+                return;
+            }
+        }
+
+        //responses of removed stages are dropped
+        for (auto it = m_responses.begin(); it != m_responses.end(); ) {
+            auto used = std::any_of(stages.cbegin(), stages.cend(), [id = it->first](const auto & stage) {
+                return stage.id == id;
+            });
+            it = (used ? std::next(it) : m_responses.erase(it));
+        }
+
+        const auto size = m_grid.size();
+        std::fill(m_real.begin(), m_real.end(), 1.f);
+        std::fill(m_imag.begin(), m_imag.end(), 0.f);
+        for (auto &stage : stages) {
+            if (!stage.enabled) {
+                continue;
+            }
+            auto &response = m_responses[stage.id];
+            if (response.real.size() != size || response.filter != stage.filter) {
+                response.filter = stage.filter;
+                response.real.resize(size);
+                response.imag.resize(size);
+                stage.filter.response(m_grid.data(), size, response.real.data(), response.imag.data());
+            }
+
+            //plain arrays: the compiler vectorises the complex product
+            auto re = m_real.data(), im = m_imag.data();
+            auto sr = response.real.data(), si = response.imag.data();
+            for (std::size_t i = 0; i < size; ++i) {
+                auto r = re[i] * sr[i] - im[i] * si[i];
+                im[i]  = re[i] * si[i] + im[i] * sr[i];
+                re[i]  = r;
+            }
+        }
+
+        for (unsigned int i = 0; i < m_dataLength; ++i) {
+            complex H{m_real[i], m_imag[i]};
+            m_ftdata.module[i]      = H.abs();
+            m_ftdata.magnitude[i]   = m_ftdata.module[i];
+            m_ftdata.phase[i]       = H.normalize();
+        }
+
+        auto inverseSize = size - m_dataLength;
+        for (unsigned int i = 0; i < inverseSize; ++i) {
+            complex v{m_real[m_dataLength + i], m_imag[m_dataLength + i]};
+            m_inverse.set(i, v.conjugate(), 0.f);
+            m_inverse.set(m_deconvolutionSize - i - 1, v, 0.f);
+        }
+        m_inverse.transformSingleChannel();
+
+        auto norm = 1.f / m_deconvolutionSize;
+        for (unsigned int i = 0, j = m_deconvolutionSize / 2 - 1; i < m_deconvolutionSize; i++, j++) {
+            if (j >= m_deconvolutionSize) {
+                j -= m_deconvolutionSize;
+            }
+            m_impulseData.value[j] = m_inverse.af(i).real * norm;
+        }
+        publish();
+    }
+    //the reader that forced the calc takes the data itself
+    if (!force) {
+        emit readyRead();
+    }
+}
+
+bool FilterChain::resize(Meta::Measurement::Mode mode, unsigned int sampleRate)
+{
+    m_dataFT.setSampleRate(sampleRate);
+    m_inverse.setSampleRate(sampleRate);
+
+    try {
+        using M = Meta::Measurement;
+        switch (mode) {
+        case M::Mode::LFT:
+            m_dataFT.setType(FourierTransform::Log);
+            m_deconvolutionSize = pow(2, M::m_FFTsizes.at(M::FFT12));
+            break;
+
+        default:
+            m_dataFT.setType(FourierTransform::Fast);
+            m_dataFT.setSize(pow(2, M::m_FFTsizes.at(mode)));
+            m_deconvolutionSize = pow(2, M::m_FFTsizes.at(mode));
+        }
+    } catch (std::exception &e) {
+        qWarning() << "filter chain: unsupported mode" << mode << "in" << name() << e.what();
+        return false;
+    }
+    m_usedMode = mode;
+    m_usedSampleRate = sampleRate;
+
+    m_inverse.setType(FourierTransform::Fast);
+    m_inverse.setSize(m_deconvolutionSize);
+    m_inverse.prepare();
+    m_dataFT.prepare();
+
+    m_ftdata.axis = Source::Axis::fromTransform(m_dataFT);
+    m_dataLength = m_ftdata.axis->size();
+    m_ftdata.resize(m_dataLength);
+    std::fill(m_ftdata.coherence.begin(), m_ftdata.coherence.end(), 1.f);
+
+    m_grid.assign(m_ftdata.axis->data(), m_ftdata.axis->data() + m_dataLength);
+    auto inverse = m_inverse.getFrequencies();
+    m_grid.insert(m_grid.end(), inverse.cbegin(), inverse.cend());
+    m_real.resize(m_grid.size());
+    m_imag.resize(m_grid.size());
+
+    m_impulseData.resize(m_deconvolutionSize);
+    int t = 0;
+    float kt = 1000.f / sampleRate;
+    for (unsigned int i = 0, j = m_deconvolutionSize / 2 - 1; i < m_deconvolutionSize; i++, j++, t++) {
+        if (t > static_cast<int>(m_deconvolutionSize / 2)) {
+            t -= static_cast<int>(m_deconvolutionSize);
+            j -= m_deconvolutionSize;
+        }
+        m_impulseData.time[j]  = t * kt;//ms
+    }
+    return true;
+}
+
+QString FilterChain::stageName(const Stage &stage)
+{
+    auto &filter = stage.filter;
+    auto name = Meta::Filter::m_typeShortMap.count(filter.type) ? Meta::Filter::m_typeShortMap.at(filter.type) : QString("?");
+    switch (filter.type) {
+    case Meta::Filter::Delay:
+        name += QString(" %1 ms").arg(static_cast<double>(filter.delay), 0, 'f', 2);
+        break;
+    case Meta::Filter::Peak:
+    case Meta::Filter::LowShelf:
+    case Meta::Filter::HighShelf:
+        name += QString(" %1 Hz %2 dB").arg(static_cast<double>(filter.frequency), 0, 'f', 0)
+                .arg(static_cast<double>(filter.gain), 0, 'f', 1);
+        break;
+    default:
+        name += QString(" %1 %2 Hz").arg(filter.order).arg(static_cast<double>(filter.frequency), 0, 'f', 0);
+    }
+    return stage.enabled ? name : "(" + name + ")";
+}
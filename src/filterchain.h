@@ -0,0 +1,127 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FILTERCHAIN_H
+#define FILTERCHAIN_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <QtQml>
+#include "meta/metafilter.h"
+#include "source/source_abstract.h"
+#include "math/analogfilter.h"
+#include "math/fouriertransform.h"
+
+/**
+ * @brief The FilterChain class
+ * cascade of analog filters (crossovers, all-pass, peak, shelves, delay) shown as one source.
+ * The response of every stage over the bins is cached, so an edit recomputes only the edited stage
+ * and the product of the cached responses. The calculation and the inverse transform of the impulse
+ * run as one coalesced task on the Scheduler. A hidden chain is calculated only when it is read.
+ */
+class FilterChain : public Source::Abstract
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(QVariant modes READ getAvailableModes CONSTANT)
+    Q_PROPERTY(QVariant types READ getAvailableTypes CONSTANT)
+
+    Q_PROPERTY(Meta::Measurement::Mode mode READ mode WRITE setMode NOTIFY modeChanged)
+    Q_PROPERTY(unsigned int sampleRate READ sampleRate WRITE setSampleRate NOTIFY sampleRateChanged)
+
+    Q_PROPERTY(int count READ count NOTIFY stagesChanged)
+    Q_PROPERTY(QStringList stageNames READ stageNames NOTIFY stagesChanged)
+
+public:
+    struct Stage {
+        quint32 id = 0;
+        bool enabled = true;
+        math::AnalogFilter filter;
+    };
+
+    FilterChain(QObject *parent = nullptr);
+    ~FilterChain();
+
+    Source::Shared clone() const override;
+    Q_INVOKABLE QJsonObject toJSON(const SourceList *list = nullptr) const noexcept override;
+    void fromJSON(QJsonObject data, const SourceList *list = nullptr) noexcept override;
+
+    Q_INVOKABLE Source::Shared store()  override;
+    void pageIn() override;
+
+    Meta::Measurement::Mode mode() const;
+    void setMode(Meta::Measurement::Mode newMode);
+
+    unsigned int sampleRate() const;
+    void setSampleRate(unsigned int newSampleRate);
+
+    static QVariant getAvailableModes();
+    static QVariant getAvailableTypes();
+
+    int count() const;
+    QStringList stageNames() const;
+
+    std::vector<Stage> stages() const;
+    //! replaces all stages, ids are given to them here
+    void setStages(std::vector<Stage> stages);
+
+    //! appends a stage with default parameters of the type, returns its index
+    Q_INVOKABLE int addStage(int type);
+    Q_INVOKABLE void removeStage(int index);
+
+    //! type, order, frequency, gain, q, delay and enabled of the stage
+    Q_INVOKABLE QVariantMap stage(int index) const;
+    Q_INVOKABLE void setStage(int index, const QString &key, const QVariant &value);
+    Q_INVOKABLE QVariant orders(int type) const;
+
+signals:
+    void modeChanged();
+    void sampleRateChanged();
+    void stagesChanged();
+    void stageChanged(int index);
+
+private:
+    void update();
+    void calc(bool force = false);
+    bool resize(Meta::Measurement::Mode mode, unsigned int sampleRate);
+    static QString stageName(const Stage &stage);
+
+    //settings and stages, locked before m_dataMutex
+    mutable std::mutex m_stagesMutex;
+    std::vector<Stage> m_stages;
+    quint32 m_nextId;
+    Meta::Measurement::Mode m_mode;
+    unsigned int m_sampleRate;
+
+    //used by calc only
+    struct Response {
+        math::AnalogFilter filter;
+        std::vector<float> real, imag;
+    };
+    std::map<quint32, Response> m_responses;
+    std::vector<float> m_grid;          //bins of the axis, then bins of the inverse transform
+    std::vector<float> m_real, m_imag;  //product of the stages over the grid
+    Meta::Measurement::Mode m_usedMode;
+    unsigned int m_usedSampleRate;
+    FourierTransform m_dataFT, m_inverse;
+    std::atomic<quint64> m_changes;     //edits of the stages and settings
+    quint64 m_usedChanges;              //edits applied by the last calc
+};
+
+#endif // FILTERCHAIN_H
@@ -30,6 +30,7 @@ FilterSource::FilterSource(QObject *parent) : Source::Abstract(parent), Meta::Fi
     connect(this, &FilterSource::orderChanged, this, &FilterSource::update);
     connect(this, &FilterSource::gainChanged, this, &FilterSource::update);
     connect(this, &FilterSource::qChanged, this, &FilterSource::update);
+    connect(this, &FilterSource::delayChanged, this, &FilterSource::update);
     connect(this, &FilterSource::cornerFrequencyChanged, this, &FilterSource::update);
     connect(this, &FilterSource::sampleRateChanged, this, &FilterSource::update);
 
@@ -47,6 +48,9 @@ Source::Shared FilterSource::clone() const
     cloned->setMode(mode());
     cloned->setType(type());
     cloned->setCornerFrequency(cornerFrequency());
+    cloned->setGain(gain());
+    cloned->setQ(q());
+    cloned->setDelay(delay());
     cloned->setOrder(order());
     cloned->setSampleRate(sampleRate());
 
@@ -62,6 +66,7 @@ QJsonObject FilterSource::toJSON(const SourceList *list) const noexcept
     object["cornerFrequency"]     = cornerFrequency();
     object["gain"]          = gain();
     object["q"]             = q();
+    object["delay"]         = delay();
     object["order"]         = static_cast<int>(order());
     object["sampleRate"]    = static_cast<int>(sampleRate());
 
@@ -88,6 +93,7 @@ void FilterSource::fromJSON(QJsonObject data, const SourceList *list) noexcept
     setCornerFrequency( data["cornerFrequency"].toDouble(cornerFrequency()));
     setGain( data["gain"].toDouble(cornerFrequency()));
     setQ(    data["q"].toDouble(cornerFrequency()));
+    setDelay(data["delay"].toDouble(delay()));
 }
 
 Source::Shared FilterSource::store()
@@ -123,6 +129,7 @@ void FilterSource::update()
             qDebug() << __FILE__ << ":" << __LINE__  << e.what();
             m_deconvolutionSize = 0;
             m_dataLength = 0;
+            publish();
             return;
         }
 
@@ -131,26 +138,24 @@ void FilterSource::update()
         m_inverse.prepare();
         m_dataFT.prepare();
 
-        auto frequencyList = m_dataFT.getFrequencies();
-        m_dataLength = frequencyList.size();
+        m_ftdata.axis = Source::Axis::fromTransform(m_dataFT);
+        m_dataLength = m_ftdata.axis->size();
         m_ftdata.resize(m_dataLength);
-        unsigned int i = 0;
-        for (auto frequency : frequencyList) {
-            auto H = calculate(frequency);
-
-            m_ftdata[i].frequency   = frequency;
-            m_ftdata[i].module      = H.abs();
-            m_ftdata[i].coherence   = 1.f;
-            m_ftdata[i].magnitude   = H.abs();
-            m_ftdata[i].phase       = H.normalize();
-            ++i;
+        auto filter = this->filter();
+        for (unsigned int i = 0; i < m_dataLength; ++i) {
+            auto H = filter.response((*m_ftdata.axis)[i]);
+
+            m_ftdata.module[i]      = H.abs();
+            m_ftdata.coherence[i]   = 1.f;
+            m_ftdata.magnitude[i]   = H.abs();
+            m_ftdata.phase[i]       = H.normalize();
         }
 
         m_impulseData.resize(m_deconvolutionSize);
 
-        frequencyList = m_inverse.getFrequencies();
+        auto frequencyList = m_inverse.getFrequencies();
         for (unsigned int i = 0; i < frequencyList.size(); ++i) {
-            auto v = calculate(frequencyList[i]);
+            auto v = filter.response(frequencyList[i]);
             if (std::isnan(v.real) || std::isnan(v.imag)) {
                 v = 0;
             }
@@ -169,9 +174,10 @@ void FilterSource::update()
                 j -= m_deconvolutionSize;
             }
 
-            m_impulseData[j].value = m_inverse.af(i).real * norm;
-            m_impulseData[j].time  = t * kt;//ms
+            m_impulseData.value[j] = m_inverse.af(i).real * norm;
+            m_impulseData.time[j]  = t * kt;//ms
         }
+        publish();
     }
     emit readyRead();
 }
@@ -188,149 +194,16 @@ void FilterSource::applyAutoName()
     }
 }
 
-complex FilterSource::calculate(float frequency) const
+math::AnalogFilter FilterSource::filter() const
 {
-    auto w = frequency / cornerFrequency();
-    auto s = complex::i * w;
-
-    switch (type()) {
-    case ButterworthHPF:
-        return Butterworth(true, order(), s);
-    case ButterworthLPF:
-        return Butterworth(false, order(), s);
-    case LinkwitzRileyHPF:
-        return LinkwitzRiley(true, s);
-    case LinkwitzRileyLPF:
-        return LinkwitzRiley(false, s);
-    case BesselHPF:
-        return Bessel(true, s);
-    case BesselLPF:
-        return Bessel(false, s);
-    case APF:
-        return calculateAPF(s);
-    case Peak:
-        return calculatePeak(s);
-    }
-}
-
-complex FilterSource::Bessel(bool hpf, complex s) const
-{
-    auto n  = order();
-
-    auto factorial = [](unsigned long k) {
-        unsigned long value = 1;
-        for (unsigned long i = 2; i <= k; ++i) {
-            value *= i;
-        }
-        return value;
-    };
-
-    auto a = [&n, &factorial](unsigned long k) -> float {
-        return factorial(2 * n - k) / (std::pow(2.0, n - k) * factorial(k) * factorial(n - k));
-    };
-
-    complex s_k = 1;
-    complex numerator = a(0);
-    complex denominator = 0;
-    float orderK = 1;
-
-    switch (order()) {
-    case 2:
-        orderK = 4 / 3.f;
-        break;
-    case 3:
-        orderK = 1.755672389;
-        break;
-    case 4:
-        orderK = 2.113917675;
-        break;
-    case 5:
-        orderK = 2.427410702;
-        break;
-    case 6:
-        orderK = 2.703395061;
-        break;
-    }
-
-    if (hpf) {
-        s = complex{1, 0} / s;
-    }
-    s *= orderK;
-
-
-
-    for (unsigned int k = 0; k <= n; ++k) {
-        denominator += s_k * a(k);
-        s_k *= s;
-    }
-
-    return numerator / denominator;
-}
-
-complex FilterSource::calculateAPF(complex s) const
-{
-    float q;
-    complex numerator;
-    complex denominator;
-
-    switch (order()) {
-    case 2:
-        q = 1.f / 2;
-        numerator = s * s - 1;
-        denominator = s * s + s / q + 1;
-        break;
-    case 4:
-        q = 1.f / sqrt(2);
-        numerator = s * s - s / q + 1;
-        denominator = s * s + s / q + 1;
-        break;
-    }
-
-    return numerator / denominator;
-}
-
-complex FilterSource::calculatePeak(complex s) const
-{
-    float a;
-    complex numerator;
-    complex denominator;
-
-    a = std::pow(10, gain() / 40);
-    numerator   = s * s + (s * a) / q() + 1;
-    denominator = s * s + s / (a * q()) + 1;
-
-    return numerator / denominator;
-}
-
-complex FilterSource::Butterworth(bool hpf, unsigned int order, const complex &s) const
-{
-    complex numerator = 1;
-    if (hpf) {
-        for (unsigned int i = 0; i < order; ++i) {
-            numerator *= s;
-        }
-    }
-
-    bool odd = order % 2;
-    complex denominator = (odd ? (s + 1) : 1);
-    unsigned int lastK = (order - (odd % 2 ? 1 : 0)) / 2;
-    for (unsigned int k = 1; k <= lastK; ++k) {
-        denominator *= ButterworthPolinom(k, order, s);
-    }
-
-    return numerator / denominator;
-}
-
-complex FilterSource::ButterworthPolinom(unsigned int k, unsigned int order, const complex &s) const
-{
-    float b =  -2 * cos((2 * k + order - 1) * M_PI / (2 * order));
-    return s * s + s * b + 1;
-}
-
-complex FilterSource::LinkwitzRiley(bool hpf, const complex &s) const
-{
-    auto b = Butterworth(hpf, order() / 2, s);
-    return b * b;
+    math::AnalogFilter filter;
+    filter.type      = type();
+    filter.order     = order();
+    filter.frequency = cornerFrequency();
+    filter.gain      = gain();
+    filter.q         = q();
+    filter.delay     = delay();
+    return filter;
 }
 
 bool FilterSource::autoName() const
@@ -21,6 +21,7 @@
 #include <QtQml>
 #include "meta/metafilter.h"
 #include "source/source_abstract.h"
+#include "math/analogfilter.h"
 #include "math/fouriertransform.h"
 
 class FilterSource : public Source::Abstract, public Meta::Filter
@@ -42,6 +43,7 @@ class FilterSource : public Source::Abstract, public Meta::Filter
     Q_PROPERTY(float cornerFrequency READ cornerFrequency WRITE setCornerFrequency NOTIFY cornerFrequencyChanged)
     Q_PROPERTY(float gain READ gain WRITE setGain NOTIFY gainChanged)
     Q_PROPERTY(float q READ q WRITE setQ NOTIFY qChanged)
+    Q_PROPERTY(float delay READ delay WRITE setDelay NOTIFY delayChanged)
 
 public:
     FilterSource(QObject *parent = nullptr);
@@ -63,6 +65,7 @@ signals:
     void orderChanged(unsigned int) override;
     void gainChanged(float) override;
     void qChanged(float) override;
+    void delayChanged(float) override;
     void autoNameChanged();
 
 private slots:
@@ -70,15 +73,7 @@ private slots:
     void applyAutoName();
 
 private:
-    complex calculate(float frequency) const;
-    complex Bessel(bool hpf, complex s) const;
-    complex calculateAPF(complex s) const;
-    complex calculatePeak(complex s) const;
-
-    complex Butterworth(bool hpf, unsigned int order, const complex &s) const;
-    complex ButterworthPolinom(unsigned int k, unsigned int order, const complex &s) const;
-
-    complex LinkwitzRiley(bool hpf, const complex &s) const;
+    math::AnalogFilter filter() const;
 
     bool m_autoName;
     FourierTransform m_dataFT, m_inverse;
@@ -17,6 +17,7 @@
  */
 #include "generatorthread.h"
 #include "audio/client.h"
+#include "audio/loopback.h"
 #include <QVariant>
 
 #include "whitenoise.h"
@@ -111,7 +112,6 @@ void GeneratorThread::init()
 
     for (auto &source : m_sources) {
         connect(source, &OutputDevice::sampleError, this, &GeneratorThread::deviceError);
-        connect(source, &OutputDevice::sampleOut, this, &GeneratorThread::sampleOut, Qt::DirectConnection);
     }
     connect(this, SIGNAL(finished()), this, SLOT(finish()));
 }
@@ -150,6 +150,7 @@ void GeneratorThread::updateAudio()
         m_audioStream->close();
     }
     m_audioStream = nullptr;
+    audio::Loopback::getInstance()->reset(0);
 
     if (m_enabled) {
         m_sources[m_type]->setGain(m_gain);
@@ -161,10 +162,12 @@ void GeneratorThread::updateAudio()
         m_audioStream = audio::Client::getInstance()->openOutput(m_deviceId, m_sources[m_type], format);
         if (m_audioStream) {
             m_sources[m_type]->setSamplerate(m_audioStream->format().sampleRate);
+            audio::Loopback::getInstance()->reset(m_audioStream->format().sampleRate);
             connect(m_audioStream, &audio::Stream::sampleRateChanged, this, [this]() {
                 for (auto &&source : m_sources) {
                     source->setSamplerate(m_audioStream->format().sampleRate);
                 }
+                audio::Loopback::getInstance()->reset(m_audioStream->format().sampleRate);
             });
         } else {
             emit deviceError();
@@ -99,7 +99,6 @@ signals:
     void durationChanged(float);
     void deviceIdChanged(audio::DeviceInfo::Id);
     void deviceError();
-    void sampleOut(float);
     void channelsChanged(QSet<int>);
 
     void evenPolarityChanged(bool);
@@ -22,6 +22,8 @@
 MusicNoise::MusicNoise(QObject *parent) : OutputDevice(parent)
 {
     m_name = "Music-Noise";
+    m_48.setRealtime(true);
+    m_96.setRealtime(true);
 
     if (!m_48.load(":/audio/musicnoise48.wav")) {
         qDebug() << "can't load Music-Noise 48";
@@ -19,6 +19,7 @@
 #include <cmath>
 #include <cstring>
 #include "generatorthread.h"
+#include "audio/loopback.h"
 
 OutputDevice::OutputDevice(QObject *parent) : QIODevice(parent),
     m_name("Silent"),
@@ -39,6 +40,7 @@ qint64 OutputDevice::readData(char *data, qint64 maxlen)
     int chanel = m_chanelCount;
     Sample src = {0.f}, inv = src;
     std::memset(data, 0, maxlen);
+    m_loopback.clear();
     auto generator = static_cast<GeneratorThread *>(parent());
     if (generator) {
         m_channels = generator->channels();
@@ -49,11 +51,13 @@ qint64 OutputDevice::readData(char *data, qint64 maxlen)
             chanel = 0;
             src = this->sample();
             inv.f = -src.f;
-            emit sampleOut(src.f);
             if (std::isnan(src.f)) {
+                //the loopback keeps the samples that were produced, readers stay in step with the ring
+                audio::Loopback::getInstance()->write(m_loopback.data(), m_loopback.size());
                 emit sampleError();
                 return 0;
             }
+            m_loopback.push_back(src.f);
         }
 
         if (m_channels.contains(chanel)) {
@@ -63,6 +67,7 @@ qint64 OutputDevice::readData(char *data, qint64 maxlen)
         total += sizeof(float);
         ++chanel;
     }
+    audio::Loopback::getInstance()->write(m_loopback.data(), m_loopback.size());
     return total;
 }
 Sample OutputDevice::sample()
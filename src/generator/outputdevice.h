@@ -20,6 +20,7 @@
 
 #include <QIODevice>
 #include <QDebug>
+#include <vector>
 
 #include "sample.h"
 
@@ -45,7 +46,6 @@ public slots:
 
 signals:
     void sampleError();
-    void sampleOut(float);
 
 protected:
     QString m_name;
@@ -53,6 +53,9 @@ protected:
     int m_sampleRate;
     int m_chanelCount;
     float m_gain;
+
+private:
+    std::vector<float> m_loopback;
 };
 
 #endif // OUTPUTDEVICE_H
@@ -21,6 +21,7 @@
 Wav::Wav(QObject *parent) : OutputDevice(parent)
 {
     m_name = "Wav";
+    setRealtime(true);
 }
 
 Sample Wav::sample()
@@ -0,0 +1,355 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "importer.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QUrl>
+#include <QtMath>
+
+#include "stored.h"
+#include "common/scheduler.h"
+#include "common/wavfile.h"
+
+namespace {
+
+constexpr std::size_t MAX_FIELDS = 4;
+
+struct Field {
+    const char *begin = nullptr, *end = nullptr;
+};
+using Fields = std::array<Field, MAX_FIELDS>;
+
+/**
+ * content of a text file, mapped if the platform allows
+ */
+class Content
+{
+public:
+    explicit Content(const QString &fileName) : m_file(fileName), m_buffer(), m_data(nullptr), m_size(0) {}
+
+    bool open()
+    {
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        m_size = m_file.size();
+        if (m_size == 0) {
+            return true;
+        }
+        auto mapped = m_file.map(0, m_size);
+        if (mapped) {
+            m_data = reinterpret_cast<const char *>(mapped);
+        } else {
+            m_buffer = m_file.readAll();
+            m_data = m_buffer.constData();
+            m_size = m_buffer.size();
+        }
+        return true;
+    }
+
+    //! calls row for every line with the number of its fields
+    template<typename Row> void lines(char separator, Row row) const
+    {
+        auto position = m_data, end = m_data + m_size;
+        while (position < end) {
+            auto lineEnd = static_cast<const char *>(std::memchr(position, '\n', end - position));
+            if (!lineEnd) {
+                lineEnd = end;
+            }
+
+            Fields fields;
+            std::size_t count = 0;
+            while (count < MAX_FIELDS) {
+                auto fieldEnd = static_cast<const char *>(std::memchr(position, separator, lineEnd - position));
+                fields[count++] = {position, fieldEnd ? fieldEnd : lineEnd};
+                if (!fieldEnd) {
+                    break;
+                }
+                position = fieldEnd + 1;
+            }
+            row(fields, count);
+            position = lineEnd + 1;
+        }
+    }
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+    const char *m_data;
+    qint64 m_size;
+};
+
+float number(const Field &field, float fallback)
+{
+    float value;
+    return Importer::parseNumber(field.begin, field.end, value) ? value : fallback;
+}
+
+bool readTransfer(const Content &content, char separator, Source::Abstract::Frame &frame)
+{
+    auto &ftdata = frame.ftdata;
+    std::vector<float> frequencies;
+    frequencies.reserve(480); //48 ppo
+    float maxMagnitude = -100;
+
+    content.lines(separator, [&](const Fields & fields, std::size_t count) {
+        float frequency, magnitude;
+        if (count < 2 ||
+                !Importer::parseNumber(fields[0].begin, fields[0].end, frequency) ||
+                !Importer::parseNumber(fields[1].begin, fields[1].end, magnitude)) {
+            return;
+        }
+        complex phase;
+        phase.polar(M_PI * (count > 2 ? number(fields[2], 0.f) : 0.f) / 180.f);
+
+        maxMagnitude = std::max(maxMagnitude, magnitude);
+        frequencies.push_back(frequency);
+        ftdata.module.push_back(magnitude);
+        ftdata.magnitude.push_back(magnitude);
+        ftdata.phase.push_back(phase);
+        ftdata.coherence.push_back(count > 3 ? number(fields[3], 0.f) : 1.f);
+        ftdata.peakSquared.push_back(magnitude);
+        ftdata.meanSquared.push_back(NAN);
+    });
+    if (frequencies.empty()) {
+        return false;
+    }
+
+    //exports with levels above 30 dB are in the absolute scale
+    bool absoluteScale = maxMagnitude > 30;
+    for (auto &module : ftdata.module) {
+        module = std::pow(10.f, (module + (absoluteScale ? 0 : 70) - 140) / 20.f);
+    }
+    for (auto &magnitude : ftdata.magnitude) {
+        magnitude = std::pow(10.f, (magnitude - (absoluteScale ? maxMagnitude : 0)) / 20.f);
+    }
+    frame.size = static_cast<unsigned int>(frequencies.size());
+    ftdata.axis = Source::Axis::fromValues(std::move(frequencies));
+    return true;
+}
+
+bool readImpulse(const Content &content, char separator, Source::Abstract::Frame &frame)
+{
+    auto &impulse = frame.impulseData;
+    impulse.time.reserve(6720); //140ms @ 48kHz
+    impulse.value.reserve(6720);
+
+    content.lines(separator, [&](const Fields & fields, std::size_t count) {
+        float time;
+        if (count < 2 || !Importer::parseNumber(fields[0].begin, fields[0].end, time)) {
+            return;
+        }
+        impulse.time.push_back(time);
+        impulse.value.push_back(number(fields[1], 0.f));
+    });
+    frame.impulseSize = static_cast<unsigned int>(impulse.size());
+    return frame.impulseSize > 0;
+}
+
+bool readWav(WavFile &wav, Source::Abstract::Frame &frame)
+{
+    std::vector<float> samples(std::max<qint64>(wav.frames(), 0));
+    qint64 size = 0, read;
+    while (size < static_cast<qint64>(samples.size()) &&
+            (read = wav.readChannel(samples.data() + size, samples.size() - size, 0, false)) > 0) {
+        size += read;
+    }
+    samples.resize(size);
+    if (samples.empty()) {
+        return false;
+    }
+
+    //time is counted from the peak
+    auto peak = std::max_element(samples.cbegin(), samples.cend(), [](float a, float b) {
+        return std::abs(a) < std::abs(b);
+    }) - samples.cbegin();
+    float dt = 1000.f / wav.sampleRate();
+
+    auto &impulse = frame.impulseData;
+    impulse.resize(samples.size());
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        impulse.time[i] = (static_cast<float>(i) - peak) * dt;
+        impulse.value[i] = samples[i];
+    }
+    frame.impulseSize = static_cast<unsigned int>(samples.size());
+    return true;
+}
+
+} // namespace
+
+Importer::Importer(QObject *parent) : QObject(parent)
+{
+}
+
+void Importer::import(const QStringList &fileNames, int type, const Callback &done)
+{
+    const auto total = fileNames.size();
+    std::vector<Result> results(total);
+    std::vector<bool> finished(total, false);
+    std::mutex mutex;
+    int flushed = 0;
+    std::atomic<int> count{0};
+
+    std::vector<Scheduler::Task> tasks;
+    tasks.reserve(total);
+    for (int i = 0; i < total; ++i) {
+        tasks.push_back([&, i]() {
+            auto result = importFile(fileNames[i], type);
+            emit progress(QFileInfo(fileNames[i]).fileName(), ++count, total);
+
+            //results are passed in the order of the list as soon as all before them are ready
+            std::lock_guard<std::mutex> guard(mutex);
+            results[i] = std::move(result);
+            finished[i] = true;
+            for (; flushed < total && finished[flushed]; ++flushed) {
+                done(results[flushed]);
+                results[flushed] = {};
+            }
+        });
+    }
+    Scheduler::getInstance()->parallel(tasks);
+}
+
+Importer::Result Importer::importFile(const QString &fileName, int type)
+{
+    Result result;
+    result.fileName = fileName;
+
+    Source::Abstract::Frame frame;
+    type = detect(fileName, type);
+    if (type == ImpulseWAV) {
+        WavFile wav;
+        if (!wav.load(fileName)) {
+            result.error = "can't load file";
+            return result;
+        }
+        if (!readWav(wav, frame)) {
+            result.error = "no samples in file";
+            return result;
+        }
+    } else {
+        Content content(fileName);
+        if (!content.open()) {
+            result.error = "can't open file";
+            return result;
+        }
+        char separator = (type == TransferCSV || type == ImpulseCSV ? ',' : '\t');
+        bool read = (type == ImpulseTXT || type == ImpulseCSV ?
+                     readImpulse(content, separator, frame) :
+                     readTransfer(content, separator, frame));
+        if (!read) {
+            result.error = "no data rows in file";
+            return result;
+        }
+    }
+
+    auto stored = std::make_shared<Stored>();
+    stored->build(std::move(frame));
+    stored->setName(QFileInfo(fileName).fileName());
+    stored->setNotes("Imported from " + QUrl::fromLocalFile(fileName).toDisplayString(QUrl::PreferLocalFile));
+    stored->setActive(true);
+    if (auto application = QCoreApplication::instance()) {
+        stored->moveToThread(application->thread());
+    }
+    result.trace = stored;
+    result.success = true;
+    return result;
+}
+
+int Importer::detect(const QString &fileName, int type)
+{
+    if (type != Auto) {
+        return type;
+    }
+    auto ext = QFileInfo(fileName).suffix().toLower();
+    if (ext == "csv") {
+        return TransferCSV;
+    } else if (ext == "wav") {
+        return ImpulseWAV;
+    }
+    return TransferTXT;
+}
+
+bool Importer::parseNumber(const char *begin, const char *end, float &value) noexcept
+{
+    auto space = [](char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '"';
+    };
+    auto digit = [](char c) {
+        return c >= '0' && c <= '9';
+    };
+    while (begin < end && space(*begin)) {
+        ++begin;
+    }
+    while (end > begin && space(*(end - 1))) {
+        --end;
+    }
+    if (end - begin == 1 && *begin == '*') {
+        value = 0;
+        return true;
+    }
+
+    bool negative = false;
+    if (begin < end && (*begin == '-' || *begin == '+')) {
+        negative = (*begin++ == '-');
+    }
+
+    double mantissa = 0;
+    int exponent = 0, digits = 0;
+    for (; begin < end && digit(*begin); ++begin, ++digits) {
+        mantissa = mantissa * 10 + (*begin - '0');
+    }
+    if (begin < end && (*begin == '.' || *begin == ',')) {
+        for (++begin; begin < end && digit(*begin); ++begin, ++digits, --exponent) {
+            mantissa = mantissa * 10 + (*begin - '0');
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+
+    if (begin < end && (*begin == 'e' || *begin == 'E')) {
+        ++begin;
+        bool negativeExponent = false;
+        if (begin < end && (*begin == '-' || *begin == '+')) {
+            negativeExponent = (*begin++ == '-');
+        }
+        int power = 0, powerDigits = 0;
+        for (; begin < end && digit(*begin); ++begin, ++powerDigits) {
+            power = std::min(power * 10 + (*begin - '0'), 1000);
+        }
+        if (!powerDigits) {
+            return false;
+        }
+        exponent += (negativeExponent ? -power : power);
+    }
+    if (begin != end) {
+        return false;
+    }
+
+    auto result = (exponent ? mantissa * std::pow(10.0, exponent) : mantissa);
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
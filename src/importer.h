@@ -0,0 +1,72 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#include <QObject>
+#include <QStringList>
+#include <functional>
+#include <vector>
+
+#include "source/source_shared.h"
+
+/**
+ * @brief The Importer class
+ * reads transfer and impulse exports of other analysers into stored traces.
+ * Files are parsed on the Scheduler pool straight from the mapped file into the trace columns,
+ * numbers are read by a locale independent parser, which takes both '.' and ',' as the decimal point.
+ */
+class Importer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Type {
+        Auto        = -1,
+        TransferTXT = 0,
+        TransferCSV = 1,
+        ImpulseTXT  = 2,
+        ImpulseCSV  = 3,
+        ImpulseWAV  = 4
+    };
+
+    struct Result {
+        QString fileName;
+        bool success = false;
+        QString error;
+        Source::Shared trace;
+    };
+    using Callback = std::function<void(Result &)>;
+
+    explicit Importer(QObject *parent = nullptr);
+
+    //! parses files in parallel, done is called for every file in the order of the list
+    void import(const QStringList &fileNames, int type, const Callback &done);
+    static Result importFile(const QString &fileName, int type);
+
+    //! type by the file extension if type is Auto
+    static int detect(const QString &fileName, int type);
+
+    //! parses a number, '*' is a missing value and reads as 0
+    static bool parseNumber(const char *begin, const char *end, float &value) noexcept;
+
+signals:
+    void progress(QString fileName, int done, int total);
+};
+
+#endif // IMPORTER_H
@@ -16,14 +16,18 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QQmlApplicationEngine>
 #include <QtQuick/QQuickView>
 #include <QQuickStyle>
 #include <QQmlContext>
 #include <QFontDatabase>
+#include <QDir>
+#include <QJsonDocument>
 #include "common/settings.h"
 #include "common/logger.h"
 #include "common/notifier.h"
+#include "common/scheduler.h"
 #include "src/generator/generator.h"
 #include "src/targettrace.h"
 #include "src/union.h"
@@ -33,9 +37,12 @@
 #include "src/source/group.h"
 #include "src/chart/variablechart.h"
 #include "src/measurement.h"
+#include "src/multimeasurement.h"
+#include "src/recorder.h"
 
 #include "audio/client.h"
 #include "audio/devicemodel.h"
+#include "audio/plugins/virtualplugin.h"
 #include "common/appearance.h"
 #include "common/autosaver.h"
 #include "filesystem/dialog.h"
@@ -51,10 +58,97 @@
 #define APP_GIT_VERSION "unknow"
 #endif
 
+static void setApplicationInfo()
+{
+    QCoreApplication::setApplicationName("OpenSoundMeter");
+    QCoreApplication::setApplicationVersion(APP_GIT_VERSION);
+    QCoreApplication::setOrganizationName("opensoundmeter");
+    QCoreApplication::setOrganizationDomain("opensoundmeter.com");
+}
+
+static bool headlessRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * measurement node without GUI: no QML engine, fonts and charts.
+ * Sources are restored from the autosave or the given project and served by remote::Server.
+ */
+static int headless(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    setApplicationInfo();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Open Sound Meter measurement node");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption({"headless", "Run without GUI."});
+    parser.addOption({"project", "Project file to load.", "file"});
+    parser.addOption({"generator", "Allow remote control of the generator."});
+    parser.addOption({"record", "Record input channels continuously."});
+    parser.addOption({"virtual", "Use virtual audio devices instead of the sound cards.", "devices"});
+    parser.addOption({"fast", "Run virtual audio devices as fast as possible."});
+    parser.process(app);
+
+    //must be set before the audio client is created
+    if (parser.isSet("virtual")) {
+        qputenv(audio::VirtualPlugin::DEVICES_ENV, parser.value("virtual").toLocal8Bit());
+    }
+    if (parser.isSet("fast")) {
+        qputenv(audio::VirtualPlugin::PACE_ENV, "fast");
+    }
+
+    Settings settings;
+    audio::Client::getInstance();
+    auto generator = std::make_shared<Generator>(settings.getGroup("generator"));
+    SourceList sourceList;
+    AutoSaver autoSaver(settings.getGroup("autosaver"), &sourceList);
+    new TargetTrace(settings.getGroup("targettrace"));
+    Recorder recorder(&sourceList, settings.getGroup("recorder"));
+
+    if (parser.isSet("project")) {
+        auto project = QUrl::fromUserInput(parser.value("project"), QDir::currentPath(), QUrl::AssumeLocalFile);
+        if (!sourceList.load(project)) {
+            qCritical() << "can't load project" << project;
+            return -1;
+        }
+    }
+
+    auto server = remote::Server(generator, &sourceList);
+    server.setSourceList(&sourceList);
+    server.setGeneratorEnable(parser.isSet("generator"));
+    if (!server.start()) {
+        qCritical() << "can't start remote server";
+        return -1;
+    }
+    if (parser.isSet("record")) {
+        recorder.start();
+    }
+    qInfo() << "headless node started, sources:" << sourceList.count();
+
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &autoSaver, &AutoSaver::save);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+        qInfo().noquote() << "scheduler timings:"
+                          << QJsonDocument(Scheduler::getInstance()->statistics()).toJson(QJsonDocument::Compact);
+    });
+    return QCoreApplication::exec();
+}
+
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(logger::messageHandler);
 
+    if (headlessRequested(argc, argv)) {
+        return headless(argc, argv);
+    }
+
 #ifdef GRAPH_METAL
     QQuickWindow::setSceneGraphBackend(Chart::SeriesNode::chooseRhi());
 #elif defined(GRAPH_OPENGL)
@@ -77,10 +171,7 @@ int main(int argc, char *argv[])
     QFontDatabase::addApplicationFont(":/fonts/Roboto/BoldItalic.ttf");
     QFontDatabase::addApplicationFont(":/fonts/Roboto/Italic.ttf");
     QFontDatabase::addApplicationFont(":/fonts/osm.ttf");
-    QCoreApplication::setApplicationName("OpenSoundMeter");
-    QCoreApplication::setApplicationVersion(APP_GIT_VERSION);
-    QCoreApplication::setOrganizationName("opensoundmeter");
-    QCoreApplication::setOrganizationDomain("opensoundmeter.com");
+    setApplicationInfo();
 
     Settings settings;
     Appearance appearence(&settings);
@@ -89,6 +180,7 @@ int main(int argc, char *argv[])
     SourceList sourceList;
     AutoSaver autoSaver(settings.getGroup("autosaver"), &sourceList);
     auto t = new TargetTrace(settings.getGroup("targettrace"));
+    Recorder recorder(&sourceList, settings.getGroup("recorder"));
     auto notifier = Notifier::getInstance();
 
     auto client = remote::Client(settings.getGroup("apiClient"));
@@ -101,6 +193,7 @@ int main(int argc, char *argv[])
     qmlRegisterUncreatableMetaObject(Filter::staticMetaObject, "Measurement", 1, 0, "FilterFrequency",
                                      "Error: only enums");
     qmlRegisterType<Measurement>("Measurement", 1, 0, "Measurement");
+    qmlRegisterType<MultiMeasurement>("OpenSoundMeter", 1, 0, "MultiMeasurement");
     qmlRegisterType<Union>("OpenSoundMeter", 1, 0, "UnionSource");
     qmlRegisterType<Stored>("Stored", 1, 0, "Stored");
     qmlRegisterType<StandardLine>("StandardLine", 1, 0, "StandardLine");
@@ -131,6 +224,7 @@ int main(int argc, char *argv[])
     engine.rootContext()->setContextProperty("notifier", notifier);
 
     engine.rootContext()->setContextProperty("autoSaver", &autoSaver);
+    engine.rootContext()->setContextProperty("recorder", &recorder);
 
     engine.rootContext()->setContextProperty("remoteServer", &server);
     engine.rootContext()->setContextProperty("remoteClient", &client);
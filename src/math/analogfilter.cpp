@@ -0,0 +1,219 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "analogfilter.h"
+#include <cmath>
+#include <QtMath>
+
+namespace math {
+
+complex AnalogFilter::response(float f) const
+{
+    if (type == Meta::Filter::Delay) {
+        complex rotation;
+        rotation.polar(-2 * M_PI * f * delay / 1000.f);
+        return rotation;
+    }
+
+    auto w = f / frequency;
+    auto s = complex::i * w;
+
+    switch (type) {
+    case Meta::Filter::ButterworthHPF:
+        return butterworth(true, order, s);
+    case Meta::Filter::ButterworthLPF:
+        return butterworth(false, order, s);
+    case Meta::Filter::LinkwitzRileyHPF:
+        return linkwitzRiley(true, s);
+    case Meta::Filter::LinkwitzRileyLPF:
+        return linkwitzRiley(false, s);
+    case Meta::Filter::BesselHPF:
+        return bessel(true, s);
+    case Meta::Filter::BesselLPF:
+        return bessel(false, s);
+    case Meta::Filter::APF:
+        return allPass(s);
+    case Meta::Filter::Peak:
+        return peak(s);
+    case Meta::Filter::LowShelf:
+        return shelf(false, s);
+    case Meta::Filter::HighShelf:
+        return shelf(true, s);
+    case Meta::Filter::Delay:
+        break;
+    }
+    return 1;
+}
+
+void AnalogFilter::response(const float *frequencies, std::size_t count, float *real, float *imag) const
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        auto v = response(frequencies[i]);
+        bool valid = std::isfinite(v.real) && std::isfinite(v.imag);
+        real[i] = valid ? v.real : 0.f;
+        imag[i] = valid ? v.imag : 0.f;
+    }
+}
+
+bool AnalogFilter::operator==(const AnalogFilter &other) const noexcept
+{
+    return type == other.type && order == other.order && frequency == other.frequency &&
+           gain == other.gain && q == other.q && delay == other.delay;
+}
+
+bool AnalogFilter::operator!=(const AnalogFilter &other) const noexcept
+{
+    return !(*this == other);
+}
+
+complex AnalogFilter::bessel(bool hpf, complex s) const
+{
+    auto n  = order;
+
+    auto factorial = [](unsigned long k) {
+        unsigned long value = 1;
+        for (unsigned long i = 2; i <= k; ++i) {
+            value *= i;
+        }
+        return value;
+    };
+
+    auto a = [&n, &factorial](unsigned long k) -> float {
+        return factorial(2 * n - k) / (std::pow(2.0, n - k) * factorial(k) * factorial(n - k));
+    };
+
+    complex s_k = 1;
+    complex numerator = a(0);
+    complex denominator = 0;
+    float orderK = 1;
+
+    switch (order) {
+    case 2:
+        orderK = 4 / 3.f;
+        break;
+    case 3:
+        orderK = 1.755672389;
+        break;
+    case 4:
+        orderK = 2.113917675;
+        break;
+    case 5:
+        orderK = 2.427410702;
+        break;
+    case 6:
+        orderK = 2.703395061;
+        break;
+    }
+
+    if (hpf) {
+        s = complex{1, 0} / s;
+    }
+    s *= orderK;
+
+    for (unsigned int k = 0; k <= n; ++k) {
+        denominator += s_k * a(k);
+        s_k *= s;
+    }
+
+    return numerator / denominator;
+}
+
+complex AnalogFilter::allPass(const complex &s) const
+{
+    float q;
+    complex numerator;
+    complex denominator;
+
+    switch (order) {
+    case 2:
+        q = 1.f / 2;
+        numerator = s * s - 1;
+        denominator = s * s + s / q + 1;
+        break;
+    case 4:
+        q = 1.f / sqrt(2);
+        numerator = s * s - s / q + 1;
+        denominator = s * s + s / q + 1;
+        break;
+    default:
+        return 1;
+    }
+
+    return numerator / denominator;
+}
+
+complex AnalogFilter::peak(const complex &s) const
+{
+    float a;
+    complex numerator;
+    complex denominator;
+
+    a = std::pow(10, gain / 40);
+    numerator   = s * s + (s * a) / q + 1;
+    denominator = s * s + s / (a * q) + 1;
+
+    return numerator / denominator;
+}
+
+complex AnalogFilter::shelf(bool high, const complex &s) const
+{
+    //second order shelves: gain at the top (high) or at the bottom (low), 1 on the other side
+    float a = std::pow(10, gain / 40);
+    auto b = s * (std::sqrt(a) / q);
+    complex numerator, denominator;
+    if (high) {
+        numerator   = s * s * a + b + 1;
+        denominator = s * s + b + a;
+    } else {
+        numerator   = s * s + b + a;
+        denominator = s * s * a + b + 1;
+    }
+    return numerator * a / denominator;
+}
+
+complex AnalogFilter::butterworth(bool hpf, unsigned int order, const complex &s)
+{
+    complex numerator = 1;
+    if (hpf) {
+        for (unsigned int i = 0; i < order; ++i) {
+            numerator *= s;
+        }
+    }
+
+    bool odd = order % 2;
+    complex denominator = (odd ? (s + 1) : 1);
+    unsigned int lastK = (order - (odd % 2 ? 1 : 0)) / 2;
+    for (unsigned int k = 1; k <= lastK; ++k) {
+        denominator *= butterworthPolinom(k, order, s);
+    }
+
+    return numerator / denominator;
+}
+
+complex AnalogFilter::butterworthPolinom(unsigned int k, unsigned int order, const complex &s)
+{
+    float b =  -2 * cos((2 * k + order - 1) * M_PI / (2 * order));
+    return s * s + s * b + 1;
+}
+
+complex AnalogFilter::linkwitzRiley(bool hpf, const complex &s) const
+{
+    auto b = butterworth(hpf, order / 2, s);
+    return b * b;
+}
+
+} // namespace math
@@ -0,0 +1,59 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MATH_ANALOGFILTER_H
+#define MATH_ANALOGFILTER_H
+
+#include <cstddef>
+#include "math/complex.h"
+#include "meta/metafilter.h"
+
+namespace math {
+
+/**
+ * @brief The AnalogFilter struct
+ * transfer function of one analog prototype: crossovers, all-pass, peak, shelves and delay.
+ * Responses are evaluated at s = j * f / frequency.
+ */
+struct AnalogFilter {
+    Meta::Filter::Type type = Meta::Filter::ButterworthLPF;
+    unsigned int order = 3;
+    float frequency = 1000;
+    float gain = 0;         //dB
+    float q = 1.f / std::sqrt(2.f);
+    float delay = 0;        //ms
+
+    complex response(float f) const;
+    //! responses at count frequencies into separate real and imaginary arrays, nan is written as 0
+    void response(const float *frequencies, std::size_t count, float *real, float *imag) const;
+
+    bool operator==(const AnalogFilter &other) const noexcept;
+    bool operator!=(const AnalogFilter &other) const noexcept;
+
+private:
+    complex bessel(bool hpf, complex s) const;
+    complex allPass(const complex &s) const;
+    complex peak(const complex &s) const;
+    complex shelf(bool high, const complex &s) const;
+    static complex butterworth(bool hpf, unsigned int order, const complex &s);
+    static complex butterworthPolinom(unsigned int k, unsigned int order, const complex &s);
+    complex linkwitzRiley(bool hpf, const complex &s) const;
+};
+
+} // namespace math
+
+#endif // MATH_ANALOGFILTER_H
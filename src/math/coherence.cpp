@@ -82,7 +82,7 @@ float Coherence::value(unsigned int i) const noexcept
     return Crm.abs() / std::sqrt(Crr * Cmm);
 }
 
-GNU_ALIGN void Coherence::calculate(Source::Abstract::FTData *dst, FourierTransform *src)
+GNU_ALIGN void Coherence::calculate(float *dst, FourierTransform *src)
 {
     ++m_subpointer;
     if (m_subpointer >= m_depth)
@@ -114,12 +114,7 @@ GNU_ALIGN void Coherence::calculate(Source::Abstract::FTData *dst, FourierTransf
         CrmAbsVec = _mm_mul_ps( CrmAbsVec, _mm_rsqrt_ps( CrmAbsVec ) );
 
         CrmAbsVec = _mm_div_ps(CrmAbsVec, CrrmmVec);
-        _mm_store_ps(CrmAbs, CrmAbsVec);
-
-        dst[i    ].coherence = CrmAbs[0];
-        dst[i + 1].coherence = CrmAbs[1];
-        dst[i + 2].coherence = CrmAbs[2];
-        dst[i + 3].coherence = CrmAbs[3];
+        _mm_storeu_ps(dst + i, CrmAbsVec);
     }
 }
 
@@ -21,7 +21,6 @@
 #include <cmath>
 #include "./complex.h"
 #include "container/array.h"
-#include "source/source_abstract.h"
 #include "fouriertransform.h"
 
 class Coherence
@@ -43,7 +42,8 @@ public:
     [[deprecated]] void append(unsigned int i, const complex &refernce, const complex &measurement) noexcept;
     [[deprecated]] float value(unsigned int i) const noexcept;
 
-    void calculate(Source::Abstract::FTData *dst, FourierTransform *src);
+    //! writes coherence of each bin to the dst column
+    void calculate(float *dst, FourierTransform *src);
     inline void calculateRR(unsigned int i, FourierTransform *src);
     inline void calculateMM(unsigned int i, FourierTransform *src);
     inline void calculateRM(unsigned int i, FourierTransform *src);
@@ -42,7 +42,15 @@ void Deconvolution::transform(const FourierTransform *forward)
     } else {
         source = forward;
     }
-
+    deconvolve(source);
+}
+void Deconvolution::transform(const FourierTransform &reference)
+{
+    m_fft.transform(reference);
+    deconvolve(&m_fft);
+}
+void Deconvolution::deconvolve(const FourierTransform *source)
+{
     //devision
     for (unsigned int i = 0; i < m_size; i++) {
         m_ifft.set(i, source->af(i) / source->bf(i), 0.f);
@@ -25,10 +25,14 @@
 class Deconvolution
 {
 public:
-    explicit Deconvolution(unsigned int size = 8);
+    static constexpr unsigned int MIN_SIZE = 8;
+
+    explicit Deconvolution(unsigned int size = MIN_SIZE);
     ~Deconvolution() = default;
     void add(float in, float out);
     void transform(const FourierTransform *forward);
+    //! transform own input (channel A only), reference spectrum is taken from the reference transform
+    void transform(const FourierTransform &reference);
     float get(const unsigned int i) const;
     void setSize(unsigned int size);
     void setWindowFunctionType(WindowFunction::Type type);
@@ -37,6 +41,8 @@ public:
     unsigned int size() const;
 
 private:
+    void deconvolve(const FourierTransform *source);
+
     unsigned int m_size, m_maxIndex;
     float m_norm;
     container::array<float> m_data;
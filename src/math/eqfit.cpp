@@ -0,0 +1,371 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "eqfit.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace math {
+
+namespace {
+
+constexpr double DB = 10 / M_LN10;  //10 * log10(x) = DB * ln(x)
+
+//! solves a x = b for symmetric positive definite a (size x size), false if a isn't one
+bool cholesky(std::vector<double> &a, std::vector<double> &b, std::size_t size)
+{
+    for (std::size_t j = 0; j < size; ++j) {
+        auto sum = a[j * size + j];
+        for (std::size_t k = 0; k < j; ++k) {
+            sum -= a[j * size + k] * a[j * size + k];
+        }
+        if (!(sum > 0)) {
+            return false;
+        }
+        a[j * size + j] = std::sqrt(sum);
+        for (std::size_t i = j + 1; i < size; ++i) {
+            auto value = a[i * size + j];
+            for (std::size_t k = 0; k < j; ++k) {
+                value -= a[i * size + k] * a[j * size + k];
+            }
+            a[i * size + j] = value / a[j * size + j];
+        }
+    }
+    for (std::size_t i = 0; i < size; ++i) {
+        for (std::size_t k = 0; k < i; ++k) {
+            b[i] -= a[i * size + k] * b[k];
+        }
+        b[i] /= a[i * size + i];
+    }
+    for (std::size_t i = size; i-- > 0;) {
+        for (std::size_t k = i + 1; k < size; ++k) {
+            b[i] -= a[k * size + i] * b[k];
+        }
+        b[i] /= a[i * size + i];
+    }
+    return true;
+}
+
+} // namespace
+
+EqFit::EqFit(std::vector<Point> points, const Settings &settings) :
+    m_size(0), m_frequency(), m_delta(), m_sqrtWeight(), m_types(), m_settings(settings)
+{
+    for (auto &point : points) {
+        if (point.weight > 0 && point.frequency > 0 &&
+                std::isfinite(point.level) && std::isfinite(point.target)) {
+            m_frequency.push_back(point.frequency);
+            m_delta.push_back(point.level - point.target);
+            m_sqrtWeight.push_back(std::sqrt(point.weight));
+        }
+    }
+    m_size = m_frequency.size();
+
+    m_types.assign(m_settings.bands, Meta::Filter::Peak);
+    if (m_settings.shelves && m_settings.bands >= 3) {
+        m_types[0] = Meta::Filter::LowShelf;
+        m_types[1] = Meta::Filter::HighShelf;
+    }
+}
+
+EqFit::Result EqFit::fit(unsigned int seed) const
+{
+    Result result;
+    if (!m_size) {
+        return result;
+    }
+
+    const std::size_t count = m_types.size() * BAND_SIZE + 1;
+    auto parameters = start(seed);
+    std::vector<double> values(m_size), trialValues(m_size), jacobian(m_size * count);
+    std::vector<double> normal(count * count), gradient(count), step(count), trial(count);
+    auto cost = residuals(parameters, values, &jacobian);
+
+    double lambda = 1e-2;
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        //normal equations J'J and J'r
+        std::fill(normal.begin(), normal.end(), 0.0);
+        std::fill(gradient.begin(), gradient.end(), 0.0);
+        for (std::size_t i = 0; i < m_size; ++i) {
+            auto row = jacobian.data() + i * count;
+            for (std::size_t j = 0; j < count; ++j) {
+                gradient[j] += row[j] * values[i];
+                for (std::size_t k = 0; k <= j; ++k) {
+                    normal[j * count + k] += row[j] * row[k];
+                }
+            }
+        }
+
+        bool improved = false;
+        double gain = 0;
+        while (lambda < 1e10) {
+            auto damped = normal;
+            for (std::size_t j = 0; j < count; ++j) {
+                for (std::size_t k = 0; k < j; ++k) {
+                    damped[k * count + j] = damped[j * count + k];
+                }
+                damped[j * count + j] += lambda * (normal[j * count + j] + 1e-9);
+                step[j] = -gradient[j];
+            }
+            if (!cholesky(damped, step, count)) {
+                lambda *= 10;
+                continue;
+            }
+            for (std::size_t j = 0; j < count; ++j) {
+                trial[j] = parameters[j] + step[j];
+            }
+            clamp(trial);
+
+            auto trialCost = residuals(trial, trialValues, nullptr);
+            if (trialCost < cost) {
+                gain = (cost - trialCost) / cost;
+                std::swap(parameters, trial);
+                cost = trialCost;
+                lambda = std::max(lambda / 3, 1e-9);
+                improved = true;
+                break;
+            }
+            lambda *= 4;
+        }
+        if (!improved || gain < 1e-7) {
+            break;
+        }
+        cost = residuals(parameters, values, &jacobian);
+    }
+
+    double weight = 0;
+    for (auto w : m_sqrtWeight) {
+        weight += w * w;
+    }
+    result.error = static_cast<float>(std::sqrt(cost / weight));
+    result.offset = static_cast<float>(parameters.back());
+
+    for (std::size_t b = 0; b < m_types.size(); ++b) {
+        auto p = parameters.data() + b * BAND_SIZE;
+        //bands that do nothing are not returned
+        if (std::abs(p[1]) < 0.1) {
+            continue;
+        }
+        AnalogFilter filter;
+        filter.type = m_types[b];
+        filter.order = (m_types[b] == Meta::Filter::Peak ? 1 : 2);
+        filter.frequency = static_cast<float>(std::exp(p[0]));
+        filter.gain = static_cast<float>(p[1]);
+        filter.q = static_cast<float>(std::exp(p[2]));
+        result.filters.push_back(filter);
+    }
+    std::stable_sort(result.filters.begin(), result.filters.end(), [](const auto & a, const auto & b) {
+        bool aPeak = a.type == Meta::Filter::Peak, bPeak = b.type == Meta::Filter::Peak;
+        return aPeak == bPeak ? a.frequency < b.frequency : bPeak;
+    });
+    return result;
+}
+
+std::vector<double> EqFit::start(unsigned int seed) const
+{
+    const auto bands = m_types.size();
+    std::vector<double> parameters(bands * BAND_SIZE + 1, 0.0);
+    std::vector<double> current(m_delta), level(m_size), dx(m_size), dg(m_size), dy(m_size);
+
+    auto offset = [&]() {
+        double sum = 0, weight = 0;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            auto w = m_sqrtWeight[i] * m_sqrtWeight[i];
+            sum += w * current[i];
+            weight += w;
+        }
+        return sum / weight;
+    };
+    auto c = offset();
+
+    //peaks are placed one by one against the largest weighted deviation left
+    for (std::size_t b = 0; b < bands; ++b) {
+        auto p = parameters.data() + b * BAND_SIZE;
+        if (m_types[b] != Meta::Filter::Peak) {
+            p[0] = std::log(m_types[b] == Meta::Filter::LowShelf ?
+                            2.0 * m_settings.minFrequency : m_settings.maxFrequency / 2.0);
+            p[1] = 0;
+            p[2] = std::log(M_SQRT1_2);
+            continue;
+        }
+
+        std::size_t top = 0;
+        double topValue = -1;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            auto value = m_sqrtWeight[i] * std::abs(current[i] - c);
+            if (value > topValue) {
+                top = i;
+                topValue = value;
+            }
+        }
+        auto deviation = current[top] - c;
+
+        //width is where the deviation falls to a half
+        std::size_t left = top, right = top;
+        while (left > 0 && (current[left - 1] - c) * deviation > deviation * deviation / 4) {
+            --left;
+        }
+        while (right + 1 < m_size && (current[right + 1] - c) * deviation > deviation * deviation / 4) {
+            ++right;
+        }
+        auto octaves = std::max(std::log2(m_frequency[right] / m_frequency[left]), 1.0 / 6);
+        auto q = 1.0 / (2 * std::sinh(M_LN2 / 2 * octaves));
+
+        p[0] = std::log(m_frequency[top]);
+        p[1] = -deviation;
+        p[2] = std::log(q);
+        clamp(parameters);
+
+        band(static_cast<unsigned int>(b), p, level.data(), dx.data(), dg.data(), dy.data());
+        for (std::size_t i = 0; i < m_size; ++i) {
+            current[i] += level[i];
+        }
+        c = offset();
+    }
+    parameters.back() = c;
+
+    if (seed) {
+        std::mt19937 generator(seed);
+        std::normal_distribution<double> frequency(0, M_LN2 / 4), q(0, 0.4), shelf(0, 2);
+        std::uniform_real_distribution<double> gain(0.5, 1.2);
+        for (std::size_t b = 0; b < bands; ++b) {
+            auto p = parameters.data() + b * BAND_SIZE;
+            p[0] += frequency(generator);
+            if (m_types[b] == Meta::Filter::Peak) {
+                p[1] *= gain(generator);
+            } else {
+                p[1] += shelf(generator);
+            }
+            p[2] += q(generator);
+        }
+    }
+    clamp(parameters);
+    return parameters;
+}
+
+void EqFit::clamp(std::vector<double> &parameters) const
+{
+    const double minFrequency = std::log(m_settings.minFrequency), maxFrequency = std::log(m_settings.maxFrequency);
+    const double minQ = std::log(m_settings.minQ), maxQ = std::log(m_settings.maxQ);
+    //shelves steeper than Q 2 have a bump at the corner
+    const double maxShelfQ = std::min(maxQ, std::log(2.0));
+    for (std::size_t b = 0; b < m_types.size(); ++b) {
+        auto p = parameters.data() + b * BAND_SIZE;
+        p[0] = std::clamp(p[0], minFrequency, maxFrequency);
+        p[1] = std::clamp(p[1], -static_cast<double>(m_settings.maxCut), static_cast<double>(m_settings.maxBoost));
+        p[2] = std::clamp(p[2], minQ, m_types[b] == Meta::Filter::Peak ? maxQ : maxShelfQ);
+    }
+}
+
+double EqFit::residuals(const std::vector<double> &parameters, std::vector<double> &values,
+                        std::vector<double> *jacobian) const
+{
+    const std::size_t count = parameters.size();
+    const auto offset = parameters.back();
+    std::vector<double> level(m_size), dx(m_size), dg(m_size), dy(m_size);
+
+    std::copy(m_delta.cbegin(), m_delta.cend(), values.begin());
+    for (std::size_t b = 0; b < m_types.size(); ++b) {
+        band(static_cast<unsigned int>(b), parameters.data() + b * BAND_SIZE,
+             level.data(), dx.data(), dg.data(), dy.data());
+        for (std::size_t i = 0; i < m_size; ++i) {
+            values[i] += level[i];
+        }
+        if (jacobian) {
+            auto column = jacobian->data() + b * BAND_SIZE;
+            for (std::size_t i = 0; i < m_size; ++i, column += count) {
+                column[0] = m_sqrtWeight[i] * dx[i];
+                column[1] = m_sqrtWeight[i] * dg[i];
+                column[2] = m_sqrtWeight[i] * dy[i];
+            }
+        }
+    }
+
+    double cost = 0;
+    for (std::size_t i = 0; i < m_size; ++i) {
+        values[i] = m_sqrtWeight[i] * (values[i] - offset);
+        cost += values[i] * values[i];
+    }
+    if (jacobian) {
+        for (std::size_t i = 0; i < m_size; ++i) {
+            (*jacobian)[i * count + count - 1] = -m_sqrtWeight[i];
+        }
+    }
+    return cost;
+}
+
+void EqFit::band(unsigned int index, const double *parameters, double *level,
+                 double *dx, double *dg, double *dy) const
+{
+    //u = (f / f0)^2, x = ln f0 (du/dx = -2u), y = ln q (r = 1 / q^2, dr/dy = -2r)
+    const auto f0 = std::exp(parameters[0]);
+    const auto gain = parameters[1];
+    const auto r = std::exp(-2 * parameters[2]);
+    const auto *frequency = m_frequency.data();
+
+    switch (m_types[index]) {
+    case Meta::Filter::Peak: {
+        //|H|^2 = ((1-u)^2 + u a r) / ((1-u)^2 + u r / a), a = 10^(gain/20)
+        const auto a = std::pow(10.0, gain / 20);
+        const auto da = M_LN10 / 20;    //da/dg = a * da
+        for (std::size_t i = 0; i < m_size; ++i) {
+            const auto w = frequency[i] / f0;
+            const auto u = w * w;
+            const auto p = (1 - u) * (1 - u);
+            const auto up = u * r * a, down = u * r / a;
+            const auto n = p + up, d = p + down;
+            const auto dp = 4 * u * (1 - u);
+            level[i] = DB * std::log(n / d);
+            dx[i] = DB * ((dp - 2 * up) / n - (dp - 2 * down) / d);
+            dg[i] = DB * da * (up / n + down / d);
+            dy[i] = DB * (-2 * up / n + 2 * down / d);
+        }
+        break;
+    }
+    case Meta::Filter::LowShelf:
+    case Meta::Filter::HighShelf: {
+        //|H|^2 = a^2 * (high: (1-au)^2 + uar) / ((a-u)^2 + uar), a = 10^(gain/40); low swaps them
+        const bool high = m_types[index] == Meta::Filter::HighShelf;
+        const auto a = std::pow(10.0, gain / 40);
+        const auto da = a * M_LN10 / 40;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            const auto w = frequency[i] / f0;
+            const auto u = w * w;
+            const auto c = u * a * r;
+            const auto top = (1 - a * u) * (1 - a * u) + c, bottom = (a - u) * (a - u) + c;
+            const auto topX = 4 * a * u * (1 - a * u) - 2 * c, bottomX = 4 * u * (a - u) - 2 * c;
+            const auto topA = -2 * u * (1 - a * u) + u * r, bottomA = 2 * (a - u) + u * r;
+            const auto n = high ? top : bottom, d = high ? bottom : top;
+            const auto nx = high ? topX : bottomX, ddx = high ? bottomX : topX;
+            const auto na = high ? topA : bottomA, dda = high ? bottomA : topA;
+            level[i] = gain / 2 + DB * std::log(n / d);
+            dx[i] = DB * (nx / n - ddx / d);
+            dg[i] = 0.5 + DB * da * (na / n - dda / d);
+            dy[i] = DB * (-2 * c) * (1 / n - 1 / d);
+        }
+        break;
+    }
+    default:
+        std::fill(level, level + m_size, 0.0);
+        std::fill(dx, dx + m_size, 0.0);
+        std::fill(dg, dg + m_size, 0.0);
+        std::fill(dy, dy + m_size, 0.0);
+    }
+}
+
+} // namespace math
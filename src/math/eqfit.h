@@ -0,0 +1,83 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MATH_EQFIT_H
+#define MATH_EQFIT_H
+
+#include <vector>
+#include "math/analogfilter.h"
+
+namespace math {
+
+/**
+ * @brief The EqFit class
+ * fits peak and shelf filters to bring a banded response to a target curve.
+ * Levels are in dB, the error is weighted least squares with a free level offset.
+ * Levenberg-Marquardt with the analytic jacobian of the filter magnitudes is used,
+ * every fit call is independent, so restarts can run in parallel on one object.
+ */
+class EqFit
+{
+public:
+    struct Settings {
+        unsigned int bands = 16;
+        float minFrequency = 20, maxFrequency = 20000;
+        float maxBoost = 6, maxCut = 15;    //dB
+        float minQ = 0.5, maxQ = 10;
+        bool shelves = true;                //the first two bands are low and high shelves
+    };
+
+    struct Point {
+        float frequency = 0;
+        float level = 0;                    //dB
+        float target = 0;                   //dB
+        float weight = 1;
+    };
+
+    struct Result {
+        std::vector<AnalogFilter> filters;
+        float error = 0;                    //weighted rms, dB
+        float offset = 0;                   //level offset of the target, dB
+    };
+
+    EqFit(std::vector<Point> points, const Settings &settings);
+
+    //! seed 0 starts from the greedy placement, others from its random variation
+    Result fit(unsigned int seed) const;
+
+private:
+    //parameters of a band: log frequency, gain, log q. The offset is the last parameter
+    static constexpr unsigned int BAND_SIZE = 3;
+
+    std::vector<double> start(unsigned int seed) const;
+    void clamp(std::vector<double> &parameters) const;
+    //! weighted residuals, and the jacobian (row per point) if jacobian isn't null
+    double residuals(const std::vector<double> &parameters, std::vector<double> &values,
+                     std::vector<double> *jacobian) const;
+    //! dB response of one band at all points, and its derivatives by the band parameters
+    void band(unsigned int index, const double *parameters, double *level,
+              double *dx, double *dg, double *dy) const;
+
+    std::size_t m_size;
+    std::vector<double> m_frequency, m_delta, m_sqrtWeight;  //delta is level - target
+    std::vector<Meta::Filter::Type> m_types;
+    Settings m_settings;
+};
+
+} // namespace math
+
+#endif // MATH_EQFIT_H
@@ -195,6 +195,35 @@ void FourierTransform::transform(bool ultra)
         break;
     }
 }
+void FourierTransform::transformA()
+{
+    switch (m_type) {
+    case Fast: {
+        float integrated = 0;
+        for (unsigned int i = 0, n = m_pointer + 1; i < m_size; i++, n++) {
+            if (n >= m_size) n = 0;
+            m_fastA[m_swapMap[i]] = m_inA[n] * m_window.get(i);
+            integrated += m_fastA[m_swapMap[i]].real;
+        }
+        for (unsigned int i = 0; i < m_size; i++) {
+            m_fastA[i] -= integrated;
+        }
+        transformSingleChannel(false);
+    }
+    break;
+    case Log:
+        logA();
+        break;
+    }
+}
+void FourierTransform::transform(const FourierTransform &reference)
+{
+    Q_ASSERT(reference.m_type == m_type && reference.m_fastA.size() == m_fastB.size());
+    transformA();
+    for (unsigned int i = 0; i < m_fastB.size(); ++i) {
+        m_fastB[i] = reference.m_fastA[i];
+    }
+}
 void FourierTransform::reverse()
 {
     Q_ASSERT(m_type == Fast);
@@ -462,10 +491,53 @@ GNU_ALIGN void FourierTransform::log()
         m_fastB[i].imag = std::move(stored[3]);
     }
 }
+GNU_ALIGN void FourierTransform::logA()
+{
+    v4sf data, t, m;
+    float stored[4];
+    for (unsigned int i = 0; i < m_logBasis.size(); ++i) {
+
+        data = _mm_set1_ps(0.f);
+
+        int pointer = static_cast<int>(m_pointer);
+        switch (m_align) {
+        case Center:
+            pointer -= m_size / 2;
+            pointer -= m_logBasis[i].N / 2;
+            break;
+        case Right:
+            pointer -= m_logBasis[i].N;
+            break;
+        }
+
+        while (pointer < 0) {
+            pointer += m_size;
+        }
+
+        //two samples per step: the basis keeps w twice in one vector
+        unsigned int j = 0;
+        for (; j + 1 < m_logBasis[i].N; j += 2, pointer += 2) {
+            if (pointer >= static_cast<int>(m_size)) pointer -= m_size;
+            int next = pointer + 1 < static_cast<int>(m_size) ? pointer + 1 : 0;
+            t    = _mm_set_ps(m_inA[next], m_inA[next], m_inA[pointer], m_inA[pointer]);
+            m    = _mm_mul_ps(t, _mm_shuffle_ps(m_logBasis[i].w[j], m_logBasis[i].w[j + 1], _MM_SHUFFLE(3, 2, 1, 0)));
+            data = _mm_add_ps(data, m);
+        }
+        if (j < m_logBasis[i].N) {
+            if (pointer >= static_cast<int>(m_size)) pointer -= m_size;
+            t    = _mm_set_ps(0.f, 0.f, m_inA[pointer], m_inA[pointer]);
+            m    = _mm_mul_ps(t, m_logBasis[i].w[j]);
+            data = _mm_add_ps(data, m);
+        }
+        _mm_store_ps(stored, data);
+        m_fastA[i].real = stored[0] + stored[2];
+        m_fastA[i].imag = stored[1] + stored[3];
+    }
+}
 GNU_ALIGN void FourierTransform::prepareLog()
 {
     complex w;
-    const int ppo = 24, octaves = 11;
+    const int ppo = LOG_PPO, octaves = 11;
     unsigned int startWindow = pow(2, 16), startOffset = 1'344'000 / sampleRate(); // 28 for 48k
     float wFactor = powf(10.f, 1.f / (-octaves * ppo / 2.5));
     float fFactor = powf(1000.f, 1.f / (ppo * octaves));
@@ -36,6 +36,8 @@ public:
     enum Norm { Sqrt, Lin};
     enum Align { Right, Center};
 
+    static constexpr unsigned int LOG_PPO = 24;     //points per octave of the Log type
+
     FourierTransform(unsigned int size = 2);
 
     //! set input buffer size
@@ -73,8 +75,15 @@ public:
     //! run reverse only for A transform
     void transformSingleChannel(bool reverse = true);
 
+    //! run forward transform for channel A only
+    void transformA();
+
+    //! run transform for channel A, channel B is copied from channel A of the reference transform
+    void transform(const FourierTransform &reference);
+
     //! run log transform
     void log();
+    void logA();
 
     //! prepare transform for current type
     void prepare();
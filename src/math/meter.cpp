@@ -103,6 +103,12 @@ void Meter::reset() noexcept
     m_data.clear();
 }
 
+void Meter::release() noexcept
+{
+    reset();
+    m_data.release();
+}
+
 void Meter::setSampleRate(unsigned int sampleRate)
 {
     switch (m_time) {
@@ -43,6 +43,7 @@ public:
     data_t peakSquared() const noexcept;
     data_t peakdB() const noexcept;
     void  reset() noexcept;
+    void  release() noexcept;   //! frees the buffer till setSampleRate()
 
     void setSampleRate(unsigned int sampleRate);
     static constexpr Time allTimes[] = {Fast, Slow};
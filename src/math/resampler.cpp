@@ -0,0 +1,136 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <QtGlobal>
+#if defined(Q_PROCESSOR_X86_64)
+#include "ssemath.h"
+#endif
+#if defined(Q_PROCESSOR_ARM)
+#include "armmath.h"
+#endif
+
+namespace math {
+
+namespace {
+
+//! (PHASES + 1) rows of TAPS coefficients, the last row closes the interpolation of the last phase
+const std::vector<float> &kernel()
+{
+    static const std::vector<float> table = []() {
+        std::vector<float> table((Resampler::PHASES + 1) * Resampler::TAPS);
+        const double half = Resampler::HALF;
+        for (std::size_t p = 0; p <= Resampler::PHASES; ++p) {
+            double fraction = static_cast<double>(p) / Resampler::PHASES;
+            for (std::size_t k = 0; k < Resampler::TAPS; ++k) {
+                //distance from the interpolated point to the tap
+                double t = fraction - (static_cast<double>(k) - half + 1);
+                double sinc = std::abs(t) < 1e-9 ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+                double window = std::abs(t) >= half ? 0.0 :
+                                0.42 + 0.5 * std::cos(M_PI * t / half) + 0.08 * std::cos(2 * M_PI * t / half);
+                table[p * Resampler::TAPS + k] = static_cast<float>(sinc * window);
+            }
+        }
+        return table;
+    }();
+    return table;
+}
+
+} // namespace
+
+Resampler::Resampler() : m_buffer(4096), m_fill(0), m_position(0), m_ratio(1)
+{
+    reset();
+}
+
+void Resampler::reset() noexcept
+{
+    //the history before the first sample is silence
+    std::fill(m_buffer.begin(), m_buffer.end(), 0.f);
+    m_fill = HALF - 1;
+    m_position = HALF - 1;
+}
+
+double Resampler::ratio() const noexcept
+{
+    return m_ratio;
+}
+
+void Resampler::setRatio(double ratio) noexcept
+{
+    m_ratio = ratio;
+}
+
+std::size_t Resampler::required(std::size_t count) const noexcept
+{
+    if (!count) {
+        return 0;
+    }
+    auto last = static_cast<std::size_t>(m_position + (count - 1) * m_ratio) + HALF + 1;
+    return last > m_fill ? last - m_fill : 0;
+}
+
+void Resampler::process(const float *input, std::size_t inputCount, float *output, std::size_t count)
+{
+    if (m_fill + inputCount > m_buffer.size()) {
+        m_buffer.resize(m_fill + inputCount);
+    }
+    std::copy_n(input, inputCount, m_buffer.data() + m_fill);
+    m_fill += inputCount;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        auto n = static_cast<std::size_t>(m_position);
+        if (n + HALF >= m_fill) {
+            std::fill(output + i, output + count, 0.f);
+            break;
+        }
+        output[i] = interpolate(m_buffer.data() + n + 1 - HALF, m_position - n);
+        m_position += m_ratio;
+    }
+
+    //keep only the history needed for the next output sample
+    auto n = static_cast<std::size_t>(m_position);
+    auto drop = std::min(n > HALF - 1 ? n - (HALF - 1) : 0, m_fill);
+    std::copy(m_buffer.begin() + drop, m_buffer.begin() + m_fill, m_buffer.begin());
+    m_fill -= drop;
+    m_position -= drop;
+}
+
+float Resampler::interpolate(const float *x, double fraction) const noexcept
+{
+    double phase = fraction * PHASES;
+    auto p = std::min(static_cast<std::size_t>(phase), PHASES - 1);
+    auto blend = static_cast<float>(phase - p);
+    const float *h0 = kernel().data() + p * TAPS;
+    const float *h1 = h0 + TAPS;
+
+    alignas(16) float stored[4];
+    v4sf vx, sum0 = _mm_set1_ps(0), sum1 = _mm_set1_ps(0);
+    for (std::size_t k = 0; k < TAPS; k += 4) {
+        vx   = _mm_loadu_ps(x + k);
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(vx, _mm_loadu_ps(h0 + k)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(vx, _mm_loadu_ps(h1 + k)));
+    }
+    //blend both phases at once: s0 + b * (s1 - s0)
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_set1_ps(blend), _mm_sub_ps(sum1, sum0)));
+    _mm_store_ps(stored, sum0);
+    return stored[0] + stored[1] + stored[2] + stored[3];
+}
+
+} // namespace math
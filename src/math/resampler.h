@@ -0,0 +1,63 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MATH_RESAMPLER_H
+#define MATH_RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace math {
+
+/**
+ * @brief The Resampler class
+ * band-limited interpolation with a continuously variable ratio, it follows a drifting clock.
+ * Polyphase windowed sinc kernel, neighbour phases are interpolated linearly.
+ * With the ratio 1 and zero phase the input is passed through unchanged.
+ */
+class Resampler
+{
+public:
+    static constexpr std::size_t TAPS   = 32;
+    static constexpr std::size_t HALF   = TAPS / 2;
+    static constexpr std::size_t PHASES = 512;
+
+    Resampler();
+
+    void reset() noexcept;
+
+    //! input samples per one output sample
+    double ratio() const noexcept;
+    void setRatio(double ratio) noexcept;
+
+    //! number of input samples process() needs to produce count output samples
+    std::size_t required(std::size_t count) const noexcept;
+
+    //! consumes all input samples, writes count output samples. Missing input is replaced by zeroes.
+    void process(const float *input, std::size_t inputCount, float *output, std::size_t count);
+
+private:
+    float interpolate(const float *x, double fraction) const noexcept;
+
+    std::vector<float> m_buffer;
+    std::size_t m_fill;
+    double m_position, m_ratio;
+};
+
+} // namespace math
+
+#endif // MATH_RESAMPLER_H
@@ -21,15 +21,23 @@
 #include <QDateTime>
 #include <QtMath>
 #include <algorithm>
+#include <iterator>
 #include <utility>
 #include "measurement.h"
 #include "audio/client.h"
-#include "generator/generatorthread.h"
+#include "common/memorybudget.h"
+#include "common/scheduler.h"
+#include "recorder.h"
 #include "math/notch.h"
 #include "math/bandpass.h"
 
-Measurement::Measurement(QObject *parent) : Source::Abstract(parent), Meta::Measurement(),
-    m_timer(nullptr), m_timerThread(nullptr),
+namespace {
+//deconvolution point: result and two fast transforms of both channels
+constexpr std::size_t DECONVOLUTION_BYTES = sizeof(float) +
+                                            2 * (2 * sizeof(float) + 2 * sizeof(complex) + sizeof(unsigned int) + sizeof(float));
+}
+
+Measurement::Measurement(QObject *parent, Feed feed) : Source::Abstract(parent), Meta::Measurement(),
     m_input(this),
     m_deviceId(audio::Client::defaultInputDeviceId()),
     m_audioStream(nullptr),
@@ -38,8 +46,13 @@ Measurement::Measurement(QObject *parent) : Source::Abstract(parent), Meta::Meas
     m_workingDelay(0), m_delayFinderCounter(0),
     m_estimatedDelay(0),
     m_error(false),
-    m_data(65536), m_reference(65536), m_loopBuffer(65536),
-    m_enableCalibration(false), m_calibrationLoaded(false), m_calibrationList(), m_calibrationGain()
+    m_feed(feed),
+    m_allocated(false),
+    m_data(0), m_reference(0), m_loopReader(), m_loopData(), m_clockDrift(0),
+    m_enableCalibration(false), m_calibrationLoaded(false), m_calibrationList(), m_calibrationGain(),
+    m_sharedReference(nullptr),
+    m_recorder(nullptr),
+    m_realtime(true), m_windowReady(false)
 {
     m_name = "Measurement";
     setObjectName(m_name);
@@ -71,58 +84,48 @@ Measurement::Measurement(QObject *parent) : Source::Abstract(parent), Meta::Meas
                                                                                 &Measurement::polarityChanged,      polarity()).toBool());
         selectDevice(   m_settings->reactValue<Measurement, QString>(           "device",       this,
                                                                                 &Measurement::deviceNameChanged,        deviceName()).toString());
+        setDriftCompensation(m_settings->reactValue<Measurement, bool>(         "driftCompensation", this,
+                                                                                &Measurement::driftCompensationChanged, driftCompensation()).toBool());
     }
     m_deconvolutionSize = static_cast<unsigned int>(pow(2, 12));
 
     updateFftPower();
     m_dataFT.setWindowFunctionType(m_windowFunctionType);
-    m_moduleLPFs.resize(m_dataLength);
-    m_magnitudeLPFs.resize(m_dataLength);
-    m_phaseLPFs.resize(m_dataLength);
-    m_meters.resize(m_dataLength);
-
-    m_deconvolution.setSize(m_deconvolutionSize);
     m_deconvolution.setWindowFunctionType(m_windowFunctionType);
-    m_delayFinder.setSize(pow(2, 16));
     m_delayFinder.setWindowFunctionType(m_windowFunctionType);
-    m_impulseData.resize(m_deconvolutionSize);
-    m_deconvLPFs.resize(m_deconvolutionSize);
-    m_deconvAvg.setSize(m_deconvolutionSize);
-    m_deconvAvg.reset();
     m_coherence.setDepth(21);//Filter::BesselLPF<float>::ORDER);
+    //working buffers are allocated on activation
 
-    m_timer.setInterval(TIMER_INTERVAL);
-    m_timer.moveToThread(&m_timerThread);
-    connect(&m_timer, SIGNAL(timeout()), SLOT(transform()), Qt::DirectConnection);
-    connect(&m_timerThread, SIGNAL(started()), &m_timer, SLOT(start()), Qt::DirectConnection);
-    connect(&m_timerThread, SIGNAL(finished()), &m_timer, SLOT(stop()), Qt::DirectConnection);
     connect(this, &Measurement::audioFormatChanged, this, &Measurement::onSampleRateChanged);
-    connect(GeneratorThread::getInstance(), &GeneratorThread::sampleOut, this, &Measurement::newSampleFromGenerator,
-            Qt::DirectConnection);
-    connect(GeneratorThread::getInstance(), &GeneratorThread::enabledChanged, this, &Measurement::resetLoopBuffer,
-            Qt::DirectConnection);
 
     auto refreshDelays = [this]() {
         m_resetDelay = true;
     };
-    connect(this, &Measurement::dataChanelChanged, &m_timer, refreshDelays);
-    connect(this, &Measurement::referenceChanelChanged, &m_timer, refreshDelays);
-    connect(this, &Measurement::deviceIdChanged, &m_timer, refreshDelays);
+    connect(this, &Measurement::dataChanelChanged, this, refreshDelays);
+    connect(this, &Measurement::referenceChanelChanged, this, refreshDelays);
+    connect(this, &Measurement::deviceIdChanged, this, refreshDelays);
 
     connect(this, &Measurement::averageChanged, this, &Measurement::updateAverage);
     connect(this, &Measurement::windowFunctionTypeChanged, this, &Measurement::updateWindowFunction);
     connect(this, &Measurement::filtersFrequencyChanged, this, &Measurement::updateFilterFrequency);
     connect(this, &Measurement::inputFilterChanged, this, &Measurement::applyInputFilters);
 
-    m_timerThread.start();
-    setActive(true);
+    //offline and shared channels are driven by their owner, a device one by the windows writeData collects
+    if (m_feed == Feed::Device) {
+        Scheduler::getInstance()->addPeriodic(this, "Measurement::poll", std::chrono::milliseconds(POLL_INTERVAL),
+        [this]() {
+            if (m_windowReady.exchange(false)) {
+                transform();
+            }
+        });
+        setActive(true);
+    }
 }
 Measurement::~Measurement()
 {
     setActive(false);
-
-    m_timerThread.quit();
-    m_timerThread.wait();
+    Scheduler::getInstance()->cancel(this);
+    MemoryBudget::getInstance()->unpark(this);
 }
 QJsonObject Measurement::toJSON(const SourceList *list) const noexcept
 {
@@ -140,6 +143,7 @@ QJsonObject Measurement::toJSON(const SourceList *list) const noexcept
     data["deviceName"]      = deviceName();
     data["mode"]            = mode();
     data["inputFilters"]    = static_cast<int>(inputFilter());
+    data["driftCompensation"] = driftCompensation();
 
     QJsonObject calibration;
     calibration["enabled"] = m_enableCalibration;
@@ -180,6 +184,7 @@ void Measurement::fromJSON(QJsonObject data, const SourceList *list) noexcept
     setPolarity(         data["polarity"         ].toBool(polarity()));
     selectDevice(        data["deviceName"       ].toString(deviceName()));
     setInputFilter(      data["inputFilters"     ].toInt(inputFilter()));
+    setDriftCompensation(data["driftCompensation"].toBool(driftCompensation()));
 
     QJsonObject calibration = data["calibration"].toObject();
     if (!calibration.isEmpty()) {
@@ -221,6 +226,9 @@ float Measurement::peak(const Weighting::Curve curve, const Meter::Time time) co
 }
 float Measurement::referenceLevel() const
 {
+    if (auto reference = m_sharedReference) {
+        return reference->meter.dB();
+    }
     return m_levelMeters.m_reference.dB();
 }
 float Measurement::measurementPeak() const
@@ -229,6 +237,9 @@ float Measurement::measurementPeak() const
 }
 float Measurement::referencePeak() const
 {
+    if (auto reference = m_sharedReference) {
+        return reference->meter.peakdB();
+    }
     return m_levelMeters.m_reference.peakdB();
 }
 //this calls from timer thread
@@ -251,26 +262,96 @@ void Measurement::updateFftPower()
         m_deconvolutionSize = pow(2, m_FFTsizes.at(m_currentMode));
     }
     m_dataFT.setSampleRate(sampleRate());
-    m_levelMeters.setSampleRate(sampleRate());
     m_dataFT.prepare();
     calculateDataLength();
+    m_impulseData.resize(m_deconvolutionSize);
 
-    m_moduleAvg.setSize(size());
-    m_magnitudeAvg.setSize(size());
-    m_pahseAvg.setSize(size());
-    m_coherence.setSize(size());
+    if (m_allocated) {
+        m_levelMeters.setSampleRate(sampleRate());
+        allocateTransform();
+    }
+}
+//should be called while mutex locked
+void Measurement::allocate()
+{
+    if (m_allocated) {
+        return;
+    }
+    m_allocated = true;
+    m_data.resize(BUFFER_SIZE);
+    m_reference.resize(BUFFER_SIZE);
+    m_levelMeters.setSampleRate(sampleRate());
+    allocateTransform();
+    m_resetDelay = true;
+}
+//per-bin and FFT buffers of the current mode
+void Measurement::allocateTransform()
+{
+    m_moduleAvg.setSize(m_dataLength);
+    m_magnitudeAvg.setSize(m_dataLength);
+    m_pahseAvg.setSize(m_dataLength);
+    m_coherence.setSize(m_dataLength);
 
-    m_moduleLPFs.resize(size());
-    m_magnitudeLPFs.resize(size());
-    m_phaseLPFs.resize(size());
-    m_meters.resize(size());
+    m_moduleLPFs.resize(m_dataLength);
+    m_magnitudeLPFs.resize(m_dataLength);
+    m_phaseLPFs.resize(m_dataLength);
+    m_meters.resize(m_dataLength);
 
     // Deconvolution:
     m_deconvolution.setSize(m_deconvolutionSize);
-    m_impulseData.resize(m_deconvolutionSize);
     m_deconvLPFs.resize(m_deconvolutionSize);
     m_deconvAvg.setSize(m_deconvolutionSize);
     m_deconvAvg.reset();
+
+    m_delayFinder.setSize(DELAY_FINDER_SIZE);
+    m_delayFinderCounter = 0;
+    updateFilterFrequency();
+}
+//should be called while mutex locked, published results are kept
+void Measurement::release()
+{
+    if (!m_allocated) {
+        return;
+    }
+    m_allocated = false;
+    m_data.release();
+    m_reference.release();
+    std::vector<float>().swap(m_loopData);
+    m_levelMeters.release();
+
+    m_moduleAvg.setSize(0);
+    m_magnitudeAvg.setSize(0);
+    m_pahseAvg.setSize(0);
+    m_coherence.setSize(0);
+    m_moduleLPFs.resize(0);
+    m_magnitudeLPFs.resize(0);
+    m_phaseLPFs.resize(0);
+    m_meters.resize(0);
+
+    m_deconvolution.setSize(Deconvolution::MIN_SIZE);
+    m_deconvLPFs.resize(0);
+    m_deconvAvg.setSize(0);
+    m_delayFinder.setSize(Deconvolution::MIN_SIZE);
+    m_estimatedDelay = 0;
+    emit estimatedChanged();
+}
+std::size_t Measurement::memoryUsage() const
+{
+    if (!m_allocated) {
+        return 0;
+    }
+    //working buffers only, the estimate follows allocateTransform()
+    std::size_t bytes = (m_data.size() + m_reference.size() + m_loopData.capacity()) * sizeof(float);
+    bytes += m_dataLength * (
+                 sizeof(Filter::BesselLPF<float>) * 2 + sizeof(Filter::BesselLPF<complex>) +
+                 sizeof(Meter) + Meter::DEFAULT_SIZE * sizeof(float) +
+                 (sizeof(float) * 2 + sizeof(complex)) * (m_average + 1) +
+                 (sizeof(float) * 2 + sizeof(complex)) * 22
+             );
+    bytes += m_deconvolutionSize * (sizeof(Filter::BesselLPF<float>) + sizeof(float) * (m_average + 1) + DECONVOLUTION_BYTES);
+    bytes += m_delayFinder.size() * DECONVOLUTION_BYTES;
+    bytes += sampleRate() * sizeof(float) * (std::size(Weighting::allCurves) * std::size(Meter::allTimes) + 1);
+    return bytes;
 }
 void Measurement::updateFilterFrequency()
 {
@@ -286,38 +367,31 @@ void Measurement::updateFilterFrequency()
     });
 }
 
-void Measurement::applyInputFilters()
+std::shared_ptr<math::Filter> Measurement::createInputFilter(InputFilter type, unsigned int sampleRate)
 {
-    switch (m_inputFilter) {
+    switch (type) {
     case InputFilter::A:
-        std::atomic_store(&m_inputFilters.first,  std::shared_ptr<math::Filter>(new Weighting(Weighting::Curve::A,
-                                                                                              sampleRate())));
-        std::atomic_store(&m_inputFilters.second, std::shared_ptr<math::Filter>(new Weighting(Weighting::Curve::A,
-                                                                                              sampleRate())));
-        break;
+        return std::shared_ptr<math::Filter>(new Weighting(Weighting::Curve::A, sampleRate));
     case InputFilter::C:
-        std::atomic_store(&m_inputFilters.first,  std::shared_ptr<math::Filter>(new Weighting(Weighting::Curve::C,
-                                                                                              sampleRate())));
-        std::atomic_store(&m_inputFilters.second, std::shared_ptr<math::Filter>(new Weighting(Weighting::Curve::C,
-                                                                                              sampleRate())));
-        break;
+        return std::shared_ptr<math::Filter>(new Weighting(Weighting::Curve::C, sampleRate));
     case InputFilter::Notch: {
         auto q = 3.f;// AES17-1998 says: 1 to 5
-        std::atomic_store(&m_inputFilters.first,  std::shared_ptr<math::Filter>(new math::Notch(1000, q, sampleRate())));
-        std::atomic_store(&m_inputFilters.second, std::shared_ptr<math::Filter>(new math::Notch(1000, q, sampleRate())));
-        break;
+        return std::shared_ptr<math::Filter>(new math::Notch(1000, q, sampleRate));
     }
     case InputFilter::BP100: {
         auto q = 5.f;
-        std::atomic_store(&m_inputFilters.first,  std::shared_ptr<math::Filter>(new math::BandPass(100, q, sampleRate())));
-        std::atomic_store(&m_inputFilters.second, std::shared_ptr<math::Filter>(new math::BandPass(100, q, sampleRate())));
+        return std::shared_ptr<math::Filter>(new math::BandPass(100, q, sampleRate));
     }
-    break;
     case InputFilter::Z:
-        std::atomic_store(&m_inputFilters.first, std::shared_ptr<math::Filter>());
-        std::atomic_store(&m_inputFilters.second, std::shared_ptr<math::Filter>());
         break;
     }
+    return {};
+}
+
+void Measurement::applyInputFilters()
+{
+    std::atomic_store(&m_inputFilters.first,  createInputFilter(m_inputFilter, sampleRate()));
+    std::atomic_store(&m_inputFilters.second, createInputFilter(m_inputFilter, sampleRate()));
 
     if (m_inputFilter == InputFilter::Notch) {
         std::atomic_store(&m_levelMeters.m_filter, std::shared_ptr<math::Filter>(new math::Notch(1000, 3.f, sampleRate())));
@@ -330,15 +404,21 @@ void Measurement::onSampleRateChanged()
 {
     std::lock_guard<std::mutex> guard(m_dataMutex);
     if (m_audioStream) {
-        m_sampleRate = m_audioStream->format().sampleRate;
-        m_dataFT.setSampleRate(sampleRate());
-        m_dataFT.prepare();
-        m_levelMeters.setSampleRate(sampleRate());
-        calculateDataLength();
-        updateFilterFrequency();
-        applyInputFilters();
+        applySampleRate(m_audioStream->format().sampleRate);
     }
 }
+void Measurement::applySampleRate(unsigned int sampleRate)
+{
+    m_sampleRate = sampleRate;
+    m_dataFT.setSampleRate(sampleRate);
+    m_dataFT.prepare();
+    if (m_allocated) {
+        m_levelMeters.setSampleRate(sampleRate);
+    }
+    calculateDataLength();
+    updateFilterFrequency();
+    applyInputFilters();
+}
 audio::DeviceInfo::Id Measurement::deviceId() const
 {
     return m_deviceId;
@@ -357,6 +437,10 @@ QString Measurement::deviceName() const
 }
 void Measurement::selectDevice(const QString &name)
 {
+    //offline and shared channels are routed by their owner, the device is not used
+    if (offline()) {
+        return;
+    }
     auto id = audio::Client::getInstance()->deviceIdByName(name, audio::Plugin::Direction::Input);
     setDeviceId(id);
 }
@@ -368,31 +452,61 @@ void Measurement::applyAutoGain(const float reference)
 
 void Measurement::calculateDataLength()
 {
-    auto frequencyList = m_dataFT.getFrequencies();
-    m_dataLength = frequencyList.size();
+    m_ftdata.axis = Source::Axis::fromTransform(m_dataFT);
+    m_dataLength = m_ftdata.axis->size();
     m_ftdata.resize(m_dataLength);
-    unsigned int i = 0;
-    for (auto frequency : frequencyList) {
-        m_ftdata[i++].frequency = frequency;
-    }
     applyCalibration();
 }
 void Measurement::setActive(bool active)
 {
     if (active == m_active)
         return;
-    std::lock_guard<std::mutex> guard(m_dataMutex);
 
-    Source::Abstract::setActive(active);
-    m_error = false;
-    emit errorChanged(m_error);
+    //the budget releases other measurements: it is called without the own mutex locked
+    if (active) {
+        MemoryBudget::getInstance()->unpark(this);
+    }
+    std::size_t allocated;
+    {
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        if (active) {
+            allocate();
+        }
+        Source::Abstract::setActive(active);
+
+        if (m_feed == Feed::Shared) {
+            //samples were not collected while inactive, restore the delay
+            m_resetDelay = true;
+            m_levelMeters.reset();
+            emit levelChanged();
+        } else if (m_feed == Feed::Offline) {
+            m_resetDelay = true;
+        } else {
+            m_error = false;
+            emit errorChanged(m_error);
 
-    updateAudio();
+            updateAudio();
 
-    m_levelMeters.reset();
-    m_loopBuffer.reset();
-    emit levelChanged();
-    emit referenceLevelChanged();
+            m_levelMeters.reset();
+            m_loopReader.reset();
+            emit levelChanged();
+            emit referenceLevelChanged();
+        }
+        allocated = memoryUsage();
+    }
+    if (!active) {
+        parkBuffers(allocated);
+    }
+}
+//idle buffers are kept for a restart while they fit the memory budget
+void Measurement::parkBuffers(std::size_t bytes)
+{
+    MemoryBudget::getInstance()->park(this, bytes, [this]() {
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        if (!m_active) {
+            release();
+        }
+    });
 }
 void Measurement::setError()
 {
@@ -404,15 +518,6 @@ void Measurement::setError()
     emit levelChanged();
     emit referenceLevelChanged();
 }
-void Measurement::newSampleFromGenerator(float sample)
-{
-    m_loopBuffer.write(sample);
-}
-void Measurement::resetLoopBuffer()
-{
-    std::lock_guard<std::mutex> guard(m_dataMutex);
-    m_loopBuffer.reset();
-}
 //this calls from timer thread
 void Measurement::updateDelay()
 {
@@ -463,8 +568,9 @@ void Measurement::writeData(const char *data, qint64 len)
     if (!m_audioStream || m_onReset.load() || !m_active) {
         return;
     }
+    auto captured = audio::Loopback::clock::now();
     std::lock_guard<std::mutex> guard(m_dataMutex);
-    if (!m_audioStream) {
+    if (!m_audioStream || !m_allocated) {
         return;
     }
     float sample;
@@ -472,12 +578,23 @@ void Measurement::writeData(const char *data, qint64 len)
     unsigned int currentChanel = 0;
     bool forceRef = referenceChanel() >= totalChanels;
     bool forceData = dataChanel() >= totalChanels;
+    auto frames = static_cast<size_t>(len) / (totalChanels * sizeof(float));
+    if (m_recorder) {
+        m_recorder->writeFrames(reinterpret_cast<const float *>(data), frames, totalChanels);
+    }
+    if (forceRef || forceData) {
+        if (m_loopData.size() < frames) {
+            m_loopData.resize(frames);
+        }
+        audio::Loopback::getInstance()->read(m_loopReader, m_loopData.data(), frames, captured);
+        m_clockDrift = static_cast<float>(m_loopReader.ppm());
+    }
     float loopSample = 0;
-    bool loopAvailable = m_loopBuffer.collected() >= m_audioStream->depth() * len / (totalChanels * sizeof(float));
+    size_t frame = 0;
     qint64 offset = 0;
     for (auto it = data; offset < len; ) {
-        if (currentChanel == 0) {
-            loopSample = loopAvailable ? m_loopBuffer.read() : 0;
+        if (currentChanel == 0 && (forceRef || forceData)) {
+            loopSample = frame < frames ? m_loopData[frame++] : 0;
         }
 
         if (currentChanel == dataChanel()) {
@@ -507,14 +624,89 @@ void Measurement::writeData(const char *data, qint64 len)
         offset += 4;
     }
 
+    //a collected window is only marked here, the poll task transforms it on the scheduler
+    if (m_realtime && m_data.collected() >= m_sampleRate * TIMER_INTERVAL / 1000) {
+        m_windowReady.store(true, std::memory_order_release);
+    }
+}
+bool Measurement::offline() const noexcept
+{
+    return m_feed != Feed::Device;
+}
+Measurement::Feed Measurement::feed() const noexcept
+{
+    return m_feed;
+}
+void Measurement::startOffline(unsigned int sampleRate)
+{
+    if (!offline()) {
+        return;
+    }
+    MemoryBudget::getInstance()->unpark(this);
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    allocate();
+    Source::Abstract::setActive(true);
+    m_error = false;
+    applySampleRate(sampleRate);
+    m_data.reset();
+    m_reference.reset();
+    m_levelMeters.reset();
+    m_resetDelay = true;
+}
+void Measurement::writeOffline(const float *data, const float *reference, size_t count)
+{
+    if (!offline() || !m_active) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    if (!m_allocated) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        m_data.write(m_polarity ? -m_gain * data[i] : data[i] * m_gain);
+        m_levelMeters.add(data[i] * m_gain);
+    }
+    //reference is nullptr when it is shared and transformed by MultiMeasurement
+    if (reference) {
+        for (size_t i = 0; i < count; ++i) {
+            m_reference.write(reference[i] * m_offset);
+            m_levelMeters.addToReference(reference[i] * m_offset);
+        }
+    }
+}
+void Measurement::setSharedReference(const SharedReference *reference)
+{
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    m_sharedReference = reference;
+    m_resetDelay = true;
+}
+void Measurement::setRecorder(Recorder *recorder)
+{
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    m_recorder = recorder;
 }
 void Measurement::transform()
 {
     if (!m_active || m_error)
         return;
 
-    lock();
+    m_dataMutex.lock();
+    if (!m_allocated) {
+        m_dataMutex.unlock();
+        return;
+    }
     updateFftPower();
+    if (m_sharedReference) {
+        if (transformShared()) {
+            averaging();
+            publish();
+        }
+        m_dataMutex.unlock();
+        emit readyRead();
+        emit levelChanged();
+        emit referenceLevelChanged();
+        return;
+    }
     updateDelay();
 
     float d, r;
@@ -543,20 +735,73 @@ void Measurement::transform()
         m_delayFinderCounter = 0;
     }
     averaging();
-    unlock();
+    publish();
+    m_dataMutex.unlock();
     emit readyRead();
     emit levelChanged();
     emit referenceLevelChanged();
 }
+//this calls from MultiMeasurement thread after the shared reference was transformed
+bool Measurement::transformShared()
+{
+    auto reference = m_sharedReference;
+    if (reference->dataFT.type() != m_dataFT.type() || reference->dataFT.size() != m_dataFT.size()) {
+        //mode was changed, wait until the reference and the channel are prepared for it
+        return false;
+    }
+    updateSharedDelay();
+
+    //the reference window moved by count samples: missing data is padded, so the channel stays aligned
+    auto filter = m_inputFilters.first;
+    auto available = std::min(reference->count, m_data.collected());
+    for (size_t i = 0; i < reference->count; ++i) {
+        float d = i < available ? m_data.read() : 0.f;
+        if (filter) {
+            d = filter->operator()(d);
+        }
+        m_dataFT.add(d, 0.f);
+        m_deconvolution.add(d, 0.f);
+        m_delayFinder.add(d, 0.f);
+    }
+
+    m_dataFT.transform(reference->dataFT);
+    if (m_dataFT.type() == FourierTransform::Fast) {
+        m_deconvolution.transform(&m_dataFT);
+    } else {
+        m_deconvolution.transform(reference->deconvolution);
+    }
+    if (reference->delayFinderReady) {
+        m_delayFinder.transform(reference->delayFinder);
+    }
+    return true;
+}
+//reference is delayed by the largest delay of the group, data keeps the rest
+void Measurement::updateSharedDelay()
+{
+    if (m_resetDelay) {
+        m_workingDelay = 0;
+        m_data.reset();
+        m_resetDelay = false;
+    }
+    int target = std::max(static_cast<int>(m_sharedReference->delay) - m_delay, 0);
+    for (; m_workingDelay < target; ++m_workingDelay) {
+        m_data.write(0.f);
+    }
+    for (; m_workingDelay > target; --m_workingDelay) {
+        m_data.read();
+    }
+}
 void Measurement::averaging()
 {
     complex p;
     int j;
+    //own reference samples are multiplied by the offset in writeData, the shared one is not
+    const float referenceGain = m_sharedReference ? m_offset : 1.f;
     for (unsigned int i = 0; i < m_dataLength ; i++) {
 
         j = static_cast<int>(i);
         float calibratedA = M_SQRT2 * m_dataFT.af(i).abs();
-        float calibratedB = M_SQRT2 * m_dataFT.bf(i).abs();
+        float calibratedB = M_SQRT2 * m_dataFT.bf(i).abs() * referenceGain;
         //TODO: think and do
         //if (calibratedA < someThresholdInDb ) continue;
 
@@ -580,15 +825,15 @@ void Measurement::averaging()
 
         switch (averageType()) {
         case AverageType::Off:
-            m_ftdata[i].magnitude = magnitude;
-            m_ftdata[i].module    = calibratedA;
-            m_ftdata[i].phase     = p;
+            m_ftdata.magnitude[i] = magnitude;
+            m_ftdata.module[i]    = calibratedA;
+            m_ftdata.phase[i]     = p;
             break;
 
         case AverageType::LPF:
-            m_ftdata[i].magnitude = m_magnitudeLPFs[i](magnitude);
-            m_ftdata[i].module    = m_moduleLPFs[i](calibratedA);
-            m_ftdata[i].phase     = m_phaseLPFs[i](p);
+            m_ftdata.magnitude[i] = m_magnitudeLPFs[i](magnitude);
+            m_ftdata.module[i]    = m_moduleLPFs[i](calibratedA);
+            m_ftdata.phase[i]     = m_phaseLPFs[i](p);
             break;
 
         case AverageType::FIFO:
@@ -596,17 +841,17 @@ void Measurement::averaging()
             m_moduleAvg.append(i,    calibratedA );
             m_pahseAvg.append(i,     p);
 
-            m_ftdata[i].magnitude = m_magnitudeAvg.value(i);
-            m_ftdata[i].module    = m_moduleAvg.value(i);
-            m_ftdata[i].phase     = m_pahseAvg.value(i);
+            m_ftdata.magnitude[i] = m_magnitudeAvg.value(i);
+            m_ftdata.module[i]    = m_moduleAvg.value(i);
+            m_ftdata.phase[i]     = m_pahseAvg.value(i);
             break;
         }
 
         m_meters[i].add(calibratedA);
-        m_ftdata[i].peakSquared = m_meters[i].peakSquared();
-        m_ftdata[i].meanSquared = m_meters[i].value();
+        m_ftdata.peakSquared[i] = m_meters[i].peakSquared();
+        m_ftdata.meanSquared[i] = m_meters[i].value();
     }
-    m_coherence.calculate(m_ftdata.data(), &m_dataFT);
+    m_coherence.calculate(m_ftdata.coherence.data(), &m_dataFT);
 
     int t = 0;
     float kt = 1000.f / sampleRate();
@@ -617,19 +862,20 @@ void Measurement::averaging()
             j -= m_deconvolutionSize;
         }
 
+        float impulse = m_deconvolution.get(i) / referenceGain;
         switch (averageType()) {
         case AverageType::Off:
-            m_impulseData[j].value.real = m_deconvolution.get(i);
+            m_impulseData.value[j].real = impulse;
             break;
         case AverageType::LPF:
-            m_impulseData[j].value.real = m_deconvLPFs[i](m_deconvolution.get(i));
+            m_impulseData.value[j].real = m_deconvLPFs[i](impulse);
             break;
         case AverageType::FIFO:
-            m_deconvAvg.append(i, m_deconvolution.get(i));
-            m_impulseData[j].value.real = m_deconvAvg.value(i);
+            m_deconvAvg.append(i, impulse);
+            m_impulseData.value[j].real = m_deconvAvg.value(i);
             break;
         }
-        m_impulseData[j].time  = t * kt;//ms
+        m_impulseData.time[j]  = t * kt;//ms
     }
     if (m_estimatedDelay != m_delayFinder.maxIndex()) {
         m_estimatedDelay = m_delayFinder.maxIndex();
@@ -714,6 +960,7 @@ Source::Shared Measurement::clone() const
     cloned->m_calibrationLoaded = m_calibrationLoaded;
     cloned->applyCalibration();
 
+    cloned->setDriftCompensation(driftCompensation());
     cloned->setDelay(delay());
     cloned->setGain(gain());
     cloned->setDeviceId(deviceId());
@@ -752,6 +999,27 @@ void Measurement::setCalibration(bool c) noexcept
         emit calibrationChanged(m_enableCalibration);
     }
 }
+bool Measurement::driftCompensation() const noexcept
+{
+    return m_loopReader.compensate;
+}
+void Measurement::setDriftCompensation(bool driftCompensation)
+{
+    if (m_loopReader.compensate == driftCompensation) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        m_loopReader.compensate = driftCompensation;
+        m_loopReader.reset();
+    }
+    m_clockDrift = 0;
+    emit driftCompensationChanged(driftCompensation);
+}
+float Measurement::clockDrift() const noexcept
+{
+    return m_clockDrift;
+}
 bool Measurement::loadCalibrationFile(const QUrl &fileName) noexcept
 {
     QFile loadFile(fileName.toLocalFile());
@@ -813,7 +1081,7 @@ void Measurement::applyCalibration()
     bool inList = false;
     for (int i = 0; i < static_cast<int>(m_dataLength); ++i) {
 
-        while (m_ftdata[i].frequency > m_calibrationList[j][0]) {
+        while (m_ftdata.frequency(i) > m_calibrationList[j][0]) {
             last = m_calibrationList[j];
             if (j + 1 < m_calibrationList.size()) {
                 ++j;
@@ -838,8 +1106,8 @@ void Measurement::applyCalibration()
             kp = (p2 - p1) / (f2 - f1);
             bp = p2 - f2 * kp;
 
-            g = kg * m_ftdata[i].frequency + bg;
-            p = kp * m_ftdata[i].frequency + bp;
+            g = kg * m_ftdata.frequency(i) + bg;
+            p = kp * m_ftdata.frequency(i) + bp;
         } else {
             g = m_calibrationList[j][1];
             p = m_calibrationList[j][2];
@@ -851,12 +1119,17 @@ void Measurement::applyCalibration()
 }
 void Measurement::updateAudio()
 {
+    //offline and shared channels never open own stream
+    if (offline()) {
+        return;
+    }
     if (m_audioStream) {
         m_input.close();
         m_audioStream->disconnect(this);
         m_audioStream->close();
     }
     m_audioStream = nullptr;
+    m_realtime = true;
     checkChannels();
     if (m_active) {
         std::async([this]() {
@@ -864,12 +1137,17 @@ void Measurement::updateAudio()
             m_sampleRate = format.sampleRate;
             m_input.setCallback([this](const char *buffer, qint64 size) {
                 writeData(buffer, size);
+                //a stream without a clock waits here while a collected window is transformed
+                if (!m_realtime && m_data.collected() >= m_sampleRate * TIMER_INTERVAL / 1000) {
+                    transform();
+                }
             });
             m_audioStream = audio::Client::getInstance()->openInput(m_deviceId, &m_input, format);
             if (!m_audioStream) {
                 setError();
                 return;
             }
+            m_realtime = m_audioStream->realtime();
             connect(m_audioStream, &audio::Stream::sampleRateChanged, this, &Measurement::onSampleRateChanged);
             emit audioFormatChanged();
         });
@@ -877,6 +1155,9 @@ void Measurement::updateAudio()
 }
 void Measurement::checkChannels()
 {
+    if (offline()) {
+        return;
+    }
     audio::Format format = audio::Client::getInstance()->deviceInputFormat(m_deviceId);
     if (m_referenceChanel > format.channelCount) {
         setReferenceChanel(format.channelCount - 1);
@@ -913,7 +1194,7 @@ void Measurement::resetAverage() noexcept
     m_phaseLPFs.each(reset);
 
     m_meters.each(reset);
-    m_loopBuffer.reset();
+    m_loopReader.reset();
     m_levelMeters.reset();
 
     m_onReset.store(false);
@@ -960,3 +1241,75 @@ void Measurement::Meters::reset()
     }
     m_reference.reset();
 }
+
+void Measurement::Meters::release()
+{
+    for (auto &&meter : m_meters) {
+        meter.second.release();
+    }
+    m_reference.release();
+}
+
+Measurement::SharedReference::SharedReference() :
+    dataFT(), deconvolution(), delayFinder(),
+    meter(Weighting::Z, Meter::Slow),
+    mode(Mode::LFT), window(WindowFunction::Hann), sampleRate(0),
+    count(0), delay(0), delayFinderCounter(0), delayFinderReady(false)
+{
+}
+
+void Measurement::SharedReference::prepare(Mode mode, WindowFunction::Type window, unsigned int sampleRate)
+{
+    this->mode = mode;
+    this->window = window;
+    this->sampleRate = sampleRate;
+
+    //sizes must follow Measurement::updateFftPower
+    unsigned int deconvolutionSize;
+    switch (mode) {
+    case Mode::LFT:
+        dataFT.setType(FourierTransform::Log);
+        deconvolutionSize = pow(2, m_FFTsizes.at(FFT12));
+        break;
+    default:
+        dataFT.setSize(pow(2, m_FFTsizes.at(mode)));
+        dataFT.setType(FourierTransform::Fast);
+        deconvolutionSize = pow(2, m_FFTsizes.at(mode));
+    }
+    dataFT.setWindowFunctionType(window);
+    dataFT.setSampleRate(sampleRate);
+    dataFT.prepare();
+
+    deconvolution.setSize(deconvolutionSize);
+    deconvolution.setWindowFunctionType(window);
+    deconvolution.prepareFast();
+
+    delayFinder.setSize(DELAY_FINDER_SIZE);
+    delayFinder.setWindowFunctionType(window);
+    delayFinder.prepareFast();
+
+    meter.setSampleRate(sampleRate);
+    delayFinderCounter = 0;
+    delayFinderReady = false;
+}
+
+void Measurement::SharedReference::add(float sample)
+{
+    dataFT.add(sample, 0.f);
+    deconvolution.add(sample, 0.f);
+    delayFinder.add(sample, 0.f);
+}
+
+void Measurement::SharedReference::transform()
+{
+    dataFT.transformA();
+    //fast mode deconvolution uses the data transform
+    if (dataFT.type() != FourierTransform::Fast) {
+        deconvolution.transformA();
+    }
+    delayFinderReady = (++delayFinderCounter % 25) == 0;
+    if (delayFinderReady) {
+        delayFinder.transformA();
+        delayFinderCounter = 0;
+    }
+}
@@ -19,12 +19,11 @@
 #define MEASUREMENT_H
 
 #include <QObject>
-#include <QTimer>
-#include <QThread>
 
 #include "meta/metameasurement.h"
 #include "audio/deviceinfo.h"
 #include "audio/stream.h"
+#include "audio/loopback.h"
 #include "inputdevice.h"
 #include "chart/type.h"
 #include "source/source_abstract.h"
@@ -39,6 +38,8 @@
 #include "common/settings.h"
 #include "container/circular.h"
 
+class Recorder;
+
 class Measurement : public Source::Abstract, public Meta::Measurement
 {
     Q_OBJECT
@@ -86,11 +87,46 @@ class Measurement : public Source::Abstract, public Meta::Measurement
 
     Q_PROPERTY(Meta::Measurement::InputFilter inputFilter READ inputFilter WRITE setInputFilter NOTIFY inputFilterChanged)
 
+    //clock drift between the generator and the input, used with the Loop channel
+    Q_PROPERTY(bool driftCompensation READ driftCompensation WRITE setDriftCompensation NOTIFY
+               driftCompensationChanged)
+    Q_PROPERTY(float clockDrift READ clockDrift NOTIFY levelChanged REVISION NO_API_REVISION)
+
 public:
-    explicit Measurement(QObject *parent = nullptr);
+    //! where the samples come from
+    enum class Feed {
+        Device,     //own audio stream and the scheduler timer
+        Offline,    //writeOffline and transform are called by OfflineAnalysis
+        Shared      //MultiMeasurement channel, transformed against the shared reference
+    };
+
+    explicit Measurement(QObject *parent = nullptr, Feed feed = Feed::Device);
     ~Measurement() override;
 
-    static const unsigned int TIMER_INTERVAL = 80; //ms = 12.5 per sec
+    static const unsigned int TIMER_INTERVAL = 80; //ms = 12.5 per sec, samples collected per transform
+    static const unsigned int POLL_INTERVAL = 10;  //ms, how often the scheduler looks for a collected window
+    static const unsigned int BUFFER_SIZE = 65536; //samples of the input ring buffers
+
+    //! samples of the delay finder in every mode, delays up to a half of it are found
+    static const unsigned int DELAY_FINDER_SIZE = 65536;
+
+    //! reference channel shared by channels of MultiMeasurement, it is transformed once per tick
+    struct SharedReference {
+        SharedReference();
+        void prepare(Mode mode, WindowFunction::Type window, unsigned int sampleRate);
+        void add(float sample);
+        void transform();
+
+        FourierTransform dataFT, deconvolution, delayFinder;
+        Meter meter;
+        Mode mode;
+        WindowFunction::Type window;
+        unsigned int sampleRate;
+        size_t count;           //samples added on the current tick
+        unsigned int delay;     //samples the reference is delayed by
+        unsigned int delayFinderCounter;
+        bool delayFinderReady;
+    };
 
     Source::Shared clone() const override;
 
@@ -119,11 +155,26 @@ public:
     void setCalibration(bool c) noexcept;
     Q_INVOKABLE bool loadCalibrationFile(const QUrl &fileName) noexcept;
 
+    bool driftCompensation() const noexcept;
+    void setDriftCompensation(bool driftCompensation);
+    //! ppm, positive when the generator clock is faster than the input one
+    float clockDrift() const noexcept;
+
     audio::DeviceInfo::Id deviceId() const;
     void setDeviceId(const audio::DeviceInfo::Id &deviceId);
     QString deviceName() const;
     void selectDevice(const QString &name);
 
+    //! true if the measurement has no own stream: offline and shared channels
+    bool offline() const noexcept;
+    Feed feed() const noexcept;
+    void startOffline(unsigned int sampleRate);
+    void writeOffline(const float *data, const float *reference, size_t count);
+    void setSharedReference(const SharedReference *reference);
+    //! the recorder receives the input frames in writeData, nullptr detaches it
+    void setRecorder(Recorder *recorder);
+    static std::shared_ptr<math::Filter> createInputFilter(InputFilter type, unsigned int sampleRate);
+
     Q_INVOKABLE void applyAutoGain(const float reference) override;
     Q_INVOKABLE void destroy() override final;
 
@@ -132,8 +183,6 @@ public slots:
     void onSampleRateChanged();
     void writeData(const char *data, qint64 len);
     void setError();
-    void newSampleFromGenerator(float sample);
-    void resetLoopBuffer();
 
 protected slots:
     void updateFftPower();
@@ -144,8 +193,6 @@ protected slots:
     void applyInputFilters();
 
 private:
-    QTimer m_timer;
-    QThread m_timerThread;
     InputDevice m_input;
 
     audio::DeviceInfo::Id m_deviceId;
@@ -159,8 +206,14 @@ private:
     unsigned int m_delayFinderCounter;
     long m_estimatedDelay;
     bool m_error;
-
-    container::circular<float> m_data, m_reference, m_loopBuffer;
+    const Feed m_feed;
+
+    //working buffers exist only while active or parked in the MemoryBudget
+    bool m_allocated;
+    container::circular<float> m_data, m_reference;
+    audio::Loopback::Reader m_loopReader;
+    std::vector<float> m_loopData;
+    std::atomic<float> m_clockDrift;
     struct Meters {
         std::unordered_map<Levels::Key, Meter, Levels::Key::Hash> m_meters;
         Meter m_reference;
@@ -171,6 +224,7 @@ private:
         void add(float value);
         void addToReference(const float &value);
         void reset();
+        void release();
     } m_levelMeters;
 
     FourierTransform m_dataFT;
@@ -188,6 +242,12 @@ private:
     void calculateDataLength();
     void averaging();
 
+    void allocate();
+    void allocateTransform();
+    void release();
+    void parkBuffers(std::size_t bytes);
+    std::size_t memoryUsage() const;
+
     bool m_enableCalibration, m_calibrationLoaded;
     QList<QVector<float>> m_calibrationList;
     QVector<float> m_calibrationGain;
@@ -196,8 +256,18 @@ private:
 
     std::pair<std::shared_ptr<math::Filter>, std::shared_ptr<math::Filter>> m_inputFilters;
 
+    const SharedReference *m_sharedReference;
+    Recorder *m_recorder;
+    //! false while the stream isn't paced: windows are transformed in the input callback
+    std::atomic<bool> m_realtime;
+    //! set by the input callback, taken by the poll task: the callback doesn't touch the scheduler
+    std::atomic<bool> m_windowReady;
+    bool transformShared();
+    void updateSharedDelay();
+
     void updateAudio();
     void checkChannels();
+    void applySampleRate(unsigned int sampleRate);
 
 signals:
     void audioFormatChanged();
@@ -209,6 +279,7 @@ signals:
     void errorChanged(bool);
     void calibrationChanged(bool);
     void calibrationLoadedChanged(bool);
+    void driftCompensationChanged(bool);
 
     void polarityChanged(bool) override;
     void gainChanged(float) override;
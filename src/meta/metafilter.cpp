@@ -27,7 +27,10 @@ const std::map<Filter::Type, QString>Filter::m_typeMap = {
     {Filter::BesselLPF, "Bessel LPF"},
     {Filter::BesselHPF, "Bessel HPF"},
     {Filter::APF,       "All pass"},
-    {Filter::Peak,      "Peak"}
+    {Filter::Peak,      "Peak"},
+    {Filter::LowShelf,  "Low shelf"},
+    {Filter::HighShelf, "High shelf"},
+    {Filter::Delay,     "Delay"}
 };
 
 const std::map<Filter::Type, QString>Filter::m_typeShortMap = {
@@ -38,11 +41,14 @@ const std::map<Filter::Type, QString>Filter::m_typeShortMap = {
     {Filter::BesselLPF,        "Bessel LPF"},
     {Filter::BesselHPF,        "Bessel HPF"},
     {Filter::APF,              "APF"},
-    {Filter::Peak,             "Peak"}
+    {Filter::Peak,             "Peak"},
+    {Filter::LowShelf,         "LSF"},
+    {Filter::HighShelf,        "HSF"},
+    {Filter::Delay,            "Delay"}
 };
 
 Filter::Filter() : Base(), m_type(ButterworthLPF), m_mode(Measurement::FFT14),
-    m_sampleRate(48000), m_order(3), m_cornerFrequency(1000), m_q(1.f / sqrt(2))
+    m_sampleRate(48000), m_order(3), m_cornerFrequency(1000), m_gain(0), m_q(1.f / sqrt(2)), m_delay(0)
 {
 
 }
@@ -133,9 +139,14 @@ void Filter::setOrder(unsigned int newOrder)
 }
 
 QVariant Filter::getAvailableOrders()
+{
+    return availableOrders(type());
+}
+
+QList<QVariant> Filter::availableOrders(Type type)
 {
     QList<QVariant> orders;
-    switch (type()) {
+    switch (type) {
     case ButterworthHPF:
     case ButterworthLPF:
         orders = QList<QVariant>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
@@ -152,8 +163,13 @@ QVariant Filter::getAvailableOrders()
         orders = QList<QVariant>({2, 4});
         break;
     case Peak:
+    case Delay:
         orders = QList<QVariant>({1});
         break;
+    case LowShelf:
+    case HighShelf:
+        orders = QList<QVariant>({2});
+        break;
     }
     return orders;
 }
@@ -171,6 +187,19 @@ void Filter::setQ(float newQ)
     emit qChanged(m_q);
 }
 
+float Filter::delay() const
+{
+    return m_delay;
+}
+
+void Filter::setDelay(float newDelay)
+{
+    if (qFuzzyCompare(m_delay, newDelay))
+        return;
+    m_delay = newDelay;
+    emit delayChanged(m_delay);
+}
+
 float Filter::gain() const
 {
     return m_gain;
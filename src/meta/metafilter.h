@@ -38,7 +38,10 @@ public:
         BesselLPF,
         BesselHPF,
         APF,
-        Peak    = 7
+        Peak    = 7,
+        LowShelf,
+        HighShelf,
+        Delay
     };
     Q_ENUM(Type)
 
@@ -65,9 +68,13 @@ public:
     float q() const;
     void setQ(float newQ);
 
+    float delay() const;
+    void setDelay(float newDelay);
+
     unsigned int order() const;
     void setOrder(unsigned int newOrder);
     QVariant getAvailableOrders();
+    static QList<QVariant> availableOrders(Type type);
 
 //virtual signals:
     virtual void sampleRateChanged(unsigned int) = 0;
@@ -77,6 +84,7 @@ public:
     virtual void orderChanged(unsigned int) = 0;
     virtual void gainChanged(float) = 0;
     virtual void qChanged(float) = 0;
+    virtual void delayChanged(float) = 0;
 
     static const std::map<Type, QString> m_typeMap;
     static const std::map<Type, QString> m_typeShortMap;
@@ -88,6 +96,7 @@ private:
     float m_cornerFrequency;
     float m_gain;
     float m_q;
+    float m_delay;
 };
 
 } // namespace meta
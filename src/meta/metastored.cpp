@@ -21,7 +21,7 @@ namespace Meta {
 
 Stored::Stored() : Base(),
     m_notes(), m_polarity(false), m_inverse(false),
-    m_ignoreCoherence(false), m_gain(0), m_delay(0)
+    m_ignoreCoherence(false), m_compact(false), m_gain(0), m_delay(0)
 {
 
 }
@@ -78,6 +78,19 @@ void Stored::setIgnoreCoherence(bool ignoreCoherence)
     }
 }
 
+bool Stored::compact() const
+{
+    return m_compact;
+}
+
+void Stored::setCompact(bool compact)
+{
+    if (m_compact != compact) {
+        m_compact = compact;
+        emit compactChanged();
+    }
+}
+
 float Stored::gain() const
 {
     return m_gain;
@@ -40,6 +40,9 @@ public:
     bool ignoreCoherence() const;
     void setIgnoreCoherence(bool ignoreCoherence);
 
+    bool compact() const;
+    void setCompact(bool compact);
+
     float gain() const;
     void setGain(float gain);
 
@@ -53,12 +56,14 @@ public:
     virtual void gainChanged() = 0;
     virtual void delayChanged() = 0;
     virtual void ignoreCoherenceChanged() = 0;
+    virtual void compactChanged() = 0;
 
 private:
     QString m_notes;
     bool m_polarity;
     bool m_inverse;
     bool m_ignoreCoherence;
+    bool m_compact;
     float m_gain;
     float m_delay;
 };
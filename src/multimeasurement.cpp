@@ -0,0 +1,507 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QJsonArray>
+#include <set>
+#include "multimeasurement.h"
+#include "audio/client.h"
+#include "common/scheduler.h"
+
+MultiMeasurement::MultiMeasurement(QObject *parent) : Source::Group(parent),
+    m_input(this),
+    m_deviceId(audio::Client::defaultInputDeviceId()),
+    m_audioStream(nullptr),
+    m_referenceChanel(1), m_sampleRate(0),
+    m_mode(Meta::Measurement::FFT14),
+    m_windowFunctionType(WindowFunction::Type::Hann),
+    m_inputFilter(Meta::Measurement::Z),
+    m_referenceFilter(),
+    m_error(false),
+    m_sharedReference(),
+    m_reference(65536), m_referenceDelay(0),
+    m_loopReader(), m_loopData(), m_chanelData(),
+    m_channels(), m_realtime(true), m_windowReady(false)
+{
+    setObjectName("MultiMeasurement");
+    setName("Multi");
+
+    m_input.setCallback([this](const char *buffer, qint64 size) {
+        writeData(buffer, size);
+        //a stream without a clock waits here while a collected window is transformed
+        if (!m_realtime && m_reference.collected() >= m_sampleRate * Measurement::TIMER_INTERVAL / 1000) {
+            transform();
+        }
+    });
+
+    //channel can be removed or popped from the group by the user
+    connect(sourceList(), &SourceList::preItemRemoved, this, &MultiMeasurement::detachChannel);
+
+    Scheduler::getInstance()->addPeriodic(this, "MultiMeasurement::poll",
+                                          std::chrono::milliseconds(Measurement::POLL_INTERVAL), [this]() {
+        if (m_windowReady.exchange(false)) {
+            transform();
+        }
+    });
+
+    setDataChanels({0});
+    updateAudio();
+}
+
+MultiMeasurement::~MultiMeasurement()
+{
+    sourceList()->disconnect(this);
+    Scheduler::getInstance()->cancel(this);
+
+    Source::Abstract::setActive(false);
+    updateAudio();
+
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    for (auto &channel : m_channels) {
+        channel->setSharedReference(nullptr);
+    }
+    m_channels.clear();
+}
+
+Source::Shared MultiMeasurement::clone() const
+{
+    //the clone and its channels get own uuids
+    auto data = toJSON();
+    data.remove("uuid");
+    QJsonArray channels;
+    for (const auto &channel : data["channels"].toArray()) {
+        auto object = channel.toObject();
+        object.remove("uuid");
+        channels.append(object);
+    }
+    data["channels"] = channels;
+
+    auto cloned = std::make_shared<MultiMeasurement>(parent());
+    cloned->fromJSON(data);
+    return std::static_pointer_cast<Source::Abstract>(cloned);
+}
+
+void MultiMeasurement::destroy()
+{
+    setActive(false);
+    Source::Group::destroy();
+}
+
+void MultiMeasurement::setActive(bool active)
+{
+    if (active == m_active) {
+        return;
+    }
+    Source::Abstract::setActive(active);
+    m_error = false;
+    emit errorChanged(m_error);
+    updateAudio();
+}
+
+QJsonObject MultiMeasurement::toJSON(const SourceList *list) const noexcept
+{
+    auto data = Source::Abstract::toJSON(list);
+    data["deviceName"]      = deviceName();
+    data["referenceChanel"] = static_cast<int>(m_referenceChanel);
+    data["mode"]            = m_mode;
+    data["window.type"]     = m_windowFunctionType;
+    data["inputFilters"]    = static_cast<int>(m_inputFilter);
+
+    QJsonArray channels;
+    for (auto &channel : m_channels) {
+        channels.append(channel->toJSON(list));
+    }
+    data["channels"] = channels;
+    return data;
+}
+
+void MultiMeasurement::fromJSON(QJsonObject data, const SourceList *list) noexcept
+{
+    Source::Abstract::fromJSON(data, list);
+
+    auto channelsJson = data["channels"].toArray();
+    QVariantList chanels;
+    for (const auto &channel : channelsJson) {
+        chanels << channel.toObject()["dataChanel"].toInt();
+    }
+    setDataChanels(chanels);
+    for (const auto &channelJson : channelsJson) {
+        auto object = channelJson.toObject();
+        for (auto &channel : m_channels) {
+            if (static_cast<int>(channel->dataChanel()) == object["dataChanel"].toInt()) {
+                channel->fromJSON(object, list);
+            }
+        }
+    }
+
+    //group settings override the loaded channel settings
+    setReferenceChanel(static_cast<unsigned int>(data["referenceChanel"].toInt(m_referenceChanel)));
+    setMode(static_cast<Meta::Measurement::Mode>(data["mode"].toInt(m_mode)));
+    setWindowFunctionType(static_cast<WindowFunction::Type>(data["window.type"].toInt(m_windowFunctionType)));
+    setInputFilter(static_cast<Meta::Measurement::InputFilter>(data["inputFilters"].toInt(m_inputFilter)));
+    selectDevice(data["deviceName"].toString(deviceName()));
+}
+
+float MultiMeasurement::referenceLevel() const
+{
+    return m_sharedReference.meter.dB();
+}
+
+audio::DeviceInfo::Id MultiMeasurement::deviceId() const
+{
+    return m_deviceId;
+}
+
+void MultiMeasurement::setDeviceId(const audio::DeviceInfo::Id &deviceId)
+{
+    if (!deviceId.isNull() && deviceId != m_deviceId) {
+        m_deviceId = deviceId;
+        emit deviceIdChanged(m_deviceId);
+        updateAudio();
+    }
+}
+
+QString MultiMeasurement::deviceName() const
+{
+    return audio::Client::getInstance()->deviceName(m_deviceId);
+}
+
+void MultiMeasurement::selectDevice(const QString &name)
+{
+    setDeviceId(audio::Client::getInstance()->deviceIdByName(name, audio::Plugin::Direction::Input));
+}
+
+unsigned int MultiMeasurement::referenceChanel() const
+{
+    return m_referenceChanel;
+}
+
+void MultiMeasurement::setReferenceChanel(unsigned int referenceChanel)
+{
+    if (m_referenceChanel == referenceChanel) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        m_referenceChanel = referenceChanel;
+        for (auto &channel : m_channels) {
+            channel->setReferenceChanel(referenceChanel);
+        }
+    }
+    emit referenceChanelChanged(m_referenceChanel);
+}
+
+QVariantList MultiMeasurement::dataChanels() const
+{
+    QVariantList list;
+    for (auto &channel : m_channels) {
+        list << channel->dataChanel();
+    }
+    return list;
+}
+
+void MultiMeasurement::setDataChanels(const QVariantList &chanels)
+{
+    std::set<unsigned int> requested;
+    for (auto &chanel : chanels) {
+        if (requested.size() < MAX_CHANNELS) {
+            requested.insert(chanel.toUInt());
+        }
+    }
+
+    std::vector<QUuid> removed;
+    for (auto &channel : m_channels) {
+        if (requested.erase(channel->dataChanel()) == 0) {
+            removed.push_back(channel->uuid());
+        }
+    }
+    if (removed.empty() && requested.empty()) {
+        return;
+    }
+
+    //preItemRemoved detaches the channel
+    for (auto &uuid : removed) {
+        remove(uuid);
+    }
+    for (auto chanel : requested) {
+        auto channel = createChannel(chanel);
+        {
+            std::lock_guard<std::mutex> guard(m_dataMutex);
+            m_channels.push_back(channel);
+        }
+        sourceList()->appendItem(channel, true);
+    }
+    emit dataChanelsChanged();
+}
+
+Meta::Measurement::Mode MultiMeasurement::mode() const
+{
+    return m_mode;
+}
+
+void MultiMeasurement::setMode(Meta::Measurement::Mode mode)
+{
+    if (m_mode == mode) {
+        return;
+    }
+    m_mode = mode;
+    for (auto &channel : m_channels) {
+        channel->setMode(mode);
+    }
+    emit modeChanged(m_mode);
+}
+
+WindowFunction::Type MultiMeasurement::windowFunctionType() const
+{
+    return m_windowFunctionType;
+}
+
+void MultiMeasurement::setWindowFunctionType(WindowFunction::Type type)
+{
+    if (m_windowFunctionType == type) {
+        return;
+    }
+    m_windowFunctionType = type;
+    for (auto &channel : m_channels) {
+        channel->setWindowFunctionType(type);
+    }
+    emit windowFunctionTypeChanged(m_windowFunctionType);
+}
+
+Meta::Measurement::InputFilter MultiMeasurement::inputFilter() const
+{
+    return m_inputFilter;
+}
+
+void MultiMeasurement::setInputFilter(Meta::Measurement::InputFilter inputFilter)
+{
+    if (m_inputFilter == inputFilter) {
+        return;
+    }
+    m_inputFilter = inputFilter;
+    std::atomic_store(&m_referenceFilter, Measurement::createInputFilter(m_inputFilter, m_sampleRate));
+    for (auto &channel : m_channels) {
+        channel->setInputFilter(inputFilter);
+    }
+    emit inputFilterChanged(m_inputFilter);
+}
+
+unsigned int MultiMeasurement::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+QVariant MultiMeasurement::getAvailableModes()
+{
+    return Meta::Measurement::getAvailableModes();
+}
+
+QVariant MultiMeasurement::getAvailableWindowTypes()
+{
+    return Meta::Measurement::getAvailableWindowTypes();
+}
+
+QVariant MultiMeasurement::getAvailableInputFilters()
+{
+    return Meta::Measurement::getAvailableInputFilters();
+}
+
+std::shared_ptr<Measurement> MultiMeasurement::createChannel(unsigned int chanel)
+{
+    auto channel = std::make_shared<Measurement>(nullptr, Measurement::Feed::Shared);
+    channel->setName(name() + " " + QString::number(chanel + 1));
+    channel->setDataChanel(chanel);
+    channel->setReferenceChanel(m_referenceChanel);
+    channel->setMode(m_mode);
+    channel->setWindowFunctionType(m_windowFunctionType);
+    channel->setInputFilter(m_inputFilter);
+    channel->setSharedReference(&m_sharedReference);
+    if (m_sampleRate) {
+        channel->startOffline(m_sampleRate);
+    }
+    return channel;
+}
+
+void MultiMeasurement::detachChannel(const QUuid &uuid)
+{
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    auto it = std::find_if(m_channels.begin(), m_channels.end(), [&uuid](auto &channel) {
+        return channel->uuid() == uuid;
+    });
+    if (it != m_channels.end()) {
+        (*it)->setSharedReference(nullptr);
+        m_channels.erase(it);
+    }
+}
+
+void MultiMeasurement::updateAudio()
+{
+    if (m_audioStream) {
+        m_input.close();
+        m_audioStream->disconnect(this);
+        m_audioStream->close();
+    }
+    m_audioStream = nullptr;
+    m_realtime = true;
+    if (!m_active) {
+        return;
+    }
+
+    auto format = audio::Client::getInstance()->deviceInputFormat(m_deviceId);
+    m_audioStream = audio::Client::getInstance()->openInput(m_deviceId, &m_input, format);
+    if (!m_audioStream) {
+        setError();
+        return;
+    }
+    m_realtime = m_audioStream->realtime();
+    connect(m_audioStream, &audio::Stream::sampleRateChanged, this, &MultiMeasurement::onSampleRateChanged);
+    onSampleRateChanged();
+}
+
+void MultiMeasurement::onSampleRateChanged()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        if (!m_audioStream) {
+            return;
+        }
+        m_sampleRate = m_audioStream->format().sampleRate;
+        m_reference.reset();
+        m_referenceDelay = 0;
+        m_loopReader.reset();
+        m_sharedReference.meter.reset();
+        std::atomic_store(&m_referenceFilter, Measurement::createInputFilter(m_inputFilter, m_sampleRate));
+        for (auto &channel : m_channels) {
+            channel->startOffline(m_sampleRate);
+        }
+    }
+    emit sampleRateChanged();
+}
+
+void MultiMeasurement::setError()
+{
+    Source::Abstract::setActive(false);
+    m_error = true;
+    m_input.close();
+    emit errorChanged(m_error);
+}
+
+void MultiMeasurement::writeData(const char *data, qint64 len)
+{
+    if (!m_audioStream || !m_active) {
+        return;
+    }
+    auto captured = audio::Loopback::clock::now();
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    if (!m_audioStream || !m_sampleRate) {
+        return;
+    }
+    auto totalChanels = m_audioStream->format().channelCount;
+    auto frames = static_cast<size_t>(len) / (totalChanels * sizeof(float));
+    auto input = reinterpret_cast<const float *>(data);
+
+    //as in Measurement, a channel after the last one of the device is the generator loopback
+    bool loopback = m_referenceChanel >= totalChanels;
+    for (auto &channel : m_channels) {
+        loopback = loopback || channel->dataChanel() >= totalChanels;
+    }
+    if (loopback) {
+        if (m_loopData.size() < frames) {
+            m_loopData.resize(frames);
+        }
+        audio::Loopback::getInstance()->read(m_loopReader, m_loopData.data(), frames, captured);
+    }
+    if (m_chanelData.size() < frames) {
+        m_chanelData.resize(frames);
+    }
+
+    auto deinterleave = [&](unsigned int chanel) {
+        if (chanel >= totalChanels) {
+            std::copy_n(m_loopData.begin(), frames, m_chanelData.begin());
+            return;
+        }
+        for (size_t i = 0; i < frames; ++i) {
+            m_chanelData[i] = input[i * totalChanels + chanel];
+        }
+    };
+
+    deinterleave(m_referenceChanel);
+    for (size_t i = 0; i < frames; ++i) {
+        m_reference.write(m_chanelData[i]);
+        m_sharedReference.meter.add(m_chanelData[i]);
+    }
+    for (auto &channel : m_channels) {
+        deinterleave(channel->dataChanel());
+        channel->writeOffline(m_chanelData.data(), nullptr, frames);
+    }
+
+    //as in Measurement, a collected window is only marked for the poll task
+    if (m_realtime && m_reference.collected() >= m_sampleRate * Measurement::TIMER_INTERVAL / 1000) {
+        m_windowReady.store(true, std::memory_order_release);
+    }
+}
+
+void MultiMeasurement::transform()
+{
+    if (!m_active || m_error) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    if (!m_sampleRate) {
+        return;
+    }
+    auto &reference = m_sharedReference;
+    if (reference.mode != m_mode || reference.window != m_windowFunctionType || reference.sampleRate != m_sampleRate) {
+        reference.prepare(m_mode, m_windowFunctionType, m_sampleRate);
+    }
+
+    //reference is delayed by the largest channel delay, channels delay their data by the rest
+    int delay = 0;
+    for (auto &channel : m_channels) {
+        delay = std::max(delay, channel->delay());
+    }
+    for (; static_cast<int>(m_referenceDelay) < delay; ++m_referenceDelay) {
+        m_reference.write(0.f);
+    }
+    for (; static_cast<int>(m_referenceDelay) > delay; --m_referenceDelay) {
+        m_reference.read();
+    }
+    reference.delay = m_referenceDelay;
+
+    auto collected = m_reference.collected();
+    reference.count = collected > m_referenceDelay ? collected - m_referenceDelay : 0;
+    auto filter = std::atomic_load(&m_referenceFilter);
+    for (size_t i = 0; i < reference.count; ++i) {
+        float r = m_reference.read();
+        if (filter) {
+            r = filter->operator()(r);
+        }
+        reference.add(r);
+    }
+    reference.transform();
+
+    //each channel locks itself
+    std::vector<Scheduler::Task> tasks;
+    tasks.reserve(m_channels.size());
+    for (auto &channel : m_channels) {
+        tasks.push_back([channel = channel.get()]() {
+            channel->transform();
+        });
+    }
+    Scheduler::getInstance()->parallel(tasks);
+    emit referenceLevelChanged();
+}
@@ -0,0 +1,142 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MULTIMEASUREMENT_H
+#define MULTIMEASUREMENT_H
+
+#include <QObject>
+
+#include "measurement.h"
+#include "source/group.h"
+
+/**
+ * @brief The MultiMeasurement class
+ * measures N data channels of one input device against one reference channel.
+ * The reference is buffered, windowed and transformed once per tick, each channel is a usual Measurement
+ * which transforms only its data channel and takes the reference spectrum from the group.
+ * Channels are processed in parallel on the Scheduler pool.
+ */
+class MultiMeasurement : public Source::Group
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QString deviceId READ deviceId WRITE setDeviceId NOTIFY deviceIdChanged)
+    Q_PROPERTY(unsigned int referenceChanel READ referenceChanel WRITE setReferenceChanel NOTIFY referenceChanelChanged)
+    Q_PROPERTY(QVariantList dataChanels READ dataChanels WRITE setDataChanels NOTIFY dataChanelsChanged)
+    Q_PROPERTY(Meta::Measurement::Mode mode READ mode WRITE setMode NOTIFY modeChanged)
+    Q_PROPERTY(WindowFunction::Type window READ windowFunctionType WRITE setWindowFunctionType NOTIFY
+               windowFunctionTypeChanged)
+    Q_PROPERTY(Meta::Measurement::InputFilter inputFilter READ inputFilter WRITE setInputFilter NOTIFY
+               inputFilterChanged)
+    Q_PROPERTY(int sampleRate READ sampleRate NOTIFY sampleRateChanged)
+    Q_PROPERTY(float referenceLevel READ referenceLevel NOTIFY referenceLevelChanged)
+    Q_PROPERTY(bool error MEMBER m_error NOTIFY errorChanged)
+
+    //constant meta properties
+    Q_PROPERTY(QVariant modes READ getAvailableModes CONSTANT)
+    Q_PROPERTY(QVariant inputFilters READ getAvailableInputFilters CONSTANT)
+    Q_PROPERTY(QVariant windows READ getAvailableWindowTypes CONSTANT)
+
+public:
+    static constexpr unsigned int MAX_CHANNELS = 64;
+
+    explicit MultiMeasurement(QObject *parent = nullptr);
+    ~MultiMeasurement() override;
+
+    Source::Shared clone() const override;
+    Q_INVOKABLE void destroy() override;
+    void setActive(bool active) override;
+
+    QJsonObject toJSON(const SourceList *list = nullptr) const noexcept override;
+    void fromJSON(QJsonObject data, const SourceList *list = nullptr) noexcept override;
+
+    float referenceLevel() const override;
+
+    audio::DeviceInfo::Id deviceId() const;
+    void setDeviceId(const audio::DeviceInfo::Id &deviceId);
+    QString deviceName() const;
+    void selectDevice(const QString &name);
+
+    unsigned int referenceChanel() const;
+    void setReferenceChanel(unsigned int referenceChanel);
+
+    QVariantList dataChanels() const;
+    void setDataChanels(const QVariantList &chanels);
+
+    Meta::Measurement::Mode mode() const;
+    void setMode(Meta::Measurement::Mode mode);
+
+    WindowFunction::Type windowFunctionType() const;
+    void setWindowFunctionType(WindowFunction::Type type);
+
+    Meta::Measurement::InputFilter inputFilter() const;
+    void setInputFilter(Meta::Measurement::InputFilter inputFilter);
+
+    unsigned int sampleRate() const;
+
+    static QVariant getAvailableModes();
+    static QVariant getAvailableWindowTypes();
+    static QVariant getAvailableInputFilters();
+
+public slots:
+    void transform();
+    void writeData(const char *data, qint64 len);
+    void onSampleRateChanged();
+
+signals:
+    void deviceIdChanged(audio::DeviceInfo::Id);
+    void referenceChanelChanged(unsigned int);
+    void dataChanelsChanged();
+    void modeChanged(Meta::Measurement::Mode);
+    void windowFunctionTypeChanged(WindowFunction::Type);
+    void inputFilterChanged(Meta::Measurement::InputFilter);
+    void sampleRateChanged();
+    void referenceLevelChanged();
+    void errorChanged(bool);
+
+private:
+    std::shared_ptr<Measurement> createChannel(unsigned int chanel);
+    void detachChannel(const QUuid &uuid);
+    void updateAudio();
+    void setError();
+
+    InputDevice m_input;
+
+    audio::DeviceInfo::Id m_deviceId;
+    audio::Stream *m_audioStream;
+
+    unsigned int m_referenceChanel, m_sampleRate;
+    Meta::Measurement::Mode m_mode;
+    WindowFunction::Type m_windowFunctionType;
+    Meta::Measurement::InputFilter m_inputFilter;
+    std::shared_ptr<math::Filter> m_referenceFilter;
+    bool m_error;
+
+    Measurement::SharedReference m_sharedReference;
+    container::circular<float> m_reference;
+    unsigned int m_referenceDelay;
+    audio::Loopback::Reader m_loopReader;
+    std::vector<float> m_loopData, m_chanelData;
+
+    std::vector<std::shared_ptr<Measurement>> m_channels;
+    //! false while the stream isn't paced: windows are transformed in the input callback
+    std::atomic<bool> m_realtime;
+    //! set by the input callback, taken by the poll task
+    std::atomic<bool> m_windowReady;
+};
+
+#endif // MULTIMEASUREMENT_H
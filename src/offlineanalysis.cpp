@@ -0,0 +1,196 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "offlineanalysis.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+#include "measurement.h"
+#include "stored.h"
+#include "common/wavfile.h"
+
+OfflineAnalysis::OfflineAnalysis(QObject *parent) : QObject(parent),
+    m_settings(), m_timePoints(), m_levelInterval(1.f),
+    m_threads(std::max(QThread::idealThreadCount(), 1)),
+    m_cancel(false)
+{
+}
+
+void OfflineAnalysis::setSettings(const QJsonObject &settings)
+{
+    m_settings = settings;
+}
+
+void OfflineAnalysis::setTimePoints(const std::vector<float> &timePoints)
+{
+    m_timePoints = timePoints;
+    std::sort(m_timePoints.begin(), m_timePoints.end());
+}
+
+void OfflineAnalysis::setLevelInterval(float levelInterval)
+{
+    m_levelInterval = levelInterval;
+}
+
+void OfflineAnalysis::setThreads(unsigned int threads)
+{
+    m_threads = std::max(threads, 1u);
+}
+
+void OfflineAnalysis::cancel()
+{
+    m_cancel = true;
+}
+
+std::vector<OfflineAnalysis::Result> OfflineAnalysis::analyse(const QStringList &fileNames)
+{
+    m_cancel = false;
+    std::vector<Result> results;
+    results.reserve(fileNames.size());
+
+    //every file has its own Measurement, so files are independent
+    for (int first = 0; first < fileNames.size(); first += m_threads) {
+        std::vector<std::future<Result>> tasks;
+        for (int i = first; i < fileNames.size() && i < first + static_cast<int>(m_threads); ++i) {
+            tasks.push_back(std::async(std::launch::async, [this, fileName = fileNames[i]]() {
+                return analyseFile(fileName);
+            }));
+        }
+        for (auto &task : tasks) {
+            results.push_back(task.get());
+        }
+    }
+    return results;
+}
+
+OfflineAnalysis::Result OfflineAnalysis::analyseFile(const QString &fileName)
+{
+    Result result;
+    result.fileName = fileName;
+
+    WavFile wav;
+    if (!wav.load(fileName)) {
+        result.error = "can't load file";
+        return result;
+    }
+
+    auto measurement = std::make_shared<Measurement>(nullptr, Measurement::Feed::Offline);
+    measurement->fromJSON(m_settings);
+    measurement->startOffline(wav.sampleRate());
+
+    unsigned int channels = wav.channels();
+    unsigned int dataChanel = std::min(measurement->dataChanel(), channels - 1);
+    unsigned int referenceChanel = std::min(measurement->referenceChanel(), channels - 1);
+    if (dataChanel != measurement->dataChanel() || referenceChanel != measurement->referenceChanel()) {
+        qWarning() << fileName << "has only" << channels << "channels";
+    }
+
+    qint64 block = wav.sampleRate() * Measurement::TIMER_INTERVAL / 1000;
+    std::vector<float> frames(block * channels), data(block), reference(block);
+
+    auto store = [&](float time) {
+        auto stored = measurement->store();
+        if (auto storedPtr = std::dynamic_pointer_cast<Stored>(stored)) {
+            storedPtr->setName(QFileInfo(fileName).baseName() + QString(" %1s").arg(time, 0, 'f', 1));
+            storedPtr->setNotes("Offline analysis of " + fileName + QString(" at %1 s").arg(time, 0, 'f', 2));
+        }
+        stored->moveToThread(QCoreApplication::instance()->thread());
+        result.traces << stored;
+    };
+
+    qint64 position = 0;
+    float nextLevel = m_levelInterval;
+    auto timePoint = m_timePoints.cbegin();
+    qint64 size = 0;
+    while (!m_cancel && (size = wav.readFrames(frames.data(), block, false)) > 0) {
+        for (qint64 i = 0; i < size; ++i) {
+            data[i]         = frames[i * channels + dataChanel];
+            reference[i]    = frames[i * channels + referenceChanel];
+        }
+        measurement->writeOffline(data.data(), reference.data(), size);
+        measurement->transform();
+
+        position += size;
+        float time = static_cast<float>(position) / wav.sampleRate();
+        for (; m_levelInterval > 0 && nextLevel <= time; nextLevel += m_levelInterval) {
+            result.levels.push_back({
+                time,
+                measurement->level(),
+                measurement->peak(),
+                measurement->referenceLevel()
+            });
+        }
+        for (; timePoint != m_timePoints.cend() && *timePoint <= time; ++timePoint) {
+            store(time);
+        }
+
+        emit progress(fileName, static_cast<float>(position) / wav.frames());
+    }
+    if (m_timePoints.empty() && position > 0) {
+        store(static_cast<float>(position) / wav.sampleRate());
+    }
+
+    //the level log is kept with every trace taken from the file
+    if (!result.levels.empty()) {
+        auto log = levelLog(result.levels);
+        for (auto &trace : result.traces) {
+            if (auto storedPtr = std::dynamic_pointer_cast<Stored>(trace)) {
+                storedPtr->setNotes(storedPtr->notes() + "\n\n" + log);
+            }
+        }
+    }
+
+    result.success = !m_cancel;
+    if (m_cancel) {
+        result.error = "cancelled";
+    }
+    return result;
+}
+
+QString OfflineAnalysis::levelLog(const std::vector<LevelPoint> &levels)
+{
+    if (levels.empty()) {
+        return {};
+    }
+
+    double energy = 0;
+    float maxLevel = levels.front().level, maxPeak = levels.front().peak;
+    for (auto &point : levels) {
+        energy += std::pow(10.0, point.level / 10.0);
+        maxLevel = std::max(maxLevel, point.level);
+        maxPeak = std::max(maxPeak, point.peak);
+    }
+    float leq = static_cast<float>(10.0 * std::log10(energy / levels.size()));
+
+    QString log = QString("Leq %1 dB, max %2 dB, peak %3 dB\n")
+                  .arg(leq, 0, 'f', 1)
+                  .arg(maxLevel, 0, 'f', 1)
+                  .arg(maxPeak, 0, 'f', 1);
+    log += "time, s\tlevel, dB\tpeak, dB\treference, dB";
+    for (auto &point : levels) {
+        log += QString("\n%1\t%2\t%3\t%4")
+               .arg(point.time, 0, 'f', 1)
+               .arg(point.level, 0, 'f', 1)
+               .arg(point.peak, 0, 'f', 1)
+               .arg(point.referenceLevel, 0, 'f', 1);
+    }
+    return log;
+}
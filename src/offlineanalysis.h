@@ -0,0 +1,87 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OFFLINEANALYSIS_H
+#define OFFLINEANALYSIS_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+
+#include "source/source_shared.h"
+
+/**
+ * @brief The OfflineAnalysis class
+ * pushes recorded files through the Measurement pipeline as fast as possible.
+ * Samples are processed in the same windows as a live measurement collects (Measurement::TIMER_INTERVAL),
+ * so averaging and LPF time constants give the same result as a live measurement.
+ */
+class OfflineAnalysis : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct LevelPoint {
+        float time;
+        float level;
+        float peak;
+        float referenceLevel;
+    };
+
+    struct Result {
+        QString fileName;
+        bool success = false;
+        QString error;
+        QList<Source::Shared> traces;
+        std::vector<LevelPoint> levels;
+    };
+
+    explicit OfflineAnalysis(QObject *parent = nullptr);
+
+    //! Measurement::toJSON of the measurement which settings are used
+    void setSettings(const QJsonObject &settings);
+
+    //! seconds from the beginning of the file, the last state is stored if empty
+    void setTimePoints(const std::vector<float> &timePoints);
+
+    //! interval of the level log in seconds, 0 disables the log
+    void setLevelInterval(float levelInterval);
+
+    void setThreads(unsigned int threads);
+
+    std::vector<Result> analyse(const QStringList &fileNames);
+    Result analyseFile(const QString &fileName);
+
+    void cancel();
+
+    //! summary and tab separated table of the level log
+    static QString levelLog(const std::vector<LevelPoint> &levels);
+
+signals:
+    void progress(QString fileName, float value);
+
+private:
+    QJsonObject m_settings;
+    std::vector<float> m_timePoints;
+    float m_levelInterval;
+    unsigned int m_threads;
+    std::atomic<bool> m_cancel;
+};
+
+#endif // OFFLINEANALYSIS_H
@@ -0,0 +1,473 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "recorder.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "common/notifier.h"
+#include "common/settings.h"
+#include "common/wavwriter.h"
+#include "measurement.h"
+#include "sourcelist.h"
+
+namespace {
+constexpr size_t SCRATCH_FRAMES = 4096;
+}
+
+Recorder::Recorder(SourceList *sourceList, Settings *settings, QObject *parent) : QObject(parent),
+    m_sourceList(sourceList),
+    m_settings(settings),
+    m_source(),
+    m_measurement(),
+    m_writer(nullptr),
+    m_ring(),
+    m_channels({0, 1}),
+    m_frames(),
+    m_sampleRate(0),
+    m_folder(QUrl::fromLocalFile(QStandardPaths::writableLocation(QStandardPaths::MusicLocation))),
+    m_preTrigger(5.f),
+    m_rotation(0),
+    m_currentFile(),
+    m_currentFileMutex(),
+    m_active(false), m_recording(false), m_writerRunning(false),
+    m_overruns(0)
+{
+    if (m_settings) {
+        setSource(m_settings->reactValue<Recorder, QUuid>(
+                      "source", this, &Recorder::sourceChanged, m_source).toUuid());
+        setFolder(m_settings->reactValue<Recorder, QUrl>(
+                      "folder", this, &Recorder::folderChanged, m_folder).toUrl());
+        setPreTrigger(m_settings->reactValue<Recorder, float>(
+                          "preTrigger", this, &Recorder::preTriggerChanged, m_preTrigger.load()).toFloat());
+        setRotation(m_settings->reactValue<Recorder, unsigned int>(
+                        "rotation", this, &Recorder::rotationChanged, m_rotation.load()).toUInt());
+        setChannels(m_settings->value("channels", channels()).toList());
+        connect(this, &Recorder::channelsChanged, this, [this]() {
+            m_settings->setValue("channels", channels());
+        });
+    }
+
+    if (m_sourceList) {
+        connect(m_sourceList, &SourceList::preItemRemoved, this, [this](QUuid uuid) {
+            if (m_measurement && m_measurement->uuid() == uuid) {
+                setActive(false);
+            }
+        });
+    }
+}
+
+Recorder::~Recorder()
+{
+    m_recording = false;
+    detach();
+}
+
+bool Recorder::active() const noexcept
+{
+    return m_active;
+}
+
+void Recorder::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+    if (active) {
+        attach();
+    } else {
+        m_recording = false;
+        detach();
+        emit recordingChanged(false);
+    }
+    emit activeChanged(m_active);
+}
+
+bool Recorder::recording() const noexcept
+{
+    return m_recording;
+}
+
+void Recorder::setRecording(bool recording)
+{
+    if (m_recording == recording) {
+        return;
+    }
+    if (recording && !m_active) {
+        setActive(true);
+        if (!m_active) {
+            return;
+        }
+    }
+    m_recording = recording;
+    emit recordingChanged(m_recording);
+}
+
+void Recorder::start()
+{
+    setRecording(true);
+}
+
+void Recorder::stop()
+{
+    setRecording(false);
+}
+
+QUuid Recorder::source() const
+{
+    return m_source;
+}
+
+void Recorder::setSource(const QUuid &source)
+{
+    if (m_source == source) {
+        return;
+    }
+    m_source = source;
+    if (m_active) {
+        m_recording = false;
+        detach();
+        attach();
+        emit recordingChanged(false);
+        emit activeChanged(m_active);
+    }
+    emit sourceChanged(m_source);
+}
+
+QVariantList Recorder::channels() const
+{
+    QVariantList list;
+    for (auto channel : m_channels) {
+        list << channel;
+    }
+    return list;
+}
+
+void Recorder::setChannels(const QVariantList &channels)
+{
+    if (m_active) {
+        qWarning() << "Recorder: channels can't be changed while the recorder is active";
+        return;
+    }
+
+    std::vector<unsigned int> list;
+    for (auto &channel : channels) {
+        if (list.size() == MAX_CHANNELS) {
+            break;
+        }
+        list.push_back(channel.toUInt());
+    }
+    if (list.empty() || list == m_channels) {
+        return;
+    }
+    m_channels = list;
+    emit channelsChanged();
+}
+
+QUrl Recorder::folder() const
+{
+    std::lock_guard<std::mutex> guard(m_currentFileMutex);
+    return m_folder;
+}
+
+void Recorder::setFolder(const QUrl &folder)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_currentFileMutex);
+        if (m_folder == folder) {
+            return;
+        }
+        m_folder = folder;
+    }
+    emit folderChanged(folder);
+}
+
+float Recorder::preTrigger() const noexcept
+{
+    return m_preTrigger;
+}
+
+void Recorder::setPreTrigger(float preTrigger)
+{
+    preTrigger = std::max(0.f, preTrigger);
+    if (qFuzzyCompare(m_preTrigger.load(), preTrigger)) {
+        return;
+    }
+    m_preTrigger = preTrigger;
+    if (m_active && !m_recording) {
+        detach();
+        attach();
+        emit activeChanged(m_active);
+    }
+    emit preTriggerChanged(preTrigger);
+}
+
+unsigned int Recorder::rotation() const noexcept
+{
+    return m_rotation;
+}
+
+void Recorder::setRotation(unsigned int rotation)
+{
+    if (m_rotation == rotation) {
+        return;
+    }
+    m_rotation = rotation;
+    emit rotationChanged(rotation);
+}
+
+QString Recorder::currentFile() const
+{
+    std::lock_guard<std::mutex> guard(m_currentFileMutex);
+    return m_currentFile;
+}
+
+unsigned int Recorder::overruns() const noexcept
+{
+    return m_overruns;
+}
+
+std::shared_ptr<Measurement> Recorder::findMeasurement() const
+{
+    if (!m_sourceList) {
+        return {};
+    }
+    if (!m_source.isNull()) {
+        return std::dynamic_pointer_cast<Measurement>(m_sourceList->getByUUid(m_source));
+    }
+    for (auto &item : m_sourceList->items()) {
+        auto measurement = std::dynamic_pointer_cast<Measurement>(item);
+        if (measurement && !measurement->offline() && measurement->objectName() == "Measurement") {
+            return measurement;
+        }
+    }
+    return {};
+}
+
+void Recorder::attach()
+{
+    auto measurement = findMeasurement();
+    if (!measurement) {
+        emit Notifier::getInstance()->newMessage("Recorder", "Measurement is not available.");
+        return;
+    }
+    m_sampleRate = measurement->sampleRate();
+    if (!m_sampleRate) {
+        emit Notifier::getInstance()->newMessage("Recorder", "Measurement input is not started.");
+        return;
+    }
+
+    //everything used by the audio callback is allocated here
+    auto ringSeconds = m_preTrigger.load() + RING_RESERVE;
+    m_ring.resize(static_cast<size_t>(ringSeconds * m_sampleRate) * m_channels.size());
+    m_frames.resize(SCRATCH_FRAMES * m_channels.size());
+    m_overruns = 0;
+    emit overrunsChanged();
+
+    //the measurement reopens its stream on a new format, the ring is rebuilt for the new rate
+    connect(measurement.get(), &Measurement::audioFormatChanged, this, [this]() {
+        m_recording = false;
+        detach();
+        attach();
+        emit recordingChanged(false);
+        emit activeChanged(m_active);
+    }, Qt::QueuedConnection);
+
+    m_writerRunning = true;
+    m_writer = QThread::create([this]() {
+        writerLoop();
+    });
+    m_writer->setObjectName("RecorderWriter");
+    m_writer->start(QThread::HighPriority);
+
+    m_measurement = measurement;
+    m_measurement->setRecorder(this);
+    m_active = true;
+}
+
+void Recorder::detach()
+{
+    //the measurement stops calling writeFrames before setRecorder returns
+    if (m_measurement) {
+        m_measurement->setRecorder(nullptr);
+        m_measurement->disconnect(this);
+        m_measurement.reset();
+    }
+
+    if (m_writer) {
+        m_writerRunning = false;
+        m_writer->wait();
+        delete m_writer;
+        m_writer = nullptr;
+    }
+    m_active = false;
+}
+
+void Recorder::writeFrames(const float *input, size_t count, unsigned int inputChannels)
+{
+    //audio thread: deinterleave selected channels into the preallocated scratch and push to the ring
+    if (!inputChannels || m_frames.empty()) {
+        return;
+    }
+    auto channels = m_channels.size();
+
+    for (size_t done = 0; done < count; ) {
+        auto part = std::min(SCRATCH_FRAMES, count - done);
+        auto out = m_frames.data();
+        for (size_t i = 0; i < part; ++i, input += inputChannels) {
+            for (auto channel : m_channels) {
+                *out++ = channel < inputChannels ? input[channel] : 0.f;
+            }
+        }
+        m_ring.write(m_frames.data(), part * channels);
+        done += part;
+    }
+}
+
+void Recorder::notify(const QString &text)
+{
+    QMetaObject::invokeMethod(this, [text]() {
+        emit Notifier::getInstance()->newMessage("Recorder", text);
+    }, Qt::QueuedConnection);
+}
+
+void Recorder::stopFromWriter()
+{
+    m_recording = false;
+    QMetaObject::invokeMethod(this, [this]() {
+        emit recordingChanged(m_recording);
+    }, Qt::QueuedConnection);
+}
+
+void Recorder::writerLoop()
+{
+    const auto channels = m_channels.size();
+    std::vector<float> buffer(WRITE_FRAMES * channels);
+    WavWriter writer;
+    uint64_t position = 0;
+    qint64 fileFrames = 0;
+
+    auto setCurrentFile = [this](const QString &fileName) {
+        {
+            std::lock_guard<std::mutex> guard(m_currentFileMutex);
+            m_currentFile = fileName;
+        }
+        QMetaObject::invokeMethod(this, &Recorder::currentFileChanged, Qt::QueuedConnection);
+    };
+    auto openFile = [&]() {
+        auto fileName = nextFileName();
+        if (!writer.open(fileName, m_sampleRate, static_cast<unsigned int>(channels))) {
+            notify("Can't write to " + fileName);
+            stopFromWriter();
+            return false;
+        }
+        fileFrames = 0;
+        setCurrentFile(fileName);
+        return true;
+    };
+    auto overrun = [&]() {
+        auto written = m_ring.written();
+        auto back = static_cast<uint64_t>(m_ring.size() / 2 / channels * channels);
+        position = written > back ? written - back : 0;
+        ++m_overruns;
+        qWarning() << "Recorder: writer overrun, some data was lost";
+        QMetaObject::invokeMethod(this, &Recorder::overrunsChanged, Qt::QueuedConnection);
+    };
+    //writes everything that is available till the limit, returns false on error
+    auto flush = [&](uint64_t limit) {
+        const qint64 rotationFrames = static_cast<qint64>(m_rotation) * 60 * m_sampleRate;
+        while (position < limit) {
+            if (limit - position > m_ring.size()) {
+                overrun();
+                continue;
+            }
+            qint64 frames = static_cast<qint64>((limit - position) / channels);
+            frames = std::min(frames, static_cast<qint64>(WRITE_FRAMES));
+            if (rotationFrames) {
+                frames = std::min(frames, rotationFrames - fileFrames);
+            }
+            if (frames <= 0) {
+                break;
+            }
+            if (!m_ring.read(position, buffer.data(), frames * channels)) {
+                overrun();
+                continue;
+            }
+            if (!writer.write(buffer.data(), frames)) {
+                notify("Can't write to " + writer.fileName());
+                return false;
+            }
+            position += frames * channels;
+            fileFrames += frames;
+            if (rotationFrames && fileFrames >= rotationFrames) {
+                writer.close();
+                if (!openFile()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    while (m_writerRunning) {
+        QThread::msleep(WRITER_INTERVAL);
+
+        if (m_recording && !writer.isOpen()) {
+            auto written = m_ring.written();
+            auto preTrigger = static_cast<uint64_t>(m_preTrigger.load() * m_sampleRate) * channels;
+            position = written > preTrigger ? written - preTrigger : 0;
+            if (!openFile()) {
+                continue;
+            }
+        }
+        if (!writer.isOpen()) {
+            continue;
+        }
+
+        auto limit = m_ring.written();
+        if (!flush(limit) || !m_recording) {
+            writer.close();
+            setCurrentFile({});
+            if (m_recording) {
+                stopFromWriter();
+            }
+        }
+    }
+
+    if (writer.isOpen()) {
+        flush(m_ring.written());
+        writer.close();
+        setCurrentFile({});
+    }
+}
+
+QString Recorder::nextFileName() const
+{
+    auto folder = this->folder();
+    QDir dir(folder.isLocalFile() ? folder.toLocalFile() : folder.toString());
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+    auto base = "osm_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    auto fileName = dir.filePath(base + ".wav");
+    for (int i = 1; QFileInfo::exists(fileName); ++i) {
+        fileName = dir.filePath(base + "_" + QString::number(i) + ".wav");
+    }
+    return fileName;
+}
@@ -0,0 +1,142 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <QObject>
+#include <QThread>
+#include <QUrl>
+#include <QUuid>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "container/ringbuffer.h"
+
+class Settings;
+class SourceList;
+class Measurement;
+
+/**
+ * @brief The Recorder class
+ * records selected input channels of a measurement to WAV/RF64 files.
+ * The recorder doesn't open own input: Measurement::writeData hands over the interleaved frames of its stream,
+ * they are only copied into a lock-free ring there. Files are written by the own writer thread.
+ * While the recorder is active the ring keeps the last preTrigger seconds,
+ * so a recording starts that much before it was requested.
+ */
+class Recorder : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(bool recording READ recording WRITE setRecording NOTIFY recordingChanged)
+    Q_PROPERTY(QUuid source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QVariantList channels READ channels WRITE setChannels NOTIFY channelsChanged)
+    Q_PROPERTY(QUrl folder READ folder WRITE setFolder NOTIFY folderChanged)
+    Q_PROPERTY(float preTrigger READ preTrigger WRITE setPreTrigger NOTIFY preTriggerChanged)
+    Q_PROPERTY(unsigned int rotation READ rotation WRITE setRotation NOTIFY rotationChanged)
+    Q_PROPERTY(QString currentFile READ currentFile NOTIFY currentFileChanged)
+    Q_PROPERTY(unsigned int overruns READ overruns NOTIFY overrunsChanged)
+
+public:
+    static constexpr unsigned int MAX_CHANNELS      = 64;
+    static constexpr unsigned int WRITER_INTERVAL   = 20;       //ms
+    static constexpr size_t WRITE_FRAMES            = 16384;    //frames per file write
+    static constexpr float RING_RESERVE             = 10.f;     //seconds over the pre-trigger
+
+    explicit Recorder(SourceList *sourceList, Settings *settings = nullptr, QObject *parent = nullptr);
+    ~Recorder() override;
+
+    bool active() const noexcept;
+    void setActive(bool active);
+
+    bool recording() const noexcept;
+    void setRecording(bool recording);
+    Q_INVOKABLE void start();
+    Q_INVOKABLE void stop();
+
+    //! uuid of the measurement which input is recorded, the first measurement is used if it is null
+    QUuid source() const;
+    void setSource(const QUuid &source);
+
+    //! chanels of the measurement input stream
+    QVariantList channels() const;
+    void setChannels(const QVariantList &channels);
+
+    QUrl folder() const;
+    void setFolder(const QUrl &folder);
+
+    float preTrigger() const noexcept;
+    void setPreTrigger(float preTrigger);
+
+    //! minutes per file, 0 - don't rotate
+    unsigned int rotation() const noexcept;
+    void setRotation(unsigned int rotation);
+
+    QString currentFile() const;
+    unsigned int overruns() const noexcept;
+
+    //! audio thread, called by Measurement::writeData with its data mutex locked
+    void writeFrames(const float *input, size_t count, unsigned int inputChannels);
+
+signals:
+    void activeChanged(bool);
+    void recordingChanged(bool);
+    void sourceChanged(QUuid);
+    void channelsChanged();
+    void folderChanged(QUrl);
+    void preTriggerChanged(float);
+    void rotationChanged(unsigned int);
+    void currentFileChanged();
+    void overrunsChanged();
+
+private:
+    void writerLoop();
+    QString nextFileName() const;
+    std::shared_ptr<Measurement> findMeasurement() const;
+    void attach();
+    void detach();
+
+    //writer thread: signals and messages are delivered in the recorder thread
+    void notify(const QString &text);
+    void stopFromWriter();
+
+    SourceList *m_sourceList;
+    Settings *m_settings;
+    QUuid m_source;
+    std::shared_ptr<Measurement> m_measurement;
+    QThread *m_writer;
+
+    container::ringbuffer<float> m_ring;
+    std::vector<unsigned int> m_channels;
+    std::vector<float> m_frames;
+    unsigned int m_sampleRate;
+
+    QUrl m_folder;
+    //set on the GUI thread, read by the writer
+    std::atomic<float> m_preTrigger;
+    std::atomic<unsigned int> m_rotation;
+    QString m_currentFile;
+    mutable std::mutex m_currentFileMutex;
+
+    std::atomic<bool> m_active, m_recording, m_writerRunning;
+    std::atomic<unsigned int> m_overruns;
+};
+
+#endif // RECORDER_H
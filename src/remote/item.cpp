@@ -165,16 +165,18 @@ void Item::applyData(const QJsonArray &data, const QJsonArray &timeData)
             m_ftdata.resize(m_dataLength);
         }
 
+        std::vector<float> frequencies(m_dataLength, 0.f);
         for (int i = 0; i < data.count(); i++) {
             auto row = data[i].toArray();
-            if (row.count() > 0) m_ftdata[i].frequency    = static_cast<float>(row[0].toDouble());
-            if (row.count() > 1) m_ftdata[i].module       = static_cast<float>(row[1].toDouble());
-            if (row.count() > 2) m_ftdata[i].magnitude    = static_cast<float>(row[2].toDouble());
-            if (row.count() > 3) m_ftdata[i].phase.polar(   static_cast<float>(row[3].toDouble()));
-            if (row.count() > 4) m_ftdata[i].coherence    = static_cast<float>(row[4].toDouble());
-            if (row.count() > 5) m_ftdata[i].peakSquared  = static_cast<float>(row[5].toDouble());
-            if (row.count() > 6) m_ftdata[i].meanSquared  = static_cast<float>(row[6].toDouble());
+            if (row.count() > 0) frequencies[i]           = static_cast<float>(row[0].toDouble());
+            if (row.count() > 1) m_ftdata.module[i]       = static_cast<float>(row[1].toDouble());
+            if (row.count() > 2) m_ftdata.magnitude[i]    = static_cast<float>(row[2].toDouble());
+            if (row.count() > 3) m_ftdata.phase[i].polar(   static_cast<float>(row[3].toDouble()));
+            if (row.count() > 4) m_ftdata.coherence[i]    = static_cast<float>(row[4].toDouble());
+            if (row.count() > 5) m_ftdata.peakSquared[i]  = static_cast<float>(row[5].toDouble());
+            if (row.count() > 6) m_ftdata.meanSquared[i]  = static_cast<float>(row[6].toDouble());
         }
+        m_ftdata.axis = Source::Axis::fromValues(std::move(frequencies));
 
         if (m_deconvolutionSize != static_cast<unsigned int>(timeData.count())) {
             m_deconvolutionSize = static_cast<unsigned int>(timeData.count());
@@ -183,10 +185,11 @@ void Item::applyData(const QJsonArray &data, const QJsonArray &timeData)
 
         for (int i = 0; i < timeData.count(); i++) {
             auto row = timeData[i].toArray();
-            if (row.count() > 0) m_impulseData[i].time   = static_cast<float>(row[0].toDouble());
-            if (row.count() > 1) m_impulseData[i].value  = static_cast<float>(row[1].toDouble());
+            if (row.count() > 0) m_impulseData.time[i]   = static_cast<float>(row[0].toDouble());
+            if (row.count() > 1) m_impulseData.value[i]  = static_cast<float>(row[1].toDouble());
 
         }
+        publish();
     }
     emit readyRead();
     setState(UPDATED);
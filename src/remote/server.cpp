@@ -382,6 +382,8 @@ QByteArray Server::tcpCallback([[maybe_unused]] const QHostAddress &&address, co
 
         QJsonArray ftdata;
         QJsonArray ftcell = {0, 0, 0, 0, 0};
+        source->pageIn();
+        source->lock();
         for (unsigned int i = 0; i < source->size(); ++i) {
             ftcell[0] = static_cast<double>(source->frequency(i)  );
             ftcell[1] = static_cast<double>(source->module(i)     );
@@ -411,6 +413,7 @@ QByteArray Server::tcpCallback([[maybe_unused]] const QHostAddress &&address, co
                 timeData[i] = std::move(timeCell);
             }
         }
+        source->unlock();
         object["timeData"] = std::move(timeData);
 
         QJsonDocument document(std::move(object));
@@ -0,0 +1,140 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "axis.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include "math/fouriertransform.h"
+
+namespace Source {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::map<Axis::Key, std::weak_ptr<const Axis>> keys;
+    std::unordered_multimap<quint64, std::weak_ptr<const Axis>> values;
+    quint64 next = 0;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+//FNV-1a of the values
+quint64 hashOf(const std::vector<float> &values)
+{
+    quint64 hash = 14695981039346656037ull;
+    for (auto value : values) {
+        quint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool Axis::Key::operator<(const Key &other) const noexcept
+{
+    return std::tie(type, size, sampleRate, ppo) < std::tie(other.type, other.size, other.sampleRate, other.ppo);
+}
+
+Axis::Axis(const Key &key, std::vector<float> &&values, quint64 id) :
+    m_key(key), m_values(std::move(values)), m_id(id)
+{
+}
+
+AxisShared Axis::get(const Key &key, const std::function<std::vector<float>()> &build)
+{
+    auto &list = registry();
+    {
+        std::lock_guard<std::mutex> guard(list.mutex);
+        auto it = list.keys.find(key);
+        if (it != list.keys.end()) {
+            if (auto axis = it->second.lock()) {
+                return axis;
+            }
+        }
+    }
+    return intern(key, build ? build() : std::vector<float>{});
+}
+
+AxisShared Axis::fromValues(std::vector<float> values)
+{
+    return intern({Custom, static_cast<unsigned int>(values.size()), 0, 0}, std::move(values));
+}
+
+AxisShared Axis::fromTransform(FourierTransform &transform)
+{
+    Key key {Custom, 0, transform.sampleRate(), 0};
+    switch (transform.type()) {
+    case FourierTransform::Fast:
+        key.type = Fast;
+        key.size = transform.size();
+        break;
+    case FourierTransform::Log:
+        key.type = Log;
+        key.ppo = FourierTransform::LOG_PPO;
+        break;
+    }
+    return get(key, [&transform]() {
+        return transform.getFrequencies();
+    });
+}
+
+AxisShared Axis::intern(const Key &key, std::vector<float> &&values)
+{
+    auto &list = registry();
+    auto hash = hashOf(values);
+
+    std::lock_guard<std::mutex> guard(list.mutex);
+    //grids built by another key or loaded from a file are the same grid when values match
+    AxisShared axis;
+    auto range = list.values.equal_range(hash);
+    for (auto it = range.first; it != range.second && !axis; ++it) {
+        auto candidate = it->second.lock();
+        if (candidate && candidate->m_values == values) {
+            axis = std::move(candidate);
+        }
+    }
+
+    if (!axis) {
+        axis = AxisShared(new Axis(key, std::move(values), ++list.next));
+        list.values.emplace(hash, axis);
+
+        //forget released grids
+        for (auto it = list.values.begin(); it != list.values.end(); ) {
+            it = it->second.expired() ? list.values.erase(it) : std::next(it);
+        }
+        for (auto it = list.keys.begin(); it != list.keys.end(); ) {
+            it = it->second.expired() ? list.keys.erase(it) : std::next(it);
+        }
+    }
+    if (key.type != Custom) {
+        list.keys[key] = axis;
+    }
+    return axis;
+}
+
+} // namespace Source
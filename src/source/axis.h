@@ -0,0 +1,92 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOURCE_AXIS_H
+#define SOURCE_AXIS_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <QtGlobal>
+
+class FourierTransform;
+
+namespace Source {
+
+class Axis;
+using AxisShared = std::shared_ptr<const Axis>;
+
+/**
+ * @brief The Axis class
+ * immutable frequency grid shared by all sources with the same bins. Axes are interned: a grid
+ * with the same values is created once and lives while any source or frame refers to it, so
+ * readers can compare grids by id() and cache tables per grid.
+ */
+class Axis
+{
+public:
+    enum Type {Custom, Fast, Log};
+
+    struct Key {
+        Type type = Custom;
+        unsigned int size = 0;
+        unsigned int sampleRate = 0;
+        unsigned int ppo = 0;
+
+        bool operator<(const Key &other) const noexcept;
+    };
+
+    //! interned axis of key, values are built only if the key is not known yet
+    static AxisShared get(const Key &key, const std::function<std::vector<float>()> &build);
+    //! interned axis of values, used for loaded and imported data
+    static AxisShared fromValues(std::vector<float> values);
+    //! axis of the prepared transform
+    static AxisShared fromTransform(FourierTransform &transform);
+
+    quint64 id() const noexcept
+    {
+        return m_id;
+    }
+    const Key &key() const noexcept
+    {
+        return m_key;
+    }
+    std::size_t size() const noexcept
+    {
+        return m_values.size();
+    }
+    const float *data() const noexcept
+    {
+        return m_values.data();
+    }
+    const float &operator [](std::size_t i) const noexcept
+    {
+        return m_values[i];
+    }
+
+private:
+    Axis(const Key &key, std::vector<float> &&values, quint64 id);
+    static AxisShared intern(const Key &key, std::vector<float> &&values);
+
+    const Key m_key;
+    const std::vector<float> m_values;
+    const quint64 m_id;
+};
+
+}
+
+#endif // SOURCE_AXIS_H
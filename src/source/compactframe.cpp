@@ -0,0 +1,251 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "compactframe.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <QtMath>
+#if defined(Q_PROCESSOR_X86_64)
+#include <emmintrin.h>
+#elif defined(Q_PROCESSOR_ARM)
+#include <arm_neon.h>
+#endif
+
+namespace Source {
+
+namespace {
+constexpr float ANGLE_SCALE = 32768.f / static_cast<float>(M_PI);
+constexpr float UNIT_SCALE  = 65535.f;
+constexpr quint32 EXPONENT  = 0x7F800000;
+}
+
+CompactFrame::CompactFrame() : m_axis(), m_size(0), m_impulseSize(0),
+    m_module(), m_magnitude(), m_peakSquared(), m_meanSquared(), m_coherence(), m_phase(),
+    m_impulse(), m_time(), m_timeStart(0), m_timeStep(0)
+{
+}
+
+void CompactFrame::encode(const Abstract::Frame &frame)
+{
+    auto &ftdata = frame.ftdata;
+    auto &impulseData = frame.impulseData;
+    m_axis = ftdata.axis;
+    m_size = frame.size;
+    m_impulseSize = frame.impulseSize;
+
+    auto levels = [this](std::vector<quint16> &dst, const std::vector<float> &src) {
+        dst.resize(m_size);
+        std::transform(src.cbegin(), src.cbegin() + m_size, dst.begin(), encodeLevel);
+    };
+    levels(m_module,      ftdata.module);
+    levels(m_magnitude,   ftdata.magnitude);
+    levels(m_peakSquared, ftdata.peakSquared);
+    levels(m_meanSquared, ftdata.meanSquared);
+
+    m_coherence.resize(m_size);
+    std::transform(ftdata.coherence.cbegin(), ftdata.coherence.cbegin() + m_size, m_coherence.begin(), encodeUnit);
+    m_phase.resize(m_size);
+    for (unsigned int i = 0; i < m_size; ++i) {
+        m_phase[i] = encodeAngle(ftdata.phase[i].arg());
+    }
+
+    m_impulse.resize(m_impulseSize);
+    for (unsigned int i = 0; i < m_impulseSize; ++i) {
+        m_impulse[i] = impulseData.value[i].real;
+    }
+
+    //time of a deconvolution is uniform, other sources keep it as is
+    m_time.clear();
+    m_timeStart = m_impulseSize ? impulseData.time[0] : 0.f;
+    m_timeStep = m_impulseSize > 1 ? (impulseData.time[m_impulseSize - 1] - m_timeStart) / (m_impulseSize - 1) : 0.f;
+    auto tolerance = std::abs(m_timeStep) * 1e-3f;
+    for (unsigned int i = 0; i < m_impulseSize; ++i) {
+        if (std::abs(impulseData.time[i] - (m_timeStart + i * m_timeStep)) > tolerance) {
+            m_time.assign(impulseData.time.cbegin(), impulseData.time.cbegin() + m_impulseSize);
+            break;
+        }
+    }
+}
+
+void CompactFrame::decode(Abstract::Frame &frame) const
+{
+    frame.size = m_size;
+    frame.impulseSize = m_impulseSize;
+    decode(frame.ftdata, frame.impulseData);
+}
+
+void CompactFrame::decode(Abstract::Spectrum &ftdata, Abstract::Impulse &impulseData) const
+{
+    ftdata.resize(m_size);
+    ftdata.axis = m_axis;
+    impulseData.resize(m_impulseSize);
+
+    decodeLevels(m_module.data(),      ftdata.module.data(),      m_size);
+    decodeLevels(m_magnitude.data(),   ftdata.magnitude.data(),   m_size);
+    decodeLevels(m_peakSquared.data(), ftdata.peakSquared.data(), m_size);
+    decodeLevels(m_meanSquared.data(), ftdata.meanSquared.data(), m_size);
+    decodeUnits(m_coherence.data(),    ftdata.coherence.data(),   m_size);
+
+    //angles are decoded by blocks on the stack, then turned into unit vectors
+    constexpr unsigned int ANGLE_BLOCK = 256;
+    float angles[ANGLE_BLOCK];
+    for (unsigned int from = 0; from < m_size; from += ANGLE_BLOCK) {
+        auto count = std::min(ANGLE_BLOCK, m_size - from);
+        decodeAngles(m_phase.data() + from, angles, count);
+        for (unsigned int i = 0; i < count; ++i) {
+            ftdata.phase[from + i].polar(angles[i]);
+        }
+    }
+
+    for (unsigned int i = 0; i < m_impulseSize; ++i) {
+        impulseData.value[i] = m_impulse[i];
+    }
+    if (m_time.empty()) {
+        for (unsigned int i = 0; i < m_impulseSize; ++i) {
+            impulseData.time[i] = m_timeStart + i * m_timeStep;
+        }
+    } else {
+        std::copy(m_time.cbegin(), m_time.cend(), impulseData.time.begin());
+    }
+}
+
+unsigned int CompactFrame::size() const noexcept
+{
+    return m_size;
+}
+
+unsigned int CompactFrame::impulseSize() const noexcept
+{
+    return m_impulseSize;
+}
+
+std::size_t CompactFrame::bytes() const noexcept
+{
+    return m_size * (5 * sizeof(quint16) + sizeof(qint16)) + (m_impulse.size() + m_time.size()) * sizeof(float);
+}
+
+quint16 CompactFrame::encodeLevel(float value) noexcept
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (bits >> 31) {
+        //levels aren't negative, -0 too
+        return 0;
+    }
+    if ((bits & EXPONENT) != EXPONENT) {
+        //rounded to the nearest, but never up to infinity
+        auto rounded = bits + (1u << 14);
+        if ((rounded & EXPONENT) != EXPONENT) {
+            bits = rounded;
+        }
+    }
+    return static_cast<quint16>(bits >> 15);
+}
+
+qint16 CompactFrame::encodeAngle(float angle) noexcept
+{
+    auto code = std::lround(angle * ANGLE_SCALE);
+    //pi and -pi are the same angle
+    if (code >= 32768) {
+        code -= 65536;
+    }
+    return static_cast<qint16>(std::max(code, -32768L));
+}
+
+quint16 CompactFrame::encodeUnit(float value) noexcept
+{
+    if (!(value > 0.f)) {
+        return 0;
+    }
+    return static_cast<quint16>(std::lround(std::min(value, 1.f) * UNIT_SCALE));
+}
+
+void CompactFrame::decodeLevels(const quint16 *src, float *dst, std::size_t count) noexcept
+{
+    std::size_t i = 0;
+#if defined(Q_PROCESSOR_X86_64)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_ps(dst + i,     _mm_castsi128_ps(_mm_slli_epi32(_mm_unpacklo_epi16(codes, zero), 15)));
+        _mm_storeu_ps(dst + i + 4, _mm_castsi128_ps(_mm_slli_epi32(_mm_unpackhi_epi16(codes, zero), 15)));
+    }
+#elif defined(Q_PROCESSOR_ARM)
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t codes = vld1q_u16(src + i);
+        vst1q_f32(dst + i,     vreinterpretq_f32_u32(vshll_n_u16(vget_low_u16(codes), 15)));
+        vst1q_f32(dst + i + 4, vreinterpretq_f32_u32(vshll_n_u16(vget_high_u16(codes), 15)));
+    }
+#endif
+    for (; i < count; ++i) {
+        quint32 bits = static_cast<quint32>(src[i]) << 15;
+        std::memcpy(dst + i, &bits, sizeof(bits));
+    }
+}
+
+void CompactFrame::decodeAngles(const qint16 *src, float *dst, std::size_t count) noexcept
+{
+    const float scale = 1.f / ANGLE_SCALE;
+    std::size_t i = 0;
+#if defined(Q_PROCESSOR_X86_64)
+    const __m128 k = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        //sign extension: the code goes to the upper half and is shifted back
+        __m128i low  = _mm_srai_epi32(_mm_unpacklo_epi16(codes, codes), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(codes, codes), 16);
+        _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(low),  k));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), k));
+    }
+#elif defined(Q_PROCESSOR_ARM)
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t codes = vld1q_s16(src + i);
+        vst1q_f32(dst + i,     vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(codes))),  scale));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(codes))), scale));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+void CompactFrame::decodeUnits(const quint16 *src, float *dst, std::size_t count) noexcept
+{
+    const float scale = 1.f / UNIT_SCALE;
+    std::size_t i = 0;
+#if defined(Q_PROCESSOR_X86_64)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 k = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(codes, zero)), k));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(codes, zero)), k));
+    }
+#elif defined(Q_PROCESSOR_ARM)
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t codes = vld1q_u16(src + i);
+        vst1q_f32(dst + i,     vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(codes))),  scale));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(codes))), scale));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+} // namespace Source
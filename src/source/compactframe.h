@@ -0,0 +1,72 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOURCE_COMPACTFRAME_H
+#define SOURCE_COMPACTFRAME_H
+
+#include <vector>
+#include <QtGlobal>
+#include "source_abstract.h"
+
+namespace Source {
+
+/**
+ * @brief The CompactFrame class
+ * quantised copy of a frame for data that is kept in memory but rarely read:
+ *   levels (module, magnitude, peak and mean squared)  upper 16 bits of the positive float:
+ *                                                      8 bits of exponent and 8 of mantissa, error < 0.2 %
+ *   phase                                              angle in 16 bits, step 0.0055°
+ *   coherence                                          16 bits over [0, 1]
+ *   impulse                                            real part only, time is start + i * step when uniform
+ *   frequency                                          the shared axis
+ * A bin takes 12 bytes instead of 28, an impulse sample 4 instead of 12.
+ * Decoders write into caller buffers and use SSE2 or NEON where available.
+ */
+class CompactFrame
+{
+public:
+    CompactFrame();
+
+    void encode(const Abstract::Frame &frame);
+    void decode(Abstract::Frame &frame) const;
+    //! decodes into the caller columns, their capacity is reused
+    void decode(Abstract::Spectrum &ftdata, Abstract::Impulse &impulseData) const;
+    unsigned int size() const noexcept;
+    unsigned int impulseSize() const noexcept;
+    std::size_t bytes() const noexcept;
+
+    static quint16 encodeLevel(float value) noexcept;
+    static qint16 encodeAngle(float angle) noexcept;
+    static quint16 encodeUnit(float value) noexcept;
+
+    static void decodeLevels(const quint16 *src, float *dst, std::size_t count) noexcept;
+    static void decodeAngles(const qint16 *src, float *dst, std::size_t count) noexcept;
+    static void decodeUnits(const quint16 *src, float *dst, std::size_t count) noexcept;
+
+private:
+    AxisShared m_axis;
+    unsigned int m_size, m_impulseSize;
+    std::vector<quint16> m_module, m_magnitude, m_peakSquared, m_meanSquared, m_coherence;
+    std::vector<qint16> m_phase;
+    std::vector<float> m_impulse;
+    std::vector<float> m_time;          //empty if the time is uniform
+    float m_timeStart, m_timeStep;
+};
+
+} // namespace Source
+
+#endif // SOURCE_COMPACTFRAME_H
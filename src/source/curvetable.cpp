@@ -0,0 +1,233 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "curvetable.h"
+#include <algorithm>
+#include <cmath>
+#include "source_abstract.h"
+
+namespace Source {
+
+CurveTable::CurveTable() : m_mutex(), m_log(), m_value(), m_slope(), m_revision(0), m_cache()
+{
+}
+
+void CurveTable::setPoints(std::vector<QPointF> points)
+{
+    points.erase(std::remove_if(points.begin(), points.end(), [](const auto & point) {
+        return !(point.x() > 0) || !std::isfinite(point.y());
+    }), points.end());
+    std::stable_sort(points.begin(), points.end(), [](const auto & a, const auto & b) {
+        return a.x() < b.x();
+    });
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_log.resize(points.size());
+    m_value.resize(points.size());
+    m_slope.assign(points.size(), 0.f);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        m_log[i] = std::log2(static_cast<float>(points[i].x()));
+        m_value[i] = static_cast<float>(points[i].y());
+    }
+    for (std::size_t i = 0; i + 1 < points.size(); ++i) {
+        auto octaves = m_log[i + 1] - m_log[i];
+        m_slope[i] = (octaves > 0 ? (m_value[i + 1] - m_value[i]) / octaves : 0.f);
+    }
+    ++m_revision;
+    m_cache.clear();
+}
+
+quint64 CurveTable::revision() const noexcept
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_revision;
+}
+
+float CurveTable::value(float frequency) const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_log.empty()) {
+        return 0;
+    }
+    auto x = std::log2(frequency);
+    auto next = std::upper_bound(m_log.cbegin(), m_log.cend(), x) - m_log.cbegin();
+    if (next == 0) {
+        return m_value.front();
+    }
+    auto i = static_cast<std::size_t>(next - 1);
+    if (i + 1 == m_log.size()) {
+        return m_value.back();
+    }
+    return m_value[i] + m_slope[i] * (x - m_log[i]);
+}
+
+CurveTable::Values CurveTable::sample(const AxisShared &axis) const
+{
+    if (!axis) {
+        return {};
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto cached = std::find_if(m_cache.begin(), m_cache.end(), [id = axis->id()](const auto & item) {
+        return item.first == id;
+    });
+    if (cached != m_cache.end()) {
+        return cached->second;
+    }
+
+    const auto size = axis->size();
+    auto values = std::make_shared<std::vector<float>>(size, 0.f);
+    if (!m_log.empty()) {
+        auto *x = values->data();
+        auto *frequency = axis->data();
+        for (std::size_t i = 0; i < size; ++i) {
+            x[i] = std::log2(frequency[i]);
+        }
+
+        //bins are sorted on the grids, the segment is walked forward and found again if they are not
+        const auto last = m_log.size() - 1;
+        std::size_t j = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (j > 0 && x[i] < m_log[j]) {
+                j = static_cast<std::size_t>(std::max<std::ptrdiff_t>(
+                                                 std::upper_bound(m_log.cbegin(), m_log.cend(), x[i]) - m_log.cbegin() - 1, 0));
+            }
+            while (j < last && x[i] >= m_log[j + 1]) {
+                ++j;
+            }
+            if (!(x[i] > m_log.front())) {
+                x[i] = m_value.front();
+            } else if (j == last) {
+                x[i] = m_value.back();
+            } else {
+                x[i] = m_value[j] + m_slope[j] * (x[i] - m_log[j]);
+            }
+        }
+    }
+
+    m_cache.emplace_back(axis->id(), values);
+    if (m_cache.size() > CACHE_SIZE) {
+        m_cache.erase(m_cache.begin());
+    }
+    return values;
+}
+
+CurveTable::Deviation CurveTable::deviation(const AxisShared &axis, const float *levels, unsigned int ppo,
+                                            float from, float to) const
+{
+    Deviation result;
+    auto curve = sample(axis);
+    if (!curve || !levels || !ppo || !(from > 0) || to <= from) {
+        return result;
+    }
+
+    const auto size = axis->size();
+    const auto *frequency = axis->data();
+    const auto *target = curve->data();
+    std::vector<float> difference(size), band(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        difference[i] = levels[i] - target[i];
+        band[i] = ppo * std::log2(frequency[i] / from);
+    }
+
+    const auto count = static_cast<std::size_t>(std::floor(ppo * std::log2(to / from))) + 1;
+    std::vector<double> squares(count, 0);
+    result.bands.resize(count);
+    for (std::size_t k = 0; k < count; ++k) {
+        result.bands[k].frequency = from * std::pow(2.f, static_cast<float>(k) / ppo);
+    }
+
+    double total = 0;
+    unsigned int used = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        auto k = std::lround(band[i]);
+        if (k < 0 || k >= static_cast<long>(count) || !std::isfinite(difference[i])) {
+            continue;
+        }
+        auto d = difference[i];
+        auto &item = result.bands[k];
+        squares[k] += d * d;
+        item.max = std::max(item.max, std::abs(d));
+        ++item.count;
+        total += d * d;
+        ++used;
+    }
+
+    for (std::size_t k = 0; k < count; ++k) {
+        auto &item = result.bands[k];
+        if (item.count) {
+            item.rms = static_cast<float>(std::sqrt(squares[k] / item.count));
+            result.max = std::max(result.max, item.max);
+        }
+    }
+    result.rms = used ? static_cast<float>(std::sqrt(total / used)) : 0.f;
+    return result;
+}
+
+CurveTable::Deviation CurveTable::deviation(const Shared &source, unsigned int ppo, float from, float to) const
+{
+    if (!source) {
+        return {};
+    }
+    source->pageIn();
+    source->lock();
+    auto axis = source->axis();
+    std::vector<float> levels(source->size());
+    for (unsigned int i = 0; i < levels.size(); ++i) {
+        levels[i] = source->magnitude(i);
+    }
+    source->unlock();
+
+    if (!axis || axis->size() != levels.size()) {
+        return {};
+    }
+    return deviation(axis, levels.data(), ppo, from, to);
+}
+
+QVariantMap CurveTable::toVariant(const Deviation &deviation, float tolerance)
+{
+    QVariantList bands;
+    bool pass = true;
+    for (auto &band : deviation.bands) {
+        if (!band.count) {
+            continue;
+        }
+        QVariantMap item {
+            {"frequency", band.frequency},
+            {"rms",       band.rms},
+            {"max",       band.max}
+        };
+        if (tolerance > 0) {
+            item["pass"] = band.max <= tolerance;
+            pass &= band.max <= tolerance;
+        }
+        bands << item;
+    }
+
+    QVariantMap result {
+        {"valid",   !bands.isEmpty()},
+        {"rms",     deviation.rms},
+        {"max",     deviation.max},
+        {"bands",   bands}
+    };
+    if (tolerance > 0) {
+        result["pass"] = pass && !bands.isEmpty();
+    }
+    return result;
+}
+
+} // namespace Source
@@ -0,0 +1,86 @@
+/**
+ *  OSM
+ *  Copyright (C) 2024  Pavel Smokotnin
+
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOURCE_CURVETABLE_H
+#define SOURCE_CURVETABLE_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QPointF>
+#include <QVariantMap>
+#include "axis.h"
+#include "source_shared.h"
+
+namespace Source {
+
+/**
+ * @brief The CurveTable class
+ * curve given by points in dB, joined on the log frequency scale and held flat outside of them.
+ * The curve is compiled once per edit and sampled once per frequency grid: readers get the same
+ * array while neither the points nor the grid change, instead of interpolating on every frame.
+ */
+class CurveTable
+{
+public:
+    using Values = std::shared_ptr<const std::vector<float>>;
+
+    struct Band {
+        float frequency = 0;    //centre
+        float rms = 0;          //dB
+        float max = 0;          //largest absolute deviation, dB
+        unsigned int count = 0; //bins in the band
+    };
+
+    struct Deviation {
+        float rms = 0, max = 0;
+        std::vector<Band> bands;
+    };
+
+    CurveTable();
+
+    //! points are frequency and level, they are sorted here
+    void setPoints(std::vector<QPointF> points);
+    //! changed by every setPoints
+    quint64 revision() const noexcept;
+
+    float value(float frequency) const;
+    //! the curve at every bin of the axis, built once per grid and revision
+    Values sample(const AxisShared &axis) const;
+
+    //! deviation of levels (dB, a value per bin of axis) from the curve in 1/ppo octave bands from..to.
+    //! Bins with non finite levels are skipped, bands without bins have count 0
+    Deviation deviation(const AxisShared &axis, const float *levels, unsigned int ppo,
+                        float from = 20, float to = 20000) const;
+    //! deviation of the magnitude of the source as it is shown
+    Deviation deviation(const Shared &source, unsigned int ppo, float from = 20, float to = 20000) const;
+
+    //! rms, max and bands as a list of frequency, rms, max. Pass flags are added if tolerance is above 0
+    static QVariantMap toVariant(const Deviation &deviation, float tolerance = 0);
+
+private:
+    static constexpr std::size_t CACHE_SIZE = 8;
+
+    mutable std::mutex m_mutex;
+    std::vector<float> m_log, m_value, m_slope;     //log2 of the frequency, dB, dB per octave to the next point
+    quint64 m_revision;
+    mutable std::vector<std::pair<quint64, Values>> m_cache;   //axis id and values, the recent one is the last
+};
+
+} // namespace Source
+
+#endif // SOURCE_CURVETABLE_H
@@ -27,8 +27,13 @@ Abstract::Abstract(QObject *parent) : QObject(parent),
     m_dataLength(0),
     m_deconvolutionSize(0),
     m_active(false),
-    m_uuid(QUuid::createUuid())
+    m_uuid(QUuid::createUuid()),
+    m_published(std::make_shared<Frame>()), m_framePool(), m_framePoolNext(0), m_version(0),
+    m_readMutex(), m_pinned(m_published), m_pinnedBy(std::thread::id())
 {
+    for (auto &frame : m_framePool) {
+        frame = std::make_shared<Frame>();
+    }
     qRegisterMetaType<Source::Abstract *>("Source*");
 }
 
@@ -70,7 +75,8 @@ void Abstract::setColor(QColor color)
 
 const unsigned int &Abstract::size() const noexcept
 {
-    return m_dataLength;
+    assertPinned();
+    return m_pinned->size;
 }
 void Abstract::setGlobalColor(int globalValue)
 {
@@ -96,94 +102,310 @@ QUuid Abstract::uuid() const
 }
 const float &Abstract::frequency(const unsigned int &i) const noexcept
 {
-    if (i >= m_dataLength)
+    assertPinned();
+    auto &axis = m_pinned->ftdata.axis;
+    if (i >= m_pinned->size || !axis || i >= axis->size())
         return m_zero;
-    return m_ftdata[i].frequency;
+    return (*axis)[i];
 }
 float Abstract::module(const unsigned int &i) const noexcept {
-    if (i >= m_dataLength)
+    assertPinned();
+    if (i >= m_pinned->size)
         return m_zero;
-    return m_ftdata[i].module;
+    return m_pinned->ftdata.module[i];
 }
 float Abstract::magnitude(const unsigned int &i) const noexcept
 {
-    if (i >= m_dataLength)
+    assertPinned();
+    if (i >= m_pinned->size)
         return m_zero;
-    return 20.f * log10f(m_ftdata[i].magnitude);
+    return 20.f * log10f(m_pinned->ftdata.magnitude[i]);
 }
 float Abstract::magnitudeRaw(const unsigned int &i) const noexcept
 {
-    if (i >= m_dataLength)
+    assertPinned();
+    if (i >= m_pinned->size)
         return m_zero;
-    return m_ftdata[i].magnitude;
+    return m_pinned->ftdata.magnitude[i];
 }
 complex Abstract::phase(const unsigned int &i) const noexcept
 {
-    if (i < m_dataLength)
-        return m_ftdata[i].phase;
+    assertPinned();
+    if (i < m_pinned->size)
+        return m_pinned->ftdata.phase[i];
 
     return 0;
 }
 const float &Abstract::coherence(const unsigned int &i) const noexcept
 {
-    if (i >= m_dataLength)
+    assertPinned();
+    if (i >= m_pinned->size)
         return m_zero;
 
-    return m_ftdata[i].coherence;
+    return m_pinned->ftdata.coherence[i];
 }
 
 const float &Abstract::peakSquared(const unsigned int &i) const noexcept
 {
-    if (i >= m_dataLength)
+    assertPinned();
+    if (i >= m_pinned->size)
         return m_zero;
 
-    return m_ftdata[i].peakSquared;
+    return m_pinned->ftdata.peakSquared[i];
 }
 
 float Abstract::crestFactor(const unsigned int &i) const noexcept
 {
-    if (i >= m_dataLength)
+    assertPinned();
+    if (i >= m_pinned->size)
         return -INFINITY;
 
-    return 10.f * std::log10(m_ftdata[i].peakSquared / m_ftdata[i].meanSquared);
+    return 10.f * std::log10(m_pinned->ftdata.peakSquared[i] / m_pinned->ftdata.meanSquared[i]);
 }
 
 unsigned int Abstract::impulseSize() const noexcept
 {
-    return m_deconvolutionSize;
+    assertPinned();
+    return m_pinned->impulseSize;
 }
 float Abstract::impulseTime(const unsigned int &i) const noexcept
 {
-    if (i >= m_deconvolutionSize)
+    assertPinned();
+    if (i >= m_pinned->impulseSize)
         return m_zero;
-    return m_impulseData[i].time;
+    return m_pinned->impulseData.time[i];
 }
 float Abstract::impulseValue(const unsigned int &i) const noexcept
 {
-    if (i >= m_deconvolutionSize)
+    assertPinned();
+    if (i >= m_pinned->impulseSize)
         return m_zero;
-    return m_impulseData[i].value.real;
+    return m_pinned->impulseData.value[i].real;
+}
+AxisShared Abstract::axis() const noexcept
+{
+    assertPinned();
+    return m_pinned->ftdata.axis;
+}
+container::span<const float> Abstract::frequencyColumn() const noexcept
+{
+    assertPinned();
+    auto &axis = m_pinned->ftdata.axis;
+    if (!axis) {
+        return {};
+    }
+    return {axis->data(), std::min<std::size_t>(m_pinned->size, axis->size())};
+}
+container::span<const float> Abstract::moduleColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->ftdata.module.data(), m_pinned->size};
+}
+container::span<const float> Abstract::magnitudeColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->ftdata.magnitude.data(), m_pinned->size};
+}
+container::span<const complex> Abstract::phaseColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->ftdata.phase.data(), m_pinned->size};
+}
+container::span<const float> Abstract::coherenceColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->ftdata.coherence.data(), m_pinned->size};
+}
+container::span<const float> Abstract::peakSquaredColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->ftdata.peakSquared.data(), m_pinned->size};
+}
+container::span<const float> Abstract::meanSquaredColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->ftdata.meanSquared.data(), m_pinned->size};
+}
+container::span<const float> Abstract::impulseTimeColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->impulseData.time.data(), m_pinned->impulseSize};
+}
+container::span<const complex> Abstract::impulseValueColumn() const noexcept
+{
+    assertPinned();
+    return {m_pinned->impulseData.value.data(), m_pinned->impulseSize};
 }
-void Abstract::copy(FTData *dataDist, TimeData *timeDist)
+Abstract::Modifiers Abstract::modifiers() const noexcept
 {
+    return {};
+}
+void Abstract::copy(FTData *dataDist, TimeData *timeDist) const
+{
+    assertPinned();
     if (dataDist) {
-        std::copy_n(m_ftdata.data(), size(), dataDist);
+        for (unsigned int i = 0; i < size(); ++i) {
+            dataDist[i] = m_pinned->ftdata.row(i);
+        }
     }
     if (timeDist) {
-        std::copy_n(m_impulseData.data(), impulseSize(), timeDist);
+        for (unsigned int i = 0; i < impulseSize(); ++i) {
+            timeDist[i] = m_pinned->impulseData.row(i);
+        }
     }
 }
 
 void Abstract::copyFrom(size_t dataSize, size_t timeSize, Abstract::FTData *dataSrc,
                         Abstract::TimeData *timeSrc)
 {
+    std::lock_guard<std::mutex> guard(m_dataMutex);
     m_dataLength = dataSize;
     m_deconvolutionSize = timeSize;
     m_ftdata.resize(m_dataLength);
     m_impulseData.resize(m_deconvolutionSize);
 
-    std::copy_n(dataSrc, size(), m_ftdata.data());
-    std::copy_n(timeSrc, impulseSize(), m_impulseData.data());
+    std::vector<float> frequencies(m_dataLength);
+    for (unsigned int i = 0; i < m_dataLength; ++i) {
+        frequencies[i] = dataSrc[i].frequency;
+        m_ftdata.setRow(i, dataSrc[i]);
+    }
+    m_ftdata.axis = Axis::fromValues(std::move(frequencies));
+    for (unsigned int i = 0; i < m_deconvolutionSize; ++i) {
+        m_impulseData.setRow(i, timeSrc[i]);
+    }
+    publish();
+}
+
+Abstract::FrameShared Abstract::frame() const
+{
+    return std::atomic_load(&m_published);
+}
+
+quint64 Abstract::version() const noexcept
+{
+    return m_version;
+}
+
+void Abstract::pageIn()
+{
+}
+
+void Abstract::lock() const
+{
+    m_readMutex.lock();
+    m_pinnedBy.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    auto published = std::atomic_load(&m_published);
+    if (published != m_pinned) {
+        m_pinned = std::move(published);
+    }
+}
+
+void Abstract::unlock() const
+{
+    m_pinnedBy.store(std::thread::id(), std::memory_order_relaxed);
+    m_readMutex.unlock();
+}
+
+quint64 Abstract::pinnedVersion() const noexcept
+{
+    assertPinned();
+    return m_pinned->version;
+}
+
+void Abstract::publish()
+{
+    //a frame owned by the pool only is neither published nor pinned: it can be rewritten
+    std::shared_ptr<Frame> frame;
+    for (auto &candidate : m_framePool) {
+        if (candidate && candidate.use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            frame = candidate;
+            break;
+        }
+    }
+    if (!frame) {
+        //all frames are held by readers: the oldest one is left to them
+        frame = std::make_shared<Frame>();
+        m_framePool[m_framePoolNext] = frame;
+        m_framePoolNext = (m_framePoolNext + 1) % FRAME_POOL;
+    }
+
+    frame->size = std::min<unsigned int>(m_dataLength, static_cast<unsigned int>(m_ftdata.size()));
+    frame->impulseSize = std::min<unsigned int>(m_deconvolutionSize, static_cast<unsigned int>(m_impulseData.size()));
+    frame->ftdata.assign(m_ftdata, frame->size);
+    frame->impulseData.assign(m_impulseData, frame->impulseSize);
+    frame->version = ++m_version;
+
+    std::atomic_store(&m_published, FrameShared(frame));
+}
+
+void Abstract::resetFramePool()
+{
+    //readers keep their frames till they let them go
+    for (auto &frame : m_framePool) {
+        frame.reset();
+    }
+}
+
+void Abstract::Spectrum::resize(std::size_t size)
+{
+    for (auto *column : {&module, &magnitude, &coherence, &peakSquared}) {
+        column->resize(size, 0.f);
+    }
+    meanSquared.resize(size, NAN);
+    phase.resize(size);
+}
+
+void Abstract::Spectrum::assign(const Spectrum &source, std::size_t size)
+{
+    auto copy = [size](auto & target, const auto & column) {
+        target.assign(column.cbegin(), column.cbegin() + size);
+    };
+    axis = source.axis;
+    copy(module,        source.module);
+    copy(magnitude,     source.magnitude);
+    copy(coherence,     source.coherence);
+    copy(peakSquared,   source.peakSquared);
+    copy(meanSquared,   source.meanSquared);
+    copy(phase,         source.phase);
+}
+
+Abstract::FTData Abstract::Spectrum::row(std::size_t i) const noexcept
+{
+    return {frequency(i), module[i], magnitude[i], phase[i], coherence[i], peakSquared[i], meanSquared[i]};
+}
+
+void Abstract::Spectrum::setRow(std::size_t i, const FTData &row) noexcept
+{
+    module[i]       = row.module;
+    magnitude[i]    = row.magnitude;
+    phase[i]        = row.phase;
+    coherence[i]    = row.coherence;
+    peakSquared[i]  = row.peakSquared;
+    meanSquared[i]  = row.meanSquared;
+}
+
+void Abstract::Impulse::resize(std::size_t size)
+{
+    time.resize(size, 0.f);
+    value.resize(size);
+}
+
+void Abstract::Impulse::assign(const Impulse &source, std::size_t size)
+{
+    time.assign(source.time.cbegin(), source.time.cbegin() + size);
+    value.assign(source.value.cbegin(), source.value.cbegin() + size);
+}
+
+Abstract::TimeData Abstract::Impulse::row(std::size_t i) const noexcept
+{
+    return {time[i], value[i]};
+}
+
+void Abstract::Impulse::setRow(std::size_t i, const TimeData &row) noexcept
+{
+    time[i]  = row.time;
+    value[i] = row.value;
 }
 
 QJsonObject Abstract::toJSON(const SourceList *) const noexcept
@@ -18,13 +18,19 @@
 #ifndef SOURCE_H
 #define SOURCE_H
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include <QObject>
 #include <QColor>
 #include <QJsonObject>
 
+#include "container/span.h"
+#include "source/axis.h"
 #include "math/complex.h"
 #include "math/meter.h"
 #include "source/source_shared.h"
@@ -58,6 +64,61 @@ public:
         complex value;
     };
 
+    //! frequency domain results stored by quantity: one contiguous array per column
+    struct Spectrum {
+        AxisShared           axis;  //interned frequency grid
+        std::vector<float>   module, magnitude, coherence, peakSquared, meanSquared;
+        std::vector<complex> phase;
+
+        std::size_t size() const noexcept
+        {
+            return module.size();
+        }
+        float frequency(std::size_t i) const noexcept
+        {
+            return axis && i < axis->size() ? (*axis)[i] : 0.f;
+        }
+        void resize(std::size_t size);
+        //! copies first size bins of source
+        void assign(const Spectrum &source, std::size_t size);
+        FTData row(std::size_t i) const noexcept;
+        void setRow(std::size_t i, const FTData &row) noexcept;
+    };
+
+    //! impulse response stored by quantity
+    struct Impulse {
+        std::vector<float>   time;  //ms
+        std::vector<complex> value;
+
+        std::size_t size() const noexcept
+        {
+            return time.size();
+        }
+        void resize(std::size_t size);
+        void assign(const Impulse &source, std::size_t size);
+        TimeData row(std::size_t i) const noexcept;
+        void setRow(std::size_t i, const TimeData &row) noexcept;
+    };
+
+    /**
+     * immutable result of one processing step, published by the producer for the readers
+     */
+    struct Frame {
+        Spectrum    ftdata;
+        Impulse     impulseData;
+        unsigned int size = 0;
+        unsigned int impulseSize = 0;
+        quint64 version = 0;
+    };
+    using FrameShared = std::shared_ptr<const Frame>;
+
+    //! what overridden accessors apply over the published columns, neutral by default
+    struct Modifiers {
+        float gain = 0.f;   //dB
+        float delay = 0.f;  //ms
+        bool polarity = false, inverse = false, ignoreCoherence = false;
+    };
+
     explicit Abstract(QObject *parent = nullptr);
     virtual ~Abstract();
     virtual Source::Shared clone() const = 0;
@@ -87,6 +148,8 @@ public:
         return m_color.isValid();
     }
 
+    //! accessors below read the pinned frame: the caller must hold lock(), it is asserted in debug builds.
+    //! A reader that can't hold the lock keeps the frame() instead.
     const unsigned int &size() const  noexcept;
     const float &frequency(const unsigned int &i) const noexcept;
     virtual float module(const unsigned int &i) const noexcept;
@@ -101,17 +164,38 @@ public:
     virtual float impulseTime(const unsigned int &i) const noexcept;
     virtual float impulseValue(const unsigned int &i) const noexcept;
 
-    void copy(FTData *dataDist, TimeData *timeDist);
+    //! frequency grid of the pinned frame, sources with the same grid share the object
+    AxisShared axis() const noexcept;
+
+    //! columns of the pinned frame, valid till the next lock().
+    //! Values are published ones: modifiers() applied by overridden accessors are not included.
+    container::span<const float>   frequencyColumn() const noexcept;
+    container::span<const float>   moduleColumn() const noexcept;
+    container::span<const float>   magnitudeColumn() const noexcept;  //linear, as magnitudeRaw()
+    container::span<const complex> phaseColumn() const noexcept;
+    container::span<const float>   coherenceColumn() const noexcept;
+    container::span<const float>   peakSquaredColumn() const noexcept;
+    container::span<const float>   meanSquaredColumn() const noexcept;
+    container::span<const float>   impulseTimeColumn() const noexcept;
+    container::span<const complex> impulseValueColumn() const noexcept;
+    //! a reader of the columns applies these to get what the accessors return
+    virtual Modifiers modifiers() const noexcept;
+
+    void copy(FTData *dataDist, TimeData *timeDist) const;
     void copyFrom(size_t dataSize, size_t timeSize, FTData *dataSrc, TimeData *timeSrc);
 
-    void lock()
-    {
-        m_dataMutex.lock();
-    }
-    void unlock()
-    {
-        m_dataMutex.unlock();
-    }
+    //! last published frame, can be kept by the reader as long as needed
+    FrameShared frame() const;
+    //! version of the last published frame, readers skip unchanged frames with it
+    quint64 version() const noexcept;
+    //! the data is about to be read. Sources that keep it on disk load it here, it may take a while
+    virtual void pageIn();
+
+    //! pins the last published frame for the accessors above, doesn't block the producer
+    void lock() const;
+    void unlock() const;
+    //! version of the pinned frame
+    quint64 pinnedVersion() const noexcept;
 
     virtual Q_INVOKABLE QJsonObject toJSON(const SourceList * = nullptr) const noexcept;
     virtual void fromJSON(QJsonObject data, const SourceList * = nullptr) noexcept;
@@ -138,14 +222,19 @@ public slots:
     void setGlobalColor(int globalValue);
 
 protected:
+    //! publishes m_ftdata and m_impulseData as a new frame, m_dataMutex must be held by the caller
+    void publish();
+    //! drops pooled frames with their buffers, the next publish() starts from a new frame
+    void resetFramePool();
+
     QString m_name;
     QColor m_color;
     //TODO: unsigned int m_sample_rate;
 
     std::mutex m_dataMutex;   //NOTE: shared_mutex (C++17)
     std::atomic<bool>       m_onReset;
-    std::vector<FTData>     m_ftdata;
-    std::vector<TimeData>   m_impulseData;
+    Spectrum                m_ftdata;
+    Impulse                 m_impulseData;
 
     unsigned int m_dataLength;
     unsigned int m_deconvolutionSize;
@@ -178,7 +267,25 @@ protected:
     } m_levelsData;
 
 private:
+    //frames are reused when no reader holds them: one published, one pinned and one to write
+    static constexpr std::size_t FRAME_POOL = 3;
+
     QUuid m_uuid;
+
+    FrameShared m_published;    //std::atomic_load/atomic_store only
+    std::array<std::shared_ptr<Frame>, FRAME_POOL> m_framePool;
+    std::size_t m_framePoolNext;
+    std::atomic<quint64> m_version;
+
+    mutable std::mutex m_readMutex;
+    mutable FrameShared m_pinned;
+    mutable std::atomic<std::thread::id> m_pinnedBy;    //holder of lock(), for the debug assertion only
+
+    void assertPinned() const noexcept
+    {
+        Q_ASSERT_X(m_pinnedBy.load(std::memory_order_relaxed) == std::this_thread::get_id(),
+                   "Source::Abstract", "the pinned frame is read without lock()");
+    }
 };
 }
 #endif // SOURCE_H
@@ -16,14 +16,17 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include "notifier.h"
 #include "sourcewindowing.h"
 #include "sourcelist.h"
 #include "stored.h"
+#include "common/scheduler.h"
 
 Windowing::Windowing(QObject *parent) : Source::Abstract(parent), Meta::Windowing(),
     m_sampleRate(1), m_source(nullptr),
-    m_window(WindowFunction::Type::Rectangular, this)
+    m_window(WindowFunction::Type::Rectangular, this),
+    m_dirty(true), m_sourceVersion(0)
 {
     m_name = "Windowing";
     setObjectName("Windowing");
@@ -32,22 +35,26 @@ Windowing::Windowing(QObject *parent) : Source::Abstract(parent), Meta::Windowin
     connect(this, &Windowing::domainChanged, this, &Windowing::applyAutoName);
     connect(this, &Windowing::windowFunctionTypeChanged, this, &Windowing::applyWindowFunctionType);
 
-    connect(this, &Windowing::wideChanged,   this, &Windowing::update);
-    connect(this, &Windowing::modeChanged,   this, &Windowing::update);
-    connect(this, &Windowing::minFrequencyChanged,   this, &Windowing::update);
-    connect(this, &Windowing::maxFrequencyChanged,   this, &Windowing::update);
-    connect(this, &Windowing::offsetChanged, this, &Windowing::update);
-    connect(this, &Windowing::sourceChanged, this, &Windowing::update);
-    connect(this, &Windowing::domainChanged, this, &Windowing::update);
+    connect(this, &Windowing::wideChanged,   this, &Windowing::invalidate);
+    connect(this, &Windowing::modeChanged,   this, &Windowing::invalidate);
+    connect(this, &Windowing::minFrequencyChanged,   this, &Windowing::invalidate);
+    connect(this, &Windowing::maxFrequencyChanged,   this, &Windowing::invalidate);
+    connect(this, &Windowing::offsetChanged, this, &Windowing::invalidate);
+    connect(this, &Windowing::sourceChanged, this, &Windowing::invalidate);
+    connect(this, &Windowing::domainChanged, this, &Windowing::invalidate);
     connect(this, &Windowing::modeChanged,   this, &Windowing::applyAutoWide);
-    connect(this, &Windowing::windowFunctionTypeChanged, this, &Windowing::update);
+    connect(this, &Windowing::windowFunctionTypeChanged, this, &Windowing::invalidate);
+    connect(this, &Windowing::activeChanged, this, &Windowing::update);
 
     applyAutoName();
-    //own Thread
 }
 
 Windowing::~Windowing()
 {
+    if (m_source) {
+        disconnect(m_source.get(), nullptr, this, nullptr);
+    }
+    Scheduler::getInstance()->cancel(this);
 }
 
 Source::Shared Windowing::clone() const
@@ -121,6 +128,36 @@ void Windowing::applyAutoName()
 
 void Windowing::update()
 {
+    //a burst of updates is one calc with the latest frame of the source
+    Scheduler::getInstance()->submit(this, "Windowing::calc", [this]() {
+        calc();
+    });
+}
+
+void Windowing::invalidate()
+{
+    m_dirty = true;
+    update();
+}
+
+void Windowing::pageIn()
+{
+    if (!active()) {
+        calc(true);
+    }
+}
+
+void Windowing::calc(bool force)
+{
+    //hidden: sources that read this one are told, they calc it with pageIn()
+    if (!active() && !force) {
+        emit readyRead();
+        return;
+    }
+    //stored data is paged in before the own data is locked
+    if (auto source = this->source()) {
+        source->pageIn();
+    }
     {
         std::lock_guard<std::mutex> guard(m_dataMutex);
         if (!m_source) {
@@ -129,6 +166,13 @@ void Windowing::update()
 
         // [1] lock source
         m_source->lock();
+        auto version = m_source->pinnedVersion();
+        auto dirty = m_dirty.exchange(false);
+        if (version == m_sourceVersion && !dirty) {
+            m_source->unlock();
+            return;
+        }
+        m_sourceVersion = version;
 
         // [2] resize
         resizeData();
@@ -138,12 +182,17 @@ void Windowing::update()
 
         // [4] unlock
         m_source->unlock();
+        publish();
+    }
+    //the reader that forced the calc takes the data itself
+    if (!force) {
+        emit readyRead();
     }
-    emit readyRead();
 }
 
 void Windowing::applyWindowFunctionType()
 {
+    std::lock_guard<std::mutex> guard(m_dataMutex);
     m_window.setType(windowFunctionType());
 }
 
@@ -191,19 +240,10 @@ void Windowing::resizeData()
         }
         m_dataFT.prepare();
 
-        auto frequencyList = m_dataFT.getFrequencies();
-        m_dataLength = frequencyList.size();
+        m_ftdata.axis = Source::Axis::fromTransform(m_dataFT);
+        m_dataLength = m_ftdata.axis->size();
         m_ftdata.resize(m_dataLength);
-
-        unsigned int i = 0;
-        for (auto frequency : frequencyList) {
-            m_ftdata[i].frequency = frequency;
-            m_ftdata[i].coherence = 1;
-            i++;
-            if (i >= m_dataLength) {
-                break;
-            }
-        }
+        std::fill(m_ftdata.coherence.begin(), m_ftdata.coherence.end(), 1.f);
         //fill frequency data
         int t = 0;
         float kt = 1000.f / sampleRate();
@@ -213,7 +253,7 @@ void Windowing::resizeData()
                 j -= m_deconvolutionSize;
             }
 
-            m_impulseData[j].time = t * kt;//ms
+            m_impulseData.time[j] = t * kt;//ms
         }
         m_resize = false;
     }
@@ -248,9 +288,9 @@ void Windowing::updateFromFrequencyDomain()
     complex p1, p2, kp, bp, p;
     bool inList = false;
 
-    for (unsigned i = 0; i < size(); ++i) {
+    for (unsigned i = 0; i < m_dataLength; ++i) {
 
-        while (frequency(i) > m_source->frequency(j)) {
+        while (m_ftdata.frequency(i) > m_source->frequency(j)) {
             last = j;
             if (j + 1 < m_source->size()) {
                 ++j;
@@ -290,9 +330,9 @@ void Windowing::updateFromFrequencyDomain()
             kc = (c2 - c1) / (f2 - f1);
             bc = c2 - kc * f2;
 
-            g = kg * frequency(i) + bg;
-            p = kp * frequency(i) + bp;
-            c = kc * frequency(i) + bc;
+            g = kg * m_ftdata.frequency(i) + bg;
+            p = kp * m_ftdata.frequency(i) + bp;
+            c = kc * m_ftdata.frequency(i) + bc;
         } else {
             g = g2;
             p = p2;
@@ -306,11 +346,11 @@ void Windowing::updateFromFrequencyDomain()
             c = 0;
         }
         auto complexMagnitude = i == 0 ? 0 : p * g;
-        m_ftdata[i].magnitude = g;
-        m_ftdata[i].phase = p;
-        m_ftdata[i].coherence = c;
+        m_ftdata.magnitude[i] = g;
+        m_ftdata.phase[i] = p;
+        m_ftdata.coherence[i] = c;
         m_dataFT.set(                i,     complexMagnitude.conjugate(), 0);
-        m_dataFT.set(impulseSize() - i - 1, complexMagnitude,             0);
+        m_dataFT.set(m_deconvolutionSize - i - 1, complexMagnitude,        0);
     }
 
     // apply iFFT
@@ -327,8 +367,8 @@ void Windowing::updateFromFrequencyDomain()
             j -= m_deconvolutionSize;
         }
 
-        m_impulseData[j].value.real = norm * m_dataFT.af(i).real;
-        m_impulseData[j].time = t * kt;//ms
+        m_impulseData.value[j].real = norm * m_dataFT.af(i).real;
+        m_impulseData.time[j] = t * kt;//ms
     }
 }
 
@@ -368,7 +408,7 @@ void Windowing::updateFromTimeDomain(const Source::Shared &source)
             }
         }
 
-        m_impulseData[j].value = value;
+        m_impulseData.value[j] = value;
         if (f == m_deconvolutionSize) {
             f = 0;
         }
@@ -390,28 +430,28 @@ void Windowing::transform()
     }
 
     auto criticalFrequency = 1000 / wide();
-    for (unsigned i = 0; i < size(); ++i) {
-        if (m_ftdata[i].frequency < criticalFrequency) {
-            m_ftdata[i].coherence = 0;
-        } else if (m_ftdata[i].frequency > criticalFrequency * 2) {
-            m_ftdata[i].coherence *= 1;
+    for (unsigned i = 0; i < m_dataLength; ++i) {
+        if (m_ftdata.frequency(i) < criticalFrequency) {
+            m_ftdata.coherence[i] = 0;
+        } else if (m_ftdata.frequency(i) > criticalFrequency * 2) {
+            m_ftdata.coherence[i] *= 1;
         } else {
-            m_ftdata[i].coherence *= (m_ftdata[i].frequency - criticalFrequency) / criticalFrequency;
+            m_ftdata.coherence[i] *= (m_ftdata.frequency(i) - criticalFrequency) / criticalFrequency;
         }
 
-        m_ftdata[i].magnitude   = m_dataFT.af(i).abs();
-        m_ftdata[i].module      = m_ftdata[i].magnitude;
-        m_ftdata[i].meanSquared = m_ftdata[i].magnitude * m_ftdata[i].magnitude;
-        m_ftdata[i].peakSquared = 0;
-        m_ftdata[i].phase       = m_dataFT.af(i).normalize();
+        m_ftdata.magnitude[i]   = m_dataFT.af(i).abs();
+        m_ftdata.module[i]      = m_ftdata.magnitude[i];
+        m_ftdata.meanSquared[i] = m_ftdata.magnitude[i] * m_ftdata.magnitude[i];
+        m_ftdata.peakSquared[i] = 0;
+        m_ftdata.phase[i]       = m_dataFT.af(i).normalize();
 
         static float threshold1 = powf(10, -40 / 20);
         static float threshold2 = powf(10, -30 / 20);
 
-        if (m_ftdata[i].module < threshold1) {
-            m_ftdata[i].coherence = 0;
-        } else if (m_ftdata[i].module < threshold2) {
-            m_ftdata[i].coherence *= (m_ftdata[i].module - threshold1) / (threshold2 - threshold1);
+        if (m_ftdata.module[i] < threshold1) {
+            m_ftdata.coherence[i] = 0;
+        } else if (m_ftdata.module[i] < threshold2) {
+            m_ftdata.coherence[i] *= (m_ftdata.module[i] - threshold1) / (threshold2 - threshold1);
         }
     }
 }
@@ -428,14 +468,10 @@ void Windowing::setSource(const Source::Shared &newSource)
     }
 
     {
-        auto lockSource = m_source;
-        if (lockSource) {
-            //prevent change during update
-            lockSource->lock();
-        }
+        //calc holds the data mutex while it reads the source
         std::lock_guard<std::mutex> guard(m_dataMutex);
         if (m_source) {
-            disconnect(this, nullptr, m_source.get(), nullptr);
+            disconnect(m_source.get(), nullptr, this, nullptr);
         }
 
         m_source = newSource;
@@ -446,17 +482,13 @@ void Windowing::setSource(const Source::Shared &newSource)
                 setSource(Source::Shared{ nullptr });
             }, Qt::DirectConnection);
 
+            //update only queues the calc, so it is safe on the thread of the source
             connect(
                 m_source.get(), &Source::Abstract::readyRead,
                 this, &Windowing::update,
-
-                //TODO: QueuedConnection when it will work on its own thread
                 Qt::DirectConnection
             );
         }
-        if (lockSource) {
-            lockSource->unlock();
-        }
     } //guard
     emit sourceChanged();
 }
@@ -16,6 +16,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
 #include <QJsonObject>
 #include "source/source_abstract.h"
 #include "math/fouriertransform.h"
@@ -24,7 +25,13 @@
 #ifndef SOURCE_WINDOWING_H
 #define SOURCE_WINDOWING_H
 
-
+/**
+ * @brief The Windowing class
+ * windowed transform of another source. It runs as a task on the Scheduler: updates of the source
+ * and of the settings queue one task, which takes the latest frame of the source when it starts.
+ * Hidden windowing does no work till another source reads it: pageIn() calculates it in place.
+ * The window and the transform are prepared again only on resize.
+ */
 class Windowing : public Source::Abstract, public Meta::Windowing
 {
     Q_OBJECT
@@ -60,6 +67,7 @@ public:
     QUuid sourceId() const;
 
     Q_INVOKABLE Source::Shared store() override;
+    void pageIn() override;
 
     unsigned sampleRate() const;
 
@@ -81,6 +89,8 @@ signals:
     void sourceChanged();
 
 private:
+    void calc(bool force = false);
+    void invalidate();
     void resizeData();
     void syncData();
     void updateFromDomain();
@@ -94,6 +104,8 @@ private:
     FourierTransform m_dataFT;
     Mode m_usedMode;
     bool m_resize;
+    std::atomic<bool> m_dirty;      //settings are changed since the last calc
+    quint64 m_sourceVersion;        //frame of the source used by the last calc
 };
 
 #endif // SOURCE_WINDOWING_H
@@ -21,10 +21,18 @@
 #include <QJsonArray>
 #include <QFile>
 #include <QFileInfo>
+#include <QThread>
 
-#include "common/wavfile.h"
+#include "autoeq.h"
+#include "common/binaryfile.h"
+#include "common/notifier.h"
+#include "exporter.h"
+#include "filterchain.h"
 #include "filtersource.h"
+#include "importer.h"
 #include "measurement.h"
+#include "multimeasurement.h"
+#include "offlineanalysis.h"
 #include "sourcelist.h"
 #include "sourcemodel.h"
 #include "source/group.h"
@@ -271,10 +279,14 @@ int SourceList::indexOf(const QUuid &id) const noexcept
 }
 
 QJsonArray SourceList::toJSON(const SourceList *list) const noexcept
+{
+    return toJSON(m_items, list);
+}
+
+QJsonArray SourceList::toJSON(const QVector<Source::Shared> &items, const SourceList *list) noexcept
 {
     QJsonArray data;
-    for (int i = 0; i < m_items.size(); ++i) {
-        auto &item = m_items.at(i);
+    for (auto &item : items) {
         if (!item) {
             continue;
         }
@@ -288,7 +300,9 @@ QJsonArray SourceList::toJSON(const SourceList *list) const noexcept
 
 void SourceList::fromJSON(const QJsonArray &list) noexcept
 {
-    enum LoadType {MeasurementType, StoredType, UnionType, StandardLineType, FilterType, WindowingType, GroupType};
+    enum LoadType {MeasurementType, StoredType, UnionType, StandardLineType, FilterType, WindowingType, GroupType,
+                   MultiMeasurementType, FilterChainType
+                  };
     static std::map<QString, LoadType> typeMap = {
         {"Measurement",  MeasurementType},
         {"Stored",       StoredType},
@@ -296,7 +310,9 @@ void SourceList::fromJSON(const QJsonArray &list) noexcept
         {"StandardLine", StandardLineType},
         {"Filter",       FilterType},
         {"Windowing",    WindowingType},
-        {"Group",        GroupType}
+        {"Group",        GroupType},
+        {"MultiMeasurement", MultiMeasurementType},
+        {"FilterChain",  FilterChainType}
     };
 
     clean();
@@ -335,36 +351,57 @@ void SourceList::fromJSON(const QJsonArray &list) noexcept
         case GroupType:
             loadObject<Source::Group>(object["data"].toObject());
             break;
+
+        case MultiMeasurementType:
+            loadObject<MultiMeasurement>(object["data"].toObject());
+            break;
+
+        case FilterChainType:
+            loadObject<FilterChain>(object["data"].toObject());
+            break;
         }
     }
 }
 
 bool SourceList::save(const QUrl &fileName) const noexcept
 {
-    QFile saveFile(fileName.toLocalFile());
-    if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open file");
-        return false;
+    auto path = fileName.toLocalFile();
+    if (QFileInfo(path).suffix().toLower() == "json") {
+        QFile saveFile(path);
+        if (!saveFile.open(QIODevice::WriteOnly)) {
+            qWarning("Couldn't open file");
+            return false;
+        }
+
+        QJsonDocument document(toDocument());
+        return saveFile.write(document.toJson(QJsonDocument::JsonFormat::Compact)) != -1;
     }
-    auto guard = lock();
 
+    BinaryFile file;
+    if (!file.create(path)) {
+        return false;
+    }
     QJsonObject object;
-    object["type"] = "sourcelsist";
-
-    auto data = toJSON(this);
-    object["list"] = data;
-    object["selected"] = m_selected;
-
-    QJsonDocument document(object);
-    if (saveFile.write(document.toJson(QJsonDocument::JsonFormat::Compact)) != -1) {
-        return true;
+    {
+        BinaryFile::Scope scope(&file);
+        object = toDocument();
     }
-
-    return false;
+    return file.finish(object);
 }
 bool SourceList::load(const QUrl &fileName) noexcept
 {
-    QFile loadFile(fileName.toLocalFile());
+    auto path = fileName.toLocalFile();
+    if (BinaryFile::detect(path)) {
+        BinaryFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+        //sources copy their columns while the file is mapped
+        BinaryFile::Scope scope(&file);
+        return loadDocument(QJsonDocument(file.metadata()), fileName);
+    }
+
+    QFile loadFile(path);
     if (!loadFile.open(QIODevice::ReadOnly)) {
         qWarning("Couldn't open file");
         return false;
@@ -375,20 +412,43 @@ bool SourceList::load(const QUrl &fileName) noexcept
     if (loadedDocument.isNull() || loadedDocument.isEmpty())
         return false;
 
+    return loadDocument(loadedDocument, fileName);
+}
+
+QJsonObject SourceList::toDocument() const noexcept
+{
+    //the list is locked only to copy it, sources are serialised from their published frames
+    QVector<Source::Shared> items;
+    int selected;
+    {
+        auto guard = lock();
+        items = m_items;
+        selected = m_selected;
+    }
+
+    QJsonObject object;
+    object["type"] = "sourcelsist";
+    object["list"] = toJSON(items, this);
+    object["selected"] = selected;
+    return object;
+}
+
+bool SourceList::loadDocument(const QJsonDocument &document, const QUrl &fileName) noexcept
+{
     enum LoadType {ListType, StoredType};
     static std::map<QString, LoadType> typeMap = {
         {"sourcelsist", ListType},
         {"stored",      StoredType},
     };
 
-    if (typeMap.find(loadedDocument["type"].toString()) != typeMap.end()) {
-        switch (typeMap.at(loadedDocument["type"].toString())) {
+    if (typeMap.find(document["type"].toString()) != typeMap.end()) {
+        switch (typeMap.at(document["type"].toString())) {
         case ListType:
             m_currentFile = fileName;
-            return loadList(loadedDocument, fileName);
+            return loadList(document, fileName);
 
         case StoredType:
-            return loadObject<Stored>(loadedDocument["data"].toObject());
+            return loadObject<Stored>(document["data"].toObject());
         }
     }
 
@@ -397,98 +457,100 @@ bool SourceList::load(const QUrl &fileName) noexcept
 
 bool SourceList::import(const QUrl &fileName, int type)
 {
-    if (type == -1) {
-        QFileInfo info(fileName.toLocalFile());
-        auto ext = info.suffix().toLower();
-        if (ext == "txt") {
-            type = TRANSFER_TXT;
-        } else if (ext == "csv") {
-            type = TRANSFER_CSV;
-        } else if (ext == "wav") {
-            type = IMPULSE_WAV;
-        } else {
-            type = TRANSFER_TXT;
-        }
+    auto result = Importer::importFile(fileName.toLocalFile(), type);
+    if (!result.success) {
+        qWarning() << "couldn't import" << fileName << result.error;
+        return false;
     }
+    appendItem(result.trace, true);
+    return true;
+}
 
-    switch (type) {
-    case TRANSFER_TXT:
-        return importFile(fileName, "\t");
-
-    case TRANSFER_CSV:
-        return importFile(fileName, ",");
+void SourceList::importFiles(const QList<QUrl> &fileNames, int type)
+{
+    if (fileNames.isEmpty()) {
+        return;
+    }
 
-    case IMPULSE_TXT:
-        return importImpulse(fileName, "\t");
+    QStringList files;
+    for (const auto &fileName : fileNames) {
+        files << fileName.toLocalFile();
+    }
 
-    case IMPULSE_CSV:
-        return importImpulse(fileName, ",");
+    auto importer = new Importer();
+    connect(importer, &Importer::progress, this, &SourceList::importProgress);
 
-    case IMPULSE_WAV:
-        return importWav(fileName);
-    }
-    return false;
+    auto thread = QThread::create([this, importer, files, type]() {
+        importer->import(files, type, [this](Importer::Result & result) {
+            if (!result.success) {
+                emit Notifier::getInstance()->newMessage(QFileInfo(result.fileName).fileName(), result.error);
+                return;
+            }
+            QMetaObject::invokeMethod(this, "appendItem", Qt::QueuedConnection,
+                                      Q_ARG(Source::Shared, result.trace), Q_ARG(bool, true));
+        });
+    });
+    thread->setObjectName("Importer");
+    connect(thread, &QThread::finished, importer, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
 }
 
-bool SourceList::importFile(const QUrl &fileName, QString separator)
+void SourceList::exportFiles(const QList<QUuid> &sources, const QStringList &formats, const QUrl &folder)
 {
-    QFile file(fileName.toLocalFile());
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning("Couldn't open file");
-        return false;
+    QList<Source::Shared> items;
+    for (auto &uuid : sources) {
+        if (auto item = getByUUid(uuid)) {
+            items << item;
+        }
     }
+    auto jobs = Exporter::jobs(items, formats, folder.toLocalFile());
+    if (jobs.empty()) {
+        return;
+    }
+
+    auto exporter = new Exporter();
+    connect(exporter, &Exporter::progress, this, &SourceList::exportProgress);
 
-    QString notes = "Imported from " + fileName.toDisplayString(QUrl::PreferLocalFile);
-    char line[1024];
-    bool fOk, mOk;
-    float frequency, magnitude = 0.f, coherence = 1.f, maxMagnitude = -100;
-    complex phase;
-
-    std::vector<Source::Abstract::FTData> d;
-    d.reserve(480); //48 ppo
-    auto s = std::make_shared<Stored>();
-
-    while (file.readLine(line, 1024) > 0) {
-        QString qLine(line);
-        auto list = qLine.split(separator);
-        fOk = mOk = false;
-
-        if (list.size() > 1) {
-            frequency = list[0].replace(",", ".").toFloat(&fOk);
-            magnitude = list[1].replace("*", "0").replace(",", ".").toFloat(&mOk);
-            phase.polar(M_PI * (list.size() > 2 ? list[2].replace("*", "0").replace(",", ".").toFloat() : 0) / 180.f);
-            coherence = (list.size() > 3 ? list[3].replace("*", "0").replace(",", ".").toFloat() : 1);
-
-            if (fOk && mOk && list.size() > 1) {
-                if (magnitude > maxMagnitude) {
-                    maxMagnitude = magnitude;
-                }
-
-                d.push_back({
-                    frequency,
-                    magnitude,
-                    magnitude,
-                    phase,
-                    coherence,
-                    magnitude,
-                    NAN
-                });
+    auto thread = QThread::create([exporter, jobs = std::move(jobs)]() {
+        exporter->run(jobs, [](const Exporter::Result & result) {
+            if (!result.success) {
+                emit Notifier::getInstance()->newMessage(QFileInfo(result.fileName).fileName(), result.error);
             }
-        }
-    }
+        });
+    });
+    thread->setObjectName("Exporter");
+    connect(thread, &QThread::finished, exporter, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
 
-    bool absolute_scale = maxMagnitude > 30;
-    for (auto &row : d) {
-        row.module    = std::pow(10.f, (row.module    + (absolute_scale ? 0 : 70) - 140) / 20.f);
-        row.magnitude = std::pow(10.f, (row.magnitude - (absolute_scale ? maxMagnitude : 0)      ) / 20.f);
+void SourceList::autoEQ(const QUuid &source, float from, float to, float coherence, int bands)
+{
+    auto item = getByUUid(source);
+    if (!item || bands <= 0) {
+        return;
     }
-    s->copyFrom(d.size(), 0, d.data(), nullptr);
-    s->setName(fileName.fileName());
-    s->setNotes(notes);
-    s->setActive(true);
-    Source::Shared shared{ s };
-    appendItem(shared, true);
-    return true;
+
+    AutoEQ::Settings settings;
+    settings.from = from;
+    settings.to = to;
+    settings.coherence = coherence;
+    settings.bands = static_cast<unsigned int>(bands);
+
+    auto thread = QThread::create([this, item, settings]() {
+        auto result = AutoEQ::fit(item, settings);
+        if (!result.success) {
+            emit Notifier::getInstance()->newMessage("Auto EQ", result.error);
+            return;
+        }
+        Source::Shared chain(std::static_pointer_cast<Source::Abstract>(result.chain));
+        QMetaObject::invokeMethod(this, "appendItem", Qt::QueuedConnection,
+                                  Q_ARG(Source::Shared, chain), Q_ARG(bool, true));
+    });
+    thread->setObjectName("AutoEQ");
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
 }
 
 QList<QUuid> SourceList::checked() const
@@ -507,87 +569,49 @@ void SourceList::setChecked(const QList<QUuid> &checked)
 }
 bool SourceList::importImpulse(const QUrl &fileName, QString separator)
 {
-    QFile file(fileName.toLocalFile());
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning("Couldn't open file");
-        return false;
-    }
-
-    QString notes = "Imported from " + fileName.toDisplayString(QUrl::PreferLocalFile);
-    char line[1024];
-    float time, value;
-
-    std::vector<Source::Abstract::TimeData> d;
-    d.reserve(6720); //140ms @ 48kHz
-    auto s = std::make_shared<Stored>();
-
-    while (file.readLine(line, 1024) > 0) {
-        QString qLine(line);
-        auto list = qLine.split(separator);
-
-        if (list.size() > 1) {
-            time = list[0].replace(",", ".").toFloat();
-            value = list[1].replace("*", "0").replace(",", ".").toFloat();
-
-            d.push_back({
-                time,
-                value
-            });
-
-        }
-    }
-
-    s->copyFrom(0, d.size(), nullptr, d.data());
-    s->setName(fileName.fileName());
-    s->setNotes(notes);
-    s->setActive(true);
-    appendItem(Source::Shared{ s }, true);
-    return true;
+    return import(fileName, separator == "," ? IMPULSE_CSV : IMPULSE_TXT);
 }
 bool SourceList::importWav(const QUrl &fileName)
 {
-    WavFile wav;
-    if (!wav.load(fileName.toLocalFile())) {
-        qWarning("Couldn't open file");
-        return false;
+    return import(fileName, IMPULSE_WAV);
+}
+void SourceList::analyseFiles(const QList<QUrl> &fileNames, const Source::Shared &settings)
+{
+    auto measurement = std::dynamic_pointer_cast<Measurement>(settings);
+    if (!measurement || fileNames.isEmpty()) {
+        return;
     }
 
-    //TODO: load meta from file
-    QString notes = "Imported from " + fileName.toDisplayString(QUrl::PreferLocalFile);
-    float time = 0, value = 0, dt = 1000.f / wav.sampleRate(), maxValue = 0, offset = 0;
-    bool finished = false;
-
-    std::vector<Source::Abstract::TimeData> d;
-    d.reserve(6720); //140ms @ 48kHz
-    auto s = std::make_shared<Stored>();
-
-    value = wav.nextSample(false, &finished);
-    while (!finished) {
-        d.push_back({
-            time,
-            value
-        });
-
-        if (maxValue < std::abs(value)) {
-            maxValue = std::abs(value);
-            offset = time;
-        }
-        value = wav.nextSample(false, &finished);
-        time += dt;
+    QStringList files;
+    for (const auto &fileName : fileNames) {
+        files << fileName.toLocalFile();
     }
 
-    for (auto &row : d) {
-        row.time -= offset;
-    }
+    auto analysis = new OfflineAnalysis();
+    analysis->setSettings(measurement->toJSON(this));
+    connect(analysis, &OfflineAnalysis::progress, this, &SourceList::analysisProgress);
 
-    s->copyFrom(0, d.size(), nullptr, d.data());
-    //s->restoreFromImpulse();
-    s->setName(fileName.fileName());
-    s->setNotes(notes);
-    s->setActive(true);
-    Source::Shared shared{ s };
-    appendItem(shared, true);
-    return true;
+    auto thread = QThread::create([this, analysis, files]() {
+        auto results = analysis->analyse(files);
+        for (auto &result : results) {
+            if (!result.success) {
+                emit Notifier::getInstance()->newMessage(QFileInfo(result.fileName).fileName(), result.error);
+                continue;
+            }
+            if (!result.levels.empty()) {
+                auto log = OfflineAnalysis::levelLog(result.levels);
+                emit Notifier::getInstance()->newMessage(QFileInfo(result.fileName).fileName(), log.section('\n', 0, 0));
+            }
+            for (auto &trace : result.traces) {
+                QMetaObject::invokeMethod(this, "appendItem", Qt::QueuedConnection,
+                                          Q_ARG(Source::Shared, trace), Q_ARG(bool, true));
+            }
+        }
+    });
+    thread->setObjectName("OfflineAnalysis");
+    connect(thread, &QThread::finished, analysis, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
 }
 int SourceList::selectedIndex() const
 {
@@ -715,6 +739,11 @@ Source::Shared SourceList::addFilter()
     return add<FilterSource>();
 }
 
+Source::Shared SourceList::addFilterChain()
+{
+    return add<FilterChain>();
+}
+
 Source::Shared SourceList::addWindowing()
 {
     return add<Windowing>();
@@ -737,6 +766,10 @@ Source::Shared SourceList::addMeasurement()
 {
     return add<Measurement>();
 }
+Source::Shared SourceList::addMultiMeasurement()
+{
+    return add<MultiMeasurement>();
+}
 int SourceList::appendNone()
 {
     m_items.prepend(Source::Shared{nullptr});
@@ -75,6 +75,13 @@ public:
     Q_INVOKABLE bool import(const QUrl &fileName, int type);
     Q_INVOKABLE bool importImpulse(const QUrl &fileName, QString separator);
     Q_INVOKABLE bool importWav(const QUrl &fileName) ;
+    //! imports files in parallel, traces are appended in the order of the list
+    Q_INVOKABLE void importFiles(const QList<QUrl> &fileNames, int type = -1);
+    //! writes every source in every format to the folder off the GUI thread
+    Q_INVOKABLE void exportFiles(const QList<QUuid> &sources, const QStringList &formats, const QUrl &folder);
+    Q_INVOKABLE void analyseFiles(const QList<QUrl> &fileNames, const Source::Shared &settings);
+    //! fits peak and shelf filters of the source to the target curve, the result is appended as a filter chain
+    Q_INVOKABLE void autoEQ(const QUuid &source, float from, float to, float coherence, int bands);
     Q_INVOKABLE bool move(int from, int to) noexcept;
     Q_INVOKABLE void moveToGroup(QUuid targetId, QUuid groupId) noexcept;
     Q_INVOKABLE int indexOf(const Source::Shared &item) const noexcept;
@@ -115,14 +122,18 @@ public:
 
     QJsonArray  toJSON(const SourceList *list = nullptr) const noexcept;
     void        fromJSON(const QJsonArray &list) noexcept;
+    //! project document of the save file
+    QJsonObject toDocument() const noexcept;
 
 public slots:
     Q_INVOKABLE QColor nextColor();
 
     Q_INVOKABLE Source::Shared  addMeasurement();
+    Q_INVOKABLE Source::Shared  addMultiMeasurement();
     Q_INVOKABLE Source::Shared  addUnion();
     Q_INVOKABLE Source::Shared  addStandardLine();
     Q_INVOKABLE Source::Shared  addFilter();
+    Q_INVOKABLE Source::Shared  addFilterChain();
     Q_INVOKABLE Source::Shared  addWindowing();
     Q_INVOKABLE Source::Shared  addGroup();
 
@@ -152,12 +163,16 @@ signals:
     void loaded(QUrl fileName);
 
     void countChanged();
+    void importProgress(QString fileName, int done, int total);
+    void exportProgress(QString fileName, int done, int total);
+    void analysisProgress(QString fileName, float value);
 
 private:
+    bool loadDocument(const QJsonDocument &document, const QUrl &fileName) noexcept;
+    static QJsonArray toJSON(const QVector<Source::Shared> &items, const SourceList *list) noexcept;
     bool loadList(const QJsonDocument &document, const QUrl &fileName) noexcept;
     template<typename T> bool loadObject(const QJsonObject &data);
     template<typename T, typename... Ts> Source::Shared add(Ts...);
-    bool importFile(const QUrl &fileName, QString separator);
     void appendItemsFrom(const SourceList *list, QUuid filter, bool unrollGroups);
 
     QVector<Source::Shared> m_items; //TODO: unordered_map<uuid, shared_ptr>
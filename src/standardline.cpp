@@ -89,6 +89,13 @@ void StandardLine::update()
         break;
     }
 
+    std::vector<QPointF> points(m_dataLength);
+    for (unsigned int i = 0; i < m_dataLength; ++i) {
+        points[i] = {(*m_ftdata.axis)[i], 20.f * std::log10(m_ftdata.magnitude[i])};
+    }
+    m_curve.setPoints(std::move(points));
+    publish();
+
     m_dataMutex.unlock();
     emit readyRead();
 }
@@ -100,17 +107,19 @@ void StandardLine::createELC()
     auto size = Math::EqualLoudnessContour::size();
     m_dataLength = size;
     m_ftdata.resize(size);
+    std::vector<float> frequencies(size);
     for (size_t i = 0; i < size; ++i) {
-        m_ftdata[i].frequency   = Math::EqualLoudnessContour::frequency(i);
-        m_ftdata[i].phase       = -INFINITY;
-        m_ftdata[i].module      = -INFINITY;
-        m_ftdata[i].coherence   = 1.f;
+        frequencies[i]          = Math::EqualLoudnessContour::frequency(i);
+        m_ftdata.phase[i]       = -INFINITY;
+        m_ftdata.module[i]      = -INFINITY;
+        m_ftdata.coherence[i]   = 1.f;
 
         auto Lp = Math::EqualLoudnessContour::loudness(i, loudness());
 
-        m_ftdata[i].module    = powf(10, (Lp - 140/*dB*/) / 20);
-        m_ftdata[i].magnitude = powf(10, (Lp - loudness()) / 20);
+        m_ftdata.module[i]    = powf(10, (Lp - 140/*dB*/) / 20);
+        m_ftdata.magnitude[i] = powf(10, (Lp - loudness()) / 20);
     }
+    m_ftdata.axis = Source::Axis::fromValues(std::move(frequencies));
 }
 
 void StandardLine::createWeighting()
@@ -127,17 +136,18 @@ void StandardLine::createWeighting()
     m_ftdata.resize(m_dataLength);
 
     //i = 10...43
+    std::vector<float> frequencies(m_dataLength);
     for (size_t i = 0; i < m_dataLength; ++i) {
         auto f = std::pow(10, 0.1 * (i + 10));
 
-        m_ftdata[i].frequency   = f;
-        m_ftdata[i].phase       = -INFINITY;
-        m_ftdata[i].module      = -INFINITY;
-        m_ftdata[i].coherence   = 1.f;
+        frequencies[i]          = f;
+        m_ftdata.phase[i]       = -INFINITY;
+        m_ftdata.module[i]      = -INFINITY;
+        m_ftdata.coherence[i]   = 1.f;
 
         switch (m_mode) {
         case WEIGHTING_A:
-            m_ftdata[i].magnitude = pow(10, 1.997 / 20) * (
+            m_ftdata.magnitude[i] = pow(10, 1.997 / 20) * (
                                         f4 * f4 * f * f * f * f /
                                         (
                                             (f * f + f1 * f1) *
@@ -149,7 +159,7 @@ void StandardLine::createWeighting()
             break;
 
         case WEIGHTING_B:
-            m_ftdata[i].magnitude = pow(10, 0.1696 / 20) * (
+            m_ftdata.magnitude[i] = pow(10, 0.1696 / 20) * (
                                         f4 * f4 * f * f * f /
                                         (
                                             (f * f + f1 * f1) *
@@ -160,7 +170,7 @@ void StandardLine::createWeighting()
             break;
 
         case WEIGHTING_C:
-            m_ftdata[i].magnitude = pow(10, 0.0619 / 20) * (
+            m_ftdata.magnitude[i] = pow(10, 0.0619 / 20) * (
                                         f4 * f4 * f * f /
                                         (
                                             (f * f + f1 * f1) *
@@ -174,6 +184,7 @@ void StandardLine::createWeighting()
             break;
         }
     }
+    m_ftdata.axis = Source::Axis::fromValues(std::move(frequencies));
 }
 
 StandardLine::Mode StandardLine::mode() const
@@ -201,6 +212,19 @@ void StandardLine::setMode(const Mode &mode)
     }
 }
 
+const Source::CurveTable &StandardLine::curve() const noexcept
+{
+    return m_curve;
+}
+
+QVariantMap StandardLine::deviationMap(const Source::Shared &source, int ppo, float tolerance) const
+{
+    if (ppo <= 0 || source.get() == this) {
+        return {};
+    }
+    return Source::CurveTable::toVariant(m_curve.deviation(source, static_cast<unsigned int>(ppo)), tolerance);
+}
+
 QVariant StandardLine::getAvailableModes() const
 {
     QStringList typeList;
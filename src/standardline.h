@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include "source/source_abstract.h"
+#include "source/curvetable.h"
 
 class StandardLine : public Source::Abstract
 {
@@ -52,6 +53,11 @@ public:
     void setMode(const Mode &mode);
     QVariant getAvailableModes() const;
 
+    //! the line as a curve of magnitude in dB, compiled on every change
+    const Source::CurveTable &curve() const noexcept;
+    //! deviation of the source from the line in 1/ppo octave bands, pass flags are added if tolerance is above 0
+    Q_INVOKABLE QVariantMap deviationMap(const Source::Shared &source, int ppo = 3, float tolerance = 0) const;
+
 signals:
     void loudnessChanged(float);
     void modeChanged(StandardLine::Mode);
@@ -63,6 +69,7 @@ private:
 
     Mode m_mode;
     float m_loudness;
+    Source::CurveTable m_curve;
 
     static const std::map<Mode, QString> m_modeMap;
 };
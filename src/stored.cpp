@@ -19,19 +19,66 @@
 #include <QUrl>
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QUuid>
+#include <QDebug>
 #include <QtMath>
 #include <QtEndian>
+#include "common/binaryfile.h"
+#include "common/textwriter.h"
+#include "common/memorybudget.h"
+#include "common/notifier.h"
+#include "common/scheduler.h"
 #include "common/wavfile.h"
+#include "common/workingfolder.h"
+#include "source/compactframe.h"
 
-Stored::Stored(QObject *parent) : Source::Abstract(parent), Meta::Stored()
+Stored::Stored(QObject *parent) : Source::Abstract(parent), Meta::Stored(),
+    m_pageMutex(), m_backing(), m_compactFrame(), m_resident(true), m_pageFailed(false), m_parked(false),
+    m_lastUse(clock::now().time_since_epoch().count()), m_dataVersion(0)
 {
     setObjectName("Stored");
-    connect(this, &Stored::polarityChanged, this, &Source::Abstract::readyRead);
-    connect(this, &Stored::inverseChanged, this, &Source::Abstract::readyRead);
-    connect(this, &Stored::ignoreCoherenceChanged, this, &Source::Abstract::readyRead);
-    connect(this, &Stored::gainChanged, this, &Source::Abstract::readyRead);
-    connect(this, &Stored::delayChanged, this, &Source::Abstract::readyRead);
+
+    //visible data stays in memory, hidden one may be paged out when the budget is exceeded
+    connect(this, &Stored::activeChanged, this, [this]() {
+        if (active()) {
+            MemoryBudget::getInstance()->unpark(this);
+            m_parked = false;
+            Scheduler::getInstance()->submit(this, "Stored::pageIn", [this]() {
+                pageIn();
+            });
+        } else {
+            park();
+        }
+    });
+
+    //modifiers change what the accessors return, readers know it by the new frame version
+    auto republish = [this]() {
+        {
+            std::lock_guard<std::mutex> guard(m_dataMutex);
+            publish();
+        }
+        emit readyRead();
+    };
+    connect(this, &Stored::polarityChanged, this, republish);
+    connect(this, &Stored::inverseChanged, this, republish);
+    connect(this, &Stored::ignoreCoherenceChanged, this, republish);
+    connect(this, &Stored::gainChanged, this, republish);
+    connect(this, &Stored::delayChanged, this, republish);
+
+    connect(this, &Stored::compactChanged, this, [this]() {
+        Scheduler::getInstance()->submit(this, "Stored::compact", [this]() {
+            applyCompact();
+        });
+    });
+}
+
+Stored::~Stored()
+{
+    MemoryBudget::getInstance()->unpark(this);
+    Scheduler::getInstance()->cancel(this);
 }
 
 Source::Shared Stored::clone() const
@@ -42,6 +89,7 @@ Source::Shared Stored::clone() const
     cloned->setName(name());
     cloned->setInverse(inverse());
     cloned->setIgnoreCoherence(ignoreCoherence());
+    cloned->setCompact(compact());
     cloned->setPolarity(polarity());
     cloned->setDelay(delay());
     cloned->setGain(gain());
@@ -52,16 +100,233 @@ Source::Shared Stored::clone() const
 
 void Stored::build (Source::Abstract *source)
 {
-    source->lock();
-    m_dataLength = source->size();
-    m_deconvolutionSize = source->impulseSize();
-    m_ftdata.resize(m_dataLength);
-    m_impulseData.resize(m_deconvolutionSize);
-    source->copy(m_ftdata.data(), m_impulseData.data());
-    source->unlock();
+    source->pageIn();
+    {
+        //the snapshot is consistent and the source keeps working meanwhile
+        auto frame = source->frame();
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        m_dataLength = frame->size;
+        m_deconvolutionSize = frame->impulseSize;
+        m_ftdata = frame->ftdata;
+        m_impulseData = frame->impulseData;
+        m_backing.reset();
+        m_compactFrame.reset();
+        m_resident = true;
+        m_pageFailed = false;
+        ++m_dataVersion;
+        publish();
+    }
+    if (compact()) {
+        applyCompact();
+    }
+    emit readyRead();
+}
+
+void Stored::build(Frame &&frame)
+{
+    {
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        std::lock_guard<std::mutex> guard(m_dataMutex);
+        setFrame(std::move(frame));
+        m_backing.reset();
+        m_compactFrame.reset();
+        m_resident = true;
+        m_pageFailed = false;
+        ++m_dataVersion;
+    }
+    if (compact()) {
+        applyCompact();
+    }
     emit readyRead();
 }
 
+void Stored::pageIn()
+{
+    m_lastUse = clock::now().time_since_epoch().count();
+    bool loaded = false, failed = false;
+    QString fileName;
+    {
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        if (!m_resident) {
+            Frame frame;
+            if (m_compactFrame) {
+                std::lock_guard<std::mutex> guard(m_dataMutex);
+                decodeCompact();
+                loaded = true;
+            } else if (m_backing && readBacking(*m_backing, frame)) {
+                std::lock_guard<std::mutex> guard(m_dataMutex);
+                if (compact()) {
+                    //the compact copy is made once, readers get what it holds
+                    auto compactFrame = std::make_shared<Source::CompactFrame>();
+                    compactFrame->encode(frame);
+                    frame = {};
+                    m_compactFrame = compactFrame;
+                    decodeCompact();
+                } else {
+                    setFrame(std::move(frame));
+                }
+                loaded = true;
+            } else {
+                //the data and its file are kept, the next page in tries again
+                failed = !m_pageFailed;
+                m_pageFailed = true;
+                fileName = m_backing ? m_backing->fileName : QString();
+            }
+            if (loaded) {
+                m_resident = true;
+                m_pageFailed = false;
+            }
+        }
+    }
+    if (failed) {
+        qWarning() << "stored: couldn't page in" << name() << fileName;
+        emit Notifier::getInstance()->newMessage(name(), "couldn't read the data from " + fileName);
+    }
+    if (!active()) {
+        park();
+    }
+    if (loaded) {
+        emit readyRead();
+    }
+}
+
+void Stored::park()
+{
+    std::size_t bytes;
+    {
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        if (!m_resident) {
+            return;
+        }
+        bytes = m_ftdata.size() * (5 * sizeof(float) + sizeof(complex)) +
+                m_impulseData.size() * (sizeof(float) + sizeof(complex));
+    }
+    if (m_parked.exchange(true)) {
+        return;
+    }
+    MemoryBudget::getInstance()->park(this, bytes, [this]() {
+        //the budget is locked here: the data is dropped on a worker
+        m_parked = false;
+        Scheduler::getInstance()->submit(this, "Stored::pageOut", [this]() {
+            pageOut();
+        });
+    });
+}
+
+void Stored::pageOut()
+{
+    if (active()) {
+        return;
+    }
+    //data that a union or windowing still reads is kept till it is idle for a while
+    auto idle = clock::duration(clock::now().time_since_epoch().count() - m_lastUse);
+    if (idle < IDLE_TIME) {
+        Scheduler::getInstance()->submit(this, "Stored::pageOut", [this]() {
+            pageOut();
+        }, std::chrono::duration_cast<std::chrono::milliseconds>(IDLE_TIME - idle) + std::chrono::milliseconds(1));
+        return;
+    }
+
+    std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+    if (!m_resident || m_parked) {
+        return;
+    }
+    if (!m_backing) {
+        auto frame = this->frame();
+        m_backing = writeBacking([&frame](BinaryFile & file) {
+            return writeFrame(file, *frame);
+        });
+        if (!m_backing) {
+            qWarning() << "stored: couldn't page out" << name();
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> guard(m_dataMutex);
+    m_dataLength = 0;
+    m_deconvolutionSize = 0;
+    m_ftdata = {};
+    m_impulseData = {};
+    resetFramePool();
+    publish();
+    m_resident = false;
+}
+
+void Stored::applyCompact()
+{
+    bool changed = false, failed = false;
+    QString fileName;
+    {
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        if (compact() && m_resident && !m_compactFrame) {
+            //the full precision copy stays on disk till compact is turned off
+            auto full = frame();
+            if (!m_backing) {
+                m_backing = writeBacking([&full](BinaryFile & file) {
+                    return writeFrame(file, *full);
+                });
+            }
+            if (m_backing) {
+                auto compactFrame = std::make_shared<Source::CompactFrame>();
+                compactFrame->encode(*full);
+                full.reset();
+                m_compactFrame = compactFrame;
+
+                std::lock_guard<std::mutex> guard(m_dataMutex);
+                decodeCompact();
+                changed = true;
+            } else {
+                qWarning() << "stored: no full precision copy, not compacted" << name();
+            }
+        } else if (!compact() && m_compactFrame) {
+            //full precision is back from its copy on disk, paged out data reads it on page in
+            Frame restored;
+            if (!m_resident) {
+                m_compactFrame.reset();
+            } else if (readBacking(*m_backing, restored)) {
+                m_compactFrame.reset();
+                std::lock_guard<std::mutex> guard(m_dataMutex);
+                setFrame(std::move(restored));
+                changed = true;
+            } else {
+                //the compact data is kept
+                failed = true;
+                fileName = m_backing->fileName;
+            }
+        }
+    }
+    if (failed) {
+        qWarning() << "stored: couldn't restore full precision" << name() << fileName;
+        emit Notifier::getInstance()->newMessage(name(), "couldn't read the full precision data from " + fileName);
+    }
+    //paged out data is compacted when it's paged in
+    if (!active()) {
+        park();
+    }
+    if (changed) {
+        emit readyRead();
+    }
+}
+
+void Stored::decodeCompact()
+{
+    m_compactFrame->decode(m_ftdata, m_impulseData);
+    m_dataLength = m_compactFrame->size();
+    m_deconvolutionSize = m_compactFrame->impulseSize();
+    //frames of the full data are left to their readers only
+    resetFramePool();
+    publish();
+}
+
+void Stored::setFrame(Frame &&frame)
+{
+    m_dataLength = frame.size;
+    m_deconvolutionSize = frame.impulseSize;
+    m_ftdata = std::move(frame.ftdata);
+    m_impulseData = std::move(frame.impulseData);
+    publish();
+}
+
 void Stored::autoName(const QString &prefix) noexcept
 {
     auto time = QTime::currentTime();
@@ -78,33 +343,48 @@ QJsonObject Stored::toJSON(const SourceList *list) const noexcept
     object["polarity"]  = polarity();
     object["inverse"]   = inverse();
     object["icoherence"] = ignoreCoherence();
+    object["compact"]   = compact();
     object["delay"]     = delay();
     object["gain"]      = gain();
 
+    if (auto file = BinaryFile::current()) {
+        auto key = uuid().toString(QUuid::WithoutBraces) + "-" + QString::number(m_dataVersion.load());
+        object["columns"] = file->columns(key, [this](BinaryFile & target) {
+            return writeColumns(target);
+        });
+        return object;
+    }
+
+    auto pinned = fullFrame();
+    if (!pinned) {
+        return object;
+    }
+    const auto &spectrum = pinned->ftdata;
+
     QJsonArray ftdata;
-    for (unsigned int i = 0; i < m_dataLength; ++i) {
+    for (unsigned int i = 0; i < pinned->size; ++i) {
 
         //frequecy, module, magnitude, phase, coherence
         QJsonArray ftcell;
-        ftcell.append(static_cast<double>(m_ftdata[i].frequency  ));
-        ftcell.append(static_cast<double>(m_ftdata[i].module     ));
-        ftcell.append(static_cast<double>(m_ftdata[i].magnitude  ));
-        ftcell.append(static_cast<double>(m_ftdata[i].phase.arg()));
-        ftcell.append(static_cast<double>(m_ftdata[i].coherence  ));
-        ftcell.append(static_cast<double>(m_ftdata[i].peakSquared));
-        ftcell.append(static_cast<double>(m_ftdata[i].meanSquared));
+        ftcell.append(static_cast<double>(spectrum.frequency(i)  ));
+        ftcell.append(static_cast<double>(spectrum.module[i]     ));
+        ftcell.append(static_cast<double>(spectrum.magnitude[i]  ));
+        ftcell.append(static_cast<double>(spectrum.phase[i].arg()));
+        ftcell.append(static_cast<double>(spectrum.coherence[i]  ));
+        ftcell.append(static_cast<double>(spectrum.peakSquared[i]));
+        ftcell.append(static_cast<double>(spectrum.meanSquared[i]));
 
         ftdata.append(ftcell);
     }
     object["ftdata"] = ftdata;
 
     QJsonArray impulse;
-    for (unsigned int i = 0; i < m_deconvolutionSize; ++i) {
+    for (unsigned int i = 0; i < pinned->impulseSize; ++i) {
 
         //time, value
         QJsonArray impulsecell;
-        impulsecell.append(static_cast<double>(m_impulseData[i].time));
-        impulsecell.append(static_cast<double>(m_impulseData[i].value.real));
+        impulsecell.append(static_cast<double>(pinned->impulseData.time[i]));
+        impulsecell.append(static_cast<double>(pinned->impulseData.value[i].real));
         impulse.append(impulsecell);
     }
     object["impulse"] = impulse;
@@ -115,6 +395,68 @@ void Stored::fromJSON(QJsonObject data, const SourceList *list) noexcept
 {
     Source::Abstract::fromJSON(data, list);
 
+    {
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        m_backing.reset();
+        m_compactFrame.reset();
+        m_resident = true;
+        m_pageFailed = false;
+        ++m_dataVersion;
+        if (data.contains("columns")) {
+            //columns are copied to a private file, the data is paged in from it when it's needed first
+            auto file = BinaryFile::current();
+            auto columns = data["columns"].toObject();
+            Frame frame;
+            if (file) {
+                m_backing = writeBacking([file, &columns](BinaryFile & target) {
+                    QJsonObject copied;
+                    for (auto it = columns.constBegin(); it != columns.constEnd(); ++it) {
+                        auto column = file->column(it.value());
+                        copied[it.key()] = target.writeColumn(column.data(), column.size());
+                    }
+                    return copied;
+                });
+                //without a private copy the data is loaded at once
+                if (m_backing) {
+                    m_resident = false;
+                } else if (!readColumns(*file, columns, frame)) {
+                    qWarning() << "stored: couldn't read columns of" << name();
+                }
+            } else {
+                qWarning() << "stored: columns without a binary file in" << name();
+            }
+
+            std::lock_guard<std::mutex> guard(m_dataMutex);
+            setFrame(std::move(frame));
+        } else {
+            std::lock_guard<std::mutex> guard(m_dataMutex);
+            readArrays(data);
+            publish();
+        }
+    }
+
+    setPolarity(data["polarity"].toBool(false));
+    setInverse( data["inverse" ].toBool(false));
+    setIgnoreCoherence(data["icoherence"].toBool(false));
+    setCompact(data["compact"].toBool(false));
+    setDelay(data["delay"].toDouble(0));
+    setGain( data["gain" ].toDouble(0));
+    setNotes(data["notes"].toString());
+
+    if (compact()) {
+        Scheduler::getInstance()->submit(this, "Stored::compact", [this]() {
+            applyCompact();
+        });
+    }
+    if (active()) {
+        Scheduler::getInstance()->submit(this, "Stored::pageIn", [this]() {
+            pageIn();
+        });
+    }
+}
+
+void Stored::readArrays(const QJsonObject &data) noexcept
+{
     auto ftdata         = data["ftdata"].toArray();
     auto impulse        = data["impulse"].toArray();
 
@@ -123,40 +465,187 @@ void Stored::fromJSON(QJsonObject data, const SourceList *list) noexcept
     m_ftdata.resize(m_dataLength);
     m_impulseData.resize(m_deconvolutionSize);
 
+    std::vector<float> frequencies(m_dataLength, 0.f);
     for (int i = 0; i < ftdata.count(); i++) {
         auto row = ftdata[i].toArray();
-        if (row.count() > 0) m_ftdata[i].frequency    = static_cast<float>(row[0].toDouble());
-        if (row.count() > 1) m_ftdata[i].module       = static_cast<float>(row[1].toDouble());
-        if (row.count() > 2) m_ftdata[i].magnitude    = static_cast<float>(row[2].toDouble());
-        if (row.count() > 3) m_ftdata[i].phase.polar(   static_cast<float>(row[3].toDouble()));
-        if (row.count() > 4) m_ftdata[i].coherence    = static_cast<float>(row[4].toDouble());
-        if (row.count() > 5) m_ftdata[i].peakSquared  = static_cast<float>(row[5].toDouble());
-        if (row.count() > 6) m_ftdata[i].meanSquared  = static_cast<float>(row[6].toDouble());
+        if (row.count() > 0) frequencies[i]           = static_cast<float>(row[0].toDouble());
+        if (row.count() > 1) m_ftdata.module[i]       = static_cast<float>(row[1].toDouble());
+        if (row.count() > 2) m_ftdata.magnitude[i]    = static_cast<float>(row[2].toDouble());
+        if (row.count() > 3) m_ftdata.phase[i].polar(   static_cast<float>(row[3].toDouble()));
+        if (row.count() > 4) m_ftdata.coherence[i]    = static_cast<float>(row[4].toDouble());
+        if (row.count() > 5) m_ftdata.peakSquared[i]  = static_cast<float>(row[5].toDouble());
+        if (row.count() > 6) m_ftdata.meanSquared[i]  = static_cast<float>(row[6].toDouble());
     }
+    m_ftdata.axis = Source::Axis::fromValues(std::move(frequencies));
 
     for (int i = 0; i < impulse.count(); i++) {
         auto row = impulse[i].toArray();
-        m_impulseData[i].time    = static_cast<float>(row[0].toDouble());
-        m_impulseData[i].value   = static_cast<float>(row[1].toDouble());
+        m_impulseData.time[i]    = static_cast<float>(row[0].toDouble());
+        m_impulseData.value[i]   = static_cast<float>(row[1].toDouble());
     }
+}
 
-    setPolarity(data["polarity"].toBool(false));
-    setInverse( data["inverse" ].toBool(false));
-    setIgnoreCoherence(data["icoherence"].toBool(false));
-    setDelay(data["delay"].toDouble(0));
-    setGain( data["gain" ].toDouble(0));
-    setNotes(data["notes"].toString());
+QJsonObject Stored::writeColumns(BinaryFile &file) const noexcept
+{
+    //the project file never backs the data: the user may move or overwrite it
+    auto frame = fullFrame();
+    if (!frame) {
+        return {};
+    }
+    return writeFrame(file, *frame);
+}
+
+Source::Abstract::FrameShared Stored::fullFrame() const
+{
+    //the published frame is used as is, the source isn't locked meanwhile
+    BackingShared backing;
+    {
+        std::lock_guard<std::mutex> pageGuard(m_pageMutex);
+        if (m_resident && !m_compactFrame) {
+            return frame();
+        }
+        backing = m_backing;
+    }
+
+    //paged out or compact data is read from its file, it isn't paged in for it
+    auto loaded = std::make_shared<Frame>();
+    if (!backing || !readBacking(*backing, *loaded)) {
+        qWarning() << "stored: couldn't read the full data of" << name();
+        return {};
+    }
+    return loaded;
+}
+
+QJsonObject Stored::writeFrame(BinaryFile &file, const Frame &frame)
+{
+    auto &ftdata = frame.ftdata;
+    auto &impulseData = frame.impulseData;
+
+    //phase and impulse are kept as in the JSON rows: phase angle and real part
+    std::vector<float> phase(frame.size), impulse(frame.impulseSize);
+    for (unsigned int i = 0; i < frame.size; ++i) {
+        phase[i] = ftdata.phase[i].arg();
+    }
+    for (unsigned int i = 0; i < frame.impulseSize; ++i) {
+        impulse[i] = impulseData.value[i].real;
+    }
+
+    QJsonObject columns;
+    columns["frequency"]    = file.writeColumn(ftdata.axis ? ftdata.axis->data() : nullptr, frame.size);
+    columns["module"]       = file.writeColumn(ftdata.module.data(),        frame.size);
+    columns["magnitude"]    = file.writeColumn(ftdata.magnitude.data(),     frame.size);
+    columns["phase"]        = file.writeColumn(phase.data(),                frame.size);
+    columns["coherence"]    = file.writeColumn(ftdata.coherence.data(),     frame.size);
+    columns["peakSquared"]  = file.writeColumn(ftdata.peakSquared.data(),   frame.size);
+    columns["meanSquared"]  = file.writeColumn(ftdata.meanSquared.data(),   frame.size);
+    columns["impulseTime"]  = file.writeColumn(impulseData.time.data(),     frame.impulseSize);
+    columns["impulseValue"] = file.writeColumn(impulse.data(),              frame.impulseSize);
+    return columns;
+}
+
+Stored::BackingShared Stored::writeBacking(const std::function<QJsonObject(BinaryFile &)> &write)
+{
+    QDir folder(workingfolder::pagesPath());
+    if (workingfolder::pagesPath().isEmpty() || !folder.mkpath(".")) {
+        qWarning() << "stored: couldn't create" << workingfolder::pagesPath();
+        return {};
+    }
+
+    auto fileName = folder.filePath(QUuid::createUuid().toString(QUuid::WithoutBraces) + ".page");
+    BinaryFile file;
+    if (!file.create(fileName)) {
+        return {};
+    }
+    auto columns = write(file);
+    QJsonObject metadata;
+    metadata["type"] = "page";
+    if (!file.finish(metadata)) {
+        return {};
+    }
+
+    auto backing = std::make_shared<Backing>();
+    backing->fileName = fileName;
+    backing->columns = columns;
+    return backing;
+}
+
+Stored::Backing::~Backing()
+{
+    QFile::remove(fileName);
+}
+
+bool Stored::readBacking(const Backing &backing, Frame &frame)
+{
+    BinaryFile file;
+    return file.open(backing.fileName) && readColumns(file, backing.columns, frame);
+}
+
+bool Stored::readColumns(const BinaryFile &file, const QJsonObject &columns, Frame &frame)
+{
+    auto frequency  = file.column(columns["frequency"]);
+    auto phase      = file.column(columns["phase"]);
+    auto time       = file.column(columns["impulseTime"]);
+    auto value      = file.column(columns["impulseValue"]);
+    if (phase.size() != frequency.size() || value.size() != time.size()) {
+        return false;
+    }
+
+    auto &ftdata = frame.ftdata;
+    auto &impulseData = frame.impulseData;
+    frame.size = static_cast<unsigned int>(frequency.size());
+    frame.impulseSize = static_cast<unsigned int>(time.size());
+    ftdata.resize(frame.size);
+    impulseData.resize(frame.impulseSize);
+    ftdata.axis = Source::Axis::fromValues(std::vector<float>(frequency.begin(), frequency.end()));
+
+    auto copy = [&file, &columns](const char *name, std::vector<float> &dst) {
+        auto column = file.column(columns[name]);
+        if (column.size() != dst.size()) {
+            return false;
+        }
+        std::copy(column.begin(), column.end(), dst.begin());
+        return true;
+    };
+    if (!copy("module",      ftdata.module)      ||
+            !copy("magnitude",   ftdata.magnitude)   ||
+            !copy("coherence",   ftdata.coherence)   ||
+            !copy("peakSquared", ftdata.peakSquared) ||
+            !copy("meanSquared", ftdata.meanSquared) ||
+            !copy("impulseTime", impulseData.time)) {
+        return false;
+    }
+    for (unsigned int i = 0; i < frame.size; ++i) {
+        ftdata.phase[i].polar(phase[i]);
+    }
+    for (unsigned int i = 0; i < frame.impulseSize; ++i) {
+        impulseData.value[i] = value[i];
+    }
+    return true;
 }
 
 bool Stored::save(const QUrl &fileName) const noexcept
 {
-    QFile saveFile(fileName.toLocalFile());
+    auto path = fileName.toLocalFile();
+    QJsonObject object;
+    object["type"] = "stored";
+
+    if (QFileInfo(path).suffix().toLower() != "json") {
+        BinaryFile file;
+        if (!file.create(path)) {
+            return false;
+        }
+        {
+            BinaryFile::Scope scope(&file);
+            object["data"] = toJSON();
+        }
+        return file.finish(object);
+    }
+
+    QFile saveFile(path);
     if (!saveFile.open(QIODevice::WriteOnly)) {
         qWarning("Couldn't open save file.");
         return false;
     }
-    QJsonObject object;
-    object["type"] = "stored";
     object["data"] = toJSON();
 
     QJsonDocument document(object);
@@ -168,9 +657,8 @@ bool Stored::save(const QUrl &fileName) const noexcept
 }
 bool Stored::saveCal(const QUrl &fileName) const noexcept
 {
-    QFile saveFile(fileName.toLocalFile());
-    if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+    TextWriter out;
+    if (!out.open(fileName.toLocalFile())) {
         return false;
     }
 
@@ -185,8 +673,9 @@ bool Stored::saveCal(const QUrl &fileName) const noexcept
     float avg_coherence = 0;
     complex avg_phase = 0;
 
-    QTextStream out(&saveFile);
-    for (unsigned int i = 0; i < m_dataLength; ++i) {
+    const_cast<Stored *>(this)->pageIn();
+    lock();
+    for (unsigned int i = 0; i < size(); ++i) {
 
         ppo_frequency = frequency(i);
 
@@ -227,84 +716,91 @@ bool Stored::saveCal(const QUrl &fileName) const noexcept
         }
 
     }
-    saveFile.close();
-    return true;
+    unlock();
+    return out.close();
 }
 
 bool Stored::saveFRD(const QUrl &fileName) const noexcept
 {
-    QFile saveFile(fileName.toLocalFile());
-    if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+    TextWriter out;
+    if (!out.open(fileName.toLocalFile())) {
         return false;
     }
-    QTextStream out(&saveFile);
-    for (unsigned int i = 0; i < m_dataLength; ++i) {
+    const_cast<Stored *>(this)->pageIn();
+    lock();
+    for (unsigned int i = 0; i < size(); ++i) {
         auto m = magnitude(i);
-        auto p = m_ftdata[i].phase.arg() * 180.f / static_cast<float>(M_PI);
+        auto p = Source::Abstract::phase(i).arg() * 180.f / static_cast<float>(M_PI);
         if (std::isnormal(m) && std::isnormal(p)) {
-            out << m_ftdata[i].frequency << " " << m << " " << p << " " << coherence(i) << "\n";
+            out << frequency(i) << " " << m << " " << p << " " << coherence(i) << "\n";
         }
     }
-    saveFile.close();
-    return true;
+    unlock();
+    return out.close();
 }
 bool Stored::saveTXT(const QUrl &fileName) const noexcept
 {
-    QFile saveFile(fileName.toLocalFile());
-    if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+    TextWriter out;
+    if (!out.open(fileName.toLocalFile())) {
         return false;
     }
-    QTextStream out(&saveFile);
     out << "Created with Open Sound Meter\n\n";
 
-    for (unsigned int i = 0; i < m_dataLength; ++i) {
+    const_cast<Stored *>(this)->pageIn();
+    lock();
+    for (unsigned int i = 0; i < size(); ++i) {
         auto m = magnitude(i);
-        auto p = m_ftdata[i].phase.arg() * 180.f / static_cast<float>(M_PI);
+        auto p = Source::Abstract::phase(i).arg() * 180.f / static_cast<float>(M_PI);
         if (std::isnormal(m) && std::isnormal(p)) {
-            out << m_ftdata[i].frequency << "\t" << m << "\t" << p << "\t" << coherence(i) << "\n";
+            out << frequency(i) << "\t" << m << "\t" << p << "\t" << coherence(i) << "\n";
         } else {
-            out << m_ftdata[i].frequency << "\t*\t*\t" << coherence(i) << "\n";
+            out << frequency(i) << "\t*\t*\t" << coherence(i) << "\n";
         }
     }
-    saveFile.close();
-    return true;
+    unlock();
+    return out.close();
 }
 
 bool Stored::saveCSV(const QUrl &fileName) const noexcept
 {
-    QFile saveFile(fileName.toLocalFile());
-    if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+    TextWriter out;
+    if (!out.open(fileName.toLocalFile())) {
         return false;
     }
-    QTextStream out(&saveFile);
 
-    for (unsigned int i = 0; i < m_dataLength; ++i) {
+    const_cast<Stored *>(this)->pageIn();
+    lock();
+    for (unsigned int i = 0; i < size(); ++i) {
         auto m = magnitude(i);
-        auto p = m_ftdata[i].phase.arg() * 180.f / static_cast<float>(M_PI);
+        auto p = Source::Abstract::phase(i).arg() * 180.f / static_cast<float>(M_PI);
         if (std::isnormal(m) && std::isnormal(p)) {
-            out << m_ftdata[i].frequency << "," << m << "," << p << "," << coherence(i) << "\n";
+            out << frequency(i) << "," << m << "," << p << "," << coherence(i) << "\n";
         } else {
-            out << m_ftdata[i].frequency << ",*,*," << coherence(i) << "\n";
+            out << frequency(i) << ",*,*," << coherence(i) << "\n";
         }
     }
-    saveFile.close();
-    return true;
+    unlock();
+    return out.close();
 }
 
 bool Stored::saveWAV(const QUrl &fileName) const noexcept
 {
+    const_cast<Stored *>(this)->pageIn();
+    auto pinned = frame();
+    const auto &impulse = pinned->impulseData;
+    if (pinned->impulseSize < 3) {
+        qWarning() << "no impulse to save in" << name();
+        return false;
+    }
     WavFile file;
     QByteArray data;
-    data.resize(m_deconvolutionSize * 4);
+    data.resize(pinned->impulseSize * 4);
     auto dst = data.data();
-    for (unsigned int i = 0; i < m_deconvolutionSize; ++i, dst += 4) {
-        qToLittleEndian(m_impulseData[i].value.real, dst);
+    for (unsigned int i = 0; i < pinned->impulseSize; ++i, dst += 4) {
+        qToLittleEndian(impulse.value[i].real, dst);
     }
 
-    int sampleRate = std::round(10 / std::abs(m_impulseData[1].time - m_impulseData[2].time)) * 100;
+    int sampleRate = std::round(10 / std::abs(impulse.time[1] - impulse.time[2])) * 100;
     return file.save(fileName.toLocalFile(), sampleRate, data);
 }
 
@@ -346,3 +842,8 @@ float Stored::impulseValue(const unsigned int &i) const noexcept
 {
     return (polarity() ? -1 : 1) * Source::Abstract::impulseValue(i) * std::pow(10, gain() / 20.f);
 }
+
+Source::Abstract::Modifiers Stored::modifiers() const noexcept
+{
+    return {gain(), delay(), polarity(), inverse(), ignoreCoherence()};
+}
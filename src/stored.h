@@ -18,10 +18,30 @@
 #ifndef STORED_H
 #define STORED_H
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <QJsonObject>
 #include "source/source_abstract.h"
 #include "meta/metastored.h"
 
+class BinaryFile;
+namespace Source {
+class CompactFrame;
+}
+
+/**
+ * @brief The Stored class
+ * Hidden data is parked in the MemoryBudget and dropped when the budget is exceeded and the trace
+ * wasn't read for IDLE_TIME. It is paged out to a private file in the pages folder, never to
+ * the project: the user may move or overwrite that one. A trace loaded from a binary file copies
+ * its columns there and pages them in when it's made visible or read by another source.
+ * A compact trace publishes its data decoded from a quantised copy, which is kept when it's paged
+ * out. No full precision frame is kept in memory: it stays in the private file till compact is
+ * turned off, and projects are saved from it.
+ */
 class Stored: public Source::Abstract, public Meta::Stored
 {
     Q_OBJECT
@@ -29,13 +49,20 @@ class Stored: public Source::Abstract, public Meta::Stored
     Q_PROPERTY(bool polarity READ polarity WRITE setPolarity NOTIFY polarityChanged)
     Q_PROPERTY(bool inverse READ inverse WRITE setInverse NOTIFY inverseChanged)
     Q_PROPERTY(bool ignoreCoherence READ ignoreCoherence WRITE setIgnoreCoherence NOTIFY ignoreCoherenceChanged)
+    Q_PROPERTY(bool compact READ compact WRITE setCompact NOTIFY compactChanged)
     Q_PROPERTY(float gain READ gain WRITE setGain NOTIFY gainChanged)
     Q_PROPERTY(float delay READ delay WRITE setDelay NOTIFY delayChanged)
 
 public:
+    static constexpr std::chrono::milliseconds IDLE_TIME{10'000};
+
     explicit Stored(QObject *parent = nullptr);
+    ~Stored();
     Source::Shared clone() const override;
     void build (Source::Abstract *source);
+    //! takes the data of an imported frame
+    void build (Frame &&frame);
+    void pageIn() override;
 
     Q_INVOKABLE void autoName(const QString &prefix) noexcept;
 
@@ -56,14 +83,56 @@ public:
 
     float impulseTime(const unsigned int &i) const noexcept override;
     float impulseValue(const unsigned int &i) const noexcept override;
+    Modifiers modifiers() const noexcept override;
 
 signals:
     void notesChanged() override;
     void polarityChanged() override;
     void inverseChanged() override;
     void ignoreCoherenceChanged() override;
+    void compactChanged() override;
     void gainChanged() override;
     void delayChanged() override;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    //! private copy of the data in the pages folder, the file is removed with the last owner
+    struct Backing {
+        QString fileName;
+        QJsonObject columns;
+
+        Backing() = default;
+        Backing(const Backing &) = delete;
+        Backing &operator=(const Backing &) = delete;
+        ~Backing();
+    };
+    using BackingShared = std::shared_ptr<const Backing>;
+
+    void park();
+    void pageOut();
+    void applyCompact();
+    //! the data mutex is held by the caller
+    void decodeCompact();
+    void setFrame(Frame &&frame);
+    //! full precision data, also of a compact or paged out trace. nullptr if its file is broken
+    FrameShared fullFrame() const;
+    void readArrays(const QJsonObject &data) noexcept;
+    QJsonObject writeColumns(BinaryFile &file) const noexcept;
+    static QJsonObject writeFrame(BinaryFile &file, const Frame &frame);
+    static BackingShared writeBacking(const std::function<QJsonObject(BinaryFile &)> &write);
+    static bool readBacking(const Backing &backing, Frame &frame);
+    static bool readColumns(const BinaryFile &file, const QJsonObject &columns, Frame &frame);
+
+    //page state, locked before m_dataMutex. MemoryBudget calls must be made without it
+    mutable std::mutex m_pageMutex;
+    BackingShared m_backing;    //nullptr till the data is paged out
+    std::shared_ptr<const Source::CompactFrame> m_compactFrame;
+    bool m_resident;
+    bool m_pageFailed;          //the user is told once till the next successful page in
+    std::atomic<bool> m_parked;
+    std::atomic<clock::rep> m_lastUse;
+    std::atomic<quint64> m_dataVersion;     //changes with the data only, names its autosave chunk
 };
 
 #endif // STORED_H
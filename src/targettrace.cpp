@@ -49,6 +49,10 @@ TargetTrace::TargetTrace(Settings *settings, QObject *parent) : QObject(parent),
 {
     Q_ASSERT(!m_instance);
 
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        compile();
+    }
     loadSettings();
     m_instance = this;
 }
@@ -94,18 +98,28 @@ qreal TargetTrace::gain(unsigned int i) const
 
 void TargetTrace::setFrequency(unsigned int i, qreal value)
 {
-    if (!qFuzzyCompare(m_points[i].x(), value)) {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (qFuzzyCompare(m_points[i].x(), value)) {
+            return;
+        }
         m_points[i].setX(value);
-        emit changed();
+        compile();
     }
+    emit changed();
 }
 
 void TargetTrace::setGain(unsigned int i, qreal value)
 {
-    if (!qFuzzyCompare(m_points[i].y(), value)) {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (qFuzzyCompare(m_points[i].y(), value)) {
+            return;
+        }
         m_points[i].setY(value);
-        emit changed();
+        compile();
     }
+    emit changed();
 }
 
 qreal TargetTrace::width() const
@@ -205,6 +219,7 @@ void TargetTrace::setPreset(unsigned newPreset)
             m_points[i].setX(m_presets[m_preset].second[i].x());
             m_points[i].setY(m_presets[m_preset].second[i].y());
         }
+        compile();
         emit presetChanged(m_preset);
         emit changed();
     }
@@ -220,6 +235,36 @@ const std::vector<QPointF> &TargetTrace::points() const
     return m_points;
 }
 
+float TargetTrace::level(float frequency) const
+{
+    return m_table.value(frequency);
+}
+
+Source::CurveTable::Values TargetTrace::table(const Source::AxisShared &axis) const
+{
+    return m_table.sample(axis);
+}
+
+Source::CurveTable::Deviation TargetTrace::deviation(const Source::Shared &source, unsigned int ppo) const
+{
+    return m_table.deviation(source, ppo);
+}
+
+QVariantMap TargetTrace::deviationMap(const Source::Shared &source, int ppo) const
+{
+    if (ppo <= 0) {
+        return {};
+    }
+    return Source::CurveTable::toVariant(deviation(source, static_cast<unsigned int>(ppo)),
+                                         static_cast<float>(qAbs(m_width) / 2));
+}
+
+void TargetTrace::compile()
+{
+    //called with m_mutex locked
+    m_table.setPoints(m_points);
+}
+
 qreal TargetTrace::offset() const
 {
     return m_offset;
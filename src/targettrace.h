@@ -22,6 +22,7 @@
 #include <QColor>
 #include <QPointF>
 #include "common/settings.h"
+#include "source/curvetable.h"
 
 class TargetTrace : public QObject
 {
@@ -63,6 +64,14 @@ public:
 
     const std::vector<QPointF> &points() const;
 
+    //! the target in dB at the frequency
+    float level(float frequency) const;
+    //! the target on the bins of the axis, compiled once per grid and edit
+    Source::CurveTable::Values table(const Source::AxisShared &axis) const;
+    Source::CurveTable::Deviation deviation(const Source::Shared &source, unsigned int ppo) const;
+    //! deviation of the source from the target in 1/ppo octave bands, a band passes within the width
+    Q_INVOKABLE QVariantMap deviationMap(const Source::Shared &source, int ppo = 3) const;
+
     static const QList<std::pair<QString, std::vector<QPointF>>>    m_presets;
     QVariant getAvailablePresets() const;
 
@@ -83,6 +92,7 @@ signals:
 
 private:
     void loadSettings();
+    void compile();
 
     std::mutex m_mutex;
 
@@ -92,6 +102,7 @@ private:
     QColor m_color = "#8BC34A";
 
     std::vector<QPointF>    m_points;
+    Source::CurveTable      m_table;
     unsigned m_preset;
 
     Settings *m_settings = nullptr;
@@ -19,37 +19,117 @@
 #include "stored.h"
 #include "sourcelist.h"
 #include "notifier.h"
+#include "common/scheduler.h"
 #include <QJsonArray>
+#include <algorithm>
 #include <cmath>
+#if defined(Q_PROCESSOR_X86_64)
+#include "math/ssemath.h"
+#endif
+#if defined(Q_PROCESSOR_ARM)
+#include "armmath.h"
+#endif
 
-std::mutex Union::s_calcmutex = std::mutex();
+namespace {
+
+//! dst[i] += sign * x[i]
+void add(float *dst, const float *x, float sign, unsigned int count) noexcept
+{
+    unsigned int i = 0;
+#if defined(Q_PROCESSOR_X86_64) || defined(Q_PROCESSOR_ARM)
+    v4sf k = _mm_set1_ps(sign);
+    for (; i + 4 <= count; i += 4) {
+        v4sf value = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(k, _mm_loadu_ps(x + i)));
+        _mm_storeu_ps(dst + i, value);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += sign * x[i];
+    }
+}
+
+//! dst[i] += sign * x[i] * y[i]
+void multiplyAdd(float *dst, const float *x, const float *y, float sign, unsigned int count) noexcept
+{
+    unsigned int i = 0;
+#if defined(Q_PROCESSOR_X86_64) || defined(Q_PROCESSOR_ARM)
+    v4sf k = _mm_set1_ps(sign);
+    for (; i + 4 <= count; i += 4) {
+        v4sf product = _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i));
+        v4sf value = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(k, product));
+        _mm_storeu_ps(dst + i, value);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += sign * x[i] * y[i];
+    }
+}
+
+//! dst[i] *= x[i]
+void multiply(float *dst, const float *x, unsigned int count) noexcept
+{
+    unsigned int i = 0;
+#if defined(Q_PROCESSOR_X86_64) || defined(Q_PROCESSOR_ARM)
+    for (; i + 4 <= count; i += 4) {
+        v4sf value = _mm_mul_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(x + i));
+        _mm_storeu_ps(dst + i, value);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] *= x[i];
+    }
+}
+
+//! dst[i] *= k
+void scale(float *dst, float k, unsigned int count) noexcept
+{
+    unsigned int i = 0;
+#if defined(Q_PROCESSOR_X86_64) || defined(Q_PROCESSOR_ARM)
+    v4sf factor = _mm_set1_ps(k);
+    for (; i + 4 <= count; i += 4) {
+        v4sf value = _mm_mul_ps(_mm_loadu_ps(dst + i), factor);
+        _mm_storeu_ps(dst + i, value);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] *= k;
+    }
+}
+
+//! angle between both phases, the sign is taken from the imaginary parts
+void subtractPhase(float &re, float &im, float otherRe, float otherIm) noexcept
+{
+    auto p = re * otherRe + im * otherIm;
+    auto sign = (im - otherIm > 0 ? 1 : -1);
+    re = p / (std::sqrt(re * re + im * im) * std::sqrt(otherRe * otherRe + otherIm * otherIm));
+    im = sign * std::sqrt(1 - re * re);
+}
+
+} // namespace
 
 Union::Union(QObject *parent): Source::Abstract(parent),
     m_sources(2),
-    m_timer(nullptr), m_timerThread(nullptr),
     m_operation(Summation),
     m_type(Vector),
-    m_autoName(true)
+    m_autoName(true),
+    m_dirty(true), m_inputs(), m_aligned(), m_tables(), m_accumulator()
 {
     m_name = "Union";
     setObjectName(m_name);
 
-    m_timer.setInterval(80);//12.5 per sec
-    m_timer.setSingleShot(true);
-    m_timer.moveToThread(&m_timerThread);
     connect(this, &Union::operationChanged, &Union::applyAutoName);
     connect(this, &Union::typeChanged, &Union::applyAutoName);
-    connect(&m_timer, SIGNAL(timeout()), SLOT(calc()), Qt::DirectConnection);
-    connect(this, SIGNAL(needUpdate()), &m_timer, SLOT(start()));
-    connect(&m_timerThread, SIGNAL(finished()), &m_timer, SLOT(stop()), Qt::DirectConnection);
-    m_timerThread.start();
     init();
     applyAutoName();
 }
 Union::~Union()
 {
-    m_timerThread.quit();
-    m_timerThread.wait();
+    for (auto &source : m_sources) {
+        if (source) {
+            disconnect(source.get(), nullptr, this, nullptr);
+        }
+    }
+    Scheduler::getInstance()->cancel(this);
 }
 
 Source::Shared Union::clone() const
@@ -77,6 +157,7 @@ void Union::setCount(int count) noexcept
     std::lock_guard<std::mutex> guard(m_dataMutex);
     if (m_sources.count() != count) {
         m_sources.resize(count);
+        m_dirty = true;
         emit countChanged(count);
         update();
     }
@@ -85,6 +166,7 @@ void Union::setOperation(Operation operation) noexcept
 {
     if (m_operation != operation) {
         m_operation = operation;
+        m_dirty = true;
         update();
         emit operationChanged(m_operation);
     }
@@ -99,6 +181,7 @@ void Union::setActive(bool active) noexcept
         return;
     }
     Source::Abstract::setActive(active);
+    m_dirty = true;
     update();
 }
 Union::Type Union::type() const
@@ -109,21 +192,28 @@ void Union::setType(Type type)
 {
     if (m_type != type) {
         m_type = type;
+        m_dirty = true;
         emit typeChanged();
         update();
     }
 }
 void Union::init() noexcept
 {
+    Source::Abstract::FrameShared frame;
+    auto primary = m_sources.first();
+    if (primary) {
+        primary->pageIn();
+        frame = primary->frame();
+    }
     std::lock_guard<std::mutex> guard(m_dataMutex);
-    resize();
+    resize(frame ? frame->size : 1, frame ? frame->impulseSize : 1);
+    m_ftdata.axis = frame ? frame->ftdata.axis : Source::AxisShared{};
 }
 
-void Union::resize()
+void Union::resize(unsigned int size, unsigned int impulseSize)
 {
-    auto primary = m_sources.first();
-    m_dataLength         = static_cast<unsigned int>(primary ? primary->size() : 1);
-    m_deconvolutionSize = static_cast<unsigned int>(primary ? primary->impulseSize() : 1);
+    m_dataLength         = size;
+    m_deconvolutionSize = impulseSize;
     m_ftdata.resize(m_dataLength);
     m_impulseData.resize(m_deconvolutionSize);
 }
@@ -160,7 +250,11 @@ bool Union::setSource(int index, const Source::Shared &s) noexcept
         if (m_sources[index]) {
             disconnect(m_sources[index].get(), &Source::Abstract::readyRead, this, &Union::update);
         }
-        m_sources.replace(index, s);
+        {
+            std::lock_guard<std::mutex> guard(m_dataMutex);
+            m_sources.replace(index, s);
+        }
+        m_dirty = true;
         if (index == 0)
             init();
 
@@ -176,471 +270,615 @@ bool Union::setSource(int index, const Source::Shared &s) noexcept
 
 void Union::update() noexcept
 {
-    if (!m_timer.isActive()) {
-        emit needUpdate();
-    }
+    //updates of sources are collected for 80 ms: 12.5 per sec
+    Scheduler::getInstance()->submit(this, "Union::calc", [this]() {
+        calc();
+    }, std::chrono::milliseconds(80));
 }
 
 void Union::calc() noexcept
 {
-    std::set<Source::Shared> sources;
-
     if (!active())
         return;
 
-    std::lock_guard<std::mutex> callGuard(s_calcmutex);
-    std::lock_guard<std::mutex> guard(m_dataMutex);
+    //setActive emits and submits a new calc: it is called with the data mutex released
+    std::unique_lock<std::mutex> lock(m_dataMutex);
     auto primary = m_sources.first();
-    unsigned int count = 0;
-
     if (!primary) {
+        lock.unlock();
         setActive(false);
         return;
     }
 
-    if (primary->size() != size()) {
-        resize();
+    if (m_dirty.exchange(false)) {
+        for (auto &input : m_inputs) {
+            input.source = nullptr;
+        }
     }
-
-    for (auto &s : m_sources) {
-        if (s) {
-            sources.insert(s);
-            if (s->size() != primary->size()) {
-                if (0/*can resize*/) {
-                    //resize
-                } else {
-                    setActive(false);
-                    emit Notifier::getInstance()->newMessage(name(),
-                                                             " Sources must have the same window size and sample rate: " + s->name());
-                    return;
-                }
-            }
-            count ++;
+    m_inputs.resize(m_sources.count());
+    m_aligned.resize(m_sources.count());
+    m_tables.resize(m_sources.count());
+
+    //each source is pinned only while its frame is copied
+    bool changed = false;
+    for (int i = 0; i < m_sources.count(); ++i) {
+        if (m_sources[i]) {
+            changed |= gather(m_inputs[i], m_sources[i]);
         }
     }
-    if (count < 2) {
-        setActive(false);
+    if (!changed) {
         return;
     }
 
-    //lock each unique source, prevent deadlock
-    for (auto &s : sources) {
-        if (s && s.get() != this) s->lock();
+    auto &first = m_inputs.front();
+    if (first.size != m_dataLength || first.impulseSize != m_deconvolutionSize) {
+        resize(first.size, first.impulseSize);
     }
+    m_ftdata.axis = first.axis;
 
-    if (m_operation == Apply) {
-        calcApply(primary);
-    } else {
-        switch (m_type) {
-        case Vector:
-            calcVector(count, primary);
-            break;
-        case Polar:
-            calcPolar(count, primary);
-            break;
-        case dB:
-            calcdB(count, primary);
-            break;
-        case Power:
-            calcPower(count, primary);
-            break;
+    Inputs inputs;
+    inputs.reserve(m_sources.count());
+    for (int i = 0; i < m_sources.count(); ++i) {
+        if (m_sources[i]) {
+            inputs.push_back(i == 0 ? &first : align(m_inputs[i], first, m_tables[i], m_aligned[i]));
         }
     }
+    if (inputs.size() < 2) {
+        lock.unlock();
+        setActive(false);
+        return;
+    }
 
-    for (auto &s : sources) {
-        if (s) s->unlock();
+    if (m_operation == Apply) {
+        calcApply(inputs);
+    } else if (m_type == Vector) {
+        calcVector(inputs);
+    } else {
+        calcScalar(inputs);
     }
+
+    publish();
     emit readyRead();
 }
-void Union::calcPolar(unsigned int count, const Source::Shared &primary) noexcept
-{
-    float magnitude, module, coherence, coherenceWeight;
-    complex phase;
-
-    for (unsigned int i = 0; i < primary->size(); i++) {
-        magnitude = primary->magnitudeRaw(i);
-        phase = primary->phase(i);
-        module = primary->module(i);
-        coherence = std::abs(primary->module(i) * primary->coherence(i));
-        coherenceWeight = std::abs(primary->module(i));
-
-        for (auto it = m_sources.begin(); it != m_sources.end(); ++it) {
-            if (*it && it != m_sources.begin()) {
-                switch (m_operation) {
-                case Summation:
-                case Avg:
-                    magnitude += (*it)->magnitudeRaw(i);
-                    phase += (*it)->phase(i);
-                    module += (*it)->module(i);
-                    break;
-                case Diff:
-                case Subtract: {
-                    magnitude = std::abs(magnitude - (*it)->magnitudeRaw(i));
-                    auto p = phase.real * (*it)->phase(i).real + phase.imag * (*it)->phase(i).imag;
-                    auto sign = (phase.imag - (*it)->phase(i).imag > 0 ? 1 : -1);
-                    phase.real = p / (phase.abs() * (*it)->phase(i).abs());
-                    phase.imag = sign * std::sqrt(1 - phase.real * phase.real);
-                    module -= (*it)->module(i);
-                }
-                break;
-                case Min:
-                    magnitude = std::min(magnitude, (*it)->magnitudeRaw(i));
-                    module = std::min(module, (*it)->module(i));
-                    phase.polar(std::min(phase.arg(), (*it)->phase(i).arg()));
-                    break;
-                case Max:
-                    magnitude = std::max(magnitude, (*it)->magnitudeRaw(i));
-                    module = std::max(module, (*it)->module(i));
-                    phase.polar(std::max(phase.arg(), (*it)->phase(i).arg()));
-                    break;
-                case Apply:
-                    Q_ASSERT(false);
-                    break;
-                }
 
-                coherence += std::abs((*it)->module(i) * (*it)->coherence(i));
-                coherenceWeight += std::abs((*it)->module(i));
-            }
-        }
-        if (m_operation == Avg) {
-            magnitude /= count;
-            phase /= count;
-            module /= count;
-        }
-        if (m_operation == Diff) {
-            magnitude = std::abs(magnitude);
-            phase.polar(std::abs(phase.arg()));
-            module = std::abs(module);
+bool Union::gather(Input &input, const Source::Shared &source)
+{
+    source->pageIn();
+    source->lock();
+    auto version = source->pinnedVersion();
+    if (input.source == source.get() && input.version == version) {
+        source->unlock();
+        return false;
+    }
+    input.source = source.get();
+    input.version = version;
+    input.size = source->size();
+    input.impulseSize = source->impulseSize();
+    input.axis = source->axis();
+    input.grid = input.axis ? input.axis->id() : 0;
+
+    for (auto *data : {
+                &input.frequency, &input.module, &input.magnitudeRaw, &input.magnitude,
+                &input.coherence, &input.peakSquared, &input.phaseRe, &input.phaseIm
+            }) {
+        data->resize(input.size);
+    }
+    //published columns are copied at once, modifiers of the source are applied in one pass per column
+    const auto modifiers = source->modifiers();
+
+    auto frequencies = source->frequencyColumn();
+    auto modules = source->moduleColumn();
+    auto magnitudes = source->magnitudeColumn();
+    auto phases = source->phaseColumn();
+    auto coherences = source->coherenceColumn();
+    auto peaks = source->peakSquaredColumn();
+    std::fill(std::copy(frequencies.begin(), frequencies.end(), input.frequency.begin()), input.frequency.end(), 0.f);
+    std::copy(peaks.begin(), peaks.end(), input.peakSquared.begin());
+
+    const auto size = input.size;
+    const float gain = std::pow(10.f, modifiers.gain / 20.f);
+    for (unsigned int i = 0; i < size; ++i) {
+        input.module[i] = modules[i] * gain;
+    }
+
+    const float sign = modifiers.inverse ? -1.f : 1.f;
+    for (unsigned int i = 0; i < size; ++i) {
+        input.magnitude[i] = sign * (20.f * log10f(magnitudes[i]) + modifiers.gain);
+    }
+    if (modifiers.inverse) {
+        for (unsigned int i = 0; i < size; ++i) {
+            input.magnitudeRaw[i] = gain / magnitudes[i];
         }
-        coherence /= coherenceWeight;
-        if (std::isnan(phase.real) || std::isnan(phase.imag)) {
-            phase = {1, 0};
+    } else {
+        for (unsigned int i = 0; i < size; ++i) {
+            input.magnitudeRaw[i] = magnitudes[i] * gain;
         }
+    }
 
-        m_ftdata[i].frequency  = primary->frequency(i);
-        m_ftdata[i].module     = module;
-        m_ftdata[i].phase      = phase.normalize();
-        m_ftdata[i].magnitude  = magnitude;
-        m_ftdata[i].coherence  = coherence;
-    }
-
-    for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-        m_impulseData[i].time = primary->impulseTime(i);
-        m_impulseData[i].value = NAN;
-    }
-}
-void Union::calcVector(unsigned int count, const Source::Shared &primary) noexcept
-{
-    float coherence, coherenceWeight;
-    complex a, m, p;
-
-    for (unsigned int i = 0; i < primary->size(); i++) {
-        a = primary->phase(i) * primary->module(i);
-        p = primary->phase(i) * primary->peakSquared(i);
-        m = primary->phase(i) * primary->magnitudeRaw(i);
-
-        coherence = std::abs(primary->module(i) * primary->coherence(i));
-        coherenceWeight = std::abs(primary->module(i));
-
-        for (auto it = m_sources.begin(); it != m_sources.end(); ++it) {
-            if (*it && it != m_sources.begin()) {
-                switch (m_operation) {
-                case Summation:
-                case Avg:
-                    a += (*it)->phase(i) * (*it)->module(i);
-                    p += (*it)->phase(i) * (*it)->peakSquared(i);
-                    m += (*it)->phase(i) * (*it)->magnitudeRaw(i);
-                    break;
-                case Diff:
-                case Subtract:
-                    a -= (*it)->phase(i) * (*it)->module(i);
-                    p -= (*it)->phase(i) * (*it)->peakSquared(i);
-                    m -= (*it)->phase(i) * (*it)->magnitudeRaw(i);
-                    break;
-                case Max:
-                    a = std::max(a, (*it)->phase(i) * (*it)->module(i));
-                    p = std::max(p, (*it)->phase(i) * (*it)->peakSquared(i));
-                    m = std::max(m, (*it)->phase(i) * (*it)->magnitudeRaw(i));
-                    break;
-                case Min:
-                    a = std::min(a, (*it)->phase(i) * (*it)->module(i));
-                    p = std::min(p, (*it)->phase(i) * (*it)->peakSquared(i));
-                    m = std::min(m, (*it)->phase(i) * (*it)->magnitudeRaw(i));
-                    break;
-                case Apply: //work in calcApply
-                    Q_ASSERT(false);
-                    break;
-                }
+    if (modifiers.ignoreCoherence) {
+        std::fill(input.coherence.begin(), input.coherence.end(), 1.f);
+    } else {
+        std::copy(coherences.begin(), coherences.end(), input.coherence.begin());
+    }
 
-                coherence       += std::abs((*it)->module(i) * (*it)->coherence(i));
-                coherenceWeight += std::abs((*it)->module(i));
-            }
+    if (modifiers.delay == 0.f) {
+        const float polarity = modifiers.polarity ? -1.f : 1.f;
+        for (unsigned int i = 0; i < size; ++i) {
+            input.phaseRe[i] = polarity * phases[i].real;
+            input.phaseIm[i] = polarity * phases[i].imag;
         }
-        if (m_operation == Avg) {
-            a /= count;
-            p /= count;
-            m /= count;
+    } else {
+        //as Stored::phase: rotated by the polarity and the delay in ms
+        const float base = modifiers.polarity ? static_cast<float>(M_PI) : 0.f;
+        const float k = -2.f * static_cast<float>(M_PI) * modifiers.delay / 1000.f;
+        for (unsigned int i = 0; i < size; ++i) {
+            float alpha = base + k * input.frequency[i];
+            float c = std::cos(alpha), s = std::sin(alpha);
+            input.phaseRe[i] = phases[i].real * c - phases[i].imag * s;
+            input.phaseIm[i] = phases[i].real * s + phases[i].imag * c;
         }
-        coherence /= coherenceWeight;
-
-        m_ftdata[i].frequency  = primary->frequency(i);
-        m_ftdata[i].module     = a.abs();
-        m_ftdata[i].phase      = m.normalize();
-        m_ftdata[i].magnitude  = m.abs();
-        m_ftdata[i].coherence  = coherence;
-        m_ftdata[i].peakSquared = p.abs();
     }
 
-    if (primary->impulseSize() < 2) {
-        return;
+    auto times = source->impulseTimeColumn();
+    auto values = source->impulseValueColumn();
+    input.impulseTime.resize(input.impulseSize);
+    input.impulseValue.resize(input.impulseSize);
+    const float impulseGain = (modifiers.polarity ? -1.f : 1.f) * gain;
+    for (unsigned int i = 0; i < input.impulseSize; ++i) {
+        input.impulseTime[i]  = times[i] + modifiers.delay;
+        input.impulseValue[i] = values[i].real * impulseGain;
     }
+    source->unlock();
+    return true;
+}
 
-    for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-        m_impulseData[i].time = primary->impulseTime(i);
-        m_impulseData[i].value = primary->impulseValue(i);
+const Union::Input *Union::align(const Input &input, const Input &primary, Table &table, Input &aligned)
+{
+    if (input.grid == primary.grid && input.size == primary.size) {
+        return &input;
     }
-    float dt = m_impulseData[1].time - m_impulseData[0].time;
 
-    for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-        for (auto it = m_sources.begin(); it != m_sources.end(); ++it) {
-            if (!(*it)) {
+    const auto &source = input.frequency;
+    const auto &target = primary.frequency;
+    const auto size = primary.size;
+    const bool rebuild = (table.from != input.grid || table.to != primary.grid || table.taps.size() != size);
+    if (rebuild) {
+        table.from = input.grid;
+        table.to = primary.grid;
+        table.taps.resize(size);
+
+        auto position = [](float frequency) {
+            return frequency > 0 ? std::log(frequency) : 0.f;
+        };
+        const auto last = static_cast<unsigned int>(input.size ? input.size - 1 : 0);
+        for (unsigned int i = 0; i < size; ++i) {
+            auto &tap = table.taps[i];
+            tap = {};
+
+            //band of the target bin: between geometric midpoints to the neighbours
+            float low  = i > 0        ? std::sqrt(target[i - 1] * target[i]) : target[i];
+            float high = i + 1 < size ? std::sqrt(target[i] * target[i + 1]) : target[i];
+            auto from = static_cast<unsigned int>(std::lower_bound(source.cbegin(), source.cend(), low) - source.cbegin());
+            auto to   = static_cast<unsigned int>(std::lower_bound(source.cbegin(), source.cend(), high) - source.cbegin());
+            if (to > from + 1) {
+                tap.from = from;
+                tap.to = to;
+                tap.band = true;
                 continue;
             }
-            float st = (*it)->impulseTime(i);
-            long offseted =  (long)i + (st - m_impulseData[i].time) / dt;
-
-            if (*it && it != m_sources.begin() && offseted > 0 && offseted < impulseSize()) {
-                switch (m_operation) {
-                case Summation:
-                case Avg:
-                    m_impulseData[offseted].value += (*it)->impulseValue(i);
-                    break;
-                case Subtract:
-                case Diff:
-                    m_impulseData[offseted].value -= (*it)->impulseValue(i);
-                    break;
-                case Min:
-                    m_impulseData[offseted].value = std::min(m_impulseData[offseted].value, complex{(*it)->impulseValue(i)});
-                    break;
-                case Max:
-                    m_impulseData[offseted].value = std::max(m_impulseData[offseted].value, complex{(*it)->impulseValue(i)});
-                    break;
-                case Apply:
-                    //calculated in calcApply
-                    Q_ASSERT(false);
-                    break;
-                }
+
+            auto upper = static_cast<unsigned int>(std::upper_bound(source.cbegin(), source.cend(), target[i]) - source.cbegin());
+            if (!input.size || upper == 0 || upper > last) {
+                tap.from = tap.to = (upper == 0 ? 0 : last);
+                tap.outside = (!input.size || target[i] < source.front() || target[i] > source.back());
+                continue;
             }
+            tap.from = upper - 1;
+            tap.to = upper;
+            auto span = position(source[tap.to]) - position(source[tap.from]);
+            tap.weight = span > 0 ? (position(target[i]) - position(source[tap.from])) / span : 0.f;
         }
-
     }
 
-    if (m_operation == Avg) {
-        for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-            m_impulseData[i].value /= count;
-        }
-    }
-}
-
-void Union::calcdB(unsigned int count, const Source::Shared &primary) noexcept
-{
-    float magnitude, module, coherence, coherenceWeight;
-    complex phase;
-
-    for (unsigned int i = 0; i < primary->size(); i++) {
-        magnitude = primary->magnitude(i);
-        phase = primary->phase(i);
-        module = 20.f * std::log10((primary)->module(i));
-        coherence = std::abs(primary->module(i) * primary->coherence(i));
-        coherenceWeight = std::abs(primary->module(i));
-
-        for (auto it = m_sources.begin(); it != m_sources.end(); ++it) {
-            if (*it && it != m_sources.begin()) {
-                switch (m_operation) {
-                case Summation:
-                case Avg:
-                    magnitude += (*it)->magnitude(i);
-                    phase += (*it)->phase(i);
-                    module += 20.f * std::log10((*it)->module(i));
-                    break;
-                case Diff:
-                case Subtract: {
-                    magnitude -= (*it)->magnitude(i);
-                    auto p = phase.real * (*it)->phase(i).real + phase.imag * (*it)->phase(i).imag;
-                    auto sign = (phase.imag - (*it)->phase(i).imag > 0 ? 1 : -1);
-                    phase.real = p / (phase.abs() * (*it)->phase(i).abs());
-                    phase.imag = sign * std::sqrt(1 - phase.real * phase.real);
-                    module -= 20.f * std::log10((*it)->module(i));
-                }
-                break;
-                case Min:
-                    magnitude = std::min(magnitude, (*it)->magnitude(i));
-                    module = std::min(module, 20.f * std::log10((*it)->module(i)));
-                    phase.polar(std::min(phase.arg(), (*it)->phase(i).arg()));
-                    break;
-                case Max:
-                    magnitude = std::max(magnitude, (*it)->magnitude(i));
-                    module = std::max(module, 20.f * std::log10((*it)->module(i)));
-                    phase.polar(std::max(phase.arg(), (*it)->phase(i).arg()));
-                    break;
-                case Apply:
-                    Q_ASSERT(false);
-                    break;
-                }
+    //the input frame and the table are unchanged: the aligned copy is still valid
+    if (!rebuild && aligned.source == input.source && aligned.version == input.version) {
+        return &aligned;
+    }
+    aligned.source = input.source;
+    aligned.version = input.version;
+    aligned.axis = primary.axis;
+    aligned.grid = primary.grid;
+    aligned.size = size;
+    aligned.impulseSize = input.impulseSize;
+    aligned.impulseTime = input.impulseTime;
+    aligned.impulseValue = input.impulseValue;
+    aligned.frequency = target;
+    for (auto *data : {
+                &aligned.module, &aligned.magnitudeRaw, &aligned.magnitude,
+                &aligned.coherence, &aligned.peakSquared, &aligned.phaseRe, &aligned.phaseIm
+            }) {
+        data->assign(size, 0.f);
+    }
+    if (!input.size) {
+        return &aligned;
+    }
 
-                coherence       += std::abs((*it)->module(i) * (*it)->coherence(i));
-                coherenceWeight += std::abs((*it)->module(i));
+    for (unsigned int i = 0; i < size; ++i) {
+        auto &tap = table.taps[i];
+        if (tap.band) {
+            //coherence weighted: power for levels, vector for the phase
+            float total = 0, module = 0, magnitude = 0, level = 0, peak = 0, coherence = 0, re = 0, im = 0;
+            for (auto j = tap.from; j < tap.to; ++j) {
+                auto weight = std::max(input.coherence[j], 1e-6f);
+                total     += weight;
+                module    += weight * input.module[j] * input.module[j];
+                magnitude += weight * input.magnitudeRaw[j] * input.magnitudeRaw[j];
+                level     += weight * input.magnitude[j];
+                peak      += weight * input.peakSquared[j];
+                coherence += weight * input.coherence[j];
+                re        += weight * input.phaseRe[j];
+                im        += weight * input.phaseIm[j];
             }
+            aligned.module[i]       = std::sqrt(module / total);
+            aligned.magnitudeRaw[i] = std::sqrt(magnitude / total);
+            aligned.magnitude[i]    = level / total;
+            aligned.peakSquared[i]  = peak / total;
+            aligned.coherence[i]    = coherence / total;
+            auto norm = std::sqrt(re * re + im * im);
+            aligned.phaseRe[i] = norm > 0 ? re / norm : 1.f;
+            aligned.phaseIm[i] = norm > 0 ? im / norm : 0.f;
+            continue;
         }
-        if (m_operation == Diff) {
-            magnitude = std::abs(magnitude);
-            phase.polar(std::abs(phase.arg()));
-            module = std::abs(module);
-        }
-        if (m_operation == Avg) {
-            magnitude /= count;
-            phase /= count;
-            module /= count;
-        }
-        coherence /= coherenceWeight;
-        if (std::isnan(phase.real) || std::isnan(phase.imag)) {
-            phase = {1, 0};
-        }
-
-        magnitude = std::pow(10, magnitude / 20.f);
-        module    = std::pow(10, module / 20.f);
 
-        m_ftdata[i].frequency  = primary->frequency(i);
-        m_ftdata[i].module     = module;
-        m_ftdata[i].phase      = phase.normalize();
-        m_ftdata[i].magnitude  = magnitude;
-        m_ftdata[i].coherence  = coherence;
+        //levels are interpolated in the log domain, the phase as a vector
+        auto a = tap.from, b = tap.to;
+        auto w = tap.weight;
+        aligned.module[i]       = std::pow(input.module[a], 1 - w) * std::pow(input.module[b], w);
+        aligned.magnitudeRaw[i] = std::pow(input.magnitudeRaw[a], 1 - w) * std::pow(input.magnitudeRaw[b], w);
+        aligned.peakSquared[i]  = std::pow(input.peakSquared[a], 1 - w) * std::pow(input.peakSquared[b], w);
+        aligned.magnitude[i]    = (1 - w) * input.magnitude[a] + w * input.magnitude[b];
+        aligned.coherence[i]    = tap.outside ? 0.f : (1 - w) * input.coherence[a] + w * input.coherence[b];
+
+        auto re = (1 - w) * input.phaseRe[a] + w * input.phaseRe[b];
+        auto im = (1 - w) * input.phaseIm[a] + w * input.phaseIm[b];
+        auto norm = std::sqrt(re * re + im * im);
+        aligned.phaseRe[i] = norm > 0 ? re / norm : input.phaseRe[a];
+        aligned.phaseIm[i] = norm > 0 ? im / norm : input.phaseIm[a];
     }
+    return &aligned;
+}
 
-    for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-        m_impulseData[i].time = primary->impulseTime(i);
-        m_impulseData[i].value = NAN;
+void Union::calcCoherence(const Inputs &inputs) noexcept
+{
+    auto &acc = m_accumulator;
+    const auto size = inputs.front()->size;
+    acc.coherence.assign(size, 0.f);
+    acc.weight.assign(size, 0.f);
+    for (auto input : inputs) {
+        for (unsigned int i = 0; i < size; ++i) {
+            acc.coherence[i] += std::abs(input->module[i] * input->coherence[i]);
+            acc.weight[i]    += std::abs(input->module[i]);
+        }
+    }
+    for (unsigned int i = 0; i < size; ++i) {
+        acc.coherence[i] /= acc.weight[i];
     }
 }
 
-void Union::calcPower(unsigned int count, const Source::Shared &primary) noexcept
+void Union::calcScalar(const Inputs &inputs) noexcept
 {
-    float magnitude, module, coherence, coherenceWeight;
-    complex phase;
-
-    for (unsigned int i = 0; i < primary->size(); i++) {
-        magnitude = std::pow(primary->magnitudeRaw(i), 2);
-        phase = primary->phase(i);
-        module = std::pow((primary)->module(i), 2);
-        coherence = std::abs(primary->module(i) * primary->coherence(i));
-        coherenceWeight = std::abs(primary->module(i));
+    auto &primary = *inputs.front();
+    auto &acc = m_accumulator;
+    const auto size = primary.size;
+    const auto count = static_cast<float>(inputs.size());
+
+    //magnitude and module of the input in the domain of the union type
+    auto load = [this, size](const Input & input, std::vector<float> &magnitude, std::vector<float> &module) {
+        magnitude.resize(size);
+        module.resize(size);
+        switch (m_type) {
+        case dB:
+            for (unsigned int i = 0; i < size; ++i) {
+                magnitude[i] = input.magnitude[i];
+                module[i] = 20.f * std::log10(input.module[i]);
+            }
+            break;
+        case Power:
+            for (unsigned int i = 0; i < size; ++i) {
+                magnitude[i] = input.magnitudeRaw[i] * input.magnitudeRaw[i];
+                module[i] = input.module[i] * input.module[i];
+            }
+            break;
+        default:
+            std::copy_n(input.magnitudeRaw.cbegin(), size, magnitude.begin());
+            std::copy_n(input.module.cbegin(), size, module.begin());
+        }
+    };
 
-        for (auto it = m_sources.begin(); it != m_sources.end(); ++it) {
-            if (*it && it != m_sources.begin()) {
-                switch (m_operation) {
-                case Summation:
-                case Avg:
-                    magnitude += std::pow((*it)->magnitudeRaw(i), 2);
-                    phase += (*it)->phase(i);
-                    module += std::pow((*it)->module(i), 2);
-                    break;
-                case Diff:
-                case Subtract: {
-                    magnitude -= std::pow((*it)->magnitudeRaw(i), 2);
-                    auto p = phase.real * (*it)->phase(i).real + phase.imag * (*it)->phase(i).imag;
-                    auto sign = (phase.imag - (*it)->phase(i).imag > 0 ? 1 : -1);
-                    phase.real = p / (phase.abs() * (*it)->phase(i).abs());
-                    phase.imag = sign * std::sqrt(1 - phase.real * phase.real);
-                    module -= std::pow((*it)->module(i), 2);
-                }
-                break;
-                case Min:
-                    magnitude = std::min(magnitude, powf((*it)->magnitudeRaw(i), 2));
-                    module = std::min(module, powf((*it)->module(i), 2));
-                    phase.polar(std::min(phase.arg(), (*it)->phase(i).arg()));
-                    break;
-                case Max:
-                    magnitude = std::max(magnitude, powf((*it)->magnitudeRaw(i), 2));
-                    module = std::max(module, powf((*it)->module(i), 2));
-                    phase.polar(std::max(phase.arg(), (*it)->phase(i).arg()));
-                    break;
-                case Apply:
-                    Q_ASSERT(false);
-                    break;
+    load(primary, acc.magnitude, acc.module);
+    acc.re = primary.phaseRe;
+    acc.im = primary.phaseIm;
+
+    for (auto it = std::next(inputs.cbegin()); it != inputs.cend(); ++it) {
+        auto &input = **it;
+        load(input, acc.inputMagnitude, acc.inputModule);
+
+        switch (m_operation) {
+        case Summation:
+        case Avg:
+            add(acc.magnitude.data(), acc.inputMagnitude.data(), 1.f, size);
+            add(acc.module.data(),    acc.inputModule.data(),    1.f, size);
+            add(acc.re.data(),        input.phaseRe.data(),      1.f, size);
+            add(acc.im.data(),        input.phaseIm.data(),      1.f, size);
+            break;
+        case Diff:
+        case Subtract:
+            if (m_type == Polar) {
+                for (unsigned int i = 0; i < size; ++i) {
+                    acc.magnitude[i] = std::abs(acc.magnitude[i] - acc.inputMagnitude[i]);
                 }
+            } else {
+                add(acc.magnitude.data(), acc.inputMagnitude.data(), -1.f, size);
+            }
+            add(acc.module.data(), acc.inputModule.data(), -1.f, size);
+            for (unsigned int i = 0; i < size; ++i) {
+                subtractPhase(acc.re[i], acc.im[i], input.phaseRe[i], input.phaseIm[i]);
+            }
+            break;
+        case Min:
+        case Max: {
+            const bool max = (m_operation == Max);
+            for (unsigned int i = 0; i < size; ++i) {
+                auto a = std::atan2(acc.im[i], acc.re[i]);
+                auto b = std::atan2(input.phaseIm[i], input.phaseRe[i]);
+                auto phase = max ? std::max(a, b) : std::min(a, b);
+                acc.re[i] = std::cos(phase);
+                acc.im[i] = std::sin(phase);
+                acc.magnitude[i] = max ? std::max(acc.magnitude[i], acc.inputMagnitude[i]) :
+                                   std::min(acc.magnitude[i], acc.inputMagnitude[i]);
+                acc.module[i] = max ? std::max(acc.module[i], acc.inputModule[i]) :
+                                std::min(acc.module[i], acc.inputModule[i]);
+            }
+            break;
+        }
+        case Apply:
+            Q_ASSERT(false);
+            break;
+        }
+    }
 
-                coherence       += std::abs((*it)->module(i) * (*it)->coherence(i));
-                coherenceWeight += std::abs((*it)->module(i));
+    switch (m_operation) {
+    case Avg:
+        scale(acc.magnitude.data(), 1.f / count, size);
+        scale(acc.module.data(),    1.f / count, size);
+        scale(acc.re.data(),        1.f / count, size);
+        scale(acc.im.data(),        1.f / count, size);
+        break;
+    case Diff:
+        for (unsigned int i = 0; i < size; ++i) {
+            auto phase = std::abs(std::atan2(acc.im[i], acc.re[i]));
+            acc.re[i] = std::cos(phase);
+            acc.im[i] = std::sin(phase);
+            acc.magnitude[i] = std::abs(acc.magnitude[i]);
+            acc.module[i] = std::abs(acc.module[i]);
+        }
+        break;
+    case Subtract:
+        if (m_type == Power) {
+            for (unsigned int i = 0; i < size; ++i) {
+                acc.magnitude[i] = std::abs(acc.magnitude[i]);
+                acc.module[i] = std::abs(acc.module[i]);
             }
         }
-        if (m_operation == Avg) {
-            magnitude /= count;
-            phase /= count;
-            module /= count;
-        } else if (m_operation == Subtract) {
-            magnitude = std::abs(magnitude);
-            module    = std::abs(module);
-        } else if (m_operation == Diff) {
-            magnitude = std::abs(magnitude);
-            phase.polar(std::abs(phase.arg()));
-            module = std::abs(module);
-        }
-        coherence /= coherenceWeight;
-        if (std::isnan(phase.real) || std::isnan(phase.imag)) {
-            phase = {1, 0};
+        break;
+    default:
+        break;
+    }
+
+    //back to linear values
+    switch (m_type) {
+    case dB:
+        for (unsigned int i = 0; i < size; ++i) {
+            acc.magnitude[i] = std::pow(10.f, acc.magnitude[i] / 20.f);
+            acc.module[i] = std::pow(10.f, acc.module[i] / 20.f);
         }
+        break;
+    case Power:
+        for (unsigned int i = 0; i < size; ++i) {
+            acc.magnitude[i] = std::sqrt(acc.magnitude[i]);
+            acc.module[i] = std::sqrt(acc.module[i]);
+        }
+        break;
+    default:
+        break;
+    }
 
-        magnitude = std::sqrt(magnitude);
-        module    = std::sqrt(module);
+    calcCoherence(inputs);
+    storeScalar(primary);
+}
 
-        m_ftdata[i].frequency  = primary->frequency(i);
-        m_ftdata[i].module     = module;
-        m_ftdata[i].phase      = phase.normalize();
-        m_ftdata[i].magnitude  = magnitude;
-        m_ftdata[i].coherence  = coherence;
+void Union::storeScalar(const Input &primary) noexcept
+{
+    auto &acc = m_accumulator;
+    for (unsigned int i = 0; i < primary.size; ++i) {
+        complex phase {acc.re[i], acc.im[i]};
+        if (std::isnan(phase.real) || std::isnan(phase.imag)) {
+            phase = {1, 0};
+        }
+        m_ftdata.module[i]     = acc.module[i];
+        m_ftdata.phase[i]      = phase.normalize();
+        m_ftdata.magnitude[i]  = acc.magnitude[i];
+        m_ftdata.coherence[i]  = acc.coherence[i];
     }
 
-    for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-        m_impulseData[i].time = primary->impulseTime(i);
-        m_impulseData[i].value = NAN;
+    for (unsigned int i = 0; i < primary.impulseSize; i++) {
+        m_impulseData.time[i] = primary.impulseTime[i];
+        m_impulseData.value[i] = NAN;
     }
 }
 
-void Union::calcApply(const Source::Shared &primary) noexcept
+void Union::calcVector(const Inputs &inputs) noexcept
 {
-    float magnitude, module, coherence;
-    complex phase;
+    auto &primary = *inputs.front();
+    auto &acc = m_accumulator;
+    const auto size = primary.size;
+    const auto count = static_cast<float>(inputs.size());
 
-    for (unsigned int i = 0; i < primary->size(); i++) {
-        magnitude   = primary->magnitudeRaw(i);
-        phase       = primary->phase(i);
-        module      = (primary)->module(i);
-        coherence   = primary->coherence(i);
+    for (auto *data : {&acc.re, &acc.im, &acc.peakRe, &acc.peakIm, &acc.magnitudeRe, &acc.magnitudeIm}) {
+        data->assign(size, 0.f);
+    }
+
+    switch (m_operation) {
+    case Summation:
+    case Avg:
+    case Subtract:
+    case Diff:
+        for (auto it = inputs.cbegin(); it != inputs.cend(); ++it) {
+            auto &input = **it;
+            auto sign = (it == inputs.cbegin() || m_operation == Summation || m_operation == Avg) ? 1.f : -1.f;
+            multiplyAdd(acc.re.data(),          input.phaseRe.data(), input.module.data(),       sign, size);
+            multiplyAdd(acc.im.data(),          input.phaseIm.data(), input.module.data(),       sign, size);
+            multiplyAdd(acc.peakRe.data(),      input.phaseRe.data(), input.peakSquared.data(),  sign, size);
+            multiplyAdd(acc.peakIm.data(),      input.phaseIm.data(), input.peakSquared.data(),  sign, size);
+            multiplyAdd(acc.magnitudeRe.data(), input.phaseRe.data(), input.magnitudeRaw.data(), sign, size);
+            multiplyAdd(acc.magnitudeIm.data(), input.phaseIm.data(), input.magnitudeRaw.data(), sign, size);
+        }
+        break;
+    case Min:
+    case Max: {
+        const bool max = (m_operation == Max);
+        auto pick = [max](const complex & a, const complex & b) {
+            return max ? std::max(a, b) : std::min(a, b);
+        };
+        for (unsigned int i = 0; i < size; ++i) {
+            complex phase {primary.phaseRe[i], primary.phaseIm[i]};
+            complex a = phase * primary.module[i];
+            complex p = phase * primary.peakSquared[i];
+            complex m = phase * primary.magnitudeRaw[i];
+            for (auto it = std::next(inputs.cbegin()); it != inputs.cend(); ++it) {
+                auto &input = **it;
+                complex inputPhase {input.phaseRe[i], input.phaseIm[i]};
+                a = pick(a, inputPhase * input.module[i]);
+                p = pick(p, inputPhase * input.peakSquared[i]);
+                m = pick(m, inputPhase * input.magnitudeRaw[i]);
+            }
+            acc.re[i] = a.real;
+            acc.im[i] = a.imag;
+            acc.peakRe[i] = p.real;
+            acc.peakIm[i] = p.imag;
+            acc.magnitudeRe[i] = m.real;
+            acc.magnitudeIm[i] = m.imag;
+        }
+        break;
+    }
+    case Apply: //work in calcApply
+        Q_ASSERT(false);
+        break;
+    }
+
+    if (m_operation == Avg) {
+        for (auto *data : {&acc.re, &acc.im, &acc.peakRe, &acc.peakIm, &acc.magnitudeRe, &acc.magnitudeIm}) {
+            scale(data->data(), 1.f / count, size);
+        }
+    }
+    calcCoherence(inputs);
+
+    for (unsigned int i = 0; i < size; i++) {
+        complex a {acc.re[i], acc.im[i]};
+        complex p {acc.peakRe[i], acc.peakIm[i]};
+        complex m {acc.magnitudeRe[i], acc.magnitudeIm[i]};
+
+        m_ftdata.module[i]     = a.abs();
+        m_ftdata.phase[i]      = m.normalize();
+        m_ftdata.magnitude[i]  = m.abs();
+        m_ftdata.coherence[i]  = acc.coherence[i];
+        m_ftdata.peakSquared[i] = p.abs();
+    }
 
-        for (auto it = m_sources.begin(); it != m_sources.end(); ++it) {
-            if (*it && it != m_sources.begin()) {
+    if (primary.impulseSize < 2) {
+        return;
+    }
 
-                magnitude *= (*it)->magnitudeRaw(i);
-                module    *= (*it)->magnitudeRaw(i);
-                coherence  = std::min(coherence, (*it)->coherence(i));
-                phase.polar(phase.arg() + (*it)->phase(i).arg());
+    for (unsigned int i = 0; i < primary.impulseSize; i++) {
+        m_impulseData.time[i] = primary.impulseTime[i];
+        m_impulseData.value[i] = primary.impulseValue[i];
+    }
+    const float dt = m_impulseData.time[1] - m_impulseData.time[0];
+
+    //inputs are aligned to the primary one by their own time axis
+    auto shift = [this, &primary, dt](const Input & input, auto operation) {
+        for (unsigned int i = 0; i < primary.impulseSize; i++) {
+            float st = (i < input.impulseSize ? input.impulseTime[i] : 0.f);
+            float value = (i < input.impulseSize ? input.impulseValue[i] : 0.f);
+            long offseted =  (long)i + (st - m_impulseData.time[i]) / dt;
+            if (offseted > 0 && offseted < static_cast<long>(m_deconvolutionSize)) {
+                operation(m_impulseData.value[offseted], value);
             }
         }
-        if (std::isnan(phase.real) || std::isnan(phase.imag)) {
-            phase = {1, 0};
+    };
+    for (auto it = std::next(inputs.cbegin()); it != inputs.cend(); ++it) {
+        switch (m_operation) {
+        case Summation:
+        case Avg:
+            shift(**it, [](complex & target, float value) {
+                target += value;
+            });
+            break;
+        case Subtract:
+        case Diff:
+            shift(**it, [](complex & target, float value) {
+                target -= value;
+            });
+            break;
+        case Min:
+            shift(**it, [](complex & target, float value) {
+                target = std::min(target, complex{value});
+            });
+            break;
+        case Max:
+            shift(**it, [](complex & target, float value) {
+                target = std::max(target, complex{value});
+            });
+            break;
+        case Apply:
+            //calculated in calcApply
+            Q_ASSERT(false);
+            break;
         }
+    }
 
-        m_ftdata[i].frequency  = primary->frequency(i);
-        m_ftdata[i].module     = module;
-        m_ftdata[i].phase      = phase.normalize();
-        m_ftdata[i].magnitude  = magnitude;
-        m_ftdata[i].coherence  = coherence;
+    if (m_operation == Avg) {
+        for (unsigned int i = 0; i < primary.impulseSize; i++) {
+            m_impulseData.value[i] /= count;
+        }
     }
+}
 
-    for (unsigned int i = 0; i < primary->impulseSize(); i++) {
-        m_impulseData[i].time = primary->impulseTime(i);
-        m_impulseData[i].value = NAN;
+void Union::calcApply(const Inputs &inputs) noexcept
+{
+    auto &primary = *inputs.front();
+    auto &acc = m_accumulator;
+    const auto size = primary.size;
+
+    acc.magnitude = primary.magnitudeRaw;
+    acc.module    = primary.module;
+    acc.coherence = primary.coherence;
+    acc.re        = primary.phaseRe;
+    acc.im        = primary.phaseIm;
+
+    for (auto it = std::next(inputs.cbegin()); it != inputs.cend(); ++it) {
+        auto &input = **it;
+        multiply(acc.magnitude.data(), input.magnitudeRaw.data(), size);
+        multiply(acc.module.data(),    input.magnitudeRaw.data(), size);
+        for (unsigned int i = 0; i < size; ++i) {
+            acc.coherence[i] = std::min(acc.coherence[i], input.coherence[i]);
+
+            auto phase = std::atan2(acc.im[i], acc.re[i]) + std::atan2(input.phaseIm[i], input.phaseRe[i]);
+            acc.re[i] = std::cos(phase);
+            acc.im[i] = std::sin(phase);
+        }
     }
+    storeScalar(primary);
 }
 
 bool Union::autoName() const
@@ -694,8 +932,6 @@ void Union::applyAutoName() noexcept
 
 void Union::sourceDestroyed(Source::Abstract *source)
 {
-    std::lock_guard l(s_calcmutex);
-
     auto position = std::find_if(m_sources.begin(), m_sources.end(), [source](const auto & p) {
         return p.get() == source;
     });
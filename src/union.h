@@ -20,10 +20,9 @@
 
 #include <QObject>
 #include <QPointer>
-#include <QTimer>
-#include <QThread>
 
 #include <set>
+#include <vector>
 #include "source/source_abstract.h"
 
 class Union : public Source::Abstract
@@ -96,28 +95,66 @@ public slots:
 signals:
     void countChanged(int);
     void operationChanged(Union::Operation);
-    void needUpdate();
     void typeChanged();
     void autoNameChanged();
     void modelChanged();
 
 private:
+    //! contiguous copy of one pinned frame of a source, accessors are called once per value
+    struct Input {
+        const Source::Abstract *source = nullptr;
+        quint64 version = 0;
+        unsigned int size = 0;
+        unsigned int impulseSize = 0;
+        std::vector<float> frequency, module, magnitudeRaw, magnitude, coherence, peakSquared;
+        std::vector<float> phaseRe, phaseIm;
+        std::vector<float> impulseTime, impulseValue;
+        Source::AxisShared axis;
+        quint64 grid = 0;   //id of the interned frequency axis
+    };
+    using Inputs = std::vector<const Input *>;
+
+    //! maps bins of an input onto the primary frequency axis
+    struct Tap {
+        unsigned int from = 0, to = 0;  //interpolated between both, or averaged over [from, to) for a band
+        float weight = 0;               //of the bin "to" for the interpolation
+        bool band = false;
+        bool outside = false;           //beyond the input frequency range
+    };
+    struct Table {
+        quint64 from = 0, to = 0;       //grids the taps are built for
+        std::vector<Tap> taps;
+    };
+
+    struct Accumulator {
+        std::vector<float> magnitude, module, re, im;
+        std::vector<float> peakRe, peakIm, magnitudeRe, magnitudeIm;
+        std::vector<float> coherence, weight;
+        std::vector<float> inputMagnitude, inputModule;
+    };
+
     void init() noexcept;
-    void resize();
-    void calcPolar(unsigned int count, const Source::Shared &primary) noexcept;
-    void calcVector(unsigned int count, const Source::Shared &primary) noexcept;
-    void calcdB(unsigned int count, const Source::Shared &primary) noexcept;
-    void calcPower(unsigned int count, const Source::Shared &primary) noexcept;
-    void calcApply(const Source::Shared &primary) noexcept;
+    void resize(unsigned int size, unsigned int impulseSize);
+    bool gather(Input &input, const Source::Shared &source);
+    const Input *align(const Input &input, const Input &primary, Table &table, Input &aligned);
+    void calcScalar(const Inputs &inputs) noexcept;
+    void calcVector(const Inputs &inputs) noexcept;
+    void calcApply(const Inputs &inputs) noexcept;
+    void calcCoherence(const Inputs &inputs) noexcept;
+    void storeScalar(const Input &primary) noexcept;
     bool checkLoop(Union *source) const;
 
     SourceVector m_sources;
-    QTimer m_timer;
-    QThread m_timerThread;
     Operation m_operation;
     Type m_type;
     bool m_autoName;
 
-    static std::mutex s_calcmutex;
+    //inputs are gathered again after any change of the union itself
+    std::atomic<bool> m_dirty;
+    std::vector<Input> m_inputs;
+    //inputs with another frequency axis are resampled onto the primary one
+    std::vector<Input> m_aligned;
+    std::vector<Table> m_tables;
+    Accumulator m_accumulator;
 };
 #endif // UNION_H